@@ -459,7 +459,9 @@ void _st_add_sleep_q(_st_thread_t *thread, st_utime_t timeout);
 void _st_del_sleep_q(_st_thread_t *thread);
 _st_stack_t *_st_stack_new(int stack_size);
 void _st_stack_free(_st_stack_t *ts);
+void _st_stack_destroy(void);
 int _st_io_init(void);
+void _st_io_destroy(void);
 
 st_utime_t st_utime(void);
 _st_cond_t *st_cond_new(void);
@@ -128,6 +128,20 @@ int _st_io_init(void)
 }
 
 
+/*
+ * Free the cached file descriptor objects of this VP, see st_destroy
+ */
+void _st_io_destroy(void)
+{
+    _st_netfd_t *fd;
+    
+    while ((fd = _st_netfd_freelist) != NULL) {
+        _st_netfd_freelist = fd->next;
+        free(fd);
+    }
+}
+
+
 int st_getfdlimit(void)
 {
     return _st_osfd_limit;
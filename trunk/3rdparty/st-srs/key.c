@@ -85,7 +85,7 @@ int st_thread_setspecific(int key, void *value)
 
 int st_thread_setspecific2(_st_thread_t *me, int key, void *value)
 {
-    if (key < 0 || key >= key_max) {
+    if (key < 0 || key >= key_max || !me) {
         errno = EINVAL;
         return -1;
     }
@@ -107,6 +107,10 @@ void *st_thread_getspecific(int key)
     if (key < 0 || key >= key_max)
         return NULL;
     
+    /* After st_destroy, there is no current thread */
+    if (!_ST_CURRENT_THREAD())
+        return NULL;
+    
     return ((_ST_CURRENT_THREAD())->private_data[key]);
 }
 
@@ -230,11 +230,31 @@ int st_init(void)
 
 
 /*
- * Destroy this Virtual Processor
+ * Destroy this Virtual Processor, for example, before the pthread quits. It frees the
+ * thread-local objects of ST, so it should be called by the primordial thread, after all
+ * other threads are terminated and joined, and no ST API should be used after it.
  */
 void st_destroy(void)
 {
+    _st_thread_t *thread = _ST_CURRENT_THREAD();
+    
     (*_st_eventsys->destroy)();
+    
+    /* The idle thread never terminates, its object is on its stack */
+    if (_st_this_vp.idle_thread) {
+        _st_stack_free(_st_this_vp.idle_thread->stack);
+        _st_this_vp.idle_thread = NULL;
+    }
+    
+    /* The primordial thread has no stack, it's allocated by st_init */
+    if (thread && (thread->flags & _ST_FL_PRIMORDIAL)) {
+        _st_thread_cleanup(thread);
+        _ST_SET_CURRENT_THREAD(NULL);
+        free(thread);
+    }
+    
+    _st_stack_destroy();
+    _st_io_destroy();
 }
 
 
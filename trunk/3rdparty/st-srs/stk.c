@@ -57,6 +57,7 @@ __thread int _st_num_free_stacks = 0;
 __thread int _st_randomize_stacks = 0;
 
 static char *_st_new_stk_segment(int size);
+static void _st_delete_stk_segment(char *vaddr, int size);
 
 _st_stack_t *_st_stack_new(int stack_size)
 {
@@ -152,9 +153,7 @@ static char *_st_new_stk_segment(int size)
 }
 
 
-/* Not used */
-#if 0
-void _st_delete_stk_segment(char *vaddr, int size)
+static void _st_delete_stk_segment(char *vaddr, int size)
 {
 #ifdef MALLOC_STACK
     free(vaddr);
@@ -162,7 +161,24 @@ void _st_delete_stk_segment(char *vaddr, int size)
     (void) munmap(vaddr, size);
 #endif
 }
-#endif
+
+
+/*
+ * Free the cached stacks of this VP, see st_destroy
+ */
+void _st_stack_destroy(void)
+{
+    _st_clist_t *qp;
+    _st_stack_t *ts;
+    
+    while ((qp = _st_free_stacks.next) != &_st_free_stacks) {
+        ts = _ST_THREAD_STACK_PTR(qp);
+        ST_REMOVE_LINK(&ts->links);
+        _st_num_free_stacks--;
+        _st_delete_stk_segment(ts->vaddr, ts->vaddr_size);
+        free(ts);
+    }
+}
 
 int st_randomize_stacks(int on)
 {
@@ -80,6 +80,13 @@ else
     srs_undefine_macro "SRS_RTC" $SRS_AUTO_HEADERS_H
 fi
 
+# Whether libsrtp uses openssl crypto, which supports AES-GCM and AES-NI.
+if [[ $SRS_SRTP_ASM == YES ]]; then
+    srs_define_macro "SRS_SRTP_OPENSSL" $SRS_AUTO_HEADERS_H
+else
+    srs_undefine_macro "SRS_SRTP_OPENSSL" $SRS_AUTO_HEADERS_H
+fi
+
 if [[ $SRS_FFMPEG_FIT == YES ]]; then
     srs_define_macro "SRS_FFMPEG_FIT" $SRS_AUTO_HEADERS_H
 else
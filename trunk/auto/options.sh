@@ -192,7 +192,7 @@ Performance:                @see https://ossrs.net/lts/zh-cn/docs/v5/doc/perform
   --sanitizer-static=on|off Whether build SRS with static libasan(asan). Default: $(value2switch $SRS_SANITIZER_STATIC)
   --sanitizer-log=on|off    Whether hijack the log for libasan(asan). Default: $(value2switch $SRS_SANITIZER_LOG)
   --nasm=on|off             Whether build FFMPEG for RTC with nasm. Default: $(value2switch $SRS_NASM)
-  --srtp-nasm=on|off        Whether build SRTP with ASM(openssl-asm), requires RTC and openssl-1.0.*. Default: $(value2switch $SRS_SRTP_ASM)
+  --srtp-nasm=on|off        Whether build SRTP with openssl crypto(ASM and AES-NI), which enables AES-GCM, requires RTC. Default: $(value2switch $SRS_SRTP_ASM)
 
 Toolchain options:
   --static=on|off           Whether add '-static' to link options. Default: $(value2switch $SRS_STATIC)
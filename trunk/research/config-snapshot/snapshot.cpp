@@ -0,0 +1,198 @@
+/*
+The benchmark for the config getters called when accept a connection and setup a publish stream, to compare
+the compiled snapshot with walking the directives, for a config with many vhosts.
+
+Build SRS first, then:
+    make
+Run with 1000 vhosts, and 100000 connections:
+    ./snapshot -n 1000 -c 100000
+*/
+#include <srs_core.hpp>
+#include <srs_kernel_log.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_protocol_log.hpp>
+#include <srs_app_config.hpp>
+#include <srs_app_threads.hpp>
+
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <string>
+#include <vector>
+using namespace std;
+
+class SrsServer;
+
+// The globals of SRS, see srs_main_server.cpp.
+ISrsLog* _srs_log = NULL;
+ISrsContext* _srs_context = NULL;
+SrsConfig* _srs_config = NULL;
+SrsServer* _srs_server = NULL;
+bool _srs_in_docker = false;
+bool _srs_config_by_env = false;
+const char* _srs_binary = NULL;
+
+class EmptyLog : public ISrsLog
+{
+public:
+    virtual srs_error_t initialize() { return srs_success; }
+    virtual void reopen() {}
+    virtual void log(SrsLogLevel level, const char* tag, const SrsContextId& context_id, const char* fmt, va_list args) {}
+};
+
+class BenchConfig : public SrsConfig
+{
+public:
+    // Drop the snapshot, so the getters walk the directives.
+    void drop_snapshot() {
+        srs_freep(snapshot_);
+    }
+};
+
+int64_t update_system_time()
+{
+    timeval now;
+    ::gettimeofday(&now, NULL);
+    return ((int64_t)now.tv_sec) * 1000 * 1000 + (int64_t)now.tv_usec;
+}
+
+struct Options {
+    // The number of vhosts.
+    int vhosts;
+    // The number of connections, each one publishes a stream.
+    int conns;
+};
+
+Options opts;
+
+// Write the config file, the connections use the last vhosts, which are the worst case for walking directives.
+string mock_config()
+{
+    string file = "/tmp/srs-bench-snapshot.conf";
+    FILE* f = fopen(file.c_str(), "w");
+    if (!f) {
+        return "";
+    }
+
+    fprintf(f, "listen 1935; max_connections 1000; daemon off; srs_log_tank console;\n");
+    for (int i = 0; i < opts.vhosts; i++) {
+        fprintf(f, "vhost v%d.ossrs.net { tcp_nodelay on; min_latency on; play { gop_cache on; queue_length 10; mw_latency 350; } }\n", i);
+    }
+    fclose(f);
+
+    return file;
+}
+
+// The getters for each connection, see SrsRtmpConn.
+int64_t on_accept(const string& vhost)
+{
+    int64_t v = 0;
+    v += _srs_config->get_vhost_enabled(vhost);
+    v += _srs_config->get_refer_enabled(vhost);
+    v += _srs_config->get_tcp_nodelay(vhost);
+    bool realtime = _srs_config->get_realtime_enabled(vhost);
+    v += _srs_config->get_mw_msgs(vhost, realtime);
+    v += _srs_config->get_mw_sleep(vhost);
+    v += _srs_config->get_send_min_interval(vhost);
+    v += _srs_config->get_vhost_is_edge(vhost);
+    return v;
+}
+
+// The getters for each publish stream, see SrsLiveSource.
+int64_t on_publish(const string& vhost)
+{
+    int64_t v = 0;
+    v += _srs_config->get_gop_cache(vhost);
+    v += _srs_config->get_gop_cache_max_frames(vhost);
+    v += _srs_config->get_queue_length(vhost);
+    v += _srs_config->get_atc(vhost);
+    v += _srs_config->get_time_jitter(vhost);
+    v += _srs_config->get_mix_correct(vhost);
+    v += _srs_config->try_annexb_first(vhost);
+    v += _srs_config->get_reduce_sequence_header(vhost);
+    v += _srs_config->get_vhost_is_edge(vhost);
+    return v;
+}
+
+void run(const char* mode, vector<string>& vhosts)
+{
+    int64_t v = 0;
+
+    int64_t starttime = update_system_time();
+    for (int i = 0; i < opts.conns; i++) {
+        v += on_accept(vhosts[i % vhosts.size()]);
+    }
+    int64_t accept_us = update_system_time() - starttime;
+
+    starttime = update_system_time();
+    for (int i = 0; i < opts.conns; i++) {
+        v += on_publish(vhosts[i % vhosts.size()]);
+    }
+    int64_t publish_us = update_system_time() - starttime;
+
+    printf("%s: accept=%.2fus, publish=%.2fus, per connection, v=%ld\n", mode,
+        accept_us * 1.0 / opts.conns, publish_us * 1.0 / opts.conns, v);
+}
+
+void usage(char** argv)
+{
+    printf("Usage: %s [-n vhosts] [-c conns]\n", argv[0]);
+    printf("    -n  The number of vhosts, default 1000\n");
+    printf("    -c  The number of connections, default 100000\n");
+}
+
+int main(int argc, char** argv)
+{
+    opts.vhosts = 1000;
+    opts.conns = 100000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:h")) != -1) {
+        switch (opt) {
+            case 'n': opts.vhosts = atoi(optarg); break;
+            case 'c': opts.conns = atoi(optarg); break;
+            default: usage(argv); exit(-1);
+        }
+    }
+    if (opts.vhosts <= 0 || opts.conns <= 0) {
+        usage(argv);
+        exit(-1);
+    }
+
+    srs_error_t err = srs_success;
+    if ((err = srs_global_initialize()) != srs_success) {
+        printf("init global failed, %s\n", srs_error_desc(err).c_str());
+        exit(-1);
+    }
+    srs_freep(_srs_log);
+    _srs_log = new EmptyLog();
+    srs_freep(_srs_context);
+    _srs_context = new SrsThreadContext();
+
+    string file = mock_config();
+    BenchConfig* conf = new BenchConfig();
+    srs_freep(_srs_config);
+    _srs_config = conf;
+
+    char* args[] = {argv[0], (char*)"-c", (char*)file.c_str()};
+    if (file.empty() || (err = conf->parse_options(3, args)) != srs_success) {
+        printf("parse config %s failed, %s\n", file.c_str(), srs_error_desc(err).c_str());
+        exit(-1);
+    }
+
+    // The streams are published to the last 10 vhosts.
+    vector<string> vhosts;
+    for (int i = srs_max(0, opts.vhosts - 10); i < opts.vhosts; i++) {
+        vhosts.push_back("v" + srs_int2str(i) + ".ossrs.net");
+    }
+    printf("vhosts=%d, conns=%d\n", opts.vhosts, opts.conns);
+
+    run("snapshot", vhosts);
+
+    conf->drop_snapshot();
+    run("directives", vhosts);
+
+    return 0;
+}
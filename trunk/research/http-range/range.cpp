@@ -0,0 +1,293 @@
+/*
+The benchmark for concurrent HTTP Range requests of VOD files, with keep-alive and pipelining.
+
+Build:
+    make
+Run SRS with http_server, copy some mp4 files to ./objs/nginx/html/vod, then:
+    ./range -s 127.0.0.1 -p 8080 -c 100 -n 1000 -r 65536 -d 4 /vod/a.mp4 /vod/b.mp4
+*/
+#include <st.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+using namespace std;
+
+int64_t update_system_time()
+{
+    timeval now;
+    ::gettimeofday(&now, NULL);
+    return ((int64_t)now.tv_sec) * 1000 * 1000 + (int64_t)now.tv_usec;
+}
+
+struct Options {
+    string host;
+    int port;
+    // The number of connections.
+    int conns;
+    // The number of requests per connection.
+    int requests;
+    // The bytes of each range.
+    int range;
+    // The number of pipelined requests.
+    int depth;
+    // The files to request, and the size got by probe.
+    vector<string> files;
+    vector<int64_t> sizes;
+};
+
+struct Stat {
+    int64_t requests;
+    int64_t bytes;
+    int errors;
+    int alive;
+};
+
+Options opts;
+Stat stat;
+
+st_netfd_t do_connect()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    int v = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+
+    st_netfd_t stfd = st_netfd_open_socket(fd);
+    if (!stfd) {
+        ::close(fd);
+        return NULL;
+    }
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opts.port);
+    addr.sin_addr.s_addr = inet_addr(opts.host.c_str());
+
+    if (st_connect(stfd, (sockaddr*)&addr, sizeof(addr), ST_UTIME_NO_TIMEOUT) == -1) {
+        st_netfd_close(stfd);
+        return NULL;
+    }
+
+    return stfd;
+}
+
+// Read a response, discard the body, return the status, and the total size from Content-Range.
+int read_response(st_netfd_t stfd, string& buf, int64_t* total, int64_t* nbody)
+{
+    size_t pos;
+    while ((pos = buf.find("\r\n\r\n")) == string::npos) {
+        char tmp[4096];
+        ssize_t nn = st_read(stfd, tmp, sizeof(tmp), ST_UTIME_NO_TIMEOUT);
+        if (nn <= 0) {
+            return -1;
+        }
+        buf.append(tmp, nn);
+    }
+
+    string header = buf.substr(0, pos + 4);
+    buf = buf.substr(pos + 4);
+
+    int status = 0;
+    if (sscanf(header.c_str(), "HTTP/1.1 %d", &status) != 1) {
+        return -1;
+    }
+
+    int64_t length = 0;
+    const char* p = strcasestr(header.c_str(), "Content-Length:");
+    if (!p || sscanf(p + 15, "%ld", &length) != 1) {
+        return -1;
+    }
+
+    p = strcasestr(header.c_str(), "Content-Range:");
+    if (total && p && (p = strchr(p, '/')) != NULL) {
+        *total = atoll(p + 1);
+    }
+
+    // Discard the body.
+    int64_t left = length;
+    int64_t nn = std::min(left, (int64_t)buf.length());
+    buf = buf.substr(nn);
+    left -= nn;
+
+    char tmp[64 * 1024];
+    while (left > 0) {
+        ssize_t nr = st_read(stfd, tmp, std::min(left, (int64_t)sizeof(tmp)), ST_UTIME_NO_TIMEOUT);
+        if (nr <= 0) {
+            return -1;
+        }
+        left -= nr;
+    }
+
+    *nbody = length;
+    return status;
+}
+
+int send_request(st_netfd_t stfd, string file, int64_t start, int64_t end)
+{
+    char req[1024];
+    int size = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: %s\r\nRange: bytes=%ld-%ld\r\n\r\n",
+        file.c_str(), opts.host.c_str(), start, end);
+    return st_write(stfd, req, size, ST_UTIME_NO_TIMEOUT) == size ? 0 : -1;
+}
+
+// Get the size of files, by range of the first byte.
+int probe()
+{
+    st_netfd_t stfd = do_connect();
+    if (!stfd) {
+        printf("connect %s:%d failed\n", opts.host.c_str(), opts.port);
+        return -1;
+    }
+
+    string buf;
+    for (int i = 0; i < (int)opts.files.size(); i++) {
+        int64_t total = -1, nbody = 0;
+        if (send_request(stfd, opts.files[i], 0, 0) != 0 || read_response(stfd, buf, &total, &nbody) != 206 || total <= 0) {
+            printf("probe %s failed\n", opts.files[i].c_str());
+            st_netfd_close(stfd);
+            return -1;
+        }
+        opts.sizes.push_back(total);
+        printf("probe %s size=%ld\n", opts.files[i].c_str(), total);
+    }
+
+    st_netfd_close(stfd);
+    return 0;
+}
+
+void* client(void* arg)
+{
+    st_netfd_t stfd = do_connect();
+    if (!stfd) {
+        stat.errors++;
+        stat.alive--;
+        return NULL;
+    }
+
+    string buf;
+    unsigned int seed = (unsigned int)(uint64_t)arg;
+    for (int i = 0; i < opts.requests; i += opts.depth) {
+        // Send the pipelined requests, then read the responses.
+        int depth = std::min(opts.depth, opts.requests - i);
+        for (int j = 0; j < depth; j++) {
+            int k = rand_r(&seed) % opts.files.size();
+            int64_t size = opts.sizes[k];
+            int64_t start = size > opts.range ? rand_r(&seed) % (size - opts.range) : 0;
+            int64_t end = std::min(start + opts.range, size) - 1;
+            if (send_request(stfd, opts.files[k], start, end) != 0) {
+                stat.errors++;
+                goto done;
+            }
+        }
+
+        for (int j = 0; j < depth; j++) {
+            int64_t nbody = 0;
+            if (read_response(stfd, buf, NULL, &nbody) != 206) {
+                stat.errors++;
+                goto done;
+            }
+            stat.requests++;
+            stat.bytes += nbody;
+        }
+    }
+
+done:
+    st_netfd_close(stfd);
+    stat.alive--;
+    return NULL;
+}
+
+void usage(char** argv)
+{
+    printf("Usage: %s [-s host] [-p port] [-c conns] [-n requests] [-r range] [-d depth] file...\n", argv[0]);
+    printf("    -s  The server host, default 127.0.0.1\n");
+    printf("    -p  The server port, default 8080\n");
+    printf("    -c  The number of connections, default 100\n");
+    printf("    -n  The number of requests per connection, default 1000\n");
+    printf("    -r  The bytes of each range, default 65536\n");
+    printf("    -d  The number of pipelined requests, default 1\n");
+}
+
+int main(int argc, char** argv)
+{
+    opts.host = "127.0.0.1";
+    opts.port = 8080;
+    opts.conns = 100;
+    opts.requests = 1000;
+    opts.range = 65536;
+    opts.depth = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:c:n:r:d:h")) != -1) {
+        switch (opt) {
+            case 's': opts.host = optarg; break;
+            case 'p': opts.port = atoi(optarg); break;
+            case 'c': opts.conns = atoi(optarg); break;
+            case 'n': opts.requests = atoi(optarg); break;
+            case 'r': opts.range = atoi(optarg); break;
+            case 'd': opts.depth = atoi(optarg); break;
+            default: usage(argv); exit(-1);
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        opts.files.push_back(argv[i]);
+    }
+    if (opts.files.empty() || opts.conns <= 0 || opts.requests <= 0 || opts.range <= 0 || opts.depth <= 0) {
+        usage(argv);
+        exit(-1);
+    }
+
+    if (st_set_eventsys(ST_EVENTSYS_ALT) == -1 || st_init() != 0) {
+        printf("init st failed\n");
+        exit(-1);
+    }
+
+    if (probe() != 0) {
+        exit(-1);
+    }
+
+    printf("start conns=%d, requests=%d, range=%d, depth=%d, files=%d\n",
+        opts.conns, opts.requests, opts.range, opts.depth, (int)opts.files.size());
+
+    int64_t starttime = update_system_time();
+    memset(&stat, 0, sizeof(stat));
+    for (int i = 0; i < opts.conns; i++) {
+        stat.alive++;
+        if (!st_thread_create(client, (void*)(uint64_t)(i + 1), 0, 0)) {
+            stat.alive--;
+            stat.errors++;
+        }
+    }
+
+    int64_t last = starttime, last_requests = 0;
+    while (stat.alive > 0) {
+        st_usleep(1000 * 1000);
+
+        int64_t now = update_system_time();
+        printf("alive=%d, requests=%ld, errors=%d, qps=%.1f\n", stat.alive, stat.requests, stat.errors,
+            (stat.requests - last_requests) * 1000000.0 / (now - last));
+        last = now;
+        last_requests = stat.requests;
+    }
+
+    double elapsed = (update_system_time() - starttime) / 1000000.0;
+    printf("done requests=%ld, errors=%d, elapsed=%.2fs, qps=%.1f, throughput=%.1fMB/s\n", stat.requests, stat.errors,
+        elapsed, stat.requests / elapsed, stat.bytes / elapsed / 1024 / 1024);
+
+    return 0;
+}
@@ -0,0 +1,242 @@
+/*
+The benchmark for the RTMP chunk stream demuxer, to measure the cost to receive large video messages, which are
+split to many chunks, for example, a 50Mbps 4K publisher with chunk size 128.
+
+Build SRS first, then:
+    make
+Run with chunk size 128, 4096 and 60000, and 2000 video messages of 200KB:
+    ./chunk -c 128 -s 204800 -n 2000
+    ./chunk -c 4096 -s 204800 -n 2000
+    ./chunk -c 60000 -s 204800 -n 2000
+*/
+#include <srs_core.hpp>
+#include <srs_core_autofree.hpp>
+#include <srs_kernel_log.hpp>
+#include <srs_kernel_error.hpp>
+#include <srs_kernel_flv.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_protocol_io.hpp>
+#include <srs_protocol_log.hpp>
+#include <srs_protocol_rtmp_stack.hpp>
+#include <srs_app_config.hpp>
+#include <srs_app_threads.hpp>
+
+#include <sys/time.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <string>
+using namespace std;
+
+class SrsServer;
+
+// The globals of SRS, see srs_main_server.cpp.
+ISrsLog* _srs_log = NULL;
+ISrsContext* _srs_context = NULL;
+SrsConfig* _srs_config = NULL;
+SrsServer* _srs_server = NULL;
+bool _srs_in_docker = false;
+bool _srs_config_by_env = false;
+const char* _srs_binary = NULL;
+
+class EmptyLog : public ISrsLog
+{
+public:
+    virtual srs_error_t initialize() { return srs_success; }
+    virtual void reopen() {}
+    virtual void log(SrsLogLevel level, const char* tag, const SrsContextId& context_id, const char* fmt, va_list args) {}
+};
+
+// The IO to capture the bytes sent by protocol, and feed the captured bytes to protocol, like a socket. The header
+// is sent once, then the body is sent again and again.
+class BenchIO : public ISrsProtocolReadWriter
+{
+public:
+    string header;
+    string body;
+    string* captured;
+    size_t pos;
+    int64_t rbytes;
+public:
+    BenchIO() : captured(&header), pos(0), rbytes(0) {}
+public:
+    virtual srs_error_t read(void* buf, size_t size, ssize_t* nread) {
+        string* p = (rbytes < (int64_t)header.length()) ? &header : &body;
+        size = srs_min(size, p->length() - pos);
+        memcpy(buf, p->data() + pos, size);
+        pos += size;
+        rbytes += size;
+        if (pos == p->length()) {
+            pos = 0;
+        }
+        if (nread) {
+            *nread = size;
+        }
+        return srs_success;
+    }
+    virtual srs_error_t read_fully(void* buf, size_t size, ssize_t* nread) {
+        return srs_error_new(ERROR_SOCKET_READ_FULLY, "not supported");
+    }
+    virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite) {
+        captured->append((char*)buf, size);
+        if (nwrite) {
+            *nwrite = size;
+        }
+        return srs_success;
+    }
+    virtual srs_error_t writev(const iovec* iov, int iov_size, ssize_t* nwrite) {
+        ssize_t size = 0;
+        for (int i = 0; i < iov_size; i++) {
+            captured->append((char*)iov[i].iov_base, iov[i].iov_len);
+            size += iov[i].iov_len;
+        }
+        if (nwrite) {
+            *nwrite = size;
+        }
+        return srs_success;
+    }
+    virtual void set_recv_timeout(srs_utime_t tm) {}
+    virtual srs_utime_t get_recv_timeout() { return SRS_UTIME_NO_TIMEOUT; }
+    virtual void set_send_timeout(srs_utime_t tm) {}
+    virtual srs_utime_t get_send_timeout() { return SRS_UTIME_NO_TIMEOUT; }
+    virtual int64_t get_recv_bytes() { return rbytes; }
+    virtual int64_t get_send_bytes() { return 0; }
+};
+
+int64_t update_system_time()
+{
+    timeval now;
+    ::gettimeofday(&now, NULL);
+    return ((int64_t)now.tv_sec) * 1000 * 1000 + (int64_t)now.tv_usec;
+}
+
+struct Options {
+    // The chunk size of publisher.
+    int chunk_size;
+    // The size of each video message.
+    int size;
+    // The number of video messages.
+    int count;
+};
+
+Options opts;
+
+// Capture the bytes of the set chunk size packet, and a video message.
+srs_error_t mock_publisher(BenchIO* io)
+{
+    srs_error_t err = srs_success;
+
+    SrsProtocol sender(io);
+
+    SrsSetChunkSizePacket* pkt = new SrsSetChunkSizePacket();
+    pkt->chunk_size = opts.chunk_size;
+    if ((err = sender.send_and_free_packet(pkt, 0)) != srs_success) {
+        return srs_error_wrap(err, "send chunk size");
+    }
+
+    io->captured = &io->body;
+
+    SrsMessageHeader h;
+    h.initialize_video(opts.size, 0, 1);
+    char* payload = new char[opts.size];
+    memset(payload, 0x17, opts.size);
+
+    SrsSharedPtrMessage* msg = new SrsSharedPtrMessage();
+    if ((err = msg->create(&h, payload, opts.size)) != srs_success) {
+        srs_freep(msg);
+        return srs_error_wrap(err, "create msg");
+    }
+    if ((err = sender.send_and_free_message(msg, 1)) != srs_success) {
+        return srs_error_wrap(err, "send msg");
+    }
+
+    return err;
+}
+
+srs_error_t run()
+{
+    srs_error_t err = srs_success;
+
+    BenchIO io;
+    if ((err = mock_publisher(&io)) != srs_success) {
+        return srs_error_wrap(err, "mock publisher");
+    }
+
+    SrsProtocol receiver(&io);
+
+    // The set chunk size message, to update the in chunk size of receiver.
+    SrsCommonMessage* msg = NULL;
+    if ((err = receiver.recv_message(&msg)) != srs_success) {
+        return srs_error_wrap(err, "recv chunk size");
+    }
+    srs_freep(msg);
+
+    int64_t starttime = update_system_time();
+    for (int i = 0; i < opts.count; i++) {
+        if ((err = receiver.recv_message(&msg)) != srs_success) {
+            return srs_error_wrap(err, "recv msg #%d", i);
+        }
+
+        SrsAutoFree(SrsCommonMessage, msg);
+        if (msg->size != opts.size || msg->payload[opts.size - 1] != 0x17) {
+            return srs_error_new(ERROR_RTMP_MESSAGE_DECODE, "invalid msg #%d, size=%d", i, msg->size);
+        }
+    }
+    int64_t elapsed = srs_max(1, update_system_time() - starttime);
+
+    printf("chunk=%d, size=%d, count=%d, bytes=%ld, elapsed=%.2fms, %.2fus/msg, %.1fMB/s\n", opts.chunk_size,
+        opts.size, opts.count, io.rbytes, elapsed / 1000.0, elapsed * 1.0 / opts.count,
+        io.rbytes * 1.0 / elapsed * 1000000 / 1024 / 1024);
+
+    return err;
+}
+
+void usage(char** argv)
+{
+    printf("Usage: %s [-c chunk_size] [-s size] [-n count]\n", argv[0]);
+    printf("    -c  The chunk size of publisher, default 128\n");
+    printf("    -s  The bytes of each video message, default 204800\n");
+    printf("    -n  The number of video messages, default 2000\n");
+}
+
+int main(int argc, char** argv)
+{
+    opts.chunk_size = 128;
+    opts.size = 204800;
+    opts.count = 2000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:s:n:h")) != -1) {
+        switch (opt) {
+            case 'c': opts.chunk_size = atoi(optarg); break;
+            case 's': opts.size = atoi(optarg); break;
+            case 'n': opts.count = atoi(optarg); break;
+            default: usage(argv); exit(-1);
+        }
+    }
+    if (opts.chunk_size < SRS_CONSTS_RTMP_MIN_CHUNK_SIZE || opts.chunk_size > SRS_CONSTS_RTMP_MAX_CHUNK_SIZE
+        || opts.size <= 0 || opts.count <= 0) {
+        usage(argv);
+        exit(-1);
+    }
+
+    srs_error_t err = srs_success;
+    if ((err = srs_global_initialize()) != srs_success) {
+        printf("init global failed, %s\n", srs_error_desc(err).c_str());
+        exit(-1);
+    }
+    srs_freep(_srs_log);
+    _srs_log = new EmptyLog();
+    srs_freep(_srs_context);
+    _srs_context = new SrsThreadContext();
+
+    if ((err = run()) != srs_success) {
+        printf("run failed, %s\n", srs_error_desc(err).c_str());
+        srs_freep(err);
+        exit(-1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,339 @@
+/*
+The benchmark for the SRT event loop, to compare the latency and idle CPU of the sleep mode, which polls the SRT
+epoll every 1~10ms in a coroutine, and the thread mode, which waits for the SRT events in a thread and wakes up
+ST by a pipe.
+
+Build:
+    make
+Run the sleep mode and thread mode, with 100 idle connections, then ping 1000 times every 10ms:
+    ./poller -m sleep -n 100 -c 1000 -i 10 -t 5
+    ./poller -m thread -n 100 -c 1000 -i 10 -t 5
+*/
+#include <st.h>
+#include <srt/srt.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+int64_t update_system_time()
+{
+    timeval now;
+    ::gettimeofday(&now, NULL);
+    return ((int64_t)now.tv_sec) * 1000 * 1000 + (int64_t)now.tv_usec;
+}
+
+int64_t cpu_time()
+{
+    rusage ru;
+    ::getrusage(RUSAGE_SELF, &ru);
+    return ((int64_t)ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000 * 1000 + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+struct Options {
+    // The mode of event loop, sleep or thread.
+    string mode;
+    int port;
+    // The number of idle connections.
+    int idles;
+    // The number of pings, and the interval in ms.
+    int count;
+    int interval;
+    // The seconds to measure the idle CPU.
+    int seconds;
+};
+
+Options opts;
+
+// The SRT epoll, and the waiting coroutines of sockets.
+int eid = -1;
+map<SRTSOCKET, st_cond_t> waiters;
+
+// For thread mode, the coroutine writes to ready pipe, and the thread writes to wake pipe.
+int ready_pipe[2];
+int wake_pipe[2];
+
+// Wait for the events of socket, return 0 if fired.
+int wait_event(SRTSOCKET fd, int events, st_utime_t timeout)
+{
+    st_cond_t cond = st_cond_new();
+    waiters[fd] = cond;
+
+    events |= SRT_EPOLL_ERR;
+    srt_epoll_add_usock(eid, fd, &events);
+    int r0 = st_cond_timedwait(cond, timeout);
+    srt_epoll_remove_usock(eid, fd);
+
+    waiters.erase(fd);
+    st_cond_destroy(cond);
+    return r0;
+}
+
+// Notify the fired sockets, return the number of fired sockets.
+int dispatch()
+{
+    SRT_EPOLL_EVENT events[1024];
+    int n = srt_epoll_uwait(eid, events, 1024, 0);
+    for (int i = 0; i < n; i++) {
+        map<SRTSOCKET, st_cond_t>::iterator it = waiters.find(events[i].fd);
+        if (it != waiters.end()) {
+            st_cond_signal(it->second);
+        }
+    }
+    return n;
+}
+
+void* loop_sleep(void* arg)
+{
+    while (true) {
+        int n = dispatch();
+        st_usleep((n > 0 ? 1 : 10) * 1000);
+    }
+    return NULL;
+}
+
+void* poller_thread(void* arg)
+{
+    while (true) {
+        char c = 0;
+        if (::read(ready_pipe[0], &c, 1) <= 0) {
+            continue;
+        }
+        while (srt_epoll_uwait(eid, NULL, 0, -1) == 0) {
+        }
+        if (::write(wake_pipe[1], &c, 1) <= 0) {
+            continue;
+        }
+    }
+    return NULL;
+}
+
+void* loop_thread(void* arg)
+{
+    st_netfd_t wake = st_netfd_open(wake_pipe[0]);
+    while (true) {
+        char c = 0;
+        if (::write(ready_pipe[1], &c, 1) <= 0) {
+            break;
+        }
+        char buf[128];
+        if (st_read(wake, buf, sizeof(buf), ST_UTIME_NO_TIMEOUT) <= 0) {
+            break;
+        }
+        dispatch();
+        st_usleep(0);
+    }
+    return NULL;
+}
+
+SRTSOCKET create_socket()
+{
+    SRTSOCKET fd = srt_create_socket();
+    bool v = false;
+    srt_setsockflag(fd, SRTO_SNDSYN, &v, sizeof(v));
+    srt_setsockflag(fd, SRTO_RCVSYN, &v, sizeof(v));
+    // Disable the timestamp based delivery, which delays packets by the latency, to measure the event loop.
+    srt_setsockflag(fd, SRTO_TSBPDMODE, &v, sizeof(v));
+    return fd;
+}
+
+SRTSOCKET do_connect()
+{
+    SRTSOCKET fd = create_socket();
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opts.port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    if (srt_connect(fd, (sockaddr*)&addr, sizeof(addr)) == SRT_ERROR) {
+        srt_close(fd);
+        return SRT_INVALID_SOCK;
+    }
+    if (wait_event(fd, SRT_EPOLL_OUT, 3 * 1000 * 1000) != 0 || srt_getsockstate(fd) != SRTS_CONNECTED) {
+        srt_close(fd);
+        return SRT_INVALID_SOCK;
+    }
+    return fd;
+}
+
+void* echo(void* arg)
+{
+    SRTSOCKET fd = (SRTSOCKET)(uint64_t)arg;
+    char buf[1500];
+    while (true) {
+        int nn = srt_recvmsg(fd, buf, sizeof(buf));
+        if (nn == SRT_ERROR && srt_getlasterror(NULL) == SRT_EASYNCRCV) {
+            wait_event(fd, SRT_EPOLL_IN, ST_UTIME_NO_TIMEOUT);
+            continue;
+        }
+        if (nn <= 0 || srt_sendmsg(fd, buf, nn, -1, true) == SRT_ERROR) {
+            break;
+        }
+    }
+    srt_close(fd);
+    return NULL;
+}
+
+void* server(void* arg)
+{
+    SRTSOCKET lfd = (SRTSOCKET)(uint64_t)arg;
+    while (true) {
+        SRTSOCKET fd = srt_accept(lfd, NULL, NULL);
+        if (fd == SRT_INVALID_SOCK) {
+            wait_event(lfd, SRT_EPOLL_IN, ST_UTIME_NO_TIMEOUT);
+            continue;
+        }
+        st_thread_create(echo, (void*)(uint64_t)fd, 0, 0);
+    }
+    return NULL;
+}
+
+void usage(char** argv)
+{
+    printf("Usage: %s [-m sleep|thread] [-p port] [-n idles] [-c count] [-i interval] [-t seconds]\n", argv[0]);
+    printf("    -m  The mode of event loop, default thread\n");
+    printf("    -p  The SRT listen port, default 10090\n");
+    printf("    -n  The number of idle connections, default 100\n");
+    printf("    -c  The number of pings, default 1000\n");
+    printf("    -i  The interval of pings in ms, default 10\n");
+    printf("    -t  The seconds to measure idle CPU, default 5\n");
+}
+
+int main(int argc, char** argv)
+{
+    opts.mode = "thread";
+    opts.port = 10090;
+    opts.idles = 100;
+    opts.count = 1000;
+    opts.interval = 10;
+    opts.seconds = 5;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:p:n:c:i:t:h")) != -1) {
+        switch (opt) {
+            case 'm': opts.mode = optarg; break;
+            case 'p': opts.port = atoi(optarg); break;
+            case 'n': opts.idles = atoi(optarg); break;
+            case 'c': opts.count = atoi(optarg); break;
+            case 'i': opts.interval = atoi(optarg); break;
+            case 't': opts.seconds = atoi(optarg); break;
+            default: usage(argv); exit(-1);
+        }
+    }
+    if ((opts.mode != "sleep" && opts.mode != "thread") || opts.count <= 0 || opts.idles < 0) {
+        usage(argv);
+        exit(-1);
+    }
+
+    if (st_set_eventsys(ST_EVENTSYS_ALT) == -1 || st_init() != 0 || srt_startup() < 0) {
+        printf("init st or srt failed\n");
+        exit(-1);
+    }
+    srt_setloglevel(LOG_CRIT);
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    eid = srt_epoll_create();
+    srt_epoll_set(eid, SRT_EPOLL_ENABLE_EMPTY);
+
+    if (opts.mode == "thread") {
+        pthread_t trd;
+        if (::pipe(ready_pipe) < 0 || ::pipe(wake_pipe) < 0 || pthread_create(&trd, NULL, poller_thread, NULL) != 0) {
+            printf("create thread failed\n");
+            exit(-1);
+        }
+        st_thread_create(loop_thread, NULL, 0, 0);
+    } else {
+        st_thread_create(loop_sleep, NULL, 0, 0);
+    }
+
+    SRTSOCKET lfd = create_socket();
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opts.port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (srt_bind(lfd, (sockaddr*)&addr, sizeof(addr)) == SRT_ERROR || srt_listen(lfd, 1024) == SRT_ERROR) {
+        printf("listen port %d failed, %s\n", opts.port, srt_getlasterror_str());
+        exit(-1);
+    }
+    st_thread_create(server, (void*)(uint64_t)lfd, 0, 0);
+
+    // The idle connections, wait for data which never comes.
+    vector<SRTSOCKET> idles;
+    for (int i = 0; i < opts.idles; i++) {
+        SRTSOCKET fd = do_connect();
+        if (fd == SRT_INVALID_SOCK) {
+            printf("connect #%d failed\n", i);
+            exit(-1);
+        }
+        idles.push_back(fd);
+        st_thread_create(echo, (void*)(uint64_t)fd, 0, 0);
+    }
+
+    SRTSOCKET fd = do_connect();
+    if (fd == SRT_INVALID_SOCK) {
+        printf("connect failed\n");
+        exit(-1);
+    }
+    printf("mode=%s, idles=%d, count=%d, interval=%dms\n", opts.mode.c_str(), opts.idles, opts.count, opts.interval);
+
+    // Measure the CPU when all connections are idle.
+    int64_t starttime = update_system_time();
+    int64_t startcpu = cpu_time();
+    st_usleep((st_utime_t)opts.seconds * 1000 * 1000);
+    double idle_cpu = (cpu_time() - startcpu) * 100.0 / (update_system_time() - starttime);
+    printf("idle cpu=%.2f%%\n", idle_cpu);
+
+    // Measure the RTT of ping-pong.
+    vector<int64_t> rtts;
+    starttime = update_system_time();
+    startcpu = cpu_time();
+    for (int i = 0; i < opts.count; i++) {
+        int64_t now = update_system_time();
+        if (srt_sendmsg(fd, (char*)&now, sizeof(now), -1, true) == SRT_ERROR) {
+            printf("send failed, %s\n", srt_getlasterror_str());
+            exit(-1);
+        }
+
+        char buf[1500];
+        while (srt_recvmsg(fd, buf, sizeof(buf)) == SRT_ERROR) {
+            if (srt_getlasterror(NULL) != SRT_EASYNCRCV || wait_event(fd, SRT_EPOLL_IN, 3 * 1000 * 1000) != 0) {
+                printf("recv failed, %s\n", srt_getlasterror_str());
+                exit(-1);
+            }
+        }
+        int64_t v = 0;
+        memcpy(&v, buf, sizeof(v));
+        rtts.push_back(update_system_time() - v);
+
+        if (opts.interval > 0) {
+            st_usleep(opts.interval * 1000);
+        }
+    }
+    double ping_cpu = (cpu_time() - startcpu) * 100.0 / (update_system_time() - starttime);
+
+    std::sort(rtts.begin(), rtts.end());
+    int64_t sum = 0;
+    for (int i = 0; i < (int)rtts.size(); i++) {
+        sum += rtts[i];
+    }
+    printf("rtt avg=%.2fms, p50=%.2fms, p99=%.2fms, max=%.2fms, cpu=%.2f%%\n", sum / 1000.0 / rtts.size(),
+        rtts[rtts.size() / 2] / 1000.0, rtts[rtts.size() * 99 / 100] / 1000.0, rtts.back() / 1000.0, ping_cpu);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+The benchmark for SRTP protect of 1200 bytes RTP packets in one core, one by one or in a batch,
+see SrsSRTP::protect_rtps and SrsRtcConnection::begin_batch.
+
+Build:
+    make
+    make LDFLAGS=-lcrypto # If libsrtp is built with openssl, by --srtp-nasm=on
+Run:
+    ./srtp -n 64 -l 1000
+    ./srtp -n 64 -l 1000 -g # For AEAD_AES_128_GCM, requires libsrtp with openssl.
+*/
+#include <srtp2/srtp.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <getopt.h>
+
+int64_t update_system_time()
+{
+    timeval now;
+    ::gettimeofday(&now, NULL);
+    return ((int64_t)now.tv_sec) * 1000 * 1000 + (int64_t)now.tv_usec;
+}
+
+// Build RTP packets of 1200 bytes, in buffers large enough for the SRTP trailer.
+void mock_packets(char* bufs, int nn_buf, iovec* iovs, int nn_iovs)
+{
+    for (int i = 0; i < nn_iovs; i++) {
+        char* p = bufs + i * nn_buf;
+        memset(p, i, nn_buf);
+
+        p[0] = (char)0x80;
+        p[1] = 111;
+        p[2] = (char)((100 + i) >> 8); p[3] = (char)(100 + i);
+        p[8] = 0x01; p[9] = 0x02; p[10] = 0x03; p[11] = 0x04;
+
+        iovs[i].iov_base = p;
+        iovs[i].iov_len = 1200;
+    }
+}
+
+int protect_rtps(srtp_t ctx, iovec* iovs, int nn_iovs)
+{
+    for (int i = 0; i < nn_iovs; i++) {
+        int nb_cipher = (int)iovs[i].iov_len;
+        if (srtp_protect(ctx, iovs[i].iov_base, &nb_cipher) != srtp_err_status_ok) {
+            return -1;
+        }
+        iovs[i].iov_len = nb_cipher;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int nn_iovs = 64, nn_loops = 1000;
+    bool gcm = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l:g")) != -1) {
+        switch (opt) {
+            case 'n': nn_iovs = atoi(optarg); break;
+            case 'l': nn_loops = atoi(optarg); break;
+            case 'g': gcm = true; break;
+            default: printf("Usage: %s [-n packets] [-l loops] [-g]\n", argv[0]); exit(-1);
+        }
+    }
+
+    if (srtp_init() != srtp_err_status_ok) {
+        printf("srtp init failed\n");
+        exit(-1);
+    }
+
+    srtp_policy_t policy;
+    memset(&policy, 0, sizeof(policy));
+    if (gcm) {
+        srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy.rtp);
+        srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy.rtcp);
+    } else {
+        srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtp);
+        srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtcp);
+    }
+
+    uint8_t key[30];
+    memset(key, 'k', sizeof(key));
+    policy.key = key;
+    policy.ssrc.type = ssrc_any_outbound;
+    policy.window_size = 8192;
+    policy.allow_repeat_tx = 1;
+
+    srtp_t ctx = NULL;
+    if (srtp_create(&ctx, &policy) != srtp_err_status_ok) {
+        printf("srtp create failed, gcm=%d\n", gcm);
+        exit(-1);
+    }
+
+    const int nn_buf = 1500;
+    char* bufs = new char[nn_iovs * nn_buf];
+    iovec* iovs = new iovec[nn_iovs];
+
+    // Protect packet one by one.
+    int64_t starttime = update_system_time();
+    for (int i = 0; i < nn_loops; i++) {
+        mock_packets(bufs, nn_buf, iovs, nn_iovs);
+        for (int j = 0; j < nn_iovs; j++) {
+            if (protect_rtps(ctx, iovs + j, 1) != 0) {
+                printf("protect failed\n");
+                exit(-1);
+            }
+        }
+    }
+    int64_t single = update_system_time() - starttime;
+    single = single > 0 ? single : 1;
+
+    // Protect packets in batch.
+    starttime = update_system_time();
+    for (int i = 0; i < nn_loops; i++) {
+        mock_packets(bufs, nn_buf, iovs, nn_iovs);
+        if (protect_rtps(ctx, iovs, nn_iovs) != 0) {
+            printf("protect failed\n");
+            exit(-1);
+        }
+    }
+    int64_t batch = update_system_time() - starttime;
+    batch = batch > 0 ? batch : 1;
+
+    int64_t nn_packets = (int64_t)nn_loops * nn_iovs;
+    printf("SRTP %s: %d packets of 1200B, single %.1fMbps %dpps, batch %.1fMbps %dpps\n",
+        (gcm ? "AEAD_AES_128_GCM" : "AES128_CM_SHA1_80"), (int)nn_packets,
+        nn_packets * 1200 * 8.0 / single, (int)(nn_packets * 1000000LL / single),
+        nn_packets * 1200 * 8.0 / batch, (int)(nn_packets * 1000000LL / batch));
+
+    srtp_dealloc(ctx);
+    delete[] bufs;
+    delete[] iovs;
+
+    return 0;
+}
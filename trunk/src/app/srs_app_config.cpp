@@ -58,6 +58,9 @@ const char* _srs_version = "XCORE-" RTMP_SIG_SRS_SERVER;
 // '\r'
 #define SRS_CR (char)SRS_CONSTS_CR
 
+// The number of changed vhosts to reload before yield, to bound the stall of event loop.
+#define SRS_CONF_RELOAD_VHOSTS_PER_YIELD 8
+
 // Overwrite the config by env.
 #define SRS_OVERWRITE_BY_ENV_STRING(key) if (!srs_getenv(key).empty()) return srs_getenv(key)
 #define SRS_OVERWRITE_BY_ENV_BOOL(key) if (!srs_getenv(key).empty()) return SRS_CONF_PERFER_FALSE(srs_getenv(key))
@@ -228,6 +231,55 @@ bool srs_directive_equals(SrsConfDirective* a, SrsConfDirective* b, string excep
     return true;
 }
 
+// FNV-1a hash of the bytes, see https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
+uint64_t srs_fnv1a(const std::string& v, uint64_t hash)
+{
+    for (int i = 0; i < (int)v.length(); i++) {
+        hash ^= (uint8_t)v.at(i);
+        hash *= 0x100000001b3ULL;
+    }
+
+    // Hash the terminator, so that the args "ab" "c" never equals to "a" "bc".
+    hash ^= 0xff;
+    hash *= 0x100000001b3ULL;
+
+    return hash;
+}
+
+uint64_t srs_directive_fingerprint(SrsConfDirective* conf, uint64_t previous)
+{
+    uint64_t hash = previous ? previous : 0xcbf29ce484222325ULL;
+    if (!conf) {
+        return hash;
+    }
+
+    hash = srs_fnv1a(conf->name, hash);
+    for (int i = 0; i < (int)conf->args.size(); i++) {
+        hash = srs_fnv1a(conf->args.at(i), hash);
+    }
+
+    // Hash the number of args and children, to identify the structure of tree.
+    hash = srs_fnv1a(srs_int2str(conf->args.size()) + "/" + srs_int2str(conf->directives.size()), hash);
+    for (int i = 0; i < (int)conf->directives.size(); i++) {
+        hash = srs_directive_fingerprint(conf->at(i), hash);
+    }
+
+    return hash;
+}
+
+// Get the fingerprint of vhost from snapshot, or calculate it if not compiled.
+uint64_t srs_vhost_fingerprint(SrsConfigSnapshot* snapshot, SrsConfDirective* vhost)
+{
+    if (snapshot) {
+        std::map<std::string, SrsVhostSnapshot*>::iterator it = snapshot->vhosts_.find(vhost->arg0());
+        if (it != snapshot->vhosts_.end() && it->second->vhost_ == vhost) {
+            return it->second->fingerprint_;
+        }
+    }
+
+    return srs_directive_fingerprint(vhost);
+}
+
 void set_config_directive(SrsConfDirective* parent, string dir, string value)
 {
     SrsConfDirective* d = parent->get_or_create(dir);
@@ -1284,9 +1336,54 @@ srs_error_t SrsConfDirective::read_token(SrsConfigBuffer* buffer, vector<string>
     return err;
 }
 
+SrsVhostSnapshot::SrsVhostSnapshot(SrsConfDirective* vhost)
+{
+    vhost_ = vhost;
+    fingerprint_ = srs_directive_fingerprint(vhost);
+
+    enabled_ = false;
+    is_edge_ = false;
+    refer_enabled_ = false;
+    tcp_nodelay_ = false;
+    realtime_enabled_ = false;
+    mw_sleep_ = 0;
+    mw_msgs_ = 0;
+    mw_msgs_realtime_ = 0;
+    send_min_interval_ = 0;
+    gop_cache_ = false;
+    gop_cache_max_frames_ = 0;
+    queue_length_ = 0;
+    atc_ = false;
+    time_jitter_ = 0;
+    mix_correct_ = false;
+    try_annexb_first_ = false;
+    reduce_sequence_header_ = false;
+}
+
+SrsVhostSnapshot::~SrsVhostSnapshot()
+{
+}
+
+SrsConfigSnapshot::SrsConfigSnapshot()
+{
+    default_ = NULL;
+}
+
+SrsConfigSnapshot::~SrsConfigSnapshot()
+{
+    std::map<std::string, SrsVhostSnapshot*>::iterator it;
+    for (it = vhosts_.begin(); it != vhosts_.end(); ++it) {
+        SrsVhostSnapshot* vhost = it->second;
+        srs_freep(vhost);
+    }
+
+    srs_freep(default_);
+}
+
 SrsConfig::SrsConfig()
 {
     env_only_ = false;
+    snapshot_ = NULL;
     
     show_help = false;
     show_version = false;
@@ -1300,6 +1397,7 @@ SrsConfig::SrsConfig()
 
 SrsConfig::~SrsConfig()
 {
+    srs_freep(snapshot_);
     srs_freep(root);
 }
 
@@ -1315,16 +1413,56 @@ void SrsConfig::subscribe(ISrsReloadHandler* handler)
     subscribes.push_back(handler);
 }
 
+void SrsConfig::subscribe_vhost(string vhost, ISrsReloadHandler* handler)
+{
+    std::vector<ISrsReloadHandler*>& handlers = vhost_subscribes_[vhost];
+
+    std::vector<ISrsReloadHandler*>::iterator it = std::find(handlers.begin(), handlers.end(), handler);
+    if (it != handlers.end()) {
+        return;
+    }
+
+    handlers.push_back(handler);
+}
+
 void SrsConfig::unsubscribe(ISrsReloadHandler* handler)
 {
     std::vector<ISrsReloadHandler*>::iterator it;
     
     it = std::find(subscribes.begin(), subscribes.end(), handler);
-    if (it == subscribes.end()) {
+    if (it != subscribes.end()) {
+        it = subscribes.erase(it);
         return;
     }
-    
-    it = subscribes.erase(it);
+
+    // Search the vhost subscribers, which only exists for the vhost with streams.
+    std::map<std::string, std::vector<ISrsReloadHandler*> >::iterator it2;
+    for (it2 = vhost_subscribes_.begin(); it2 != vhost_subscribes_.end(); ++it2) {
+        std::vector<ISrsReloadHandler*>& handlers = it2->second;
+
+        it = std::find(handlers.begin(), handlers.end(), handler);
+        if (it == handlers.end()) {
+            continue;
+        }
+
+        handlers.erase(it);
+        if (handlers.empty()) {
+            vhost_subscribes_.erase(it2);
+        }
+        return;
+    }
+}
+
+std::vector<ISrsReloadHandler*> SrsConfig::get_vhost_subscribes(string vhost)
+{
+    std::vector<ISrsReloadHandler*> handlers = subscribes;
+
+    std::map<std::string, std::vector<ISrsReloadHandler*> >::iterator it = vhost_subscribes_.find(vhost);
+    if (it != vhost_subscribes_.end()) {
+        handlers.insert(handlers.end(), it->second.begin(), it->second.end());
+    }
+
+    return handlers;
 }
 
 // LCOV_EXCL_START
@@ -1356,7 +1494,7 @@ srs_error_t SrsConfig::reload()
 }
 // LCOV_EXCL_STOP
 
-srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
+srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root, SrsConfigSnapshot* old_snapshot)
 {
     srs_error_t err = srs_success;
     
@@ -1393,11 +1531,29 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
     }
     
     // process each vhost
+    int nn_changed = 0;
     for (int i = 0; i < (int)vhosts.size(); i++) {
         std::string vhost = vhosts.at(i);
         
         SrsConfDirective* old_vhost = old_root->get("vhost", vhost);
         SrsConfDirective* new_vhost = root->get("vhost", vhost);
+
+        // Skip the unchanged vhost by fingerprint, without diff and notify the subscribers. Because the fingerprint
+        // might collide, we confirm it by comparing the directives, which is only done for the unchanged vhosts.
+        if (old_vhost && new_vhost && srs_vhost_fingerprint(old_snapshot, old_vhost) == srs_vhost_fingerprint(snapshot_, new_vhost)
+            && srs_directive_equals(old_vhost, new_vhost)) {
+            continue;
+        }
+
+        // Yield for each chunk of changed vhosts, because the subscribers might restart the components of streams,
+        // which stalls other coroutines for a long time if lots of vhosts changed.
+        if (nn_changed > 0 && (nn_changed % SRS_CONF_RELOAD_VHOSTS_PER_YIELD) == 0) {
+            srs_thread_yield();
+        }
+        nn_changed++;
+
+        // Only notify the global subscribers and the subscribers of this vhost.
+        std::vector<ISrsReloadHandler*> handlers = get_vhost_subscribes(vhost);
         
         //      DISABLED    =>  ENABLED
         if (!get_vhost_enabled(old_vhost) && get_vhost_enabled(new_vhost)) {
@@ -1434,7 +1590,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             srs_trace("vhost %s maybe modified, reload its detail.", vhost.c_str());
             // chunk_size, only one per vhost.
             if (!srs_directive_equals(new_vhost->get("chunk_size"), old_vhost->get("chunk_size"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_chunk_size(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes chunk_size failed", vhost.c_str());
@@ -1445,7 +1601,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // tcp_nodelay, only one per vhost
             if (!srs_directive_equals(new_vhost->get("tcp_nodelay"), old_vhost->get("tcp_nodelay"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_tcp_nodelay(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes tcp_nodelay failed", vhost.c_str());
@@ -1456,7 +1612,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // min_latency, only one per vhost
             if (!srs_directive_equals(new_vhost->get("min_latency"), old_vhost->get("min_latency"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_realtime(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes min_latency failed", vhost.c_str());
@@ -1467,7 +1623,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // play, only one per vhost
             if (!srs_directive_equals(new_vhost->get("play"), old_vhost->get("play"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_play(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes play failed", vhost.c_str());
@@ -1478,7 +1634,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // forward, only one per vhost
             if (!srs_directive_equals(new_vhost->get("forward"), old_vhost->get("forward"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_forward(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes forward failed", vhost.c_str());
@@ -1489,7 +1645,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // To reload DASH.
             if (!srs_directive_equals(new_vhost->get("dash"), old_vhost->get("dash"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_dash(vhost)) != srs_success) {
                         return srs_error_wrap(err, "Reload vhost %s dash failed", vhost.c_str());
@@ -1501,7 +1657,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             // hls, only one per vhost
             // @remark, the hls_on_error directly support reload.
             if (!srs_directive_equals(new_vhost->get("hls"), old_vhost->get("hls"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_hls(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes hls failed", vhost.c_str());
@@ -1512,7 +1668,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // hds reload
             if (!srs_directive_equals(new_vhost->get("hds"), old_vhost->get("hds"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_hds(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes hds failed", vhost.c_str());
@@ -1523,7 +1679,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // dvr, only one per vhost, except the dvr_apply
             if (!srs_directive_equals(new_vhost->get("dvr"), old_vhost->get("dvr"), "dvr_apply")) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_dvr(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes dvr failed", vhost.c_str());
@@ -1534,7 +1690,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // exec, only one per vhost
             if (!srs_directive_equals(new_vhost->get("exec"), old_vhost->get("exec"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_exec(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes exec failed", vhost.c_str());
@@ -1545,7 +1701,7 @@ srs_error_t SrsConfig::reload_vhost(SrsConfDirective* old_root)
             
             // publish, only one per vhost
             if (!srs_directive_equals(new_vhost->get("publish"), old_vhost->get("publish"))) {
-                for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+                for (it = handlers.begin(); it != handlers.end(); ++it) {
                     ISrsReloadHandler* subscribe = *it;
                     if ((err = subscribe->on_reload_vhost_publish(vhost)) != srs_success) {
                         return srs_error_wrap(err, "vhost %s notify subscribes publish failed", vhost.c_str());
@@ -1578,9 +1734,17 @@ srs_error_t SrsConfig::reload_conf(SrsConfig* conf)
     
     SrsConfDirective* old_root = root;
     SrsAutoFree(SrsConfDirective, old_root);
+
+    // Keep the old snapshot, which has the fingerprints of old vhosts.
+    SrsConfigSnapshot* old_snapshot = snapshot_;
+    SrsAutoFree(SrsConfigSnapshot, old_snapshot);
+    snapshot_ = NULL;
     
     root = conf->root;
     conf->root = NULL;
+
+    // Compile the new root before notify the handlers, which use the getters.
+    compile_snapshot();
     
     // never support reload:
     //      daemon
@@ -1619,7 +1783,7 @@ srs_error_t SrsConfig::reload_conf(SrsConfig* conf)
     // TODO: FIXME: support reload stream_caster.
     
     // merge config: vhost
-    if ((err = reload_vhost(old_root)) != srs_success) {
+    if ((err = reload_vhost(old_root, old_snapshot)) != srs_success) {
         return srs_error_wrap(err, "vhost");;
     }
     
@@ -1731,7 +1895,8 @@ srs_error_t SrsConfig::reload_transcode(SrsConfDirective* new_vhost, SrsConfDire
     
     // transcode, many per vhost
     if (changed) {
-        for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+        std::vector<ISrsReloadHandler*> handlers = get_vhost_subscribes(vhost);
+        for (it = handlers.begin(); it != handlers.end(); ++it) {
             ISrsReloadHandler* subscribe = *it;
             if ((err = subscribe->on_reload_vhost_transcode(vhost)) != srs_success) {
                 return srs_error_wrap(err, "vhost %s notify subscribes transcode failed", vhost.c_str());
@@ -1938,6 +2103,8 @@ srs_error_t SrsConfig::parse_options(int argc, char** argv)
             srs_trace("write log to console");
         }
     }
+
+    compile_snapshot();
     
     return err;
 }
@@ -2068,8 +2235,9 @@ srs_error_t SrsConfig::do_reload_vhost_added(string vhost)
     
     srs_trace("vhost %s added, reload it.", vhost.c_str());
     
+    vector<ISrsReloadHandler*> handlers = get_vhost_subscribes(vhost);
     vector<ISrsReloadHandler*>::iterator it;
-    for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+    for (it = handlers.begin(); it != handlers.end(); ++it) {
         ISrsReloadHandler* subscribe = *it;
         if ((err = subscribe->on_reload_vhost_added(vhost)) != srs_success) {
             return srs_error_wrap(err, "notify subscribes added vhost %s failed", vhost.c_str());
@@ -2087,8 +2255,9 @@ srs_error_t SrsConfig::do_reload_vhost_removed(string vhost)
     
     srs_trace("vhost %s removed, reload it.", vhost.c_str());
     
+    vector<ISrsReloadHandler*> handlers = get_vhost_subscribes(vhost);
     vector<ISrsReloadHandler*>::iterator it;
-    for (it = subscribes.begin(); it != subscribes.end(); ++it) {
+    for (it = handlers.begin(); it != handlers.end(); ++it) {
         ISrsReloadHandler* subscribe = *it;
         if ((err = subscribe->on_reload_vhost_removed(vhost)) != srs_success) {
             return srs_error_wrap(err, "notify subscribes removed vhost %s failed", vhost.c_str());
@@ -2244,6 +2413,68 @@ srs_error_t SrsConfig::check_config()
     return err;
 }
 
+void SrsConfig::compile_snapshot()
+{
+    // Free the stale snapshot first, so that the getters use the directives when compiling.
+    srs_freep(snapshot_);
+
+    SrsConfigSnapshot* snapshot = new SrsConfigSnapshot();
+    for (int i = 0; i < (int)root->directives.size(); i++) {
+        SrsConfDirective* conf = root->at(i);
+        if (conf->is_vhost() && snapshot->vhosts_.find(conf->arg0()) == snapshot->vhosts_.end()) {
+            snapshot->vhosts_[conf->arg0()] = new SrsVhostSnapshot(conf);
+        }
+    }
+
+    // The get_vhost uses the vhosts of snapshot, while other getters use the directives before default_ is set.
+    snapshot_ = snapshot;
+
+    std::map<std::string, SrsVhostSnapshot*>::iterator it;
+    for (it = snapshot->vhosts_.begin(); it != snapshot->vhosts_.end(); ++it) {
+        compile_vhost(it->first, it->second);
+    }
+
+    // For the vhost not found, which uses the default vhost, or the default values if no default vhost.
+    SrsVhostSnapshot* default_vhost = new SrsVhostSnapshot(get_vhost(SRS_CONSTS_RTMP_DEFAULT_VHOST));
+    compile_vhost(SRS_CONSTS_RTMP_DEFAULT_VHOST, default_vhost);
+    snapshot->default_ = default_vhost;
+}
+
+SrsVhostSnapshot* SrsConfig::get_vhost_snapshot(const string& vhost)
+{
+    if (!snapshot_ || !snapshot_->default_) {
+        return NULL;
+    }
+
+    std::map<std::string, SrsVhostSnapshot*>::iterator it = snapshot_->vhosts_.find(vhost);
+    if (it != snapshot_->vhosts_.end()) {
+        return it->second;
+    }
+
+    return snapshot_->default_;
+}
+
+void SrsConfig::compile_vhost(string vhost, SrsVhostSnapshot* snapshot)
+{
+    snapshot->enabled_ = get_vhost_enabled(vhost);
+    snapshot->is_edge_ = get_vhost_is_edge(vhost);
+    snapshot->refer_enabled_ = get_refer_enabled(vhost);
+    snapshot->tcp_nodelay_ = get_tcp_nodelay(vhost);
+    snapshot->realtime_enabled_ = get_realtime_enabled(vhost);
+    snapshot->mw_sleep_ = get_mw_sleep(vhost);
+    snapshot->mw_msgs_ = get_mw_msgs(vhost, false);
+    snapshot->mw_msgs_realtime_ = get_mw_msgs(vhost, true);
+    snapshot->send_min_interval_ = get_send_min_interval(vhost);
+    snapshot->gop_cache_ = get_gop_cache(vhost);
+    snapshot->gop_cache_max_frames_ = get_gop_cache_max_frames(vhost);
+    snapshot->queue_length_ = get_queue_length(vhost);
+    snapshot->atc_ = get_atc(vhost);
+    snapshot->time_jitter_ = get_time_jitter(vhost);
+    snapshot->mix_correct_ = get_mix_correct(vhost);
+    snapshot->try_annexb_first_ = try_annexb_first(vhost);
+    snapshot->reduce_sequence_header_ = get_reduce_sequence_header(vhost);
+}
+
 srs_error_t SrsConfig::check_normal_config()
 {
     srs_error_t err = srs_success;
@@ -2274,7 +2505,7 @@ srs_error_t SrsConfig::check_normal_config()
             && n != "inotify_auto_reload" && n != "auto_reload_for_docker" && n != "tcmalloc_release_rate"
             && n != "query_latest_version" && n != "first_wait_for_qlv" && n != "threads"
             && n != "circuit_breaker" && n != "is_full" && n != "in_docker" && n != "tencentcloud_cls"
-            && n != "exporter"
+            && n != "exporter" && n != "delivery"
             ) {
             return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal directive %s", n.c_str());
         }
@@ -2284,9 +2515,18 @@ srs_error_t SrsConfig::check_normal_config()
         for (int i = 0; conf && i < (int)conf->directives.size(); i++) {
             SrsConfDirective* obj = conf->at(i);
             string n = obj->name;
-            if (n != "enabled" && n != "listen" && n != "crossdomain" && n != "raw_api" && n != "https") {
+            if (n != "enabled" && n != "listen" && n != "crossdomain" && n != "raw_api" && n != "https" && n != "auth") {
                 return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal http_api.%s", n.c_str());
             }
+
+            if (n == "auth") {
+                for (int j = 0; j < (int)obj->directives.size(); j++) {
+                    string m = obj->at(j)->name;
+                    if (m != "enabled" && m != "username" && m != "password") {
+                        return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal http_api.auth.%s", m.c_str());
+                    }
+                }
+            }
             
             if (n == "raw_api") {
                 for (int j = 0; j < (int)obj->directives.size(); j++) {
@@ -2316,11 +2556,21 @@ srs_error_t SrsConfig::check_normal_config()
                 && n != "peerlatency" && n != "connect_timeout"
                 && n != "sendbuf" && n != "recvbuf" && n != "payloadsize"
                 && n != "default_app" && n != "sei_filter" && n != "mix_correct"
-                && n != "tlpktdrop" && n != "tsbpdmode" && n != "passphrase" && n != "pbkeylen") {
+                && n != "tlpktdrop" && n != "tsbpdmode" && n != "passphrase" && n != "pbkeylen"
+                && n != "poller_thread" && n != "workers") {
                 return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal srt_server.%s", n.c_str());
             }
         }
     }
+    if (true) {
+        SrsConfDirective* conf = root->get("delivery");
+        for (int i = 0; conf && i < (int)conf->directives.size(); i++) {
+            string n = conf->at(i)->name;
+            if (n != "enabled" && n != "workers" && n != "players") {
+                return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal delivery.%s", n.c_str());
+            }
+        }
+    }
     if (true) {
         SrsConfDirective* conf = get_heartbeart();
         for (int i = 0; conf && i < (int)conf->directives.size(); i++) {
@@ -2347,7 +2597,8 @@ srs_error_t SrsConfig::check_normal_config()
             if (n != "enabled" && n != "listen" && n != "dir" && n != "candidate" && n != "ecdsa" && n != "tcp"
                 && n != "encrypt" && n != "reuseport" && n != "merge_nalus" && n != "black_hole" && n != "protocol"
                 && n != "ip_family" && n != "api_as_candidates" && n != "resolve_api_domain"
-                && n != "keep_api_domain" && n != "use_auto_detect_network_ip") {
+                && n != "keep_api_domain" && n != "use_auto_detect_network_ip" && n != "dtls_workers" && n != "dtls_rate"
+                && n != "srtp_gcm") {
                 return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal rtc_server.%s", n.c_str());
             }
         }
@@ -2543,7 +2794,7 @@ srs_error_t SrsConfig::check_normal_config()
                     string m = conf->at(j)->name;
                     if (m != "time_jitter" && m != "mix_correct" && m != "atc" && m != "atc_auto" && m != "mw_latency"
                         && m != "gop_cache" && m != "gop_cache_max_frames" && m != "queue_length" && m != "send_min_interval" && m != "reduce_sequence_header"
-                        && m != "mw_msgs") {
+                        && m != "mw_msgs" && m != "mw_adaptive") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.play.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
@@ -2551,14 +2802,15 @@ srs_error_t SrsConfig::check_normal_config()
                 for (int j = 0; j < (int)conf->directives.size(); j++) {
                     string m = conf->at(j)->name;
                     if (m != "mode" && m != "origin" && m != "token_traverse" && m != "vhost" && m != "debug_srs_upnode" && m != "coworkers"
-                        && m != "origin_cluster" && m != "protocol" && m != "follow_client") {
+                        && m != "origin_cluster" && m != "protocol" && m != "follow_client" && m != "balance"
+                        && m != "hls_edge" && m != "hls_origin" && m != "hls_ttl" && m != "hls_cache") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.cluster.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
             } else if (n == "publish") {
                 for (int j = 0; j < (int)conf->directives.size(); j++) {
                     string m = conf->at(j)->name;
-                    if (m != "mr" && m != "mr_latency" && m != "firstpkt_timeout" && m != "normal_timeout"
+                    if (m != "mr" && m != "mr_latency" && m != "mr_adaptive" && m != "firstpkt_timeout" && m != "normal_timeout"
                         && m != "parse_sps" && m != "try_annexb_first" && m != "kickoff_for_idle") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.publish.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
@@ -2581,7 +2833,7 @@ srs_error_t SrsConfig::check_normal_config()
                 for (int j = 0; j < (int)conf->directives.size(); j++) {
                     string m = conf->at(j)->name;
                     if (m != "enabled" && m != "mount" && m != "fast_cache" && m != "drop_if_not_match"
-                        && m != "has_audio" && m != "has_video" && m != "guess_has_av") {
+                        && m != "has_audio" && m != "has_video" && m != "guess_has_av" && m != "shared_mux") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.http_remux.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
@@ -2589,7 +2841,8 @@ srs_error_t SrsConfig::check_normal_config()
                 for (int j = 0; j < (int)conf->directives.size(); j++) {
                     string m = conf->at(j)->name;
                     if (m != "enabled" && m != "dash_fragment" && m != "dash_update_period" && m != "dash_timeshift" && m != "dash_path"
-                        && m != "dash_mpd_file" && m != "dash_window_size" && m != "dash_dispose" && m != "dash_cleanup") {
+                        && m != "dash_mpd_file" && m != "dash_window_size" && m != "dash_dispose" && m != "dash_cleanup"
+                        && m != "dash_hls") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.dash.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
@@ -2600,7 +2853,8 @@ srs_error_t SrsConfig::check_normal_config()
                         && m != "hls_storage" && m != "hls_mount" && m != "hls_td_ratio" && m != "hls_aof_ratio" && m != "hls_acodec" && m != "hls_vcodec"
                         && m != "hls_m3u8_file" && m != "hls_ts_file" && m != "hls_ts_floor" && m != "hls_cleanup" && m != "hls_nb_notify"
                         && m != "hls_wait_keyframe" && m != "hls_dispose" && m != "hls_keys" && m != "hls_fragments_per_key" && m != "hls_key_file"
-                        && m != "hls_key_file_path" && m != "hls_key_url" && m != "hls_dts_directly" && m != "hls_ctx" && m != "hls_ts_ctx") {
+                        && m != "hls_key_file_path" && m != "hls_key_url" && m != "hls_dts_directly" && m != "hls_ctx" && m != "hls_ts_ctx"
+                        && m != "hls_storage" && m != "hls_memory_budget" && m != "hls_ll" && m != "hls_ll_part") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.hls.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                     
@@ -2660,7 +2914,8 @@ srs_error_t SrsConfig::check_normal_config()
                     if (m != "enabled" && m != "nack" && m != "twcc" && m != "nack_no_copy"
                         && m != "bframe" && m != "aac" && m != "stun_timeout" && m != "stun_strict_check"
                         && m != "dtls_role" && m != "dtls_version" && m != "drop_for_pt" && m != "rtc_to_rtmp"
-                        && m != "pli_for_rtmp" && m != "rtmp_to_rtc" && m != "keep_bframe") {
+                        && m != "pli_for_rtmp" && m != "rtmp_to_rtc" && m != "keep_bframe" && m != "fec" && m != "fec_group"
+                        && m != "red" && m != "red_distance") {
                         return srs_error_new(ERROR_SYSTEM_CONFIG_INVALID, "illegal vhost.rtc.%s of %s", m.c_str(), vhost->arg0().c_str());
                     }
                 }
@@ -2812,6 +3067,7 @@ srs_error_t SrsConfig::parse_buffer(SrsConfigBuffer* buffer)
     srs_error_t err = srs_success;
 
     // We use a new root to parse buffer, to allow parse multiple times.
+    srs_freep(snapshot_);
     srs_freep(root);
     root = new SrsConfDirective();
 
@@ -3369,6 +3625,63 @@ int SrsConfig::get_dying_pulse()
     return ::atoi(conf->arg0().c_str());
 }
 
+bool SrsConfig::get_delivery_enabled()
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.delivery.enabled"); // SRS_DELIVERY_ENABLED
+
+    static bool DEFAULT = SRS_PERF_DELIVERY_ENABLED;
+
+    SrsConfDirective* conf = root->get("delivery");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("enabled");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
+int SrsConfig::get_delivery_workers()
+{
+    SRS_OVERWRITE_BY_ENV_INT("srs.delivery.workers"); // SRS_DELIVERY_WORKERS
+
+    static int DEFAULT = SRS_PERF_DELIVERY_WORKERS;
+
+    SrsConfDirective* conf = root->get("delivery");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("workers");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return ::atoi(conf->arg0().c_str());
+}
+
+int SrsConfig::get_delivery_players()
+{
+    SRS_OVERWRITE_BY_ENV_INT("srs.delivery.players"); // SRS_DELIVERY_PLAYERS
+
+    static int DEFAULT = SRS_PERF_DELIVERY_PLAYERS;
+
+    SrsConfDirective* conf = root->get("delivery");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("players");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return ::atoi(conf->arg0().c_str());
+}
+
 bool SrsConfig::get_tencentcloud_cls_enabled()
 {
     SRS_OVERWRITE_BY_ENV_BOOL("srs.tencentcloud_cls.enabled"); // SRS_TENCENTCLOUD_CLS_ENABLED
@@ -4257,6 +4570,69 @@ bool SrsConfig::get_rtc_server_encrypt()
     return SRS_CONF_PERFER_TRUE(conf->arg0());
 }
 
+int SrsConfig::get_rtc_server_dtls_workers()
+{
+    SRS_OVERWRITE_BY_ENV_INT("srs.rtc_server.dtls_workers"); // SRS_RTC_SERVER_DTLS_WORKERS
+
+    static int DEFAULT = 0;
+
+    SrsConfDirective* conf = root->get("rtc_server");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("dtls_workers");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    int v = ::atoi(conf->arg0().c_str());
+    if (v < 0 || v > 64) {
+        srs_warn("Reset dtls_workers %d to %d", v, DEFAULT);
+        return DEFAULT;
+    }
+
+    return v;
+}
+
+int SrsConfig::get_rtc_server_dtls_rate()
+{
+    SRS_OVERWRITE_BY_ENV_INT("srs.rtc_server.dtls_rate"); // SRS_RTC_SERVER_DTLS_RATE
+
+    static int DEFAULT = 0;
+
+    SrsConfDirective* conf = root->get("rtc_server");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("dtls_rate");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return srs_max(0, ::atoi(conf->arg0().c_str()));
+}
+
+bool SrsConfig::get_rtc_server_srtp_gcm()
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.rtc_server.srtp_gcm"); // SRS_RTC_SERVER_SRTP_GCM
+
+    static bool DEFAULT = false;
+
+    SrsConfDirective* conf = root->get("rtc_server");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("srtp_gcm");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
 int SrsConfig::get_rtc_server_reuseport()
 {
     int v = get_rtc_server_reuseport2();
@@ -4627,57 +5003,164 @@ bool SrsConfig::get_rtc_twcc_enabled(string vhost)
     return SRS_CONF_PERFER_TRUE(conf->arg0());
 }
 
-SrsConfDirective* SrsConfig::get_vhost(string vhost, bool try_default_vhost)
+bool SrsConfig::get_rtc_fec_enabled(string vhost)
 {
-    srs_assert(root);
-    
-    for (int i = 0; i < (int)root->directives.size(); i++) {
-        SrsConfDirective* conf = root->at(i);
-        
-        if (!conf->is_vhost()) {
-            continue;
-        }
-        
-        if (conf->arg0() == vhost) {
-            return conf;
-        }
-    }
-    
-    if (try_default_vhost && vhost != SRS_CONSTS_RTMP_DEFAULT_VHOST) {
-        return get_vhost(SRS_CONSTS_RTMP_DEFAULT_VHOST);
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.rtc.fec"); // SRS_VHOST_RTC_FEC
+
+    static bool DEFAULT = false;
+
+    SrsConfDirective* conf = get_rtc(vhost);
+    if (!conf) {
+        return DEFAULT;
     }
-    
-    return NULL;
-}
 
-void SrsConfig::get_vhosts(vector<SrsConfDirective*>& vhosts)
-{
-    srs_assert(root);
-    
-    for (int i = 0; i < (int)root->directives.size(); i++) {
-        SrsConfDirective* conf = root->at(i);
-        
-        if (!conf->is_vhost()) {
-            continue;
-        }
-        
-        vhosts.push_back(conf);
+    conf = conf->get("fec");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
     }
-}
 
-bool SrsConfig::get_vhost_enabled(string vhost)
-{
-    SrsConfDirective* conf = get_vhost(vhost);
-    
-    return get_vhost_enabled(conf);
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
 }
 
-bool SrsConfig::get_vhost_enabled(SrsConfDirective* conf)
+int SrsConfig::get_rtc_fec_group(string vhost)
 {
-    static bool DEFAULT = true;
-    
-    // false for NULL vhost.
-    if (!conf) {
+    SRS_OVERWRITE_BY_ENV_INT("srs.vhost.rtc.fec_group"); // SRS_VHOST_RTC_FEC_GROUP
+
+    static int DEFAULT = 10;
+
+    SrsConfDirective* conf = get_rtc(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("fec_group");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    int v = ::atoi(conf->arg0().c_str());
+    if (v < 2 || v > 16) {
+        srs_warn("Reset fec_group %d to %d", v, DEFAULT);
+        return DEFAULT;
+    }
+
+    return v;
+}
+
+bool SrsConfig::get_rtc_red_enabled(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.rtc.red"); // SRS_VHOST_RTC_RED
+
+    static bool DEFAULT = false;
+
+    SrsConfDirective* conf = get_rtc(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("red");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
+int SrsConfig::get_rtc_red_distance(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_INT("srs.vhost.rtc.red_distance"); // SRS_VHOST_RTC_RED_DISTANCE
+
+    static int DEFAULT = 1;
+
+    SrsConfDirective* conf = get_rtc(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("red_distance");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    int v = ::atoi(conf->arg0().c_str());
+    if (v < 1 || v > 5) {
+        srs_warn("Reset red_distance %d to %d", v, DEFAULT);
+        return DEFAULT;
+    }
+
+    return v;
+}
+
+SrsConfDirective* SrsConfig::get_vhost(string vhost, bool try_default_vhost)
+{
+    srs_assert(root);
+
+    // Find by the compiled vhosts, rather than walk all directives.
+    if (snapshot_) {
+        std::map<std::string, SrsVhostSnapshot*>::iterator it = snapshot_->vhosts_.find(vhost);
+        if (it != snapshot_->vhosts_.end()) {
+            return it->second->vhost_;
+        }
+
+        if (try_default_vhost && vhost != SRS_CONSTS_RTMP_DEFAULT_VHOST) {
+            return get_vhost(SRS_CONSTS_RTMP_DEFAULT_VHOST);
+        }
+
+        return NULL;
+    }
+    
+    for (int i = 0; i < (int)root->directives.size(); i++) {
+        SrsConfDirective* conf = root->at(i);
+        
+        if (!conf->is_vhost()) {
+            continue;
+        }
+        
+        if (conf->arg0() == vhost) {
+            return conf;
+        }
+    }
+    
+    if (try_default_vhost && vhost != SRS_CONSTS_RTMP_DEFAULT_VHOST) {
+        return get_vhost(SRS_CONSTS_RTMP_DEFAULT_VHOST);
+    }
+    
+    return NULL;
+}
+
+void SrsConfig::get_vhosts(vector<SrsConfDirective*>& vhosts)
+{
+    srs_assert(root);
+    
+    for (int i = 0; i < (int)root->directives.size(); i++) {
+        SrsConfDirective* conf = root->at(i);
+        
+        if (!conf->is_vhost()) {
+            continue;
+        }
+        
+        vhosts.push_back(conf);
+    }
+}
+
+bool SrsConfig::get_vhost_enabled(string vhost)
+{
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->enabled_;
+    }
+
+    SrsConfDirective* conf = get_vhost(vhost);
+    
+    return get_vhost_enabled(conf);
+}
+
+bool SrsConfig::get_vhost_enabled(SrsConfDirective* conf)
+{
+    static bool DEFAULT = true;
+    
+    // false for NULL vhost.
+    if (!conf) {
         return false;
     }
     
@@ -4692,6 +5175,11 @@ bool SrsConfig::get_vhost_enabled(SrsConfDirective* conf)
 
 bool SrsConfig::get_gop_cache(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->gop_cache_;
+    }
+
     SRS_OVERWRITE_BY_ENV_BOOL2("srs.vhost.play.gop_cache"); // SRS_VHOST_PLAY_GOP_CACHE
 
     SrsConfDirective* conf = get_vhost(vhost);
@@ -4715,6 +5203,11 @@ bool SrsConfig::get_gop_cache(string vhost)
 
 int SrsConfig::get_gop_cache_max_frames(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->gop_cache_max_frames_;
+    }
+
     SRS_OVERWRITE_BY_ENV_INT("srs.vhost.play.gop_cache_max_frames"); // SRS_VHOST_PLAY_GOP_CACHE_MAX_FRAMES
 
     static int DEFAULT = 2500;
@@ -4762,6 +5255,11 @@ bool SrsConfig::get_debug_srs_upnode(string vhost)
 
 bool SrsConfig::get_atc(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->atc_;
+    }
+
     SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.play.atc"); // SRS_VHOST_PLAY_ATC
 
     static bool DEFAULT = false;
@@ -4810,6 +5308,11 @@ bool SrsConfig::get_atc_auto(string vhost)
 
 int SrsConfig::get_time_jitter(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->time_jitter_;
+    }
+
     if (!srs_getenv("srs.vhost.play.time_jitter").empty()) { // SRS_VHOST_PLAY_TIME_JITTER
         return srs_time_jitter_string2int(srs_getenv("srs.vhost.play.time_jitter"));
     }
@@ -4836,6 +5339,11 @@ int SrsConfig::get_time_jitter(string vhost)
 
 bool SrsConfig::get_mix_correct(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->mix_correct_;
+    }
+
     SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.play.mix_correct"); // SRS_VHOST_PLAY_MIX_CORRECT
 
     static bool DEFAULT = false;
@@ -4860,6 +5368,11 @@ bool SrsConfig::get_mix_correct(string vhost)
 
 srs_utime_t SrsConfig::get_queue_length(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->queue_length_;
+    }
+
     SRS_OVERWRITE_BY_ENV_SECONDS("srs.vhost.play.queue_length"); // SRS_VHOST_PLAY_QUEUE_LENGTH
 
     static srs_utime_t DEFAULT = SRS_PERF_PLAY_QUEUE;
@@ -4884,6 +5397,11 @@ srs_utime_t SrsConfig::get_queue_length(string vhost)
 
 bool SrsConfig::get_refer_enabled(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->refer_enabled_;
+    }
+
     static bool DEFAULT = false;
     
     SrsConfDirective* conf = get_vhost(vhost);
@@ -5045,6 +5563,11 @@ bool SrsConfig::get_parse_sps(string vhost)
 
 bool SrsConfig::try_annexb_first(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->try_annexb_first_;
+    }
+
     SRS_OVERWRITE_BY_ENV_BOOL2("srs.vhost.publish.try_annexb_first"); // SRS_VHOST_PUBLISH_TRY_ANNEXB_FIRST
 
     static bool DEFAULT = true;
@@ -5114,8 +5637,61 @@ srs_utime_t SrsConfig::get_mr_sleep(string vhost)
     return (srs_utime_t)(::atoi(conf->arg0().c_str()) * SRS_UTIME_MILLISECONDS);
 }
 
+bool SrsConfig::get_mw_adaptive(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.play.mw_adaptive"); // SRS_VHOST_PLAY_MW_ADAPTIVE
+
+    static bool DEFAULT = SRS_PERF_MW_ADAPTIVE;
+
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("play");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("mw_adaptive");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
+bool SrsConfig::get_mr_adaptive(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.publish.mr_adaptive"); // SRS_VHOST_PUBLISH_MR_ADAPTIVE
+
+    static bool DEFAULT = SRS_PERF_MR_ADAPTIVE;
+
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("publish");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("mr_adaptive");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
 srs_utime_t SrsConfig::get_mw_sleep(string vhost, bool is_rtc)
 {
+    SrsVhostSnapshot* snapshot = !is_rtc ? get_vhost_snapshot(vhost) : NULL;
+    if (snapshot) {
+        return snapshot->mw_sleep_;
+    }
+
     if (!srs_getenv("srs.vhost.play.mw_latency").empty()) { // SRS_VHOST_PLAY_MW_LATENCY
         int v = ::atoi(srs_getenv("srs.vhost.play.mw_latency").c_str());
         if (is_rtc && v > 0) {
@@ -5157,6 +5733,11 @@ srs_utime_t SrsConfig::get_mw_sleep(string vhost, bool is_rtc)
 
 int SrsConfig::get_mw_msgs(string vhost, bool is_realtime, bool is_rtc)
 {
+    SrsVhostSnapshot* snapshot = !is_rtc ? get_vhost_snapshot(vhost) : NULL;
+    if (snapshot) {
+        return is_realtime ? snapshot->mw_msgs_realtime_ : snapshot->mw_msgs_;
+    }
+
     if (!srs_getenv("srs.vhost.play.mw_msgs").empty()) { // SRS_VHOST_PLAY_MW_MSGS
         int v = ::atoi(srs_getenv("srs.vhost.play.mw_msgs").c_str());
         if (v > SRS_PERF_MW_MSGS) {
@@ -5201,6 +5782,11 @@ int SrsConfig::get_mw_msgs(string vhost, bool is_realtime, bool is_rtc)
 
 bool SrsConfig::get_realtime_enabled(string vhost, bool is_rtc)
 {
+    SrsVhostSnapshot* snapshot = !is_rtc ? get_vhost_snapshot(vhost) : NULL;
+    if (snapshot) {
+        return snapshot->realtime_enabled_;
+    }
+
     if (is_rtc) {
         SRS_OVERWRITE_BY_ENV_BOOL2("srs.vhost.min_latency"); // SRS_VHOST_MIN_LATENCY
     } else {
@@ -5231,6 +5817,11 @@ bool SrsConfig::get_realtime_enabled(string vhost, bool is_rtc)
 
 bool SrsConfig::get_tcp_nodelay(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->tcp_nodelay_;
+    }
+
     SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.tcp_nodelay"); // SRS_VHOST_TCP_NODELAY
 
     static bool DEFAULT = false;
@@ -5250,6 +5841,11 @@ bool SrsConfig::get_tcp_nodelay(string vhost)
 
 srs_utime_t SrsConfig::get_send_min_interval(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->send_min_interval_;
+    }
+
     SRS_OVERWRITE_BY_ENV_FLOAT_MILLISECONDS("srs.vhost.play.send_min_interval"); // SRS_VHOST_PLAY_SEND_MIN_INTERVAL
 
     static srs_utime_t DEFAULT = 0;
@@ -5274,6 +5870,11 @@ srs_utime_t SrsConfig::get_send_min_interval(string vhost)
 
 bool SrsConfig::get_reduce_sequence_header(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->reduce_sequence_header_;
+    }
+
     SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.play.reduce_sequence_header"); // SRS_VHOST_PLAY_REDUCE_SEQUENCE_HEADER
 
     static bool DEFAULT = false;
@@ -5600,6 +6201,11 @@ SrsConfDirective* SrsConfig::get_vhost_on_hls_notify(string vhost)
 
 bool SrsConfig::get_vhost_is_edge(string vhost)
 {
+    SrsVhostSnapshot* snapshot = get_vhost_snapshot(vhost);
+    if (snapshot) {
+        return snapshot->is_edge_;
+    }
+
     SrsConfDirective* conf = get_vhost(vhost);
     return get_vhost_is_edge(conf);
 }
@@ -5685,6 +6291,111 @@ bool SrsConfig::get_vhost_edge_follow_client(string vhost)
     return SRS_CONF_PERFER_FALSE(conf->arg0());
 }
 
+string SrsConfig::get_vhost_edge_balance(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_STRING("srs.vhost.cluster.balance"); // SRS_VHOST_CLUSTER_BALANCE
+
+    static string DEFAULT = "round_robin";
+
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("cluster");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("balance");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return conf->arg0();
+}
+
+bool SrsConfig::get_vhost_edge_hls(string vhost)
+{
+    static bool DEFAULT = false;
+
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("cluster");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("hls_edge");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
+SrsConfDirective* SrsConfig::get_vhost_edge_hls_origin(string vhost)
+{
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return NULL;
+    }
+
+    conf = conf->get("cluster");
+    if (!conf) {
+        return NULL;
+    }
+
+    return conf->get("hls_origin");
+}
+
+srs_utime_t SrsConfig::get_vhost_edge_hls_ttl(string vhost)
+{
+    static srs_utime_t DEFAULT = 1 * SRS_UTIME_SECONDS;
+
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("cluster");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("hls_ttl");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return (srs_utime_t)(::atof(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
+}
+
+int SrsConfig::get_vhost_edge_hls_cache(string vhost)
+{
+    static int DEFAULT = 256;
+
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("cluster");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("hls_cache");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return ::atoi(conf->arg0().c_str());
+}
+
 bool SrsConfig::get_vhost_edge_token_traverse(string vhost)
 {
     static bool DEFAULT = false;
@@ -6721,6 +7432,25 @@ srs_utime_t SrsConfig::get_dash_dispose(std::string vhost)
     return (srs_utime_t)(::atoi(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
 }
 
+bool SrsConfig::get_dash_hls(std::string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.dash.dash_hls"); // SRS_VHOST_DASH_DASH_HLS
+
+    static bool DEFAULT = false;
+
+    SrsConfDirective* conf = get_dash(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("dash_hls");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
 SrsConfDirective* SrsConfig::get_hls(string vhost)
 {
     SrsConfDirective* conf = get_vhost(vhost);
@@ -7085,6 +7815,82 @@ bool SrsConfig::get_hls_cleanup(string vhost)
     return SRS_CONF_PERFER_TRUE(conf->arg0());
 }
 
+string SrsConfig::get_hls_storage(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_STRING("srs.vhost.hls.hls_storage"); // SRS_VHOST_HLS_HLS_STORAGE
+
+    static string DEFAULT = "disk";
+
+    SrsConfDirective* conf = get_hls(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("hls_storage");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return conf->arg0();
+}
+
+int SrsConfig::get_hls_memory_budget(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_INT("srs.vhost.hls.hls_memory_budget"); // SRS_VHOST_HLS_HLS_MEMORY_BUDGET
+
+    static int DEFAULT = 256;
+
+    SrsConfDirective* conf = get_hls(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("hls_memory_budget");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return ::atoi(conf->arg0().c_str());
+}
+
+bool SrsConfig::get_hls_ll(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.hls.hls_ll"); // SRS_VHOST_HLS_HLS_LL
+
+    static bool DEFAULT = false;
+
+    SrsConfDirective* conf = get_hls(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("hls_ll");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
+srs_utime_t SrsConfig::get_hls_ll_part(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_FLOAT_SECONDS("srs.vhost.hls.hls_ll_part"); // SRS_VHOST_HLS_HLS_LL_PART
+
+    static srs_utime_t DEFAULT = 500 * SRS_UTIME_MILLISECONDS;
+
+    SrsConfDirective* conf = get_hls(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("hls_ll_part");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return (srs_utime_t)(::atof(conf->arg0().c_str()) * SRS_UTIME_SECONDS);
+}
+
 srs_utime_t SrsConfig::get_hls_dispose(string vhost)
 {
     SRS_OVERWRITE_BY_ENV_SECONDS("srs.vhost.hls.hls_dispose"); // SRS_VHOST_HLS_HLS_DISPOSE
@@ -7588,6 +8394,78 @@ bool SrsConfig::get_raw_api_allow_reload()
     return SRS_CONF_PERFER_FALSE(conf->arg0());
 }
 
+bool SrsConfig::get_http_api_auth_enabled()
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.http_api.auth.enabled"); // SRS_HTTP_API_AUTH_ENABLED
+
+    static bool DEFAULT = false;
+
+    SrsConfDirective* conf = root->get("http_api");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("auth");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("enabled");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
+string SrsConfig::get_http_api_auth_username()
+{
+    SRS_OVERWRITE_BY_ENV_STRING("srs.http_api.auth.username"); // SRS_HTTP_API_AUTH_USERNAME
+
+    static string DEFAULT = "";
+
+    SrsConfDirective* conf = root->get("http_api");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("auth");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("username");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    return conf->arg0();
+}
+
+string SrsConfig::get_http_api_auth_password()
+{
+    SRS_OVERWRITE_BY_ENV_STRING("srs.http_api.auth.password"); // SRS_HTTP_API_AUTH_PASSWORD
+
+    static string DEFAULT = "";
+
+    SrsConfDirective* conf = root->get("http_api");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("auth");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("password");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    return conf->arg0();
+}
+
 bool SrsConfig::get_raw_api_allow_query()
 {
     // Disable RAW API query, @see https://github.com/ossrs/srs/issues/2653#issuecomment-939389178
@@ -7727,6 +8605,47 @@ unsigned short SrsConfig::get_srt_listen_port()
     return (unsigned short)atoi(conf->arg0().c_str());
 }
 
+bool SrsConfig::get_srt_poller_thread()
+{
+    SRS_OVERWRITE_BY_ENV_BOOL2("srs.srt_server.poller_thread"); // SRS_SRT_SERVER_POLLER_THREAD
+
+    static bool DEFAULT = true;
+    SrsConfDirective* conf = root->get("srt_server");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("poller_thread");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+    return SRS_CONF_PERFER_TRUE(conf->arg0());
+}
+
+int SrsConfig::get_srt_workers()
+{
+    SRS_OVERWRITE_BY_ENV_INT("srs.srt_server.workers"); // SRS_SRT_SERVER_WORKERS
+
+    static int DEFAULT = 0;
+    SrsConfDirective* conf = root->get("srt_server");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("workers");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    int v = ::atoi(conf->arg0().c_str());
+    if (v < 0 || v > 64) {
+        srs_warn("Reset srt workers %d to %d", v, DEFAULT);
+        return DEFAULT;
+    }
+
+    return v;
+}
+
 int64_t SrsConfig::get_srto_maxbw()
 {
     SRS_OVERWRITE_BY_ENV_INT("srs.srt_server.maxbw"); // SRS_SRT_SERVER_MAXBW
@@ -8437,6 +9356,30 @@ bool SrsConfig::get_vhost_http_remux_guess_has_av(string vhost)
     return SRS_CONF_PERFER_TRUE(conf->arg0());
 }
 
+bool SrsConfig::get_vhost_http_remux_shared_mux(string vhost)
+{
+    SRS_OVERWRITE_BY_ENV_BOOL("srs.vhost.http_remux.shared_mux"); // SRS_VHOST_HTTP_REMUX_SHARED_MUX
+
+    static bool DEFAULT = false;
+
+    SrsConfDirective* conf = get_vhost(vhost);
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("http_remux");
+    if (!conf) {
+        return DEFAULT;
+    }
+
+    conf = conf->get("shared_mux");
+    if (!conf || conf->arg0().empty()) {
+        return DEFAULT;
+    }
+
+    return SRS_CONF_PERFER_FALSE(conf->arg0());
+}
+
 string SrsConfig::get_vhost_http_remux_mount(string vhost)
 {
     SRS_OVERWRITE_BY_ENV_STRING("srs.vhost.http_remux.mount"); // SRS_VHOST_HTTP_REMUX_MOUNT
@@ -8523,6 +9466,35 @@ string SrsConfig::get_heartbeat_url()
     return conf->arg0();
 }
 
+vector<string> SrsConfig::get_heartbeat_urls()
+{
+    // The urls are separated by space, for example, SRS_HEARTBEAT_URL="http://a/api http://b/api"
+    if (!srs_getenv("srs.heartbeat.url").empty()) {
+        vector<string> urls = srs_string_split(srs_getenv("srs.heartbeat.url"), " ");
+        urls.erase(std::remove(urls.begin(), urls.end(), ""), urls.end());
+        return urls;
+    }
+
+    vector<string> urls;
+
+    SrsConfDirective* conf = get_heartbeart();
+    if (conf) {
+        conf = conf->get("url");
+    }
+
+    for (int i = 0; conf && i < (int)conf->args.size(); i++) {
+        if (!conf->args.at(i).empty()) {
+            urls.push_back(conf->args.at(i));
+        }
+    }
+
+    if (urls.empty()) {
+        urls.push_back(get_heartbeat_url());
+    }
+
+    return urls;
+}
+
 string SrsConfig::get_heartbeat_device_id()
 {
     SRS_OVERWRITE_BY_ENV_STRING("srs.heartbeat.device_id"); // SRS_HEARTBEAT_DEVICE_ID
@@ -91,6 +91,8 @@ namespace srs_internal
 // Deep compare directive.
 extern bool srs_directive_equals(SrsConfDirective* a, SrsConfDirective* b);
 extern bool srs_directive_equals(SrsConfDirective* a, SrsConfDirective* b, std::string except);
+// The fingerprint of directive and its children, the equal directives always get the same fingerprint.
+extern uint64_t srs_directive_fingerprint(SrsConfDirective* conf, uint64_t previous = 0);
 
 // The helper utilities, used for compare the consts values.
 extern bool srs_config_hls_is_on_error_ignore(std::string strategy);
@@ -256,6 +258,52 @@ private:
     virtual srs_error_t read_token(srs_internal::SrsConfigBuffer* buffer, std::vector<std::string>& args, int& line_start, SrsDirectiveState& state);
 };
 
+// The typed config of vhost, compiled from the directives and env when load or reload config, for the
+// hot-path getters which are called for each connection or stream.
+class SrsVhostSnapshot
+{
+public:
+    // The vhost directive, which is freed when reload, so never keep the snapshot cross st-thread.
+    SrsConfDirective* vhost_;
+    // The fingerprint of vhost directive, to skip the unchanged vhost when reload.
+    uint64_t fingerprint_;
+public:
+    bool enabled_;
+    bool is_edge_;
+    bool refer_enabled_;
+    bool tcp_nodelay_;
+    // For RTMP only, the RTC always calls the getters.
+    bool realtime_enabled_;
+    srs_utime_t mw_sleep_;
+    int mw_msgs_;
+    int mw_msgs_realtime_;
+    srs_utime_t send_min_interval_;
+    bool gop_cache_;
+    int gop_cache_max_frames_;
+    srs_utime_t queue_length_;
+    bool atc_;
+    int time_jitter_;
+    bool mix_correct_;
+    bool try_annexb_first_;
+    bool reduce_sequence_header_;
+public:
+    SrsVhostSnapshot(SrsConfDirective* vhost);
+    virtual ~SrsVhostSnapshot();
+};
+
+// The compiled config, which is rebuilt as a whole when load or reload config.
+class SrsConfigSnapshot
+{
+public:
+    // The vhosts by name, the first one wins for duplicated vhosts, same to the directives.
+    std::map<std::string, SrsVhostSnapshot*> vhosts_;
+    // The config for the vhost not found, NULL when compiling.
+    SrsVhostSnapshot* default_;
+public:
+    SrsConfigSnapshot();
+    virtual ~SrsConfigSnapshot();
+};
+
 // The config service provider.
 // For the config supports reload, so never keep the reference cross st-thread,
 // that is, never save the SrsConfDirective* get by any api of config,
@@ -292,10 +340,14 @@ private:
 protected:
     // The directive root.
     SrsConfDirective* root;
+    // The compiled config of root, NULL if not compiled, or root is changed.
+    SrsConfigSnapshot* snapshot_;
 // Reload  section
 private:
     // The reload subscribers, when reload, callback all handlers.
     std::vector<ISrsReloadHandler*> subscribes;
+    // The reload subscribers of vhost, only callback when the vhost is changed.
+    std::map<std::string, std::vector<ISrsReloadHandler*> > vhost_subscribes_;
 public:
     SrsConfig();
     virtual ~SrsConfig();
@@ -304,14 +356,20 @@ public:
     // For reload handler to register itself,
     // when config service do the reload, callback the handler.
     virtual void subscribe(ISrsReloadHandler* handler);
-    // For reload handler to unregister itself.
+    // For reload handler of a stream to register itself, which only cares about the specified vhost,
+    // so we never callback the handlers of other vhosts, for there might be lots of streams.
+    virtual void subscribe_vhost(std::string vhost, ISrsReloadHandler* handler);
+    // For reload handler to unregister itself, for both subscribe and subscribe_vhost.
     virtual void unsubscribe(ISrsReloadHandler* handler);
     // Reload  the config file.
     // @remark, user can test the config before reload it.
     virtual srs_error_t reload();
 private:
     // Reload  the vhost section of config.
-    virtual srs_error_t reload_vhost(SrsConfDirective* old_root);
+    // @param old_snapshot The compiled old root, to skip the unchanged vhosts by fingerprint, NULL to calculate it.
+    virtual srs_error_t reload_vhost(SrsConfDirective* old_root, SrsConfigSnapshot* old_snapshot);
+    // Get the subscribers of vhost, both the global and vhost subscribers.
+    virtual std::vector<ISrsReloadHandler*> get_vhost_subscribes(std::string vhost);
 protected:
     // Reload  from the config.
     // @remark, use protected for the utest to override with mock.
@@ -360,6 +418,13 @@ private:
 public:
     // Check the parsed config.
     virtual srs_error_t check_config();
+    // Compile the config to snapshot, for the hot-path getters. Note that the env is also applied, so the
+    // env changed after compiling is ignored by these getters.
+    virtual void compile_snapshot();
+private:
+    // Get the compiled vhost, or the default one if not found. NULL if not compiled.
+    SrsVhostSnapshot* get_vhost_snapshot(const std::string& vhost);
+    void compile_vhost(std::string vhost, SrsVhostSnapshot* snapshot);
 protected:
     virtual srs_error_t check_normal_config();
     virtual srs_error_t check_number_connections();
@@ -450,6 +515,14 @@ public:
     virtual int get_critical_pulse();
     virtual int get_dying_threshold();
     virtual int get_dying_pulse();
+// Delivery worker threads section.
+public:
+    // Whether deliver the players of mega stream in worker threads.
+    virtual bool get_delivery_enabled();
+    // Get the number of delivery worker threads.
+    virtual int get_delivery_workers();
+    // Get the number of players of stream, to deliver the new players in workers.
+    virtual int get_delivery_players();
 // TencentCloud service section.
 public:
     virtual bool get_tencentcloud_cls_enabled();
@@ -508,6 +581,12 @@ public:
     virtual std::string get_rtc_server_ip_family();
     virtual bool get_rtc_server_ecdsa();
     virtual bool get_rtc_server_encrypt();
+    // Get the number of threads to do DTLS handshake, 0 to do it in the main thread.
+    virtual int get_rtc_server_dtls_workers();
+    // Get the max number of new DTLS handshakes per second, 0 for no limit.
+    virtual int get_rtc_server_dtls_rate();
+    // Whether prefer SRTP AES-GCM, which requires libsrtp with openssl, see --srtp-nasm.
+    virtual bool get_rtc_server_srtp_gcm();
     virtual int get_rtc_server_reuseport();
     virtual bool get_rtc_server_merge_nalus();
 public:
@@ -531,6 +610,12 @@ public:
     bool get_rtc_nack_enabled(std::string vhost);
     bool get_rtc_nack_no_copy(std::string vhost);
     bool get_rtc_twcc_enabled(std::string vhost);
+    bool get_rtc_fec_enabled(std::string vhost);
+    // Get the number of packets protected by a FEC packet, in [2, 16].
+    int get_rtc_fec_group(std::string vhost);
+    bool get_rtc_red_enabled(std::string vhost);
+    // Get the max number of redundant blocks in a RED packet, in [1, 5].
+    int get_rtc_red_distance(std::string vhost);
 
 // vhost specified section
 public:
@@ -614,6 +699,9 @@ public:
     // @param vhost, the vhost to get the mr sleep time.
     // TODO: FIXME: add utest for mr config.
     virtual srs_utime_t get_mr_sleep(std::string vhost);
+    // Whether adaptive mr, which tunes the sleep by the bitrate of publisher,
+    // and the mr sleep time is the latency budget.
+    virtual bool get_mr_adaptive(std::string vhost);
     // Get the mw_latency, mw sleep time in srs_utime_t for vhost.
     // @param vhost, the vhost to get the mw sleep time.
     // TODO: FIXME: add utest for mw config.
@@ -622,6 +710,9 @@ public:
     // @param vhost, the vhost to get the mw sleep msgs.
     // TODO: FIXME: add utest for mw config.
     virtual int get_mw_msgs(std::string vhost, bool is_realtime, bool is_rtc = false);
+    // Whether adaptive mw for RTMP player, which tunes the wait by the bitrate of player,
+    // and the mw sleep time is the latency budget.
+    virtual bool get_mw_adaptive(std::string vhost);
     // Whether min latency mode enabled.
     // @param vhost, the vhost to get the min_latency.
     // TODO: FIXME: add utest for min_latency.
@@ -657,6 +748,10 @@ public:
     virtual bool get_srt_enabled();
     // Get the srt service listen port
     virtual unsigned short get_srt_listen_port();
+    // Whether use a thread to poll the SRT events and wake up ST, default is true.
+    virtual bool get_srt_poller_thread();
+    // Get the number of threads to demux the SRT streams, 0 to demux in ST thread, default is 0.
+    virtual int get_srt_workers();
     // Get the srt SRTO_MAXBW, max bandwith, default is -1.
     virtual int64_t get_srto_maxbw();
     // Get the srt SRTO_MSS, Maximum Segment Size, default is 1500.
@@ -748,6 +843,16 @@ public:
     virtual std::string get_vhost_edge_protocol(std::string vhost);
     // Whether follow client protocol to connect to origin.
     virtual bool get_vhost_edge_follow_client(std::string vhost);
+    // Get the algorithm to select origin, round_robin, hash or least_load.
+    virtual std::string get_vhost_edge_balance(std::string vhost);
+    // Whether edge HLS is enabled, which fetches m3u8 and ts from origin.
+    virtual bool get_vhost_edge_hls(std::string vhost);
+    // Get the HTTP servers of origin for edge HLS.
+    virtual SrsConfDirective* get_vhost_edge_hls_origin(std::string vhost);
+    // Get the TTL of m3u8 for edge HLS.
+    virtual srs_utime_t get_vhost_edge_hls_ttl(std::string vhost);
+    // Get the max size of cache in MB for edge HLS.
+    virtual int get_vhost_edge_hls_cache(std::string vhost);
     // Whether edge token tranverse is enabled,
     // If  true, edge will send connect origin to verfy the token of client.
     // For example, we verify all clients on the origin FMS by server-side as,
@@ -905,6 +1010,8 @@ public:
     virtual bool get_dash_cleanup(std::string vhost);
     // The timeout in srs_utime_t to dispose the dash.
     virtual srs_utime_t get_dash_dispose(std::string vhost);
+    // Whether write HLS m3u8 for the fmp4 segments of DASH, the CMAF HLS.
+    virtual bool get_dash_hls(std::string vhost);
 // hls section
 private:
     // Get the hls directive of vhost.
@@ -943,6 +1050,14 @@ public:
     virtual std::string get_hls_vcodec(std::string vhost);
     // Whether cleanup the old ts files.
     virtual bool get_hls_cleanup(std::string vhost);
+    // Get the storage of hls, disk, memory or both.
+    virtual std::string get_hls_storage(std::string vhost);
+    // Get the memory budget in MB of each stream, for in-memory hls.
+    virtual int get_hls_memory_budget(std::string vhost);
+    // Whether enable LL-HLS, with partial segments and blocking playlist reload.
+    virtual bool get_hls_ll(std::string vhost);
+    // Get the target duration of LL-HLS part.
+    virtual srs_utime_t get_hls_ll_part(std::string vhost);
     // The timeout in srs_utime_t to dispose the hls.
     virtual srs_utime_t get_hls_dispose(std::string vhost);
     // Whether reap the ts when got keyframe.
@@ -1017,6 +1132,10 @@ public:
     virtual bool get_raw_api();
     // Whether allow rpc reload.
     virtual bool get_raw_api_allow_reload();
+    // Whether enable the HTTP API auth, and the username and password of Basic authorization.
+    virtual bool get_http_api_auth_enabled();
+    virtual std::string get_http_api_auth_username();
+    virtual std::string get_http_api_auth_password();
     // Whether allow rpc query.
     virtual bool get_raw_api_allow_query();
     // Whether allow rpc update.
@@ -1075,6 +1194,8 @@ public:
     bool get_vhost_http_remux_has_video(std::string vhost);
     // Whether guessing stream about audio or video track
     bool get_vhost_http_remux_guess_has_av(std::string vhost);
+    // Whether mux the HTTP-TS/AAC/MP3 stream once and share the chunks by all players.
+    bool get_vhost_http_remux_shared_mux(std::string vhost);
     // Get the http flv live stream mount point for vhost.
     // used to generate the flv stream mount path.
     virtual std::string get_vhost_http_remux_mount(std::string vhost);
@@ -1089,6 +1210,8 @@ public:
     virtual srs_utime_t get_heartbeat_interval();
     // Get the heartbeat report url.
     virtual std::string get_heartbeat_url();
+    // Get all the heartbeat report urls, for example, to report to multiple edges.
+    virtual std::vector<std::string> get_heartbeat_urls();
     // Get the device id of heartbeat, to report to server.
     virtual std::string get_heartbeat_device_id();
     // Whether report with summaries of http api: /api/v1/summaries.
@@ -538,6 +538,11 @@ srs_error_t SrsTcpConnection::set_socket_buffer(srs_utime_t buffer_v)
     return err;
 }
 
+int SrsTcpConnection::fd()
+{
+    return srs_netfd_fileno(stfd);
+}
+
 void SrsTcpConnection::set_recv_timeout(srs_utime_t tm)
 {
     skt->set_recv_timeout(tm);
@@ -588,6 +593,16 @@ srs_error_t SrsTcpConnection::writev(const iovec *iov, int iov_size, ssize_t* nw
     return skt->writev(iov, iov_size, nwrite);
 }
 
+bool SrsTcpConnection::sendfile_enabled()
+{
+    return skt->sendfile_enabled();
+}
+
+srs_error_t SrsTcpConnection::sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite)
+{
+    return skt->sendfile(fd, offset, count, nwrite);
+}
+
 SrsBufferedReadWriter::SrsBufferedReadWriter(ISrsProtocolReadWriter* io)
 {
     io_ = io;
@@ -712,6 +727,21 @@ srs_error_t SrsBufferedReadWriter::writev(const iovec *iov, int iov_size, ssize_
     return io_->writev(iov, iov_size, nwrite);
 }
 
+bool SrsBufferedReadWriter::sendfile_enabled()
+{
+    ISrsProtocolFileWriter* fw = dynamic_cast<ISrsProtocolFileWriter*>(io_);
+    return fw && fw->sendfile_enabled();
+}
+
+srs_error_t SrsBufferedReadWriter::sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite)
+{
+    ISrsProtocolFileWriter* fw = dynamic_cast<ISrsProtocolFileWriter*>(io_);
+    if (!fw) {
+        return srs_error_new(ERROR_SOCKET_WRITE, "sendfile not supported");
+    }
+    return fw->sendfile(fd, offset, count, nwrite);
+}
+
 SrsSslConnection::SrsSslConnection(ISrsProtocolReadWriter* c)
 {
     transport = c;
@@ -233,7 +233,7 @@ public:
 // The basic connection of SRS, for TCP based protocols,
 // all connections accept from listener must extends from this base class,
 // server will add the connection to manager, and delete it when remove.
-class SrsTcpConnection : public ISrsProtocolReadWriter
+class SrsTcpConnection : public ISrsProtocolReadWriter, public ISrsProtocolFileWriter
 {
 private:
     // The underlayer st fd handler.
@@ -248,6 +248,8 @@ public:
     virtual srs_error_t set_tcp_nodelay(bool v);
     // Set socket option SO_SNDBUF in srs_utime_t.
     virtual srs_error_t set_socket_buffer(srs_utime_t buffer_v);
+    // Get the fd of socket, for example, to hand off the connection to other thread.
+    virtual int fd();
 // Interface ISrsProtocolReadWriter
 public:
     virtual void set_recv_timeout(srs_utime_t tm);
@@ -260,11 +262,15 @@ public:
     virtual srs_utime_t get_send_timeout();
     virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite);
     virtual srs_error_t writev(const iovec *iov, int iov_size, ssize_t* nwrite);
+// Interface ISrsProtocolFileWriter
+public:
+    virtual bool sendfile_enabled();
+    virtual srs_error_t sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite);
 };
 
 // With a small fast read buffer, to support peek for protocol detecting. Note that directly write to io without any
 // cache or buffer.
-class SrsBufferedReadWriter : public ISrsProtocolReadWriter
+class SrsBufferedReadWriter : public ISrsProtocolReadWriter, public ISrsProtocolFileWriter
 {
 private:
     // The under-layer transport.
@@ -294,6 +300,11 @@ public:
     virtual srs_utime_t get_send_timeout();
     virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite);
     virtual srs_error_t writev(const iovec *iov, int iov_size, ssize_t* nwrite);
+// Interface ISrsProtocolFileWriter
+public:
+    // Send file by the under-layer transport, if it's able to.
+    virtual bool sendfile_enabled();
+    virtual srs_error_t sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite);
 };
 
 // The SSL connection over TCP transport, in server mode.
@@ -18,6 +18,7 @@
 #include <srs_kernel_mp4.hpp>
 
 #include <stdlib.h>
+#include <math.h>
 #include <sstream>
 #include <unistd.h>
 
@@ -35,6 +36,70 @@ string srs_time_to_utc_format_str(srs_utime_t u)
     return std::string(print_buf, ret);
 }
 
+string srs_fmp4_video_codecs(SrsFormat* format, bool hvc1)
+{
+    SrsVideoCodecConfig* c = format->vcodec;
+    if (!c) {
+        return "";
+    }
+
+    // The AVCDecoderConfigurationRecord starts with version, profile, compatibility and level.
+    if (c->id == SrsVideoCodecIdAVC) {
+        if (c->avc_extra_data.size() < 4) {
+            return "avc1.64001e";
+        }
+        uint8_t* p = (uint8_t*)&c->avc_extra_data[0];
+        return srs_fmt("avc1.%02x%02x%02x", p[1], p[2], p[3]);
+    }
+
+#ifdef SRS_H265
+    if (c->id == SrsVideoCodecIdHEVC) {
+        SrsHevcDecoderConfigurationRecord* r = &c->hevc_dec_conf_record_;
+
+        // The compatibility flags in reverse bit order, see ISO_IEC_14496-15-AVC-format-2012.pdf, Annex E.
+        uint32_t flags = r->general_profile_compatibility_flags, compat = 0;
+        for (int i = 0; i < 32; i++) {
+            compat = (compat << 1) | ((flags >> i) & 0x01);
+        }
+
+        std::stringstream ss;
+        ss << (hvc1 ? "hvc1." : "hev1.");
+        if (r->general_profile_space) {
+            ss << (char)('A' + r->general_profile_space - 1);
+        }
+        ss << (int)r->general_profile_idc << "." << srs_fmt("%x", compat);
+        ss << "." << (r->general_tier_flag ? "H" : "L") << (int)r->general_level_idc;
+
+        // The 6 bytes of constraint flags, the trailing zero bytes are omitted.
+        int nn_bytes = 6;
+        while (nn_bytes > 0 && ((r->general_constraint_indicator_flags >> (48 - 8 * nn_bytes)) & 0xff) == 0) {
+            nn_bytes--;
+        }
+        for (int i = 0; i < nn_bytes; i++) {
+            ss << "." << srs_fmt("%X", (int)((r->general_constraint_indicator_flags >> (40 - 8 * i)) & 0xff));
+        }
+        return ss.str();
+    }
+#endif
+
+    return "";
+}
+
+string srs_fmp4_audio_codecs(SrsFormat* format)
+{
+    SrsAudioCodecConfig* c = format->acodec;
+    if (!c) {
+        return "";
+    }
+
+    if (c->id == SrsAudioCodecIdAAC) {
+        int object = (c->aac_object != SrsAacObjectTypeReserved) ? (int)c->aac_object : (int)SrsAacObjectTypeAacLC;
+        return "mp4a.40." + srs_int2str(object);
+    }
+
+    return "";
+}
+
 SrsInitMp4::SrsInitMp4()
 {
     fw = new SrsFileWriter();
@@ -47,6 +112,11 @@ SrsInitMp4::~SrsInitMp4()
     srs_freep(fw);
 }
 
+void SrsInitMp4::set_hvc1(bool v)
+{
+    init->set_hvc1(v);
+}
+
 srs_error_t SrsInitMp4::write(SrsFormat* format, bool video, int tid)
 {
     srs_error_t err = srs_success;
@@ -255,7 +325,7 @@ srs_error_t SrsMpdWriter::write(SrsFormat* format, SrsFragmentWindow* afragments
     if (format->acodec && ! afragments->empty()) {
         int start_index = srs_max(0, afragments->size()-window_size_);
         ss << "        <AdaptationSet mimeType=\"audio/mp4\" segmentAlignment=\"true\" startWithSAP=\"1\">" << endl;
-        ss << "            <Representation id=\"audio\" bandwidth=\"48000\" codecs=\"mp4a.40.2\">" << endl;
+        ss << "            <Representation id=\"audio\" bandwidth=\"48000\" codecs=\"" << srs_fmp4_audio_codecs(format) << "\">" << endl;
         ss << "                <SegmentTemplate initialization=\"$RepresentationID$-init.mp4\" "
                                             << "media=\"$RepresentationID$-$Number$.m4s\" "
                                             << "startNumber=\"" << afragments->at(start_index)->number() << "\" "
@@ -276,7 +346,7 @@ srs_error_t SrsMpdWriter::write(SrsFormat* format, SrsFragmentWindow* afragments
         int w = format->vcodec->width;
         int h = format->vcodec->height;
         ss << "        <AdaptationSet mimeType=\"video/mp4\" segmentAlignment=\"true\" startWithSAP=\"1\">" << endl;
-        ss << "            <Representation id=\"video\" bandwidth=\"800000\" codecs=\"avc1.64001e\" " << "width=\"" << w << "\" height=\"" << h << "\">" << endl;
+        ss << "            <Representation id=\"video\" bandwidth=\"800000\" codecs=\"" << srs_fmp4_video_codecs(format, _srs_config->get_dash_hls(req->vhost)) << "\" " << "width=\"" << w << "\" height=\"" << h << "\">" << endl;
         ss << "                <SegmentTemplate initialization=\"$RepresentationID$-init.mp4\" "
                                             << "media=\"$RepresentationID$-$Number$.m4s\" "
                                             << "startNumber=\"" << vfragments->at(start_index)->number() << "\" "
@@ -347,6 +417,176 @@ srs_utime_t SrsMpdWriter::get_availability_start_time()
     return availability_start_time_;
 }
 
+SrsCmafM3u8Writer::SrsCmafM3u8Writer()
+{
+    req = NULL;
+    enabled_ = false;
+    window_size_ = 0;
+}
+
+SrsCmafM3u8Writer::~SrsCmafM3u8Writer()
+{
+}
+
+void SrsCmafM3u8Writer::dispose()
+{
+    if (!req || !enabled_) {
+        return;
+    }
+
+    string files[] = {home + "/" + master_file, home + "/" + fragment_home + "/video.m3u8",
+        home + "/" + fragment_home + "/audio.m3u8"};
+    for (int i = 0; i < (int)(sizeof(files) / sizeof(string)); i++) {
+        if (unlink(files[i].c_str()) < 0) {
+            srs_warn("ignore remove m3u8 failed, %s", files[i].c_str());
+        }
+    }
+}
+
+srs_error_t SrsCmafM3u8Writer::initialize(SrsRequest* r)
+{
+    req = r;
+    return srs_success;
+}
+
+srs_error_t SrsCmafM3u8Writer::on_publish()
+{
+    SrsRequest* r = req;
+
+    enabled_ = _srs_config->get_dash_hls(r->vhost);
+    home = _srs_config->get_dash_path(r->vhost);
+    window_size_ = _srs_config->get_dash_window_size(r->vhost);
+
+    // The master m3u8 is beside the MPD, and the fragments is in the same home of MPD.
+    string mpd_file = _srs_config->get_dash_mpd_file(r->vhost);
+    string mpd_path = srs_path_build_stream(mpd_file, r->vhost, r->app, r->stream);
+    master_file = srs_path_dirname(mpd_path) + "/" + r->stream + ".cmaf.m3u8";
+    fragment_home = srs_path_dirname(mpd_path) + "/" + r->stream;
+
+    if (enabled_) {
+        srs_trace("DASH: CMAF HLS master=%s, window=%d, home=%s", master_file.c_str(), window_size_, home.c_str());
+    }
+
+    return srs_success;
+}
+
+srs_error_t SrsCmafM3u8Writer::write(SrsFormat* format, SrsFragmentWindow* afragments, SrsFragmentWindow* vfragments)
+{
+    srs_error_t err = srs_success;
+
+    // Support the pure audio or pure video stream, by writing the track which has fragments.
+    bool has_video = format->vcodec && !vfragments->empty();
+    bool has_audio = format->acodec && !afragments->empty();
+    if (!enabled_ || (!has_video && !has_audio)) {
+        return err;
+    }
+
+    string full_home = home + "/" + fragment_home;
+    if ((err = srs_create_dir_recursively(full_home)) != srs_success) {
+        return srs_error_wrap(err, "Create m3u8 home failed, home=%s", full_home.c_str());
+    }
+
+    // Write the media m3u8 before master, so the player always got them.
+    if (has_video && (err = write_media("video", vfragments)) != srs_success) {
+        return srs_error_wrap(err, "video m3u8");
+    }
+
+    if (has_audio && (err = write_media("audio", afragments)) != srs_success) {
+        return srs_error_wrap(err, "audio m3u8");
+    }
+
+    // The media playlists are relative to the master, in the fragment home.
+    int bandwidth = 0;
+    if (has_video) {
+        bandwidth += format->vcodec->video_data_rate > 0 ? format->vcodec->video_data_rate : 800000;
+    }
+    if (has_audio) {
+        bandwidth += format->acodec->audio_data_rate > 0 ? format->acodec->audio_data_rate : 48000;
+    }
+
+    stringstream ss;
+    ss << "#EXTM3U" << SRS_CONSTS_LF
+       << "#EXT-X-VERSION:7" << SRS_CONSTS_LF
+       << "#EXT-X-INDEPENDENT-SEGMENTS" << SRS_CONSTS_LF;
+
+    if (!has_video) {
+        // For pure audio, the audio m3u8 is the variant stream.
+        ss << "#EXT-X-STREAM-INF:BANDWIDTH=" << bandwidth << ","
+           << "CODECS=\"" << srs_fmp4_audio_codecs(format) << "\"" << SRS_CONSTS_LF;
+        ss << req->stream << "/audio.m3u8" << SRS_CONSTS_LF;
+    } else {
+        // The HEVC is written as hvc1 when CMAF HLS is enabled, see SrsDashController::refresh_init_mp4.
+        string codecs = srs_fmp4_video_codecs(format, true);
+        if (has_audio) {
+            codecs += "," + srs_fmp4_audio_codecs(format);
+            ss << "#EXT-X-MEDIA:TYPE=AUDIO,GROUP-ID=\"audio\",NAME=\"audio\",DEFAULT=YES,AUTOSELECT=YES,"
+               << "URI=\"" << req->stream << "/audio.m3u8\"" << SRS_CONSTS_LF;
+        }
+        ss << "#EXT-X-STREAM-INF:BANDWIDTH=" << bandwidth << ","
+           << "CODECS=\"" << codecs << "\","
+           << "RESOLUTION=" << format->vcodec->width << "x" << format->vcodec->height;
+        if (has_audio) {
+            ss << ",AUDIO=\"audio\"";
+        }
+        ss << SRS_CONSTS_LF;
+        ss << req->stream << "/video.m3u8" << SRS_CONSTS_LF;
+    }
+
+    if ((err = write_file(home + "/" + master_file, ss.str())) != srs_success) {
+        return srs_error_wrap(err, "master m3u8");
+    }
+
+    return err;
+}
+
+srs_error_t SrsCmafM3u8Writer::write_media(string track, SrsFragmentWindow* fragments)
+{
+    int start_index = srs_max(0, fragments->size() - window_size_);
+
+    srs_utime_t max_duration = 0;
+    for (int i = start_index; i < fragments->size(); ++i) {
+        max_duration = srs_max(max_duration, fragments->at(i)->duration());
+    }
+
+    stringstream ss;
+    ss << "#EXTM3U" << SRS_CONSTS_LF
+       << "#EXT-X-VERSION:7" << SRS_CONSTS_LF
+       << "#EXT-X-TARGETDURATION:" << (int)ceil(srsu2ms(max_duration) / 1000.0) << SRS_CONSTS_LF
+       << "#EXT-X-MEDIA-SEQUENCE:" << fragments->at(start_index)->number() << SRS_CONSTS_LF
+       << "#EXT-X-MAP:URI=\"" << track << "-init.mp4\"" << SRS_CONSTS_LF;
+
+    for (int i = start_index; i < fragments->size(); ++i) {
+        SrsFragment* fragment = fragments->at(i);
+        ss << "#EXTINF:" << srs_fmt("%.3f", srsu2ms(fragment->duration()) / 1000.0) << "," << SRS_CONSTS_LF
+           << track << "-" << fragment->number() << ".m4s" << SRS_CONSTS_LF;
+    }
+
+    return write_file(home + "/" + fragment_home + "/" + track + ".m3u8", ss.str());
+}
+
+srs_error_t SrsCmafM3u8Writer::write_file(string path, string content)
+{
+    srs_error_t err = srs_success;
+
+    SrsFileWriter* fw = new SrsFileWriter();
+    SrsAutoFree(SrsFileWriter, fw);
+
+    string path_tmp = path + ".tmp";
+    if ((err = fw->open(path_tmp)) != srs_success) {
+        return srs_error_wrap(err, "Open m3u8 file=%s failed", path_tmp.c_str());
+    }
+
+    if ((err = fw->write((void*)content.data(), content.length(), NULL)) != srs_success) {
+        return srs_error_wrap(err, "Write m3u8 file=%s failed", path.c_str());
+    }
+
+    if (::rename(path_tmp.c_str(), path.c_str()) < 0) {
+        return srs_error_new(ERROR_DASH_WRITE_FAILED, "Rename %s to %s failed", path_tmp.c_str(), path.c_str());
+    }
+
+    return err;
+}
+
 SrsDashController::SrsDashController()
 {
     req = NULL;
@@ -355,6 +595,7 @@ SrsDashController::SrsDashController()
     video_track_id = 1;
     audio_track_id = 2;
     mpd = new SrsMpdWriter();
+    m3u8 = new SrsCmafM3u8Writer();
     vcurrent = acurrent = NULL;
     vfragments = new SrsFragmentWindow();
     afragments = new SrsFragmentWindow();
@@ -367,6 +608,7 @@ SrsDashController::SrsDashController()
 SrsDashController::~SrsDashController()
 {
     srs_freep(mpd);
+    srs_freep(m3u8);
     srs_freep(vcurrent);
     srs_freep(acurrent);
     srs_freep(vfragments);
@@ -391,6 +633,7 @@ void SrsDashController::dispose()
     }
 
     mpd->dispose();
+    m3u8->dispose();
     
     srs_trace("gracefully dispose dash %s", req? req->get_stream_url().c_str() : "");
 }
@@ -404,6 +647,10 @@ srs_error_t SrsDashController::initialize(SrsRequest* r)
     if ((err = mpd->initialize(r)) != srs_success) {
         return srs_error_wrap(err, "mpd");
     }
+
+    if ((err = m3u8->initialize(r)) != srs_success) {
+        return srs_error_wrap(err, "m3u8");
+    }
     
     return err;
 }
@@ -421,6 +668,10 @@ srs_error_t SrsDashController::on_publish()
         return srs_error_wrap(err, "mpd");
     }
 
+    if ((err = m3u8->on_publish()) != srs_success) {
+        return srs_error_wrap(err, "m3u8");
+    }
+
     srs_freep(vcurrent);
     srs_freep(vfragments);
     vfragments = new SrsFragmentWindow();
@@ -494,8 +745,9 @@ srs_error_t SrsDashController::on_audio(SrsSharedPtrMessage* shared_audio, SrsFo
         mpd->set_availability_start_time(srs_get_system_time() - first_dts_ * SRS_UTIME_MILLISECONDS);
     }
 
-    // TODO: FIXME: Support pure audio streaming.
-    if (video_reaped_) {
+    // For pure audio stream, there is no video to align with, so reap the audio by the fragment duration.
+    bool pure_audio_reap = !format->vcodec && acurrent->duration() >= fragment;
+    if (video_reaped_ || pure_audio_reap) {
         // The video is reaped, audio must be reaped right now to align the timestamp of video.
         video_reaped_ = false;
         // Append current timestamp to calculate right duration.
@@ -618,6 +870,11 @@ srs_error_t SrsDashController::refresh_mpd(SrsFormat* format)
 {
     srs_error_t err = srs_success;
     
+    // The CMAF HLS shares the same fmp4 segments with DASH, and supports pure audio or video stream.
+    if ((err = m3u8->write(format, afragments, vfragments)) != srs_success) {
+        return srs_error_wrap(err, "write m3u8");
+    }
+
     // TODO: FIXME: Support pure audio streaming.
     if (!format->acodec || !format->vcodec) {
         return err;
@@ -656,6 +913,8 @@ srs_error_t SrsDashController::refresh_init_mp4(SrsSharedPtrMessage* msg, SrsFor
     SrsAutoFree(SrsInitMp4, init_mp4);
     
     init_mp4->set_path(path);
+    // Only use hvc1 for CMAF HLS, which is required by Safari, while keep hev1 for DASH.
+    init_mp4->set_hvc1(_srs_config->get_dash_hls(req->vhost));
     
     int tid = msg->is_video()? video_track_id : audio_track_id;
     if ((err = init_mp4->write(format, msg->is_video(), tid)) != srs_success) {
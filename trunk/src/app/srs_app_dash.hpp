@@ -23,6 +23,12 @@ class SrsMpdWriter;
 class SrsMp4M2tsInitEncoder;
 class SrsMp4M2tsSegmentEncoder;
 
+// Get the codecs string of fmp4, for the MPD and m3u8, for example, avc1.64001f, hev1.1.6.L93.B0 and mp4a.40.2
+// The hvc1 should match the sample entry of HEVC in init mp4, see SrsMp4M2tsInitEncoder::set_hvc1.
+// @see RFC6381 and ISO_IEC_14496-15-AVC-format-2012.pdf, Annex E.
+extern std::string srs_fmp4_video_codecs(SrsFormat* format, bool hvc1 = false);
+extern std::string srs_fmp4_audio_codecs(SrsFormat* format);
+
 // The init mp4 for FMP4.
 class SrsInitMp4 : public SrsFragment
 {
@@ -33,6 +39,8 @@ public:
     SrsInitMp4();
     virtual ~SrsInitMp4();
 public:
+    // Whether write HEVC as hvc1 sample entry, see SrsMp4M2tsInitEncoder::set_hvc1.
+    virtual void set_hvc1(bool v);
     // Write the init mp4 file, with the tid(track id).
     virtual srs_error_t write(SrsFormat* format, bool video, int tid);
 };
@@ -102,6 +110,39 @@ public:
     virtual srs_utime_t get_availability_start_time();
 };
 
+// The writer to write HLS m3u8 for the FMP4 segments of DASH, the CMAF HLS, so the segments are muxed once and
+// shared by DASH and HLS. The master m3u8 is beside the MPD, and the media m3u8 are in the fragment home.
+class SrsCmafM3u8Writer
+{
+private:
+    SrsRequest* req;
+private:
+    // Whether write the m3u8, by config dash_hls.
+    bool enabled_;
+    // The base or home dir for dash to write files.
+    std::string home;
+    // The master m3u8 path, relative to home.
+    std::string master_file;
+    // The home for fragment, relative to home.
+    std::string fragment_home;
+    // The number of fragments in m3u8 file.
+    int window_size_;
+public:
+    SrsCmafM3u8Writer();
+    virtual ~SrsCmafM3u8Writer();
+public:
+    virtual void dispose();
+public:
+    virtual srs_error_t initialize(SrsRequest* r);
+    virtual srs_error_t on_publish();
+    // Write the master and media m3u8 according to parsed format of stream.
+    virtual srs_error_t write(SrsFormat* format, SrsFragmentWindow* afragments, SrsFragmentWindow* vfragments);
+private:
+    // Write the media m3u8 of track, such as video or audio.
+    virtual srs_error_t write_media(std::string track, SrsFragmentWindow* fragments);
+    virtual srs_error_t write_file(std::string path, std::string content);
+};
+
 // The controller for DASH, control the MPD and FMP4 generating system.
 class SrsDashController
 {
@@ -109,6 +150,7 @@ private:
     SrsRequest* req;
     SrsFormat* format_;
     SrsMpdWriter* mpd;
+    SrsCmafM3u8Writer* m3u8;
 private:
     SrsFragmentedMp4* vcurrent;
     SrsFragmentWindow* vfragments;
@@ -0,0 +1,1203 @@
+//
+// Copyright (c) 2013-2023 The SRS Authors
+//
+// SPDX-License-Identifier: MIT or MulanPSL-2.0
+//
+
+#include <srs_app_delivery.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+using namespace std;
+
+#include <srs_kernel_flv.hpp>
+#include <srs_kernel_codec.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_kernel_buffer.hpp>
+#include <srs_core_autofree.hpp>
+#include <srs_protocol_utility.hpp>
+#include <srs_protocol_log.hpp>
+#include <srs_protocol_rtmp_stack.hpp>
+#include <srs_protocol_rtmp_msg_array.hpp>
+#include <srs_protocol_http_stack.hpp>
+#include <srs_app_source.hpp>
+#include <srs_app_config.hpp>
+#include <srs_app_threads.hpp>
+#include <srs_app_statistic.hpp>
+#include <srs_app_http_hooks.hpp>
+
+SrsDeliveryJob::SrsDeliveryJob(SrsDeliveryJobType type, string url)
+{
+    type_ = type;
+    url_ = url;
+    worker_ = -1;
+    fd_ = -1;
+    chunk_size_ = SRS_CONSTS_RTMP_PROTOCOL_CHUNK_SIZE;
+    stream_id_ = 0;
+    flv_ = false;
+}
+
+SrsDeliveryJob::~SrsDeliveryJob()
+{
+    // The fd is not taken by worker, for example, the worker is stopped.
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+
+    for (int i = 0; i < (int)msgs_.size(); i++) {
+        SrsSharedPtrMessage* msg = msgs_.at(i);
+        srs_freep(msg);
+    }
+}
+
+SrsDeliveryMessage::SrsDeliveryMessage(SrsSharedPtrMessage* msg)
+{
+    msg_ = msg;
+    refs_ = 1;
+}
+
+SrsDeliveryMessage::~SrsDeliveryMessage()
+{
+    srs_freep(msg_);
+}
+
+SrsDeliveryMessage* SrsDeliveryMessage::ref()
+{
+    refs_++;
+    return this;
+}
+
+void SrsDeliveryMessage::unref(SrsDeliveryMessage* msg)
+{
+    if (msg && --msg->refs_ <= 0) {
+        srs_freep(msg);
+    }
+}
+
+SrsDeliveryReplica::SrsDeliveryReplica(string url, int max_msgs)
+{
+    url_ = url;
+    meta_ = video_sh_ = audio_sh_ = NULL;
+    first_ = 0;
+    keyframe_ = prev_keyframe_ = -1;
+    max_msgs_ = max_msgs;
+    cond_ = srs_cond_new();
+    nn_players_ = 0;
+}
+
+SrsDeliveryReplica::~SrsDeliveryReplica()
+{
+    SrsDeliveryMessage::unref(meta_);
+    SrsDeliveryMessage::unref(video_sh_);
+    SrsDeliveryMessage::unref(audio_sh_);
+
+    for (int i = 0; i < (int)msgs_.size(); i++) {
+        SrsDeliveryMessage* msg = msgs_.at(i);
+        SrsDeliveryMessage::unref(msg);
+    }
+
+    srs_cond_destroy(cond_);
+}
+
+void SrsDeliveryReplica::on_message(SrsSharedPtrMessage* msg)
+{
+    int64_t seq = head();
+    SrsDeliveryMessage* m = new SrsDeliveryMessage(msg);
+
+    // Update the cached metadata and sequence headers, which are also in ring for the playing players.
+    if (!msg->is_av()) {
+        SrsDeliveryMessage::unref(meta_);
+        meta_ = m->ref();
+    } else if (msg->is_video() && SrsFlvVideo::sh(msg->payload, msg->size)) {
+        SrsDeliveryMessage::unref(video_sh_);
+        video_sh_ = m->ref();
+    } else if (msg->is_audio() && SrsFlvAudio::sh(msg->payload, msg->size)) {
+        SrsDeliveryMessage::unref(audio_sh_);
+        audio_sh_ = m->ref();
+    } else if (msg->is_video() && SrsFlvVideo::keyframe(msg->payload, msg->size)) {
+        prev_keyframe_ = keyframe_;
+        keyframe_ = seq;
+    }
+
+    msgs_.push_back(m);
+    shrink();
+}
+
+void SrsDeliveryReplica::notify()
+{
+    srs_cond_broadcast(cond_);
+}
+
+int SrsDeliveryReplica::wait(srs_utime_t timeout)
+{
+    return srs_cond_timedwait(cond_, timeout);
+}
+
+string SrsDeliveryReplica::url()
+{
+    return url_;
+}
+
+int64_t SrsDeliveryReplica::first()
+{
+    return first_;
+}
+
+int64_t SrsDeliveryReplica::head()
+{
+    return first_ + (int64_t)msgs_.size();
+}
+
+int64_t SrsDeliveryReplica::start()
+{
+    return (keyframe_ >= 0) ? keyframe_ : head();
+}
+
+SrsDeliveryMessage* SrsDeliveryReplica::at(int64_t seq)
+{
+    srs_assert(seq >= first_ && seq < head());
+    return msgs_.at(seq - first_);
+}
+
+void SrsDeliveryReplica::dump_headers(vector<SrsDeliveryMessage*>& msgs)
+{
+    if (meta_) {
+        msgs.push_back(meta_->ref());
+    }
+    if (video_sh_) {
+        msgs.push_back(video_sh_->ref());
+    }
+    if (audio_sh_) {
+        msgs.push_back(audio_sh_->ref());
+    }
+}
+
+void SrsDeliveryReplica::shrink()
+{
+    // Drop the messages before the previous GOP, or when exceed the max messages.
+    while (!msgs_.empty()) {
+        bool overflow = (int)msgs_.size() > max_msgs_;
+        bool expired = prev_keyframe_ >= 0 && first_ < prev_keyframe_;
+        if (!overflow && !expired) {
+            break;
+        }
+
+        SrsDeliveryMessage* msg = msgs_.front();
+        SrsDeliveryMessage::unref(msg);
+        msgs_.pop_front();
+        first_++;
+    }
+
+    if (prev_keyframe_ < first_) {
+        prev_keyframe_ = -1;
+    }
+    if (keyframe_ < first_) {
+        keyframe_ = -1;
+    }
+}
+
+SrsDeliveryPlayer::SrsDeliveryPlayer(SrsDeliveryWorker* worker, SrsDeliveryReplica* replica, SrsDeliveryJob* job)
+{
+    worker_ = worker;
+    replica_ = replica;
+
+    stfd_ = srs_netfd_open_socket(job->fd_);
+    if (stfd_) {
+        job->fd_ = -1;
+    }
+
+    id_ = job->id_;
+    chunk_size_ = job->chunk_size_;
+    stream_id_ = job->stream_id_;
+    flv_ = job->flv_;
+    cursor_ = 0;
+    send_trd_ = recv_trd_ = NULL;
+    closed_ = false;
+}
+
+SrsDeliveryPlayer::~SrsDeliveryPlayer()
+{
+    stop();
+    srs_close_stfd(stfd_);
+}
+
+int SrsDeliveryPlayer::start()
+{
+    if (!stfd_) {
+        return -1;
+    }
+
+    // Start the receiver first, because the sender notifies the worker when done.
+    if ((recv_trd_ = (srs_thread_t)_pfn_st_thread_create(pfn_recv, this, 1, 0)) == NULL) {
+        return -1;
+    }
+
+    if ((send_trd_ = (srs_thread_t)_pfn_st_thread_create(pfn_send, this, 1, 0)) == NULL) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void SrsDeliveryPlayer::stop()
+{
+    closed_ = true;
+
+    if (send_trd_) {
+        srs_thread_interrupt(send_trd_);
+        srs_thread_join(send_trd_, NULL);
+        send_trd_ = NULL;
+    }
+
+    if (recv_trd_) {
+        srs_thread_interrupt(recv_trd_);
+        srs_thread_join(recv_trd_, NULL);
+        recv_trd_ = NULL;
+    }
+}
+
+void* SrsDeliveryPlayer::pfn_send(void* arg)
+{
+    SrsDeliveryPlayer* player = (SrsDeliveryPlayer*)arg;
+    player->do_send();
+    return NULL;
+}
+
+void* SrsDeliveryPlayer::pfn_recv(void* arg)
+{
+    SrsDeliveryPlayer* player = (SrsDeliveryPlayer*)arg;
+    player->do_recv();
+    return NULL;
+}
+
+void SrsDeliveryPlayer::do_send()
+{
+    vector<SrsDeliveryMessage*> refs;
+    vector<SrsSharedPtrMessage*> msgs;
+
+    // Start from the last keyframe, with the metadata and sequence headers.
+    replica_->dump_headers(refs);
+    cursor_ = replica_->start();
+
+    while (!closed_) {
+        // The player is too slow and the messages are dropped, skip to the last keyframe.
+        if (cursor_ < replica_->first()) {
+            cursor_ = replica_->start();
+        }
+
+        // Refer to the messages, because the ring might shrink when we are sending.
+        int64_t head = srs_min(replica_->head(), cursor_ + SRS_PERF_MW_MSGS);
+        for (; cursor_ < head; cursor_++) {
+            refs.push_back(replica_->at(cursor_)->ref());
+        }
+
+        if (refs.empty()) {
+            replica_->wait(SRS_UTIME_NO_TIMEOUT);
+            continue;
+        }
+
+        for (int i = 0; i < (int)refs.size(); i++) {
+            msgs.push_back(refs.at(i)->msg_);
+        }
+
+        int r0 = send_messages(msgs);
+
+        for (int i = 0; i < (int)refs.size(); i++) {
+            SrsDeliveryMessage::unref(refs.at(i));
+        }
+        refs.clear();
+        msgs.clear();
+
+        if (r0 != 0) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < (int)refs.size(); i++) {
+        SrsDeliveryMessage::unref(refs.at(i));
+    }
+
+    closed_ = true;
+    if (recv_trd_) {
+        srs_thread_interrupt(recv_trd_);
+    }
+
+    worker_->on_player_done(this);
+}
+
+void SrsDeliveryPlayer::do_recv()
+{
+    // Drop all messages from player, such as acknowledgement or HTTP request, we only detect whether the peer is closed.
+    char buf[4096];
+    while (!closed_) {
+        if (srs_read(stfd_, buf, sizeof(buf), SRS_UTIME_NO_TIMEOUT) <= 0) {
+            break;
+        }
+    }
+
+    closed_ = true;
+    if (send_trd_) {
+        srs_thread_interrupt(send_trd_);
+    }
+}
+
+int SrsDeliveryPlayer::send_messages(vector<SrsSharedPtrMessage*>& msgs)
+{
+    return flv_ ? send_flv(msgs) : send_rtmp(msgs);
+}
+
+int SrsDeliveryPlayer::send_rtmp(vector<SrsSharedPtrMessage*>& msgs)
+{
+    // Allocate the headers for all chunks first, because the iovs refer to it.
+    int nn_chunks = 0;
+    for (int i = 0; i < (int)msgs.size(); i++) {
+        SrsSharedPtrMessage* msg = msgs.at(i);
+        nn_chunks += srs_max(1, (msg->size + chunk_size_ - 1) / chunk_size_);
+    }
+
+    if ((int)headers_.size() < nn_chunks * SRS_CONSTS_RTMP_MAX_FMT0_HEADER_SIZE) {
+        headers_.resize(nn_chunks * SRS_CONSTS_RTMP_MAX_FMT0_HEADER_SIZE);
+    }
+    if ((int)iovs_.size() < nn_chunks * 2) {
+        iovs_.resize(nn_chunks * 2);
+    }
+
+    char* p = &headers_[0];
+    int nn_iovs = 0;
+    for (int i = 0; i < (int)msgs.size(); i++) {
+        SrsSharedPtrMessage* msg = msgs.at(i);
+
+        // The stream id is per player, and the message is shared by players of worker, so we set it before generating
+        // the chunk header, and never yield util all headers are generated.
+        msg->stream_id = stream_id_;
+
+        char* payload = msg->payload;
+        char* end = msg->payload + msg->size;
+        bool c0 = true;
+        do {
+            int nn_header = msg->chunk_header(p, SRS_CONSTS_RTMP_MAX_FMT0_HEADER_SIZE, c0);
+            iovs_[nn_iovs].iov_base = p;
+            iovs_[nn_iovs].iov_len = nn_header;
+            p += nn_header;
+
+            int size = srs_min(chunk_size_, (int)(end - payload));
+            iovs_[nn_iovs + 1].iov_base = payload;
+            iovs_[nn_iovs + 1].iov_len = size;
+            payload += size;
+
+            nn_iovs += 2;
+            c0 = false;
+        } while (payload < end);
+    }
+
+    return writev(nn_iovs);
+}
+
+int SrsDeliveryPlayer::send_flv(vector<SrsSharedPtrMessage*>& msgs)
+{
+    // Each message is a FLV tag, with a tag header, payload and previous tag size.
+    int nn_headers = SRS_FLV_TAG_HEADER_SIZE + SRS_FLV_PREVIOUS_TAG_SIZE;
+    if ((int)headers_.size() < (int)msgs.size() * nn_headers) {
+        headers_.resize(msgs.size() * nn_headers);
+    }
+    // Each tag requires 3 iovs, and the chunk header and eof of HTTP chunked encoding.
+    if ((int)iovs_.size() < (int)msgs.size() * 3 + 2) {
+        iovs_.resize(msgs.size() * 3 + 2);
+    }
+
+    char* p = &headers_[0];
+    int nn_iovs = 1;
+    int size = 0;
+    for (int i = 0; i < (int)msgs.size(); i++) {
+        SrsSharedPtrMessage* msg = msgs.at(i);
+
+        char type = SrsFrameTypeScript;
+        int64_t timestamp = 0;
+        if (msg->is_av()) {
+            type = msg->is_audio() ? SrsFrameTypeAudio : SrsFrameTypeVideo;
+            timestamp = msg->timestamp & 0x7fffffff;
+        }
+
+        // The same as SrsFlvTransmuxer, we should never use it because the error is not thread-safe.
+        SrsBuffer tag(p, nn_headers);
+        tag.write_1bytes(type);
+        tag.write_3bytes(msg->size);
+        tag.write_3bytes((int32_t)timestamp);
+        tag.write_1bytes((timestamp >> 24) & 0xFF);
+        tag.write_3bytes(0x00);
+        tag.write_4bytes(SRS_FLV_TAG_HEADER_SIZE + msg->size);
+
+        iovs_[nn_iovs].iov_base = p;
+        iovs_[nn_iovs].iov_len = SRS_FLV_TAG_HEADER_SIZE;
+        iovs_[nn_iovs + 1].iov_base = msg->payload;
+        iovs_[nn_iovs + 1].iov_len = msg->size;
+        iovs_[nn_iovs + 2].iov_base = p + SRS_FLV_TAG_HEADER_SIZE;
+        iovs_[nn_iovs + 2].iov_len = SRS_FLV_PREVIOUS_TAG_SIZE;
+
+        p += nn_headers;
+        nn_iovs += 3;
+        size += nn_headers + msg->size;
+    }
+
+    // Send all tags in one chunk, see SrsHttpMessageWriter::writev.
+    char chunk[32];
+    int nn_chunk = snprintf(chunk, sizeof(chunk), "%x" SRS_HTTP_CRLF, size);
+    iovs_[0].iov_base = chunk;
+    iovs_[0].iov_len = nn_chunk;
+    iovs_[nn_iovs].iov_base = (char*)SRS_HTTP_CRLF;
+    iovs_[nn_iovs].iov_len = 2;
+    nn_iovs++;
+
+    return writev(nn_iovs);
+}
+
+int SrsDeliveryPlayer::writev(int nn_iovs)
+{
+    // Send in multiple times, because of the limits of writev iovs.
+    for (int i = 0; i < nn_iovs; i += SRS_CONSTS_IOVS_MAX) {
+        int count = srs_min(SRS_CONSTS_IOVS_MAX, nn_iovs - i);
+        if (srs_writev(stfd_, &iovs_[i], count, SRS_CONSTS_RTMP_TIMEOUT) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+SrsDeliveryWorker::SrsDeliveryWorker(SrsDeliveryWorkers* owner, int index)
+{
+    owner_ = owner;
+    index_ = index;
+    jobs_pipe_[0] = jobs_pipe_[1] = -1;
+    lock_ = new SrsThreadMutex();
+    nn_players_ = 0;
+}
+
+// The worker thread must be stopped, see SrsDeliveryWorkers::stop_workers.
+SrsDeliveryWorker::~SrsDeliveryWorker()
+{
+    // The jobs which are not consumed by worker, for example, the duplicated fd of player.
+    for (int i = 0; i < (int)jobs_.size(); i++) {
+        SrsDeliveryJob* job = jobs_.at(i);
+        srs_freep(job);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (jobs_pipe_[i] >= 0) {
+            ::close(jobs_pipe_[i]);
+        }
+    }
+
+    srs_freep(lock_);
+}
+
+void SrsDeliveryWorker::on_player_done(SrsDeliveryPlayer* player)
+{
+    std::vector<SrsDeliveryPlayer*>::iterator it = std::find(players_.begin(), players_.end(), player);
+    if (it != players_.end()) {
+        players_.erase(it);
+    }
+    zombies_.push_back(player);
+
+    // Wake up the worker to free the player, ignore if pipe is full.
+    char c = 0;
+    ssize_t nn = ::write(jobs_pipe_[1], &c, 1);
+    (void)nn;
+}
+
+void SrsDeliveryWorker::dispose()
+{
+    // Stop the alive players, which notify us by on_player_done.
+    while (!players_.empty()) {
+        SrsDeliveryPlayer* player = players_.back();
+        player->stop();
+
+        // The player which is never started, never notifies us.
+        if (!players_.empty() && players_.back() == player) {
+            players_.pop_back();
+            zombies_.push_back(player);
+        }
+    }
+
+    for (int i = 0; i < (int)zombies_.size(); i++) {
+        SrsDeliveryPlayer* player = zombies_.at(i);
+        srs_freep(player);
+    }
+    zombies_.clear();
+
+    // The joined coroutines free their stacks when scheduled, so we yield to them before ST is destroyed.
+    srs_thread_yield();
+
+    std::map<string, SrsDeliveryReplica*>::iterator it;
+    for (it = replicas_.begin(); it != replicas_.end(); ++it) {
+        SrsDeliveryReplica* replica = it->second;
+        srs_freep(replica);
+    }
+    replicas_.clear();
+}
+
+SrsDeliveryFeeder::SrsDeliveryFeeder(SrsDeliveryWorkers* owner, SrsDeliveryWorker* worker, string url)
+{
+    owner_ = owner;
+    worker_ = worker;
+    url_ = url;
+    nn_players_ = 0;
+    consumer_ = NULL;
+    trd_ = NULL;
+    mw_msgs_ = SRS_PERF_MW_MIN_MSGS;
+    mw_sleep_ = SRS_PERF_MW_SLEEP;
+}
+
+SrsDeliveryFeeder::~SrsDeliveryFeeder()
+{
+    srs_freep(trd_);
+    srs_freep(consumer_);
+}
+
+srs_error_t SrsDeliveryFeeder::start(SrsLiveSource* source, SrsRequest* req)
+{
+    srs_error_t err = srs_success;
+
+    if ((err = source->create_consumer(consumer_)) != srs_success) {
+        return srs_error_wrap(err, "create consumer");
+    }
+
+    if ((err = source->consumer_dumps(consumer_)) != srs_success) {
+        return srs_error_wrap(err, "dumps consumer");
+    }
+
+    consumer_->set_queue_size(_srs_config->get_queue_length(req->vhost));
+
+    bool realtime = _srs_config->get_realtime_enabled(req->vhost);
+    mw_msgs_ = _srs_config->get_mw_msgs(req->vhost, realtime);
+    mw_sleep_ = _srs_config->get_mw_sleep(req->vhost);
+
+    trd_ = new SrsSTCoroutine("delivery", this, _srs_context->get_id());
+    if ((err = trd_->start()) != srs_success) {
+        return srs_error_wrap(err, "start coroutine");
+    }
+
+    return err;
+}
+
+srs_error_t SrsDeliveryFeeder::cycle()
+{
+    srs_error_t err = do_cycle();
+
+    // The feeder is stopped when no player in worker, so it never quit normally.
+    if (err != srs_success && srs_error_code(err) != ERROR_THREAD_INTERRUPED) {
+        srs_warn("Delivery: Feed %s to worker #%d err %s", url_.c_str(), worker_->index_, srs_error_desc(err).c_str());
+    }
+
+    return err;
+}
+
+srs_error_t SrsDeliveryFeeder::do_cycle()
+{
+    srs_error_t err = srs_success;
+
+    SrsMessageArray msgs(SRS_PERF_MW_MSGS);
+
+    while (true) {
+        if ((err = trd_->pull()) != srs_success) {
+            return srs_error_wrap(err, "pull");
+        }
+
+        consumer_->wait(mw_msgs_, mw_sleep_);
+
+        int count = 0;
+        if ((err = consumer_->dump_packets(&msgs, count)) != srs_success) {
+            return srs_error_wrap(err, "dump packets");
+        }
+
+        if (count <= 0) {
+            continue;
+        }
+
+        // Deep copy for worker, because the ref-count of shared message is not thread-safe.
+        vector<SrsSharedPtrMessage*> copies;
+        for (int i = 0; i < count; i++) {
+            SrsSharedPtrMessage* msg = msgs.msgs[i];
+            copies.push_back(msg->deep_copy());
+            srs_freep(msg);
+            msgs.msgs[i] = NULL;
+        }
+
+        owner_->feed(this, copies);
+    }
+
+    return err;
+}
+
+SrsDeliveryAsyncCallOnStop::SrsDeliveryAsyncCallOnStop(SrsContextId cid, SrsRequest* req)
+{
+    cid_ = cid;
+    req_ = req->copy();
+}
+
+SrsDeliveryAsyncCallOnStop::~SrsDeliveryAsyncCallOnStop()
+{
+    srs_freep(req_);
+}
+
+srs_error_t SrsDeliveryAsyncCallOnStop::call()
+{
+    srs_error_t err = srs_success;
+
+    if (!_srs_config->get_vhost_http_hooks_enabled(req_->vhost)) {
+        return err;
+    }
+
+    // the http hooks will cause context switch,
+    // so we must copy all hooks for the on_connect may freed.
+    // @see https://github.com/ossrs/srs/issues/475
+    vector<string> hooks;
+
+    if (true) {
+        SrsConfDirective* conf = _srs_config->get_vhost_on_stop(req_->vhost);
+
+        if (!conf) {
+            return err;
+        }
+
+        hooks = conf->args;
+    }
+
+    SrsContextRestore(_srs_context->get_id());
+    _srs_context->set_id(cid_);
+
+    for (int i = 0; i < (int)hooks.size(); i++) {
+        std::string url = hooks.at(i);
+        SrsHttpHooks::on_stop(url, req_);
+    }
+
+    return err;
+}
+
+std::string SrsDeliveryAsyncCallOnStop::to_string()
+{
+    return std::string("");
+}
+
+SrsDeliveryWorkers* _srs_delivery = NULL;
+
+SrsDeliveryWorkers::SrsDeliveryWorkers()
+{
+    done_pipe_[0] = done_pipe_[1] = -1;
+    done_fd_ = NULL;
+    trd_ = NULL;
+
+    lock_ = new SrsThreadMutex();
+    quit_ = false;
+    nn_running_ = 0;
+
+    async_ = new SrsAsyncCallWorker();
+}
+
+SrsDeliveryWorkers::~SrsDeliveryWorkers()
+{
+    srs_freep(trd_);
+
+    std::map<string, vector<SrsDeliveryFeeder*> >::iterator it;
+    for (it = feeders_.begin(); it != feeders_.end(); ++it) {
+        vector<SrsDeliveryFeeder*>& feeders = it->second;
+        for (int i = 0; i < (int)feeders.size(); i++) {
+            SrsDeliveryFeeder* feeder = feeders.at(i);
+            srs_freep(feeder);
+        }
+    }
+
+    // Stop the workers before freeing them, because they access the workers and pipes.
+    stop_workers();
+
+    for (int i = 0; i < (int)workers_.size(); i++) {
+        SrsDeliveryWorker* worker = workers_.at(i);
+        srs_freep(worker);
+    }
+
+    for (int i = 0; i < (int)done_.size(); i++) {
+        SrsDeliveryJob* job = done_.at(i);
+        srs_freep(job);
+    }
+
+    std::map<string, SrsRequest*>::iterator cit;
+    for (cit = clients_.begin(); cit != clients_.end(); ++cit) {
+        SrsRequest* req = cit->second;
+        srs_freep(req);
+    }
+
+    async_->stop();
+    srs_freep(async_);
+
+    srs_close_stfd(done_fd_);
+    if (done_pipe_[1] >= 0) {
+        ::close(done_pipe_[1]);
+    }
+    srs_freep(lock_);
+}
+
+srs_error_t SrsDeliveryWorkers::initialize()
+{
+    srs_error_t err = srs_success;
+
+    // Ignore if already started, for example, reload.
+    if (trd_) {
+        return err;
+    }
+
+    int nn_workers = _srs_config->get_delivery_workers();
+    if (!_srs_config->get_delivery_enabled() || nn_workers <= 0) {
+        return err;
+    }
+
+    if (::pipe(done_pipe_) < 0) {
+        return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "create pipe");
+    }
+
+    if ((done_fd_ = srs_netfd_open(done_pipe_[0])) == NULL) {
+        return srs_error_new(ERROR_ST_OPEN_SOCKET, "open pipe fd=%d", done_pipe_[0]);
+    }
+
+    for (int i = 0; i < nn_workers; i++) {
+        SrsDeliveryWorker* worker = new SrsDeliveryWorker(this, i);
+        workers_.push_back(worker);
+
+        if (::pipe(worker->jobs_pipe_) < 0) {
+            return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "create pipe");
+        }
+
+        // Never block the ST thread when submit job, see submit.
+        int flags = fcntl(worker->jobs_pipe_[1], F_GETFL, 0);
+        if (flags == -1 || fcntl(worker->jobs_pipe_[1], F_SETFL, flags | O_NONBLOCK) == -1) {
+            return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "nonblock pipe fd=%d", worker->jobs_pipe_[1]);
+        }
+    }
+
+    if ((err = async_->start()) != srs_success) {
+        return srs_error_wrap(err, "start async worker");
+    }
+
+    trd_ = new SrsSTCoroutine("delivery", this);
+    if ((err = trd_->start()) != srs_success) {
+        return srs_error_wrap(err, "start coroutine");
+    }
+
+    for (int i = 0; i < (int)workers_.size(); i++) {
+        // Count the worker before it starts, so we always wait for it when stopping.
+        if (true) {
+            SrsThreadLocker(lock_);
+            nn_running_++;
+        }
+
+        if ((err = _srs_thread_pool->execute("delivery", SrsDeliveryWorkers::start, workers_.at(i))) != srs_success) {
+            SrsThreadLocker(lock_);
+            nn_running_--;
+            return srs_error_wrap(err, "start worker #%d", i);
+        }
+    }
+
+    srs_trace("Delivery: Deliver mega stream in %d workers, players=%d", nn_workers, _srs_config->get_delivery_players());
+
+    return err;
+}
+
+bool SrsDeliveryWorkers::enabled()
+{
+    return trd_ != NULL;
+}
+
+bool SrsDeliveryWorkers::hot(SrsLiveSource* source, SrsRequest* req)
+{
+    if (!enabled()) {
+        return false;
+    }
+
+    string url = req->get_stream_url();
+    int players = source->nb_consumers();
+
+    // The feeders are consumers of source, but not players.
+    std::map<string, vector<SrsDeliveryFeeder*> >::iterator fit = feeders_.find(url);
+    if (fit != feeders_.end()) {
+        vector<SrsDeliveryFeeder*>& feeders = fit->second;
+        for (int i = 0; i < (int)feeders.size(); i++) {
+            if (feeders.at(i)) {
+                players--;
+            }
+        }
+    }
+
+    std::map<string, int>::iterator it = players_.find(url);
+    if (it != players_.end()) {
+        players += it->second;
+    }
+
+    return players >= _srs_config->get_delivery_players();
+}
+
+srs_error_t SrsDeliveryWorkers::handoff(SrsLiveSource* source, SrsRequest* req, string id, int fd, int chunk_size, int stream_id)
+{
+    SrsDeliveryJob* job = new SrsDeliveryJob(SrsDeliveryJobPlay, req->get_stream_url());
+    job->id_ = id;
+    job->chunk_size_ = chunk_size;
+    job->stream_id_ = stream_id;
+    return do_handoff(source, req, req, fd, job);
+}
+
+srs_error_t SrsDeliveryWorkers::handoff_flv(SrsLiveSource* source, SrsRequest* req, SrsRequest* client, string id, int fd)
+{
+    SrsDeliveryJob* job = new SrsDeliveryJob(SrsDeliveryJobPlay, req->get_stream_url());
+    job->id_ = id;
+    job->flv_ = true;
+    return do_handoff(source, req, client, fd, job);
+}
+
+bool SrsDeliveryWorkers::delivered(string id)
+{
+    return clients_.find(id) != clients_.end();
+}
+
+srs_error_t SrsDeliveryWorkers::do_handoff(SrsLiveSource* source, SrsRequest* req, SrsRequest* client, int fd, SrsDeliveryJob* job)
+{
+    srs_error_t err = srs_success;
+
+    SrsDeliveryWorker* worker = least_loaded();
+    string url = req->get_stream_url();
+
+    // Start a feeder for the replica of worker, if it's the first player of stream in this worker.
+    vector<SrsDeliveryFeeder*>& feeders = feeders_[url];
+    if (feeders.empty()) {
+        feeders.resize(workers_.size(), NULL);
+    }
+
+    SrsDeliveryFeeder* feeder = feeders.at(worker->index_);
+    if (!feeder) {
+        feeder = new SrsDeliveryFeeder(this, worker, url);
+        if ((err = feeder->start(source, req)) != srs_success) {
+            srs_freep(feeder);
+            srs_freep(job);
+            return srs_error_wrap(err, "start feeder");
+        }
+        feeders[worker->index_] = feeder;
+    }
+
+    // The worker owns the duplicated fd, and the caller closes its own.
+    if ((job->fd_ = ::dup(fd)) < 0) {
+        srs_freep(job);
+        return srs_error_new(ERROR_SOCKET_CREATE, "dup fd=%d", fd);
+    }
+
+    worker->nn_players_++;
+    feeder->nn_players_++;
+    players_[url]++;
+
+    // Keep the client in stat util the player is gone, but the connection is freed, so it can't be kicked off.
+    string id = job->id_;
+    if (!id.empty() && clients_.find(id) == clients_.end()) {
+        SrsStatistic::instance()->on_client_handoff(id);
+        clients_[id] = client->copy();
+    }
+
+    // Never touch the job after submitted, it's freed by worker.
+    string desc = job->flv_ ? "FLV" : "RTMP";
+    submit(worker, job);
+
+    srs_trace("Delivery: Handoff %s player of %s to worker #%d, players=%d/%d", desc.c_str(), url.c_str(),
+        worker->index_, feeder->nn_players_, worker->nn_players_);
+
+    return err;
+}
+
+SrsDeliveryWorker* SrsDeliveryWorkers::least_loaded()
+{
+    SrsDeliveryWorker* best = NULL;
+    for (int i = 0; i < (int)workers_.size(); i++) {
+        SrsDeliveryWorker* worker = workers_.at(i);
+        if (!best || worker->nn_players_ < best->nn_players_) {
+            best = worker;
+        }
+    }
+    return best;
+}
+
+void SrsDeliveryWorkers::feed(SrsDeliveryFeeder* feeder, vector<SrsSharedPtrMessage*>& msgs)
+{
+    SrsDeliveryJob* job = new SrsDeliveryJob(SrsDeliveryJobMessages, feeder->url_);
+    job->msgs_.swap(msgs);
+    submit(feeder->worker_, job);
+}
+
+void SrsDeliveryWorkers::submit(SrsDeliveryWorker* worker, SrsDeliveryJob* job)
+{
+    bool wakeup = false;
+    if (true) {
+        SrsThreadMutex* lock = worker->lock_;
+        SrsThreadLocker(lock);
+        wakeup = worker->jobs_.empty();
+        worker->jobs_.push_back(job);
+    }
+
+    // Wake up the worker if it might be idle, ignore if pipe is full, because worker consumes all jobs when wake up.
+    if (wakeup) {
+        char c = 0;
+        ssize_t nn = ::write(worker->jobs_pipe_[1], &c, 1);
+        (void)nn;
+    }
+}
+
+srs_error_t SrsDeliveryWorkers::cycle()
+{
+    srs_error_t err = srs_success;
+
+    while (true) {
+        if ((err = trd_->pull()) != srs_success) {
+            return srs_error_wrap(err, "pull");
+        }
+
+        char buf[128];
+        ssize_t nn = srs_read(done_fd_, buf, sizeof(buf), SRS_UTIME_NO_TIMEOUT);
+        if (nn <= 0) {
+            return srs_error_new(ERROR_SOCKET_READ, "read pipe, nn=%d", (int)nn);
+        }
+
+        vector<SrsDeliveryJob*> jobs;
+        if (true) {
+            SrsThreadLocker(lock_);
+            jobs.swap(done_);
+        }
+
+        for (int i = 0; i < (int)jobs.size(); i++) {
+            SrsDeliveryJob* job = jobs.at(i);
+            SrsAutoFree(SrsDeliveryJob, job);
+
+            if (job->type_ == SrsDeliveryJobLeave) {
+                on_leave(job);
+            }
+        }
+    }
+
+    return err;
+}
+
+void SrsDeliveryWorkers::on_leave(SrsDeliveryJob* job)
+{
+    srs_error_t err = srs_success;
+
+    SrsDeliveryWorker* worker = workers_.at(job->worker_);
+    worker->nn_players_--;
+
+    // The player is gone, remove it from stat and fire the on_stop hook.
+    std::map<string, SrsRequest*>::iterator cit = clients_.find(job->id_);
+    if (cit != clients_.end()) {
+        SrsRequest* req = cit->second;
+        SrsAutoFree(SrsRequest, req);
+        clients_.erase(cit);
+
+        SrsStatistic::instance()->on_disconnect(job->id_, srs_success);
+
+        SrsContextId cid;
+        cid.set_value(job->id_);
+        if ((err = async_->execute(new SrsDeliveryAsyncCallOnStop(cid, req))) != srs_success) {
+            srs_warn("Delivery: Ignore on_stop of %s err %s", job->id_.c_str(), srs_error_desc(err).c_str());
+            srs_freep(err);
+        }
+    }
+
+    std::map<string, int>::iterator it = players_.find(job->url_);
+    if (it != players_.end() && --it->second <= 0) {
+        players_.erase(it);
+    }
+
+    std::map<string, vector<SrsDeliveryFeeder*> >::iterator fit = feeders_.find(job->url_);
+    if (fit == feeders_.end()) {
+        return;
+    }
+
+    // Stop the feeder and free the replica, when no player of stream in worker.
+    vector<SrsDeliveryFeeder*>& feeders = fit->second;
+    SrsDeliveryFeeder* feeder = feeders.at(job->worker_);
+    if (!feeder || --feeder->nn_players_ > 0) {
+        return;
+    }
+
+    srs_freep(feeder);
+    feeders[job->worker_] = NULL;
+    submit(worker, new SrsDeliveryJob(SrsDeliveryJobClose, job->url_));
+
+    for (int i = 0; i < (int)feeders.size(); i++) {
+        if (feeders.at(i)) {
+            return;
+        }
+    }
+    feeders_.erase(fit);
+}
+
+srs_error_t SrsDeliveryWorkers::start(void* arg)
+{
+    SrsDeliveryWorker* worker = (SrsDeliveryWorker*)arg;
+    worker->owner_->do_work(worker);
+    return srs_success;
+}
+
+void SrsDeliveryWorkers::stop_workers()
+{
+    if (true) {
+        SrsThreadLocker(lock_);
+        quit_ = true;
+    }
+
+    // Wake up the workers, which quit when see the quit flag.
+    for (int i = 0; i < (int)workers_.size(); i++) {
+        SrsDeliveryWorker* worker = workers_.at(i);
+        char c = 0;
+        ssize_t nn = ::write(worker->jobs_pipe_[1], &c, 1);
+        (void)nn;
+    }
+
+    // Wait for the workers to quit, because they access the workers.
+    while (true) {
+        int nn_running = 0;
+        if (true) {
+            SrsThreadLocker(lock_);
+            nn_running = nn_running_;
+        }
+
+        if (nn_running <= 0) {
+            break;
+        }
+        srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+    }
+}
+
+void SrsDeliveryWorkers::do_work(SrsDeliveryWorker* worker)
+{
+    // The worker has its own ST, so we read the pipe by ST, to run the coroutines of players.
+    srs_netfd_t jobs_fd = srs_netfd_open(worker->jobs_pipe_[0]);
+    if (jobs_fd) {
+        worker->jobs_pipe_[0] = -1;
+        do_work_loop(worker, jobs_fd);
+        worker->dispose();
+        srs_close_stfd(jobs_fd);
+    }
+
+    SrsThreadLocker(lock_);
+    nn_running_--;
+}
+
+void SrsDeliveryWorkers::do_work_loop(SrsDeliveryWorker* worker, srs_netfd_t jobs_fd)
+{
+    while (true) {
+        char buf[128];
+        ssize_t nn = srs_read(jobs_fd, buf, sizeof(buf), SRS_UTIME_NO_TIMEOUT);
+
+        bool quit = false;
+        if (true) {
+            SrsThreadLocker(lock_);
+            quit = quit_;
+        }
+
+        if (quit) {
+            break;
+        }
+
+        // Retry if interrupted, or quit the worker if the pipe is closed or broken, to avoid spinning.
+        if (nn < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if (nn <= 0) {
+            srs_warn("Delivery: Worker #%d quit for read jobs pipe, nn=%d, errno=%d", worker->index_, (int)nn, errno);
+            break;
+        }
+
+        // Free the closed players, and notify the ST thread.
+        vector<SrsDeliveryPlayer*> zombies;
+        zombies.swap(worker->zombies_);
+        for (int i = 0; i < (int)zombies.size(); i++) {
+            SrsDeliveryPlayer* player = zombies.at(i);
+            player->replica_->nn_players_--;
+
+            SrsDeliveryJob* job = new SrsDeliveryJob(SrsDeliveryJobLeave, player->replica_->url());
+            job->worker_ = worker->index_;
+            job->id_ = player->id_;
+            srs_freep(player);
+
+            on_done(job);
+        }
+
+        while (true) {
+            vector<SrsDeliveryJob*> jobs;
+            if (true) {
+                SrsThreadMutex* lock = worker->lock_;
+                SrsThreadLocker(lock);
+                jobs.swap(worker->jobs_);
+            }
+
+            if (jobs.empty()) {
+                break;
+            }
+
+            for (int i = 0; i < (int)jobs.size(); i++) {
+                SrsDeliveryJob* job = jobs.at(i);
+                consume(worker, job);
+                srs_freep(job);
+            }
+        }
+    }
+}
+
+void SrsDeliveryWorkers::consume(SrsDeliveryWorker* worker, SrsDeliveryJob* job)
+{
+    std::map<string, SrsDeliveryReplica*>::iterator it = worker->replicas_.find(job->url_);
+
+    if (job->type_ == SrsDeliveryJobClose) {
+        if (it != worker->replicas_.end() && it->second->nn_players_ <= 0) {
+            SrsDeliveryReplica* replica = it->second;
+            srs_freep(replica);
+            worker->replicas_.erase(it);
+        }
+        return;
+    }
+
+    // The replica is created by the first player or messages of stream.
+    SrsDeliveryReplica* replica = NULL;
+    if (it != worker->replicas_.end()) {
+        replica = it->second;
+    } else {
+        replica = new SrsDeliveryReplica(job->url_);
+        worker->replicas_[job->url_] = replica;
+    }
+
+    if (job->type_ == SrsDeliveryJobMessages) {
+        for (int i = 0; i < (int)job->msgs_.size(); i++) {
+            replica->on_message(job->msgs_.at(i));
+        }
+        job->msgs_.clear();
+        replica->notify();
+        return;
+    }
+
+    if (job->type_ == SrsDeliveryJobPlay) {
+        SrsDeliveryPlayer* player = new SrsDeliveryPlayer(worker, replica, job);
+        replica->nn_players_++;
+        worker->players_.push_back(player);
+
+        // Free the player by the zombies, as well as notify the ST thread.
+        if (player->start() != 0) {
+            worker->on_player_done(player);
+        }
+    }
+}
+
+void SrsDeliveryWorkers::on_done(SrsDeliveryJob* job)
+{
+    if (true) {
+        SrsThreadLocker(lock_);
+        done_.push_back(job);
+    }
+
+    // Notify the ST thread, which reads all done jobs when wake up.
+    char c = 0;
+    ssize_t nn = ::write(done_pipe_[1], &c, 1);
+    (void)nn;
+}
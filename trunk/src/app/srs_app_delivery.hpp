@@ -0,0 +1,321 @@
+//
+// Copyright (c) 2013-2023 The SRS Authors
+//
+// SPDX-License-Identifier: MIT or MulanPSL-2.0
+//
+
+#ifndef SRS_APP_DELIVERY_HPP
+#define SRS_APP_DELIVERY_HPP
+
+#include <srs_core.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <srs_protocol_st.hpp>
+#include <srs_app_st.hpp>
+#include <srs_app_async_call.hpp>
+
+class SrsSharedPtrMessage;
+class SrsThreadMutex;
+class SrsLiveSource;
+class SrsLiveConsumer;
+class SrsRequest;
+class SrsDeliveryWorker;
+class SrsDeliveryWorkers;
+
+// The type of job, submitted by ST thread to worker, or by worker to ST thread.
+enum SrsDeliveryJobType
+{
+    // A player is handed off to the worker, by ST thread.
+    SrsDeliveryJobPlay = 0,
+    // The messages of stream, for the replica of worker, by ST thread.
+    SrsDeliveryJobMessages,
+    // No player of stream in worker, so free the replica, by ST thread.
+    SrsDeliveryJobClose,
+    // A player of worker is closed, by worker.
+    SrsDeliveryJobLeave,
+};
+
+// The job between ST thread and delivery worker.
+class SrsDeliveryJob
+{
+public:
+    SrsDeliveryJobType type_;
+    // The url of stream, to identify the replica.
+    std::string url_;
+    // The worker index, for leave job.
+    int worker_;
+    // For play and leave job, the id of client in stat, that is the context id of connection.
+    std::string id_;
+    // For play job, the duplicated fd of player, and the RTMP chunk size and stream id.
+    int fd_;
+    int chunk_size_;
+    int stream_id_;
+    // For play job, whether HTTP-FLV player in chunked encoding, otherwise RTMP player.
+    bool flv_;
+    // For messages job, the deep copied messages, because the ref-count of shared message is not thread-safe.
+    std::vector<SrsSharedPtrMessage*> msgs_;
+public:
+    SrsDeliveryJob(SrsDeliveryJobType type, std::string url);
+    virtual ~SrsDeliveryJob();
+};
+
+// The message of replica, shared by the ring, the cached headers and the sending players in worker thread, and freed
+// when no one refers to it. We never copy the shared message in worker, because its constructor is not thread-safe.
+class SrsDeliveryMessage
+{
+public:
+    SrsSharedPtrMessage* msg_;
+private:
+    // The reference count, only accessed by the worker thread.
+    int refs_;
+public:
+    // Own the msg, and the reference count is 1.
+    SrsDeliveryMessage(SrsSharedPtrMessage* msg);
+    virtual ~SrsDeliveryMessage();
+public:
+    // Refer to this message, return itself.
+    SrsDeliveryMessage* ref();
+    // Release the message, free it if no one refers to it.
+    static void unref(SrsDeliveryMessage* msg);
+};
+
+// The read-only mirror of a live stream in worker thread, a ring of messages shared by all players of worker,
+// so no per-player queue is required, and each player only keeps the sequence of the next message to send.
+class SrsDeliveryReplica
+{
+private:
+    std::string url_;
+    // The cached metadata and sequence headers, for new players.
+    SrsDeliveryMessage* meta_;
+    SrsDeliveryMessage* video_sh_;
+    SrsDeliveryMessage* audio_sh_;
+    // The ring of messages, the sequence of first message, and the sequence of last keyframe(-1 if no keyframe).
+    std::deque<SrsDeliveryMessage*> msgs_;
+    int64_t first_;
+    int64_t keyframe_;
+    // The sequence of previous keyframe, we keep about two GOPs for players lagging a bit.
+    int64_t prev_keyframe_;
+    // The max number of messages in ring.
+    int max_msgs_;
+    // The cond to notify players when got messages.
+    srs_cond_t cond_;
+public:
+    // The players of replica, only for worker to free it.
+    int nn_players_;
+public:
+    SrsDeliveryReplica(std::string url, int max_msgs = SRS_PERF_DELIVERY_MSGS);
+    virtual ~SrsDeliveryReplica();
+public:
+    // Append the message to ring, the replica owns it.
+    void on_message(SrsSharedPtrMessage* msg);
+    // Notify the waiting players.
+    void notify();
+    // Wait for messages.
+    int wait(srs_utime_t timeout);
+public:
+    std::string url();
+    // The sequence of first message in ring.
+    int64_t first();
+    // The sequence of next message to be appended.
+    int64_t head();
+    // The sequence for new player or player lagging out of ring, from the last keyframe if possible.
+    int64_t start();
+    // Get the message at sequence, which must in [first, head), user should ref it before yield.
+    SrsDeliveryMessage* at(int64_t seq);
+    // Dump the referred cached metadata and sequence headers, user should unref them.
+    void dump_headers(std::vector<SrsDeliveryMessage*>& msgs);
+private:
+    void shrink();
+};
+
+// The RTMP or HTTP-FLV player in worker thread, which sends the messages of replica to the duplicated fd.
+// @remark Never use SrsCoroutine, error or log in worker thread, because the context and log are not thread-safe.
+class SrsDeliveryPlayer
+{
+public:
+    SrsDeliveryWorker* worker_;
+    SrsDeliveryReplica* replica_;
+    // The id of client in stat.
+    std::string id_;
+private:
+    srs_netfd_t stfd_;
+    int chunk_size_;
+    int stream_id_;
+    bool flv_;
+    // The sequence of next message to send.
+    int64_t cursor_;
+    // The coroutine to send messages, and to receive from player to detect the peer closed.
+    srs_thread_t send_trd_;
+    srs_thread_t recv_trd_;
+    bool closed_;
+    // The cache for chunk headers and iovs.
+    std::vector<char> headers_;
+    std::vector<iovec> iovs_;
+public:
+    SrsDeliveryPlayer(SrsDeliveryWorker* worker, SrsDeliveryReplica* replica, SrsDeliveryJob* job);
+    virtual ~SrsDeliveryPlayer();
+public:
+    // Start the coroutines, return -1 if failed.
+    int start();
+    // Stop and join the coroutines.
+    void stop();
+private:
+    static void* pfn_send(void* arg);
+    static void* pfn_recv(void* arg);
+    void do_send();
+    void do_recv();
+    // Send the messages in RTMP chunks or FLV tags, return -1 if failed.
+    int send_messages(std::vector<SrsSharedPtrMessage*>& msgs);
+    int send_rtmp(std::vector<SrsSharedPtrMessage*>& msgs);
+    int send_flv(std::vector<SrsSharedPtrMessage*>& msgs);
+    int writev(int nn_iovs);
+};
+
+// The worker thread to deliver the players of mega streams, each worker runs its own ST, and holds the replica
+// of streams which have players in this worker.
+class SrsDeliveryWorker
+{
+public:
+    SrsDeliveryWorkers* owner_;
+    int index_;
+    // The pipe to wake up the worker when a job is submitted.
+    int jobs_pipe_[2];
+    // To protect the jobs, which are accessed by ST thread and worker thread.
+    SrsThreadMutex* lock_;
+    std::vector<SrsDeliveryJob*> jobs_;
+    // The players in worker, which is only accessed by the ST thread, for placement.
+    int nn_players_;
+    // The replicas and players, only accessed by the worker thread.
+    std::map<std::string, SrsDeliveryReplica*> replicas_;
+    std::vector<SrsDeliveryPlayer*> players_;
+    std::vector<SrsDeliveryPlayer*> zombies_;
+public:
+    SrsDeliveryWorker(SrsDeliveryWorkers* owner, int index);
+    virtual ~SrsDeliveryWorker();
+public:
+    // Notify the worker thread that a player is done, only called in worker thread.
+    void on_player_done(SrsDeliveryPlayer* player);
+    // Free the players and replicas when worker quit, only called in worker thread.
+    void dispose();
+};
+
+// The feeder in ST thread, which consumes a live source and submits the deep copied messages to a worker, so the
+// replica of worker follows the stream, and the players of worker never touch the live source.
+class SrsDeliveryFeeder : public ISrsCoroutineHandler
+{
+public:
+    SrsDeliveryWorkers* owner_;
+    SrsDeliveryWorker* worker_;
+    std::string url_;
+    // The players of stream in worker.
+    int nn_players_;
+private:
+    SrsLiveConsumer* consumer_;
+    SrsCoroutine* trd_;
+    // The merged-write config of vhost, to batch the messages for worker.
+    int mw_msgs_;
+    srs_utime_t mw_sleep_;
+public:
+    SrsDeliveryFeeder(SrsDeliveryWorkers* owner, SrsDeliveryWorker* worker, std::string url);
+    virtual ~SrsDeliveryFeeder();
+public:
+    srs_error_t start(SrsLiveSource* source, SrsRequest* req);
+// Interface ISrsCoroutineHandler.
+public:
+    virtual srs_error_t cycle();
+private:
+    srs_error_t do_cycle();
+};
+
+// The async call to fire the on_stop hook, when the player of worker is gone.
+class SrsDeliveryAsyncCallOnStop : public ISrsAsyncCallTask
+{
+private:
+    SrsContextId cid_;
+    SrsRequest* req_;
+public:
+    SrsDeliveryAsyncCallOnStop(SrsContextId cid, SrsRequest* req);
+    virtual ~SrsDeliveryAsyncCallOnStop();
+public:
+    virtual srs_error_t call();
+    virtual std::string to_string();
+};
+
+// The delivery workers for mega streams. A single ST thread can not saturate the NIC when there are tens of
+// thousands of players of a stream, so when the players exceed the threshold, new RTMP and HTTP-FLV players are handed
+// off to the least-loaded worker thread, which holds a replica of the stream fed by the ST thread. The ST thread still
+// owns all live sources, and the feeders is the registry of which stream is replicated in which worker.
+class SrsDeliveryWorkers : public ISrsCoroutineHandler
+{
+private:
+    std::vector<SrsDeliveryWorker*> workers_;
+    // The pipe to notify the ST thread.
+    int done_pipe_[2];
+    srs_netfd_t done_fd_;
+    SrsCoroutine* trd_;
+    // To protect the done jobs and the state of workers, which are accessed by multiple threads.
+    SrsThreadMutex* lock_;
+    std::vector<SrsDeliveryJob*> done_;
+    // Whether workers should quit, and the number of running workers.
+    bool quit_;
+    int nn_running_;
+private:
+    // The feeders in ST thread, by the url of stream and the index of worker.
+    std::map<std::string, std::vector<SrsDeliveryFeeder*> > feeders_;
+    // The players delivered by workers, by the url of stream.
+    std::map<std::string, int> players_;
+    // The request of players delivered by workers, by the id of client in stat.
+    std::map<std::string, SrsRequest*> clients_;
+    // To fire the on_stop hook when player is gone.
+    SrsAsyncCallWorker* async_;
+public:
+    SrsDeliveryWorkers();
+    virtual ~SrsDeliveryWorkers();
+public:
+    // Start the worker threads by config, in the ST thread of server.
+    srs_error_t initialize();
+    // Whether deliver in worker threads.
+    bool enabled();
+    // Whether the stream is hot, that is, the players exceed the threshold.
+    bool hot(SrsLiveSource* source, SrsRequest* req);
+    // Hand off the RTMP player to the least-loaded worker, the fd is duplicated so the caller should close its own.
+    // @param id The id of client in stat, which is kept util the player is gone, as well as the on_stop hook.
+    srs_error_t handoff(SrsLiveSource* source, SrsRequest* req, std::string id, int fd, int chunk_size, int stream_id);
+    // Hand off the HTTP-FLV player, whose response header and FLV header are sent, in chunked encoding.
+    // @param client The request of player for the on_stop hook, which carries the ip and params of player.
+    srs_error_t handoff_flv(SrsLiveSource* source, SrsRequest* req, SrsRequest* client, std::string id, int fd);
+    // Whether the client is delivered by worker, so the caller should never fire on_stop or remove it from stat.
+    bool delivered(std::string id);
+    // The worker to place a new player, the least-loaded one.
+    SrsDeliveryWorker* least_loaded();
+private:
+    srs_error_t do_handoff(SrsLiveSource* source, SrsRequest* req, SrsRequest* client, int fd, SrsDeliveryJob* job);
+    // Stop all worker threads, and wait for them to quit.
+    void stop_workers();
+    void submit(SrsDeliveryWorker* worker, SrsDeliveryJob* job);
+// Interface ISrsCoroutineHandler.
+public:
+    virtual srs_error_t cycle();
+private:
+    void on_leave(SrsDeliveryJob* job);
+public:
+    // Feed the deep copied messages to the replica of worker, by feeder in ST thread.
+    void feed(SrsDeliveryFeeder* feeder, std::vector<SrsSharedPtrMessage*>& msgs);
+public:
+    // The callbacks of worker thread.
+    static srs_error_t start(void* arg);
+    void do_work(SrsDeliveryWorker* worker);
+    void do_work_loop(SrsDeliveryWorker* worker, srs_netfd_t jobs_fd);
+    // Notify the ST thread, for example, a player is closed.
+    void on_done(SrsDeliveryJob* job);
+private:
+    void consume(SrsDeliveryWorker* worker, SrsDeliveryJob* job);
+};
+
+extern SrsDeliveryWorkers* _srs_delivery;
+
+#endif
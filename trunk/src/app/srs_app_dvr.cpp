@@ -38,8 +38,6 @@ SrsDvrSegmenter::SrsDvrSegmenter()
     fragment = new SrsFragment();
     fs = new SrsFileWriter();
     jitter_algorithm = SrsRtmpJitterAlgorithmOFF;
-    
-    _srs_config->subscribe(this);
 }
 
 SrsDvrSegmenter::~SrsDvrSegmenter()
@@ -55,6 +53,9 @@ srs_error_t SrsDvrSegmenter::initialize(SrsDvrPlan* p, SrsRequest* r)
 {
     req = r;
     plan = p;
+
+    // Only care about the reload of vhost of stream.
+    _srs_config->subscribe_vhost(req->vhost, this);
     
     jitter_algorithm = (SrsRtmpJitterAlgorithm)_srs_config->get_dvr_time_jitter(req->vhost);
     wait_keyframe = _srs_config->get_dvr_wait_keyframe(req->vhost);
@@ -923,8 +924,6 @@ SrsDvr::SrsDvr()
     plan = NULL;
     req = NULL;
     actived = false;
-    
-    _srs_config->subscribe(this);
 }
 
 SrsDvr::~SrsDvr()
@@ -941,6 +940,9 @@ srs_error_t SrsDvr::initialize(SrsOriginHub* h, SrsRequest* r)
     
     req = r->copy();
     hub = h;
+
+    // Only care about the reload of vhost of stream.
+    _srs_config->subscribe_vhost(req->vhost, this);
     
     SrsConfDirective* conf = _srs_config->get_dvr_apply(r->vhost);
     actived = srs_config_apply_filter(conf, r);
@@ -36,6 +36,9 @@ using namespace std;
 #include <srs_protocol_amf0.hpp>
 #include <srs_app_http_client.hpp>
 #include <srs_app_tencentcloud.hpp>
+#ifdef SRS_RTC
+#include <srs_app_rtc_source.hpp>
+#endif
 
 // when edge timeout, retry next.
 #define SRS_EDGE_INGESTER_TIMEOUT (5 * SRS_UTIME_SECONDS)
@@ -63,7 +66,7 @@ SrsEdgeRtmpUpstream::~SrsEdgeRtmpUpstream()
     close();
 }
 
-srs_error_t SrsEdgeRtmpUpstream::connect(SrsRequest* r, SrsLbRoundRobin* lb)
+srs_error_t SrsEdgeRtmpUpstream::connect(SrsRequest* r, ISrsLbBalancer* lb)
 {
     srs_error_t err = srs_success;
     
@@ -180,7 +183,7 @@ SrsEdgeFlvUpstream::~SrsEdgeFlvUpstream()
     close();
 }
 
-srs_error_t SrsEdgeFlvUpstream::connect(SrsRequest* r, SrsLbRoundRobin* lb)
+srs_error_t SrsEdgeFlvUpstream::connect(SrsRequest* r, ISrsLbBalancer* lb)
 {
     // Because we might modify the r, which cause retry fail, so we must copy it.
     SrsRequest* cp = r->copy();
@@ -192,7 +195,7 @@ srs_error_t SrsEdgeFlvUpstream::connect(SrsRequest* r, SrsLbRoundRobin* lb)
     return do_connect(cp, lb, 0);
 }
 
-srs_error_t SrsEdgeFlvUpstream::do_connect(SrsRequest* r, SrsLbRoundRobin* lb, int redirect_depth)
+srs_error_t SrsEdgeFlvUpstream::do_connect(SrsRequest* r, ISrsLbBalancer* lb, int redirect_depth)
 {
     srs_error_t err = srs_success;
 
@@ -422,6 +425,11 @@ srs_error_t SrsEdgeIngester::initialize(SrsLiveSource* s, SrsPlayEdge* e, SrsReq
     edge = e;
     req = r;
 
+    // Select origin by the balance algorithm, hash by the stream url, so the edges pull the same stream
+    // from the same origin.
+    srs_freep(lb);
+    lb = srs_lb_create(_srs_config->get_vhost_edge_balance(req->vhost), req->get_stream_url());
+
 #ifdef SRS_APM
     // We create a dedicate span for edge ingester, and all players will link to this one.
     // Note that we use a producer span and end it immediately.
@@ -435,7 +443,13 @@ srs_error_t SrsEdgeIngester::initialize(SrsLiveSource* s, SrsPlayEdge* e, SrsReq
 srs_error_t SrsEdgeIngester::start()
 {
     srs_error_t err = srs_success;
-    
+
+    // Bridge to RTC only when there is RTC player, or it's created by SrsPlayEdge::on_bridge_play later.
+    // Note that the bridge is freed when unpublish, so we create it for each start.
+    if (source->nb_bridge_players() > 0 && (err = bridge_to_rtc()) != srs_success) {
+        return srs_error_wrap(err, "bridge rtc");
+    }
+
     if ((err = source->on_publish()) != srs_success) {
         return srs_error_wrap(err, "notify source");
     }
@@ -461,6 +475,45 @@ void SrsEdgeIngester::stop()
     }
 }
 
+srs_error_t SrsEdgeIngester::bridge_to_rtc()
+{
+    srs_error_t err = srs_success;
+
+    // Bridge to RTC, so the RTC players share the same upstream pull with RTMP and FLV players.
+#if defined(SRS_RTC) && defined(SRS_FFMPEG_FIT)
+    if (source->has_bridge()) {
+        return err;
+    }
+
+    bool rtc_server_enabled = _srs_config->get_rtc_server_enabled();
+    bool rtc_enabled = _srs_config->get_rtc_enabled(req->vhost);
+    if (!rtc_server_enabled || !rtc_enabled || !_srs_config->get_rtc_from_rtmp(req->vhost)) {
+        return err;
+    }
+
+    SrsRtcSource* rtc = NULL;
+    if ((err = _srs_rtc_sources->fetch_or_create(req, &rtc)) != srs_success) {
+        return srs_error_wrap(err, "create rtc source");
+    }
+
+    if (!rtc->can_publish()) {
+        return err;
+    }
+
+    SrsRtcFromRtmpBridge* bridge = new SrsRtcFromRtmpBridge(rtc);
+    if ((err = bridge->initialize(req)) != srs_success) {
+        srs_freep(bridge);
+        return srs_error_wrap(err, "bridge init");
+    }
+
+    if ((err = source->attach_bridge(bridge)) != srs_success) {
+        return srs_error_wrap(err, "attach bridge");
+    }
+#endif
+
+    return err;
+}
+
 string SrsEdgeIngester::get_curr_origin()
 {
     return lb->selected();
@@ -555,8 +608,15 @@ srs_error_t SrsEdgeIngester::do_cycle()
         }
         
         if ((err = upstream->connect(req, lb)) != srs_success) {
+            // Mark the origin as down, to failover to other origins, except the redirected server.
+            if (redirect.empty()) {
+                _srs_lb_servers->on_failure(lb->selected());
+            }
             return srs_error_wrap(err, "connect upstream");
         }
+        if (redirect.empty()) {
+            _srs_lb_servers->on_success(lb->selected());
+        }
         
         if ((err = edge->on_ingest_play()) != srs_success) {
             return srs_error_wrap(err, "notify edge play");
@@ -754,6 +814,9 @@ srs_error_t SrsEdgeForwarder::initialize(SrsLiveSource* s, SrsPublishEdge* e, Sr
     edge = e;
     req = r;
 
+    srs_freep(lb);
+    lb = srs_lb_create(_srs_config->get_vhost_edge_balance(req->vhost), req->get_stream_url());
+
     return srs_success;
 }
 
@@ -795,8 +858,10 @@ srs_error_t SrsEdgeForwarder::start()
 #endif
     
     if ((err = sdk->connect()) != srs_success) {
+        _srs_lb_servers->on_failure(lb->selected());
         return srs_error_wrap(err, "sdk connect %s failed, cto=%dms, sto=%dms.", url.c_str(), srsu2msi(cto), srsu2msi(sto));
     }
+    _srs_lb_servers->on_success(lb->selected());
 
     // For RTMP client, we pass the vhost in tcUrl when connecting,
     // so we publish without vhost in stream.
@@ -993,6 +1058,24 @@ srs_error_t SrsPlayEdge::on_client_play()
     return err;
 }
 
+srs_error_t SrsPlayEdge::on_bridge_play()
+{
+    srs_error_t err = srs_success;
+
+    // The ingester creates the bridge when start, see SrsEdgeIngester::start.
+    bool started = (state != SrsEdgeStateInit);
+    if ((err = on_client_play()) != srs_success) {
+        return srs_error_wrap(err, "play");
+    }
+
+    // The ingester is started by other players, so bridge to the first RTC player now.
+    if (started && (err = ingester->bridge_to_rtc()) != srs_success) {
+        return srs_error_wrap(err, "bridge rtc");
+    }
+
+    return err;
+}
+
 void SrsPlayEdge::on_all_client_stop()
 {
     // when all client disconnected,
@@ -24,7 +24,7 @@ class SrsCommonMessage;
 class SrsMessageQueue;
 class ISrsProtocolReadWriter;
 class SrsKbps;
-class SrsLbRoundRobin;
+class ISrsLbBalancer;
 class SrsTcpClient;
 class SrsSimpleRtmpClient;
 class SrsPacket;
@@ -65,7 +65,7 @@ public:
     SrsEdgeUpstream();
     virtual ~SrsEdgeUpstream();
 public:
-    virtual srs_error_t connect(SrsRequest* r, SrsLbRoundRobin* lb) = 0;
+    virtual srs_error_t connect(SrsRequest* r, ISrsLbBalancer* lb) = 0;
     virtual srs_error_t recv_message(SrsCommonMessage** pmsg) = 0;
     virtual srs_error_t decode_message(SrsCommonMessage* msg, SrsPacket** ppacket) = 0;
     virtual void close() = 0;
@@ -91,7 +91,7 @@ public:
     SrsEdgeRtmpUpstream(std::string r);
     virtual ~SrsEdgeRtmpUpstream();
 public:
-    virtual srs_error_t connect(SrsRequest* r, SrsLbRoundRobin* lb);
+    virtual srs_error_t connect(SrsRequest* r, ISrsLbBalancer* lb);
     virtual srs_error_t recv_message(SrsCommonMessage** pmsg);
     virtual srs_error_t decode_message(SrsCommonMessage* msg, SrsPacket** ppacket);
     virtual void close();
@@ -120,9 +120,9 @@ public:
     SrsEdgeFlvUpstream(std::string schema);
     virtual ~SrsEdgeFlvUpstream();
 public:
-    virtual srs_error_t connect(SrsRequest* r, SrsLbRoundRobin* lb);
+    virtual srs_error_t connect(SrsRequest* r, ISrsLbBalancer* lb);
 private:
-    virtual srs_error_t do_connect(SrsRequest* r, SrsLbRoundRobin* lb, int redirect_depth);
+    virtual srs_error_t do_connect(SrsRequest* r, ISrsLbBalancer* lb, int redirect_depth);
 public:
     virtual srs_error_t recv_message(SrsCommonMessage** pmsg);
     virtual srs_error_t decode_message(SrsCommonMessage* msg, SrsPacket** ppacket);
@@ -141,7 +141,7 @@ private:
     SrsPlayEdge* edge;
     SrsRequest* req;
     SrsCoroutine* trd;
-    SrsLbRoundRobin* lb;
+    ISrsLbBalancer* lb;
     SrsEdgeUpstream* upstream;
 #ifdef SRS_APM
     ISrsApmSpan* span_main_;
@@ -154,6 +154,8 @@ public:
     virtual srs_error_t start();
     virtual void stop();
     virtual std::string get_curr_origin();
+    // Bridge to RTC for the RTC players, ignore if already bridged.
+    virtual srs_error_t bridge_to_rtc();
 #ifdef SRS_APM
     // Get the current main span. Note that it might be NULL.
     ISrsApmSpan* span();
@@ -177,7 +179,7 @@ private:
     SrsRequest* req;
     SrsCoroutine* trd;
     SrsSimpleRtmpClient* sdk;
-    SrsLbRoundRobin* lb;
+    ISrsLbBalancer* lb;
     // we must ensure one thread one fd principle,
     // that is, a fd must be write/read by the one thread.
     // The publish service thread will proxy(msg), and the edge forward thread
@@ -219,6 +221,8 @@ public:
     virtual srs_error_t initialize(SrsLiveSource* source, SrsRequest* req);
     // When client play stream on edge.
     virtual srs_error_t on_client_play();
+    // When player of other protocol, such as RTC, play stream on edge, bridge to it.
+    virtual srs_error_t on_bridge_play();
     // When all client stopped play, disconnect to origin.
     virtual void on_all_client_stop();
     virtual std::string get_curr_origin();
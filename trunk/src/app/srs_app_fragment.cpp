@@ -228,6 +228,17 @@ void SrsFragmentWindow::shrink(srs_utime_t window)
     }
 }
 
+void SrsFragmentWindow::expire_first()
+{
+    if (fragments.empty()) {
+        return;
+    }
+
+    SrsFragment* fragment = *fragments.begin();
+    fragments.erase(fragments.begin());
+    expired_fragments.push_back(fragment);
+}
+
 void SrsFragmentWindow::clear_expired(bool delete_files)
 {
     srs_error_t err = srs_success;
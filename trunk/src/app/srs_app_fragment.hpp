@@ -81,6 +81,8 @@ public:
     virtual void append(SrsFragment* fragment);
     // Shrink the window, push the expired fragment to a queue.
     virtual void shrink(srs_utime_t window);
+    // Expire the first fragment, push it to the expired queue.
+    virtual void expire_first();
     // Clear the expired fragments.
     virtual void clear_expired(bool delete_files);
     // Get the max duration in srs_utime_t of all fragments.
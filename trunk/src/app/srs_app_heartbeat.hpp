@@ -9,6 +9,8 @@
 
 #include <srs_core.hpp>
 
+#include <string>
+
 // The http heartbeat to api-server to notice api that the information of SRS.
 class SrsHttpHeartbeat
 {
@@ -19,6 +21,7 @@ public:
     virtual void heartbeat();
 private:
     virtual srs_error_t do_heartbeat();
+    virtual srs_error_t do_report(std::string url, std::string req);
 };
 
 #endif
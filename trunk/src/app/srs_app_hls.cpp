@@ -34,6 +34,7 @@ using namespace std;
 #include <srs_app_utility.hpp>
 #include <srs_app_http_hooks.hpp>
 #include <srs_protocol_format.hpp>
+#include <srs_kernel_flv.hpp>
 #include <openssl/rand.h>
 
 // drop the segment when duration of ts too small.
@@ -45,16 +46,411 @@ using namespace std;
 // reset the piece id when deviation overflow this.
 #define SRS_JUMP_WHEN_PIECE_DEVIATION 20
 
+// For LL-HLS, the number of latest segments to keep the parts in playlist.
+#define SRS_HLS_LL_PART_SEGMENTS 2
+
+// The initial buffer size of in-memory segment, grow when exceed.
+#define SRS_HLS_MEMORY_BUFFER_SIZE (256 * 1024)
+
+SrsHlsMemoryStore* _srs_hls_memory = NULL;
+
+// Build the path of LL-HLS part, for example, livestream-5.ts to livestream-5.0.ts
+static string srs_hls_part_path(string path, int index)
+{
+    path = srs_string_replace(path, "[duration]", "");
+
+    if (srs_string_ends_with(path, ".ts")) {
+        return path.substr(0, path.length() - 3) + "." + srs_int2str(index) + ".ts";
+    }
+    return path + "." + srs_int2str(index);
+}
+
+SrsHlsMemoryWriter::SrsHlsMemoryWriter(bool disk)
+{
+    disk_ = disk;
+    opened_ = false;
+    buf_ = NULL;
+    size_ = capacity_ = 0;
+}
+
+SrsHlsMemoryWriter::~SrsHlsMemoryWriter()
+{
+    srs_freepa(buf_);
+}
+
+bool SrsHlsMemoryWriter::disk()
+{
+    return disk_;
+}
+
+SrsSharedPtrMessage* SrsHlsMemoryWriter::take()
+{
+    // Always create a buffer, because the shared message requires a payload.
+    reserve(0);
+
+    // Transfer the buffer to shared message, without copy.
+    SrsSharedPtrMessage* msg = new SrsSharedPtrMessage();
+    msg->wrap(buf_, size_);
+
+    buf_ = NULL;
+    size_ = capacity_ = 0;
+
+    return msg;
+}
+
+SrsSharedPtrMessage* SrsHlsMemoryWriter::slice(int offset)
+{
+    int size = srs_max(0, size_ - offset);
+
+    char* payload = new char[srs_max(1, size)];
+    if (size > 0) {
+        memcpy(payload, buf_ + offset, size);
+    }
+
+    SrsSharedPtrMessage* msg = new SrsSharedPtrMessage();
+    msg->wrap(payload, size);
+
+    return msg;
+}
+
+srs_error_t SrsHlsMemoryWriter::open(string p)
+{
+    srs_error_t err = srs_success;
+
+    if (disk_ && (err = SrsFileWriter::open(p)) != srs_success) {
+        return srs_error_wrap(err, "open %s", p.c_str());
+    }
+
+    opened_ = true;
+    size_ = 0;
+
+    return err;
+}
+
+srs_error_t SrsHlsMemoryWriter::open_append(string p)
+{
+    srs_error_t err = srs_success;
+
+    if (disk_ && (err = SrsFileWriter::open_append(p)) != srs_success) {
+        return srs_error_wrap(err, "open %s", p.c_str());
+    }
+
+    opened_ = true;
+
+    return err;
+}
+
+void SrsHlsMemoryWriter::close()
+{
+    if (disk_) {
+        SrsFileWriter::close();
+    }
+
+    opened_ = false;
+}
+
+bool SrsHlsMemoryWriter::is_open()
+{
+    return opened_;
+}
+
+int64_t SrsHlsMemoryWriter::tellg()
+{
+    return size_;
+}
+
+srs_error_t SrsHlsMemoryWriter::write(void* buf, size_t count, ssize_t* pnwrite)
+{
+    srs_error_t err = srs_success;
+
+    if (!opened_) {
+        return srs_error_new(ERROR_SYSTEM_FILE_NOT_OPEN, "memory writer not opened");
+    }
+
+    if (disk_ && (err = SrsFileWriter::write(buf, count, NULL)) != srs_success) {
+        return srs_error_wrap(err, "write");
+    }
+
+    reserve((int)count);
+    memcpy(buf_ + size_, buf, count);
+    size_ += (int)count;
+
+    if (pnwrite) {
+        *pnwrite = (ssize_t)count;
+    }
+
+    return err;
+}
+
+srs_error_t SrsHlsMemoryWriter::lseek(off_t offset, int whence, off_t* seeked)
+{
+    // The segment is always written sequentially, so we only support to query the position.
+    if (offset != 0 || whence != SEEK_CUR) {
+        return srs_error_new(ERROR_SYSTEM_FILE_SEEK, "memory writer seek offset=%d, whence=%d", (int)offset, whence);
+    }
+
+    if (seeked) {
+        *seeked = size_;
+    }
+
+    return srs_success;
+}
+
+void SrsHlsMemoryWriter::reserve(int size)
+{
+    if (buf_ && size_ + size <= capacity_) {
+        return;
+    }
+
+    int capacity = srs_max(capacity_, SRS_HLS_MEMORY_BUFFER_SIZE);
+    while (capacity < size_ + size) {
+        capacity *= 2;
+    }
+
+    char* buf = new char[capacity];
+    if (size_ > 0) {
+        memcpy(buf, buf_, size_);
+    }
+
+    srs_freepa(buf_);
+    buf_ = buf;
+    capacity_ = capacity;
+}
+
+SrsHlsMemoryFile::SrsHlsMemoryFile(string vhost, SrsSharedPtrMessage* data)
+{
+    vhost_ = vhost;
+    data_ = data;
+    msn_ = -1;
+    parts_ = 0;
+}
+
+SrsHlsMemoryFile::~SrsHlsMemoryFile()
+{
+    srs_freep(data_);
+}
+
+SrsHlsMemoryWaiters::SrsHlsMemoryWaiters()
+{
+    cond_ = srs_cond_new();
+    nn_waiters_ = 0;
+}
+
+SrsHlsMemoryWaiters::~SrsHlsMemoryWaiters()
+{
+    srs_cond_destroy(cond_);
+}
+
+SrsHlsMemoryStore::SrsHlsMemoryStore()
+{
+}
+
+SrsHlsMemoryStore::~SrsHlsMemoryStore()
+{
+    std::map<std::string, SrsHlsMemoryFile*>::iterator it;
+    for (it = files_.begin(); it != files_.end(); ++it) {
+        SrsHlsMemoryFile* file = it->second;
+        srs_freep(file);
+    }
+    files_.clear();
+
+    // The store is global and never freed util quit, so there is no waiting request.
+    std::map<std::string, SrsHlsMemoryWaiters*>::iterator it2;
+    for (it2 = waiters_.begin(); it2 != waiters_.end(); ++it2) {
+        SrsHlsMemoryWaiters* waiters = it2->second;
+        srs_freep(waiters);
+    }
+    waiters_.clear();
+}
+
+void SrsHlsMemoryStore::put(string vhost, string path, SrsSharedPtrMessage* data)
+{
+    remove(path);
+
+    SrsHlsMemoryFile* file = new SrsHlsMemoryFile(vhost, data->copy());
+    files_[key(path)] = file;
+    sizes_[vhost] += data->size;
+
+    // Wakeup the requests waiting for the file.
+    notify(path);
+}
+
+void SrsHlsMemoryStore::put_playlist(string vhost, string path, SrsSharedPtrMessage* data, int64_t msn, int parts, string hint)
+{
+    put(vhost, path, data);
+
+    SrsHlsMemoryFile* file = files_[key(path)];
+    file->msn_ = msn;
+    file->parts_ = parts;
+
+    if (!hint.empty()) {
+        file->hint_ = key(hint);
+        hints_[file->hint_] = key(path);
+    }
+}
+
+void SrsHlsMemoryStore::remove(string path, SrsSharedPtrMessage* data)
+{
+    std::map<std::string, SrsHlsMemoryFile*>::iterator it = files_.find(key(path));
+    if (it == files_.end()) {
+        return;
+    }
+
+    SrsHlsMemoryFile* file = it->second;
+    if (data && file->data_->payload != data->payload) {
+        return;
+    }
+
+    sizes_[file->vhost_] -= file->data_->size;
+    if (!file->hint_.empty()) {
+        hints_.erase(file->hint_);
+    }
+    files_.erase(it);
+    srs_freep(file);
+}
+
+bool SrsHlsMemoryStore::exists(string path)
+{
+    return files_.find(key(path)) != files_.end();
+}
+
+SrsSharedPtrMessage* SrsHlsMemoryStore::fetch(string path)
+{
+    std::map<std::string, SrsHlsMemoryFile*>::iterator it = files_.find(key(path));
+    if (it == files_.end()) {
+        return NULL;
+    }
+
+    SrsHlsMemoryFile* file = it->second;
+    return file->data_->copy();
+}
+
+int64_t SrsHlsMemoryStore::size(string vhost)
+{
+    std::map<std::string, int64_t>::iterator it = sizes_.find(vhost);
+    if (it == sizes_.end()) {
+        return 0;
+    }
+    return it->second;
+}
+
+bool SrsHlsMemoryStore::progress(string path, string* pvhost, int64_t* pmsn, int* pparts)
+{
+    std::map<std::string, SrsHlsMemoryFile*>::iterator it = files_.find(key(path));
+    if (it == files_.end()) {
+        return false;
+    }
+
+    SrsHlsMemoryFile* file = it->second;
+    if (file->msn_ < 0) {
+        return false;
+    }
+
+    *pvhost = file->vhost_;
+    *pmsn = file->msn_;
+    *pparts = file->parts_;
+
+    return true;
+}
+
+bool SrsHlsMemoryStore::is_hint(string path)
+{
+    return hints_.find(key(path)) != hints_.end();
+}
+
+void SrsHlsMemoryStore::wait(string path, srs_utime_t timeout)
+{
+    // Wait on the playlist of the preload hint part.
+    string playlist = key(path);
+    std::map<std::string, std::string>::iterator it = hints_.find(playlist);
+    if (it != hints_.end()) {
+        playlist = it->second;
+    }
+
+    SrsHlsMemoryWaiters* waiters = waiters_[playlist];
+    if (!waiters) {
+        waiters = waiters_[playlist] = new SrsHlsMemoryWaiters();
+    }
+
+    waiters->nn_waiters_++;
+    srs_cond_timedwait(waiters->cond_, timeout);
+    waiters->nn_waiters_--;
+
+    // Free the cond when there is no waiting request of the playlist.
+    if (waiters->nn_waiters_ == 0) {
+        waiters_.erase(playlist);
+        srs_freep(waiters);
+    }
+}
+
+void SrsHlsMemoryStore::notify(string path)
+{
+    // The preload hint part is written, notify the requests waiting on its playlist.
+    string playlist = key(path);
+    std::map<std::string, std::string>::iterator it = hints_.find(playlist);
+    if (it != hints_.end()) {
+        playlist = it->second;
+    }
+
+    std::map<std::string, SrsHlsMemoryWaiters*>::iterator it2 = waiters_.find(playlist);
+    if (it2 != waiters_.end()) {
+        srs_cond_broadcast(it2->second->cond_);
+    }
+}
+
+string SrsHlsMemoryStore::key(string path)
+{
+    while (path.find("//") != string::npos) {
+        path = srs_string_replace(path, "//", "/");
+    }
+
+    while (srs_string_starts_with(path, "./")) {
+        path = path.substr(2);
+    }
+
+    return path;
+}
+
+SrsHlsPart::SrsHlsPart()
+{
+    duration_ = 0;
+    independent_ = false;
+    data_ = NULL;
+}
+
+SrsHlsPart::~SrsHlsPart()
+{
+    if (data_) {
+        _srs_hls_memory->remove(path_, data_);
+        srs_freep(data_);
+    }
+}
+
 SrsHlsSegment::SrsHlsSegment(SrsTsContext* c, SrsAudioCodecId ac, SrsVideoCodecId vc, SrsFileWriter* w)
 {
     sequence_no = 0;
     writer = w;
     tscw = new SrsTsContextWriter(writer, c, ac, vc);
+    memory_ = NULL;
+    part_start_ = -1;
+    part_offset_ = 0;
+    part_independent_ = false;
+    part_last_ = 0;
+
+    SrsHlsMemoryWriter* mw = dynamic_cast<SrsHlsMemoryWriter*>(writer);
+    disk_ = !mw || mw->disk();
 }
 
 SrsHlsSegment::~SrsHlsSegment()
 {
     srs_freep(tscw);
+    clear_parts();
+
+    // The segment is expired, remove it from memory store.
+    if (memory_) {
+        _srs_hls_memory->remove(fullpath(), memory_);
+        srs_freep(memory_);
+    }
 }
 
 void SrsHlsSegment::config_cipher(unsigned char* key,unsigned char* iv)
@@ -67,13 +463,150 @@ void SrsHlsSegment::config_cipher(unsigned char* key,unsigned char* iv)
 
 srs_error_t SrsHlsSegment::rename()
 {
+    srs_error_t err = srs_success;
+
     if (true) {
         std::stringstream ss;
         ss << srsu2msi(duration());
         uri = srs_string_replace(uri, "[duration]", ss.str());
     }
 
-    return SrsFragment::rename();
+    SrsHlsMemoryWriter* mw = dynamic_cast<SrsHlsMemoryWriter*>(writer);
+    if (!mw) {
+        return SrsFragment::rename();
+    }
+
+    // Rename the file on disk, or only apply the placeholder for memory only.
+    if (mw->disk()) {
+        if ((err = SrsFragment::rename()) != srs_success) {
+            return srs_error_wrap(err, "rename");
+        }
+    } else {
+        std::stringstream ss;
+        ss << srsu2msi(duration());
+        set_path(srs_string_replace(fullpath(), "[duration]", ss.str()));
+    }
+
+    // Publish the segment to memory store, the buffer is shared without copy.
+    srs_freep(memory_);
+    memory_ = mw->take();
+    _srs_hls_memory->put(vhost_, fullpath(), memory_);
+
+    return err;
+}
+
+void SrsHlsSegment::set_vhost(string v)
+{
+    vhost_ = v;
+}
+
+int SrsHlsSegment::memory_size()
+{
+    return memory_ ? memory_->size : 0;
+}
+
+bool SrsHlsSegment::part_opened()
+{
+    return part_start_ >= 0;
+}
+
+void SrsHlsSegment::open_part(bool independent)
+{
+    part_start_ = part_last_ = duration();
+    part_offset_ = (int)writer->tellg();
+    part_independent_ = independent;
+}
+
+srs_error_t SrsHlsSegment::close_part()
+{
+    srs_error_t err = srs_success;
+
+    SrsHlsMemoryWriter* mw = dynamic_cast<SrsHlsMemoryWriter*>(writer);
+    if (!mw) {
+        return srs_error_new(ERROR_HLS_WRITE_FAILED, "part requires memory writer");
+    }
+
+    int size = (int)mw->tellg() - part_offset_;
+    if (!part_opened() || size <= 0) {
+        return err;
+    }
+
+    int index = (int)parts.size();
+
+    SrsHlsPart* part = new SrsHlsPart();
+    part->uri_ = part_uri(index);
+    part->path_ = part_path(index);
+    part->duration_ = part_duration();
+    part->independent_ = part_independent_;
+    part->data_ = mw->slice(part_offset_);
+    parts.push_back(part);
+
+    _srs_hls_memory->put(vhost_, part->path_, part->data_);
+
+    part_start_ = -1;
+    part_offset_ += size;
+
+    return err;
+}
+
+void SrsHlsSegment::clear_parts()
+{
+    std::vector<SrsHlsPart*>::iterator it;
+    for (it = parts.begin(); it != parts.end(); ++it) {
+        SrsHlsPart* part = *it;
+        srs_freep(part);
+    }
+    parts.clear();
+}
+
+srs_utime_t SrsHlsSegment::part_duration()
+{
+    return part_opened() ? duration() - part_start_ : 0;
+}
+
+srs_utime_t SrsHlsSegment::on_frame()
+{
+    srs_utime_t v = duration() - part_last_;
+    part_last_ = duration();
+    return v;
+}
+
+string SrsHlsSegment::part_uri(int index)
+{
+    return srs_hls_part_path(uri, index);
+}
+
+string SrsHlsSegment::part_path(int index)
+{
+    return srs_hls_part_path(fullpath(), index);
+}
+
+srs_error_t SrsHlsSegment::create_dir()
+{
+    if (!disk_) {
+        return srs_success;
+    }
+    return SrsFragment::create_dir();
+}
+
+srs_error_t SrsHlsSegment::unlink_file()
+{
+    if (memory_) {
+        _srs_hls_memory->remove(fullpath(), memory_);
+    }
+
+    if (!disk_) {
+        return srs_success;
+    }
+    return SrsFragment::unlink_file();
+}
+
+srs_error_t SrsHlsSegment::unlink_tmpfile()
+{
+    if (!disk_) {
+        return srs_success;
+    }
+    return SrsFragment::unlink_tmpfile();
 }
 
 SrsDvrAsyncCallOnHls::SrsDvrAsyncCallOnHls(SrsContextId c, SrsRequest* r, string p, string t, string m, string mu, int s, srs_utime_t d)
@@ -195,6 +728,11 @@ SrsHlsMuxer::SrsHlsMuxer()
     hls_ts_floor = false;
     max_td = 0;
     writer = NULL;
+    hls_disk_ = true;
+    hls_memory_ = false;
+    hls_memory_budget_ = 0;
+    hls_ll_ = false;
+    hls_ll_part_ = 0;
     _sequence_no = 0;
     current = NULL;
     hls_keys = false;
@@ -233,7 +771,11 @@ void SrsHlsMuxer::dispose()
         srs_freep(current);
     }
     
-    if (unlink(m3u8.c_str()) < 0) {
+    if (hls_memory_) {
+        _srs_hls_memory->remove(m3u8);
+    }
+
+    if (hls_disk_ && unlink(m3u8.c_str()) < 0) {
         srs_warn("dispose unlink path failed. file=%s", m3u8.c_str());
     }
     
@@ -358,10 +900,30 @@ srs_error_t SrsHlsMuxer::update_config(SrsRequest* r, string entry_prefix,
     
     // when update config, reset the history target duration.
     max_td = fragment * _srs_config->get_hls_td_ratio(r->vhost);
+
+    // The storage of m3u8 and segments, on disk, in memory or both.
+    string storage = _srs_config->get_hls_storage(r->vhost);
+    hls_memory_ = (storage == "memory" || storage == "both");
+    hls_disk_ = (storage != "memory");
+    hls_memory_budget_ = (int64_t)_srs_config->get_hls_memory_budget(r->vhost) * 1024 * 1024;
+
+    // The LL-HLS parts are always served from memory.
+    hls_ll_ = _srs_config->get_hls_ll(r->vhost);
+    hls_ll_part_ = _srs_config->get_hls_ll_part(r->vhost);
+    if (hls_ll_) {
+        hls_memory_ = true;
+    }
+
+    // The encrypted segments are written to disk only.
+    if (hls_keys && hls_memory_) {
+        srs_warn("hls: ignore storage=%s, ll=%d for hls_keys, use disk", storage.c_str(), hls_ll_);
+        hls_memory_ = hls_ll_ = false;
+        hls_disk_ = true;
+    }
     
     // create m3u8 dir once.
     m3u8_dir = srs_path_dirname(m3u8);
-    if ((err = srs_create_dir_recursively(m3u8_dir)) != srs_success) {
+    if (hls_disk_ && (err = srs_create_dir_recursively(m3u8_dir)) != srs_success) {
         return srs_error_wrap(err, "create dir");
     }
 
@@ -374,8 +936,11 @@ srs_error_t SrsHlsMuxer::update_config(SrsRequest* r, string entry_prefix,
         }
     }
 
+    srs_freep(writer);
     if(hls_keys) {
         writer = new SrsEncFileWriter();
+    } else if (hls_memory_) {
+        writer = new SrsHlsMemoryWriter(hls_disk_);
     } else {
         writer = new SrsFileWriter();
     }
@@ -432,6 +997,7 @@ srs_error_t SrsHlsMuxer::segment_open()
     // new segment.
     current = new SrsHlsSegment(context, default_acodec, default_vcodec, writer);
     current->sequence_no = _sequence_no++;
+    current->set_vhost(req->vhost);
 
     if ((err = write_hls_key()) != srs_success) {
         return srs_error_wrap(err, "write hls key");
@@ -516,6 +1082,11 @@ srs_error_t SrsHlsMuxer::segment_open()
 
     // reset the context for a new ts start.
     context->reset();
+
+    // For LL-HLS, refresh the m3u8 for the preload hint of new segment.
+    if (hls_ll_ && (err = refresh_m3u8()) != srs_success) {
+        return srs_error_wrap(err, "refresh m3u8");
+    }
     
     return err;
 }
@@ -588,6 +1159,11 @@ srs_error_t SrsHlsMuxer::flush_audio(SrsTsMessageCache* cache)
     
     // update the duration of segment.
     current->append(cache->audio->pts / 90);
+
+    // Only independent for pure audio, because there is no keyframe.
+    if ((err = cut_part(pure_audio())) != srs_success) {
+        return srs_error_wrap(err, "hls: cut part");
+    }
     
     if ((err = current->tscw->write_audio(cache->audio)) != srs_success) {
         return srs_error_wrap(err, "hls: write audio");
@@ -618,6 +1194,10 @@ srs_error_t SrsHlsMuxer::flush_video(SrsTsMessageCache* cache)
     // update the duration of segment.
     current->append(cache->video->dts / 90);
 
+    if ((err = cut_part(cache->video->write_pcr)) != srs_success) {
+        return srs_error_wrap(err, "hls: cut part");
+    }
+
     if ((err = current->tscw->write_video(cache->video)) != srs_success) {
         return srs_error_wrap(err, "hls: write video");
     }
@@ -628,6 +1208,44 @@ srs_error_t SrsHlsMuxer::flush_video(SrsTsMessageCache* cache)
     return err;
 }
 
+srs_error_t SrsHlsMuxer::cut_part(bool independent)
+{
+    srs_error_t err = srs_success;
+
+    if (!hls_ll_) {
+        return err;
+    }
+
+    // The first frame of segment, start the first part.
+    srs_utime_t frame = current->on_frame();
+    if (!current->part_opened()) {
+        current->open_part(independent);
+        return err;
+    }
+
+    // Cut the part at each keyframe, so the part is INDEPENDENT and the player is able to start from it. For
+    // pure audio, all parts are independent, so only cut by duration.
+    bool keyframe = independent && !pure_audio();
+
+    // Cut the part when it will exceed the target duration if we write this frame, which is estimated by
+    // the duration of previous frame.
+    if (!keyframe && current->part_duration() + frame <= hls_ll_part_) {
+        return err;
+    }
+
+    if ((err = current->close_part()) != srs_success) {
+        return srs_error_wrap(err, "close part");
+    }
+    current->open_part(independent);
+
+    // Refresh the m3u8 when part is written, to wakeup the blocking playlist reload.
+    if ((err = refresh_m3u8()) != srs_success) {
+        return srs_error_wrap(err, "refresh m3u8");
+    }
+
+    return err;
+}
+
 srs_error_t SrsHlsMuxer::segment_close()
 {
     srs_error_t err = do_segment_close();
@@ -662,6 +1280,11 @@ srs_error_t SrsHlsMuxer::do_segment_close()
     bool matchMinDuration = current->duration() >= SRS_HLS_SEGMENT_MIN_DURATION;
     bool matchMaxDuration = current->duration() <= max_td * 2 * 1000;
     if (matchMinDuration && matchMaxDuration) {
+        // For LL-HLS, the last part ends with the segment.
+        if (hls_ll_ && (err = current->close_part()) != srs_success) {
+            return srs_error_wrap(err, "close part");
+        }
+
         // rename from tmp to real path
         if ((err = current->rename()) != srs_success) {
             return srs_error_wrap(err, "rename");
@@ -698,6 +1321,13 @@ srs_error_t SrsHlsMuxer::do_segment_close()
     
     // shrink the segments.
     segments->shrink(hls_window);
+    shrink_memory();
+
+    // For LL-HLS, only keep the parts of the last segments, which are close to the live edge.
+    for (int i = 0; hls_ll_ && i < segments->size() - SRS_HLS_LL_PART_SEGMENTS; i++) {
+        SrsHlsSegment* segment = dynamic_cast<SrsHlsSegment*>(segments->at(i));
+        segment->clear_parts();
+    }
     
     // refresh the m3u8, donot contains the removed ts
     err = refresh_m3u8();
@@ -753,8 +1383,37 @@ srs_error_t SrsHlsMuxer::refresh_m3u8()
 {
     srs_error_t err = srs_success;
     
-    // no segments, also no m3u8, return.
-    if (segments->empty()) {
+    // no segments, also no m3u8, return. For LL-HLS, the parts of current segment are also in m3u8.
+    bool has_parts = hls_ll_ && current && !current->parts.empty();
+    if (segments->empty() && !has_parts) {
+        return err;
+    }
+
+    // Render the m3u8 in memory, which is served without touching disk.
+    if (hls_memory_) {
+        string content;
+        if ((err = render_m3u8(content)) != srs_success) {
+            return srs_error_wrap(err, "render m3u8");
+        }
+
+        char* payload = new char[content.length()];
+        memcpy(payload, content.data(), content.length());
+
+        SrsSharedPtrMessage data;
+        data.wrap(payload, (int)content.length());
+
+        if (hls_ll_) {
+            // The progress of playlist is the parts of segment in writing, for blocking playlist reload.
+            int64_t msn = current ? current->sequence_no : _sequence_no;
+            int nn_parts = current ? (int)current->parts.size() : 0;
+            string hint = current ? current->part_path(nn_parts) : "";
+            _srs_hls_memory->put_playlist(req->vhost, m3u8, &data, msn, nn_parts, hint);
+        } else {
+            _srs_hls_memory->put(req->vhost, m3u8, &data);
+        }
+    }
+
+    if (!hls_disk_) {
         return err;
     }
     
@@ -780,23 +1439,41 @@ srs_error_t SrsHlsMuxer::_refresh_m3u8(string m3u8_file)
     srs_error_t err = srs_success;
     
     // no segments, return.
-    if (segments->empty()) {
+    if (segments->empty() && !hls_ll_) {
         return err;
     }
     
+    std::string m3u8;
+    if ((err = render_m3u8(m3u8)) != srs_success) {
+        return srs_error_wrap(err, "hls: render m3u8");
+    }
+
     SrsFileWriter writer;
     if ((err = writer.open(m3u8_file)) != srs_success) {
         return srs_error_wrap(err, "hls: open m3u8 file %s", m3u8_file.c_str());
     }
+
+    // write m3u8 to writer.
+    if ((err = writer.write((char*)m3u8.c_str(), (int)m3u8.length(), NULL)) != srs_success) {
+        return srs_error_wrap(err, "hls: write m3u8");
+    }
     
+    return err;
+}
+
+srs_error_t SrsHlsMuxer::render_m3u8(string& m3u8)
+{
+    srs_error_t err = srs_success;
+
     // #EXTM3U\n
     // #EXT-X-VERSION:3\n
     std::stringstream ss;
     ss << "#EXTM3U" << SRS_CONSTS_LF;
-    ss << "#EXT-X-VERSION:3" << SRS_CONSTS_LF;
+    ss << "#EXT-X-VERSION:" << (hls_ll_ ? 6 : 3) << SRS_CONSTS_LF;
     
     // #EXT-X-MEDIA-SEQUENCE:4294967295\n
-    SrsHlsSegment* first = dynamic_cast<SrsHlsSegment*>(segments->first());
+    // For LL-HLS, there might be only the parts of current segment.
+    SrsHlsSegment* first = segments->empty() ? current : dynamic_cast<SrsHlsSegment*>(segments->first());
     if (first == NULL) {
         return srs_error_new(ERROR_HLS_WRITE_FAILED, "segments cast");
     }
@@ -817,6 +1494,14 @@ srs_error_t SrsHlsMuxer::_refresh_m3u8(string m3u8_file)
     int target_duration = (int)ceil(srsu2msi(srs_max(max_duration, max_td)) / 1000.0);
     
     ss << "#EXT-X-TARGETDURATION:" << target_duration << SRS_CONSTS_LF;
+
+    // For LL-HLS, the client should play at least 3 parts away from the live edge.
+    ss.precision(3);
+    ss.setf(std::ios::fixed, std::ios::floatfield);
+    if (hls_ll_) {
+        ss << "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=" << srsu2msi(hls_ll_part_ * 3) / 1000.0 << SRS_CONSTS_LF;
+        ss << "#EXT-X-PART-INF:PART-TARGET=" << srsu2msi(hls_ll_part_) / 1000.0 << SRS_CONSTS_LF;
+    }
     
     // write all segments
     for (int i = 0; i < segments->size(); i++) {
@@ -844,9 +1529,10 @@ srs_error_t SrsHlsMuxer::_refresh_m3u8(string m3u8_file)
             ss << "#EXT-X-KEY:METHOD=AES-128,URI=" << "\"" << key_path << "\",IV=0x" << hexiv << SRS_CONSTS_LF;
         }
         
+        // #EXT-X-PART:DURATION=0.500,URI="livestream-5.0.ts",INDEPENDENT=YES\n
+        render_parts(ss, segment);
+
         // "#EXTINF:4294967295.208,\n"
-        ss.precision(3);
-        ss.setf(std::ios::fixed, std::ios::floatfield);
         ss << "#EXTINF:" << srsu2msi(segment->duration()) / 1000.0 << ", no desc" << SRS_CONSTS_LF;
         
         // {file name}\n
@@ -859,16 +1545,58 @@ srs_error_t SrsHlsMuxer::_refresh_m3u8(string m3u8_file)
         //ss << segment->uri << SRS_CONSTS_LF;
         ss << seg_uri << SRS_CONSTS_LF;
     }
-    
-    // write m3u8 to writer.
-    std::string m3u8 = ss.str();
-    if ((err = writer.write((char*)m3u8.c_str(), (int)m3u8.length(), NULL)) != srs_success) {
-        return srs_error_wrap(err, "hls: write m3u8");
+
+    // For LL-HLS, the parts of current segment, and the hint of next part.
+    if (hls_ll_ && current) {
+        if (current->is_sequence_header() && !current->parts.empty()) {
+            ss << "#EXT-X-DISCONTINUITY" << SRS_CONSTS_LF;
+        }
+        render_parts(ss, current);
+
+        ss << "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"" << current->part_uri((int)current->parts.size()) << "\"" << SRS_CONSTS_LF;
     }
     
+    m3u8 = ss.str();
+    
     return err;
 }
 
+void SrsHlsMuxer::render_parts(std::stringstream& ss, SrsHlsSegment* segment)
+{
+    std::vector<SrsHlsPart*>::iterator it;
+    for (it = segment->parts.begin(); it != segment->parts.end(); ++it) {
+        SrsHlsPart* part = *it;
+
+        ss << "#EXT-X-PART:DURATION=" << srsu2msi(part->duration_) / 1000.0 << ",URI=\"" << part->uri_ << "\"";
+        if (part->independent_) {
+            ss << ",INDEPENDENT=YES";
+        }
+        ss << SRS_CONSTS_LF;
+    }
+}
+
+void SrsHlsMuxer::shrink_memory()
+{
+    if (!hls_memory_ || hls_memory_budget_ <= 0) {
+        return;
+    }
+
+    // The budget is per stream, so a stream never expires the segments of other streams.
+    int64_t size = 0;
+    for (int i = 0; i < segments->size(); i++) {
+        SrsHlsSegment* segment = dynamic_cast<SrsHlsSegment*>(segments->at(i));
+        size += segment->memory_size();
+    }
+
+    // Expire the oldest segments, but always keep the latest one to play.
+    int64_t overflow = size - hls_memory_budget_;
+    while (overflow > 0 && segments->size() > 1) {
+        SrsHlsSegment* segment = dynamic_cast<SrsHlsSegment*>(segments->first());
+        overflow -= segment->memory_size();
+        segments->expire_first();
+    }
+}
+
 SrsHlsController::SrsHlsController()
 {
     tsmc = new SrsTsMessageCache();
@@ -11,11 +11,14 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <sstream>
 
 #include <srs_kernel_codec.hpp>
 #include <srs_kernel_file.hpp>
 #include <srs_app_async_call.hpp>
 #include <srs_app_fragment.hpp>
+#include <srs_protocol_st.hpp>
 
 class SrsFormat;
 class SrsSharedPtrMessage;
@@ -32,6 +35,138 @@ class SrsTsAacJitter;
 class SrsTsMessageCache;
 class SrsHlsSegment;
 class SrsTsContext;
+class SrsTsMessage;
+
+// The writer of in-memory HLS segment, which writes to a growing buffer, and also writes to the file
+// for hls_storage both. When segment closed, the buffer is taken as a shared message without copy.
+class SrsHlsMemoryWriter : public SrsFileWriter
+{
+private:
+    // Whether write to the file on disk also.
+    bool disk_;
+    bool opened_;
+    char* buf_;
+    int size_;
+    int capacity_;
+public:
+    SrsHlsMemoryWriter(bool disk);
+    virtual ~SrsHlsMemoryWriter();
+public:
+    // Whether the segment is also written to disk.
+    virtual bool disk();
+    // Take the written bytes as a shared message, user should free it.
+    // @remark The writer is reset to empty, and it's ok to take after closed.
+    virtual SrsSharedPtrMessage* take();
+    // Copy the written bytes from offset to a shared message, user should free it.
+    virtual SrsSharedPtrMessage* slice(int offset);
+public:
+    virtual srs_error_t open(std::string p);
+    virtual srs_error_t open_append(std::string p);
+    virtual void close();
+public:
+    virtual bool is_open();
+    virtual int64_t tellg();
+// Interface ISrsWriteSeeker
+public:
+    virtual srs_error_t write(void* buf, size_t count, ssize_t* pnwrite);
+    virtual srs_error_t lseek(off_t offset, int whence, off_t* seeked);
+private:
+    void reserve(int size);
+};
+
+// The in-memory HLS file, the m3u8 or segment.
+class SrsHlsMemoryFile
+{
+public:
+    std::string vhost_;
+    SrsSharedPtrMessage* data_;
+public:
+    // For LL-HLS playlist, the media sequence of the segment in writing, and the number of parts
+    // written in it, -1 if not a LL-HLS playlist.
+    int64_t msn_;
+    int parts_;
+    // For LL-HLS playlist, the path of preload hint part.
+    std::string hint_;
+public:
+    SrsHlsMemoryFile(std::string vhost, SrsSharedPtrMessage* data);
+    virtual ~SrsHlsMemoryFile();
+};
+
+// The requests waiting for a LL-HLS playlist or its parts to be written.
+class SrsHlsMemoryWaiters
+{
+public:
+    srs_cond_t cond_;
+    int nn_waiters_;
+public:
+    SrsHlsMemoryWaiters();
+    virtual ~SrsHlsMemoryWaiters();
+};
+
+// The in-memory HLS files, indexed by the path as if they were on disk, so the HTTP server is able to serve
+// them without touching disk. The segments are owned by the SrsFragmentWindow of muxer, and the store only
+// references the shared buffers, which are freed when segments expired.
+class SrsHlsMemoryStore
+{
+private:
+    std::map<std::string, SrsHlsMemoryFile*> files_;
+    // The total bytes of files for each vhost.
+    std::map<std::string, int64_t> sizes_;
+    // For LL-HLS, the preload hint parts to the playlist.
+    std::map<std::string, std::string> hints_;
+    // To notify the requests waiting for a playlist or part to be written, key is the path of playlist,
+    // so a playlist only wakes up its own requests.
+    std::map<std::string, SrsHlsMemoryWaiters*> waiters_;
+public:
+    SrsHlsMemoryStore();
+    virtual ~SrsHlsMemoryStore();
+public:
+    // Put the file to store, replace the previous one. The store copies the shared message, so user
+    // should free the data.
+    virtual void put(std::string vhost, std::string path, SrsSharedPtrMessage* data);
+    // Put the LL-HLS playlist to store, with the progress of parts and the preload hint.
+    virtual void put_playlist(std::string vhost, std::string path, SrsSharedPtrMessage* data, int64_t msn, int parts, std::string hint);
+    // Remove the file by path. If data is not NULL, only remove the file when it's the same buffer,
+    // to avoid removing a new file of the same path.
+    virtual void remove(std::string path, SrsSharedPtrMessage* data = NULL);
+    // Whether the file of path exists.
+    virtual bool exists(std::string path);
+    // Fetch the file by path, NULL if not found, user should free the data.
+    virtual SrsSharedPtrMessage* fetch(std::string path);
+    // Get the total bytes of files of vhost.
+    virtual int64_t size(std::string vhost);
+public:
+    // Get the progress of LL-HLS playlist, return false if not a LL-HLS playlist.
+    virtual bool progress(std::string path, std::string* pvhost, int64_t* pmsn, int* pparts);
+    // Whether the path is the preload hint part of a LL-HLS playlist.
+    virtual bool is_hint(std::string path);
+    // Wait for the playlist, or the preload hint part of playlist, to be written, in timeout.
+    virtual void wait(std::string path, srs_utime_t timeout);
+private:
+    // Wakeup the requests waiting for the file, which is a playlist or a preload hint part.
+    void notify(std::string path);
+    // Normalize the path, for example, ./objs//live/a.ts to objs/live/a.ts
+    static std::string key(std::string path);
+};
+
+// @global The in-memory HLS files.
+extern SrsHlsMemoryStore* _srs_hls_memory;
+
+// The partial segment of LL-HLS, a piece of segment which is cut on frame boundary, so it's able to be
+// delivered before the whole segment is written.
+class SrsHlsPart
+{
+public:
+    std::string uri_;
+    std::string path_;
+    srs_utime_t duration_;
+    // Whether the part starts with a keyframe, for INDEPENDENT=YES.
+    bool independent_;
+    SrsSharedPtrMessage* data_;
+public:
+    SrsHlsPart();
+    virtual ~SrsHlsPart();
+};
 
 // The wrapper of m3u8 segment from specification:
 //
@@ -52,13 +187,51 @@ public:
     unsigned char iv[16];
     // The full key path.
     std::string keypath;
+    // For LL-HLS, the written parts of segment.
+    std::vector<SrsHlsPart*> parts;
+private:
+    // For LL-HLS, the start position in duration and bytes of the part in writing, and the
+    // position of last frame. The part_start_ is -1 if no part in writing.
+    srs_utime_t part_start_;
+    int part_offset_;
+    bool part_independent_;
+    srs_utime_t part_last_;
+private:
+    // For in-memory HLS, the vhost and shared buffer of segment, NULL if not in memory.
+    std::string vhost_;
+    SrsSharedPtrMessage* memory_;
+    // Whether the segment is written to disk, false for memory only.
+    bool disk_;
 public:
     SrsHlsSegment(SrsTsContext* c, SrsAudioCodecId ac, SrsVideoCodecId vc, SrsFileWriter* w);
     virtual ~SrsHlsSegment();
 public:
     void config_cipher(unsigned char* key,unsigned char* iv);
+    // Set the vhost to account the memory of segment.
+    void set_vhost(std::string v);
+    // Get the size of segment in memory, 0 if not in memory.
+    int memory_size();
+public:
+    // For LL-HLS, whether there is a part in writing.
+    bool part_opened();
+    // Start a new part at current position, must use the memory writer.
+    void open_part(bool independent);
+    // Close the part in writing, put it to memory store. Ignore if no bytes written.
+    srs_error_t close_part();
+    // Free the parts when they are out of the playlist.
+    void clear_parts();
+    // Get the duration of part in writing.
+    srs_utime_t part_duration();
+    // Update the position of last frame, return the duration since previous frame.
+    srs_utime_t on_frame();
+    // Get the uri or path of part by index.
+    std::string part_uri(int index);
+    std::string part_path(int index);
     // replace the placeholder
     virtual srs_error_t rename();
+    virtual srs_error_t create_dir();
+    virtual srs_error_t unlink_file();
+    virtual srs_error_t unlink_tmpfile();
 };
 
 // The hls async call: on_hls
@@ -144,6 +317,15 @@ private:
     unsigned char iv[16];
     // The underlayer file writer.
     SrsFileWriter* writer;
+private:
+    // Whether write the m3u8 and segments to disk or memory, see hls_storage.
+    bool hls_disk_;
+    bool hls_memory_;
+    // The memory budget in bytes of each stream, for in-memory HLS.
+    int64_t hls_memory_budget_;
+    // Whether enable LL-HLS, and the target duration of part.
+    bool hls_ll_;
+    srs_utime_t hls_ll_part_;
 private:
     int _sequence_no;
     srs_utime_t max_td;
@@ -211,6 +393,14 @@ private:
     virtual srs_error_t write_hls_key();
     virtual srs_error_t refresh_m3u8();
     virtual srs_error_t _refresh_m3u8(std::string m3u8_file);
+    // Render the m3u8 content of segments.
+    virtual srs_error_t render_m3u8(std::string& m3u8);
+    // For LL-HLS, cut the part before writing the frame, so the part always ends at frame boundary.
+    virtual srs_error_t cut_part(bool independent);
+    // For LL-HLS, render the parts of segment.
+    virtual void render_parts(std::stringstream& ss, SrsHlsSegment* segment);
+    // Expire the oldest segments when exceed the memory budget of vhost.
+    virtual void shrink_memory();
 };
 
 // The hls stream cache,
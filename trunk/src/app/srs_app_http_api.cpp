@@ -30,6 +30,7 @@ using namespace std;
 #include <srs_protocol_amf0.hpp>
 #include <srs_protocol_utility.hpp>
 #include <srs_app_coworkers.hpp>
+#include <srs_kernel_balance.hpp>
 
 #if defined(__linux__) || defined(SRS_OSX)
 #include <sys/utsname.h>
@@ -999,6 +1000,88 @@ srs_error_t SrsGoApiClusters::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
     return srs_api_response(w, r, obj->dumps());
 }
 
+SrsGoApiHeartbeats::SrsGoApiHeartbeats()
+{
+}
+
+SrsGoApiHeartbeats::~SrsGoApiHeartbeats()
+{
+}
+
+// Whether the request is authorized by the Basic authorization of HTTP API, see http_api.auth
+bool srs_api_authorized(ISrsHttpMessage* r)
+{
+    if (!_srs_config->get_http_api_auth_enabled()) {
+        return true;
+    }
+
+    string token = r->header()->get("Authorization");
+    if (token.find("Basic ") != 0) {
+        return false;
+    }
+
+    string plaintext;
+    srs_error_t err = srs_av_base64_decode(srs_string_trim_start(token.substr(6), " "), plaintext);
+    if (err != srs_success) {
+        srs_freep(err);
+        return false;
+    }
+
+    string expect = _srs_config->get_http_api_auth_username() + ":" + _srs_config->get_http_api_auth_password();
+    return plaintext == expect;
+}
+
+srs_error_t SrsGoApiHeartbeats::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r)
+{
+    srs_error_t err = srs_success;
+
+    if (!r->is_http_post()) {
+        return srs_api_response_code(w, r, SRS_CONSTS_HTTP_MethodNotAllowed);
+    }
+
+    // The heartbeat changes the load of origins, so it requires the HTTP API auth if enabled.
+    if (!srs_api_authorized(r)) {
+        w->header()->set("WWW-Authenticate", "Basic realm=\"SRS\"");
+        w->header()->set_content_length(0);
+        w->write_header(SRS_CONSTS_HTTP_Unauthorized);
+        return w->final_request();
+    }
+
+    string body;
+    if ((err = r->body_read_all(body)) != srs_success) {
+        return srs_api_response_code(w, r, srs_error_wrap(err, "read body"));
+    }
+
+    SrsJsonAny* json = SrsJsonAny::loads(body);
+    SrsAutoFree(SrsJsonAny, json);
+    if (!json || !json->is_object()) {
+        return srs_api_response_code(w, r, SRS_CONSTS_HTTP_BadRequest);
+    }
+
+    // The heartbeat of server, see SrsHttpHeartbeat, for example:
+    //      {"device_id": "my-srs-device", "ip": "192.168.1.100", "load": 15, "ports": [1935, 8080]}
+    SrsJsonObject* obj = json->to_object();
+    SrsJsonAny* ip = obj->ensure_property_string("ip");
+    SrsJsonAny* load = obj->ensure_property_integer("load");
+    if (!ip || !load) {
+        return srs_api_response_code(w, r, SRS_CONSTS_HTTP_BadRequest);
+    }
+
+    // The origin is configured as ip:port, or ip only for the default port.
+    _srs_lb_servers->on_load(ip->to_str(), (int)load->to_integer());
+
+    SrsJsonAny* ports = obj->ensure_property_array("ports");
+    for (int i = 0; ports && i < ports->to_array()->count(); i++) {
+        SrsJsonAny* port = ports->to_array()->at(i);
+        if (port->is_integer()) {
+            string server = srs_fmt("%s:%d", ip->to_str().c_str(), (int)port->to_integer());
+            _srs_lb_servers->on_load(server, (int)load->to_integer());
+        }
+    }
+
+    return srs_api_response_code(w, r, ERROR_SUCCESS);
+}
+
 SrsGoApiError::SrsGoApiError()
 {
 }
@@ -1128,6 +1211,8 @@ srs_error_t SrsGoApiMetrics::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessa
      * clients gauge
      * clients_total counter
      * error counter
+     * reload_total counter
+     * reload_duration_ms gauge
     */
 
     SrsStatistic* stat = SrsStatistic::instance();
@@ -1226,6 +1311,23 @@ srs_error_t SrsGoApiMetrics::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessa
        << nerrs
        << "\n";
 
+    // The config reloads, and the duration of last reload.
+    int64_t nreloads = 0;
+    srs_utime_t reload_duration = 0;
+    stat->dumps_reload_metrics(nreloads, reload_duration);
+
+    ss << "# HELP srs_reload_total The total counts of SRS config reloads.\n"
+       << "# TYPE srs_reload_total counter\n"
+       << "srs_reload_total "
+       << nreloads
+       << "\n";
+
+    ss << "# HELP srs_reload_duration_ms The duration in ms of last SRS config reload.\n"
+       << "# TYPE srs_reload_duration_ms gauge\n"
+       << "srs_reload_duration_ms "
+       << srsu2msi(reload_duration)
+       << "\n";
+
     w->header()->set_content_type("text/plain; charset=utf-8");
 
     return srs_api_response(w, r, ss.str());
@@ -31,6 +31,9 @@ class SrsHttpConn;
 extern srs_error_t srs_api_response(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string json);
 extern srs_error_t srs_api_response_code(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, int code);
 extern srs_error_t srs_api_response_code(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, srs_error_t code);
+// Whether the request is authorized by the Basic authorization of HTTP API, see http_api.auth
+// @remark Always authorized if auth is disabled, like other HTTP APIs.
+extern bool srs_api_authorized(ISrsHttpMessage* r);
 
 // For http root.
 class SrsGoApiRoot : public ISrsHttpHandler
@@ -196,6 +199,16 @@ public:
     virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
 };
 
+// The heartbeat of origin servers, to feed the load for edge to select origin.
+class SrsGoApiHeartbeats : public ISrsHttpHandler
+{
+public:
+    SrsGoApiHeartbeats();
+    virtual ~SrsGoApiHeartbeats();
+public:
+    virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+};
+
 class SrsGoApiError : public ISrsHttpHandler
 {
 public:
@@ -42,6 +42,7 @@ using namespace std;
 #include <srs_app_utility.hpp>
 #include <srs_app_st.hpp>
 #include <srs_app_statistic.hpp>
+#include <srs_app_delivery.hpp>
 
 ISrsHttpConnOwner::ISrsHttpConnOwner()
 {
@@ -216,6 +217,11 @@ srs_error_t SrsHttpConn::process_requests(SrsRequest** preq)
         if (!req->is_keep_alive()) {
             break;
         }
+
+        // For keep-alive, the next request may be pipelined in the buffer, after the body of this one.
+        if ((err = discard_body(hreq)) != srs_success) {
+            return srs_error_wrap(err, "discard body");
+        }
     }
 
     return err;
@@ -236,6 +242,27 @@ srs_error_t SrsHttpConn::process_request(ISrsHttpResponseWriter* w, ISrsHttpMess
     return err;
 }
 
+srs_error_t SrsHttpConn::discard_body(SrsHttpMessage* r)
+{
+    srs_error_t err = srs_success;
+
+    // For request without content-length and not chunked, there is no body.
+    if (!r->is_chunked() && r->content_length() <= 0) {
+        return err;
+    }
+
+    ISrsHttpResponseReader* br = r->body_reader();
+
+    char buf[SRS_HTTP_READ_CACHE_BYTES];
+    while (!br->eof()) {
+        if ((err = br->read(buf, sizeof(buf), NULL)) != srs_success) {
+            return srs_error_wrap(err, "read body");
+        }
+    }
+
+    return err;
+}
+
 srs_error_t SrsHttpConn::on_disconnect(SrsRequest* req)
 {
     // TODO: FIXME: Implements it.
@@ -319,6 +346,16 @@ void SrsHttpxConn::set_enable_stat(bool v)
     enable_stat_ = v;
 }
 
+int SrsHttpxConn::fd()
+{
+    SrsTcpConnection* io = dynamic_cast<SrsTcpConnection*>(io_);
+    if (ssl || !io) {
+        return -1;
+    }
+
+    return io->fd();
+}
+
 srs_error_t SrsHttpxConn::pop_message(ISrsHttpMessage** preq)
 {
     srs_error_t err = srs_success;
@@ -406,7 +443,10 @@ srs_error_t SrsHttpxConn::on_conn_done(srs_error_t r0)
 {
     // Only stat the HTTP streaming clients, ignore all API clients.
     if (enable_stat_) {
-        SrsStatistic::instance()->on_disconnect(get_id().c_str(), r0);
+        // The player delivered by worker is kept in stat, util the worker reports it's gone.
+        if (!_srs_delivery->delivered(get_id().c_str())) {
+            SrsStatistic::instance()->on_disconnect(get_id().c_str(), r0);
+        }
         SrsStatistic::instance()->kbps_add_delta(get_id().c_str(), conn->delta());
     }
 
@@ -100,6 +100,8 @@ private:
     virtual srs_error_t do_cycle();
     virtual srs_error_t process_requests(SrsRequest** preq);
     virtual srs_error_t process_request(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, int rid);
+    // Discard the body which is not read by handler, because the next pipelined request follows it.
+    virtual srs_error_t discard_body(SrsHttpMessage* r);
     // When the connection disconnect, call this method.
     // e.g. log msg of connection and report to other system.
     // @param request: request which is converted by the last http message.
@@ -139,6 +141,8 @@ public:
 public:
     // Require statistic about HTTP connection, for HTTP streaming clients only.
     void set_enable_stat(bool v);
+    // Get the fd of plain HTTP connection, to hand off the HTTP stream to other thread, -1 for HTTPS.
+    int fd();
     // Directly read a HTTP request message.
     // It's exported for HTTP stream, such as HTTP FLV, only need to write to client when
     // serving it, but we need to start a thread to read message to detect whether FD is closed.
@@ -38,6 +38,10 @@ using namespace std;
 #include <srs_app_statistic.hpp>
 #include <srs_app_hybrid.hpp>
 #include <srs_protocol_log.hpp>
+#include <srs_kernel_balance.hpp>
+#include <srs_protocol_http_client.hpp>
+#include <srs_app_hls.hpp>
+#include <srs_kernel_mp4.hpp>
 
 #define SRS_CONTEXT_IN_HLS "hls_ctx"
 
@@ -61,6 +65,9 @@ void SrsHlsVirtualConn::expire()
     stat->on_disconnect(ctx, srs_success);
 }
 
+// For LL-HLS, the max time to wait for the preload hint part.
+#define SRS_HLS_PART_TIMEOUT (5 * SRS_UTIME_SECONDS)
+
 SrsHlsStream::SrsHlsStream()
 {
     _srs_hybrid->timer5s()->subscribe(this);
@@ -144,6 +151,69 @@ void SrsHlsStream::on_serve_ts_ctx(ISrsHttpResponseWriter* w, ISrsHttpMessage* r
     SrsStatistic::instance()->kbps_add_delta(ctx, delta);
 }
 
+srs_error_t SrsHlsStream::block_reload(ISrsHttpMessage* r, string fullpath)
+{
+    srs_error_t err = srs_success;
+
+    string smsn = r->query_get("_HLS_msn");
+    if (smsn.empty()) {
+        return err;
+    }
+
+    string spart = r->query_get("_HLS_part");
+    int64_t msn = ::atoll(smsn.c_str());
+    int part = spart.empty() ? -1 : ::atoi(spart.c_str());
+
+    srs_utime_t deadline = 0;
+    while (true) {
+        string vhost;
+        int64_t cur_msn = 0;
+        int nn_parts = 0;
+        if (!_srs_hls_memory->progress(fullpath, &vhost, &cur_msn, &nn_parts)) {
+            return err;
+        }
+
+        // The segment in writing is the last one of playlist, reject if too far in the future.
+        if (msn > cur_msn + 1) {
+            return srs_error_new(ERROR_HLS_BLOCKING_RELOAD, "msn=%" PRId64 ", part=%d, current msn=%" PRId64, msn, part, cur_msn);
+        }
+
+        // The segment is done, or the part of segment in writing is done.
+        if (msn < cur_msn || (part >= 0 && msn == cur_msn && part < nn_parts)) {
+            return err;
+        }
+
+        // Hold the request for at most 3 target durations, then serve the latest playlist.
+        srs_utime_t now = srs_update_system_time();
+        if (!deadline) {
+            deadline = now + 3 * _srs_config->get_hls_fragment(vhost);
+        }
+        if (now >= deadline) {
+            return err;
+        }
+
+        _srs_hls_memory->wait(fullpath, deadline - now);
+    }
+
+    return err;
+}
+
+void SrsHlsStream::block_part(string fullpath)
+{
+    srs_utime_t deadline = 0;
+    while (_srs_hls_memory->is_hint(fullpath) && !_srs_hls_memory->exists(fullpath)) {
+        srs_utime_t now = srs_update_system_time();
+        if (!deadline) {
+            deadline = now + SRS_HLS_PART_TIMEOUT;
+        }
+        if (now >= deadline) {
+            return;
+        }
+
+        _srs_hls_memory->wait(fullpath, deadline - now);
+    }
+}
+
 srs_error_t SrsHlsStream::serve_new_session(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, SrsRequest* req, std::string& ctx)
 {
     srs_error_t err = srs_success;
@@ -198,40 +268,75 @@ srs_error_t SrsHlsStream::serve_new_session(ISrsHttpResponseWriter* w, ISrsHttpM
     return err;
 }
 
-srs_error_t SrsHlsStream::serve_exists_session(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, ISrsFileReaderFactory* factory, std::string fullpath)
+// Append the hls_ctx to uri of ts, for example, livestream-0.ts?hls_ctx=xxx
+static string srs_hls_uri_with_ctx(string uri, string ctx)
 {
-    srs_error_t err = srs_success;
-
-    // Read m3u8 content.
-    SrsFileReader* fs = factory->create_file_reader();
-    SrsAutoFree(SrsFileReader, fs);
+    size_t pos = uri.find("?");
+    if (!srs_string_ends_with(uri.substr(0, pos), ".ts")) {
+        return uri;
+    }
 
-    if ((err = fs->open(fullpath)) != srs_success) {
-        return srs_error_wrap(err, "open %s", fullpath.c_str());
+    string query = string(SRS_CONTEXT_IN_HLS) + "=" + ctx;
+    if (pos == string::npos) {
+        return uri + "?" + query;
     }
+    return uri.substr(0, pos + 1) + query + "&" + uri.substr(pos + 1);
+}
 
-    string content;
-    if ((err = srs_ioutil_read_all(fs, content)) != srs_success) {
-        return srs_error_wrap(err, "read %s", fullpath.c_str());
+string srs_hls_rewrite_ctx(string content, string ctx)
+{
+    vector<string> lines = srs_string_split(content, "\n");
+    for (int i = 0; i < (int)lines.size(); i++) {
+        string& line = lines.at(i);
+
+        // The uri of segment.
+        if (!line.empty() && line.at(0) != '#') {
+            line = srs_hls_uri_with_ctx(line, ctx);
+            continue;
+        }
+
+        // For LL-HLS, the uri of part and preload hint part, for example:
+        //      #EXT-X-PART:DURATION=0.2,URI="livestream-0.0.ts"
+        //      #EXT-X-PRELOAD-HINT:TYPE=PART,URI="livestream-0.1.ts"
+        if (srs_string_starts_with(line, "#EXT-X-PART:") || srs_string_starts_with(line, "#EXT-X-PRELOAD-HINT:")) {
+            size_t start = line.find("URI=\"");
+            size_t end = (start == string::npos) ? string::npos : line.find("\"", start + 5);
+            if (end != string::npos) {
+                string uri = line.substr(start + 5, end - start - 5);
+                line = line.substr(0, start + 5) + srs_hls_uri_with_ctx(uri, ctx) + line.substr(end);
+            }
+        }
     }
 
-    // Rebuild the m3u8 content, make .ts with hls_ctx.
-    size_t pos_ts = content.find(".ts");
-    static string QUERY_PREFIX = string(".ts?") + string(SRS_CONTEXT_IN_HLS) + string("=");
+    return srs_join_vector_string(lines, "\n");
+}
 
-    if (pos_ts != string::npos) {
-        string ctx = r->query_get(SRS_CONTEXT_IN_HLS);
-        string query = QUERY_PREFIX + ctx;
+srs_error_t SrsHlsStream::serve_exists_session(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, ISrsFileReaderFactory* factory, std::string fullpath)
+{
+    srs_error_t err = srs_success;
 
-        size_t pos_query = content.find(".ts?");
-        if (pos_query != string::npos) {
-            query += "&";
-            content = srs_string_replace(content, ".ts?", query);
-        } else {
-            content = srs_string_replace(content, ".ts", query);
+    // Read m3u8 content, from memory for in-memory HLS, or from file.
+    string content;
+    SrsSharedPtrMessage* data = _srs_hls_memory->fetch(fullpath);
+    if (data) {
+        content.assign(data->payload, data->size);
+        srs_freep(data);
+    } else {
+        SrsFileReader* fs = factory->create_file_reader();
+        SrsAutoFree(SrsFileReader, fs);
+
+        if ((err = fs->open(fullpath)) != srs_success) {
+            return srs_error_wrap(err, "open %s", fullpath.c_str());
+        }
+
+        if ((err = srs_ioutil_read_all(fs, content)) != srs_success) {
+            return srs_error_wrap(err, "read %s", fullpath.c_str());
         }
     }
 
+    // Rebuild the m3u8 content, make .ts with hls_ctx.
+    content = srs_hls_rewrite_ctx(content, r->query_get(SRS_CONTEXT_IN_HLS));
+
     // Response with rebuilt content.
     w->header()->set_content_type("application/vnd.apple.mpegurl");
     w->header()->set_content_length(content.length());
@@ -382,12 +487,470 @@ bool SrsHlsStream::is_interrupt(std::string id) {
     return false;
 }
 
+// The timeout for edge HLS to fetch file from origin.
+#define SRS_HLS_EDGE_TIMEOUT (10 * SRS_UTIME_SECONDS)
+
+SrsHlsEdgeEntry::SrsHlsEdgeEntry()
+{
+    data_ = NULL;
+    fetching_ = false;
+    expire_at_ = 0;
+}
+
+SrsHlsEdgeEntry::~SrsHlsEdgeEntry()
+{
+    srs_freep(data_);
+}
+
+// Get the stream url of HLS file, for example, /live/livestream for /live/livestream.m3u8, and the ts file is
+// named as [stream]-[seq].ts by default, for example, /live/livestream-10.ts is also /live/livestream.
+string srs_hls_edge_stream_url(string vhost, string url)
+{
+    string path = url;
+    size_t pos = path.find("?");
+    if (pos != string::npos) {
+        path = path.substr(0, pos);
+    }
+
+    string stream = srs_path_filename(srs_path_basename(path));
+    if (srs_string_ends_with(path, ".ts") && (pos = stream.rfind("-")) != string::npos && pos + 1 < stream.length()) {
+        string seq = stream.substr(pos + 1);
+        if (seq.find_first_not_of("0123456789") == string::npos) {
+            stream = stream.substr(0, pos);
+        }
+    }
+
+    string app = srs_string_trim_start(srs_path_dirname(path), "/");
+    return srs_generate_stream_url(vhost, app, stream);
+}
+
+SrsHlsEdgeCache::SrsHlsEdgeCache(string vhost)
+{
+    vhost_ = vhost;
+    lb_ = srs_lb_create(_srs_config->get_vhost_edge_balance(vhost), vhost);
+    size_ = 0;
+    cond_ = srs_cond_new();
+    nn_users_ = 0;
+    disposing_ = false;
+}
+
+SrsHlsEdgeCache::~SrsHlsEdgeCache()
+{
+    // Wakeup the waiting requests, and wait for all requests to quit, because they use the cache.
+    disposing_ = true;
+    while (nn_users_ > 0) {
+        srs_cond_broadcast(cond_);
+        srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+    }
+
+    std::map<std::string, SrsHlsEdgeEntry*>::iterator it;
+    for (it = entries_.begin(); it != entries_.end(); ++it) {
+        SrsHlsEdgeEntry* entry = it->second;
+        srs_freep(entry);
+    }
+    entries_.clear();
+    lru_.clear();
+
+    srs_freep(lb_);
+    srs_cond_destroy(cond_);
+}
+
+srs_error_t SrsHlsEdgeCache::fetch(string url, SrsSharedPtrMessage** pdata)
+{
+    srs_error_t err = srs_success;
+
+    if (disposing_) {
+        return srs_error_new(ERROR_EDGE_VHOST_REMOVED, "hls edge of %s disposed", vhost_.c_str());
+    }
+
+    nn_users_++;
+    err = fetch_or_wait(url, pdata);
+    nn_users_--;
+
+    return err;
+}
+
+srs_error_t SrsHlsEdgeCache::fetch_or_wait(string url, SrsSharedPtrMessage** pdata)
+{
+    srs_error_t err = srs_success;
+
+    srs_utime_t starttime = srs_get_system_time();
+    while (true) {
+        std::map<std::string, SrsHlsEdgeEntry*>::iterator it = entries_.find(url);
+        SrsHlsEdgeEntry* entry = (it != entries_.end()) ? it->second : NULL;
+        if (!entry) {
+            break;
+        }
+
+        // Collapse the concurrent requests, wait for the fetching one. Note that the entry might be freed when
+        // fetch failed, so we must find it again when wakeup.
+        if (entry->fetching_) {
+            if (srs_get_system_time() - starttime > SRS_HLS_EDGE_TIMEOUT) {
+                return srs_error_new(ERROR_HLS_EDGE_TIMEOUT, "wait for %s", url.c_str());
+            }
+            srs_cond_timedwait(cond_, SRS_HLS_EDGE_TIMEOUT);
+
+            if (disposing_) {
+                return srs_error_new(ERROR_EDGE_VHOST_REMOVED, "hls edge of %s disposed", vhost_.c_str());
+            }
+            continue;
+        }
+
+        // Expired m3u8, fetch it again.
+        if (entry->expire_at_ && entry->expire_at_ <= srs_get_system_time()) {
+            remove(entry);
+            break;
+        }
+
+        // Hit the cache, move to the front of LRU.
+        lru_.erase(entry->lru_);
+        lru_.push_front(entry);
+        entry->lru_ = lru_.begin();
+
+        *pdata = entry->data_->copy();
+        return err;
+    }
+
+    // Missing, fetch from origin, and the entry is not in LRU util fetched, so it's never evicted.
+    SrsHlsEdgeEntry* entry = new SrsHlsEdgeEntry();
+    entry->url_ = url;
+    entry->fetching_ = true;
+    entries_[url] = entry;
+
+    string body;
+    err = do_fetch(url, body);
+
+    if (err != srs_success) {
+        entries_.erase(url);
+        srs_freep(entry);
+        srs_cond_broadcast(cond_);
+        return srs_error_wrap(err, "fetch %s", url.c_str());
+    }
+
+    char* payload = new char[body.length()];
+    memcpy(payload, body.data(), body.length());
+
+    entry->data_ = new SrsSharedPtrMessage();
+    entry->data_->wrap(payload, (int)body.length());
+    entry->fetching_ = false;
+    if (srs_string_ends_with(url.substr(0, url.find("?")), ".m3u8")) {
+        entry->expire_at_ = srs_get_system_time() + ttl();
+    }
+
+    lru_.push_front(entry);
+    entry->lru_ = lru_.begin();
+    size_ += body.length();
+
+    // Copy before shrink, because the entry might be evicted.
+    *pdata = entry->data_->copy();
+    shrink();
+
+    srs_cond_broadcast(cond_);
+
+    return err;
+}
+
+int64_t SrsHlsEdgeCache::size()
+{
+    return size_;
+}
+
+srs_utime_t SrsHlsEdgeCache::ttl()
+{
+    return _srs_config->get_vhost_edge_hls_ttl(vhost_);
+}
+
+srs_error_t SrsHlsEdgeCache::do_fetch(string url, string& body)
+{
+    srs_error_t err = srs_success;
+
+    SrsConfDirective* conf = _srs_config->get_vhost_edge_hls_origin(vhost_);
+    if (!conf || conf->args.empty()) {
+        return srs_error_new(ERROR_EDGE_VHOST_REMOVED, "no hls origin of vhost %s", vhost_.c_str());
+    }
+
+    // For consistent hash, the key is the stream url, so the m3u8 and ts of a stream are fetched from the
+    // same origin, as the edge ingester does.
+    string server;
+    if (_srs_config->get_vhost_edge_balance(vhost_) == "hash") {
+        SrsLbConsistentHash lb(srs_hls_edge_stream_url(vhost_, url));
+        server = lb.select(conf->args);
+    } else {
+        server = lb_->select(conf->args);
+    }
+
+    string host = server;
+    int port = SRS_DEFAULT_HTTP_PORT;
+    srs_parse_hostport(server, host, port);
+
+    SrsHttpClient http;
+    if ((err = http.initialize("http", host, port, SRS_HLS_EDGE_TIMEOUT)) != srs_success) {
+        _srs_lb_servers->on_failure(server);
+        return srs_error_wrap(err, "init %s", server.c_str());
+    }
+
+    // Forward the query to origin, for example, the hls_ctx of session.
+    ISrsHttpMessage* msg = NULL;
+    if ((err = http.get(url, "", &msg)) != srs_success) {
+        _srs_lb_servers->on_failure(server);
+        return srs_error_wrap(err, "get %s%s", server.c_str(), url.c_str());
+    }
+    SrsAutoFree(ISrsHttpMessage, msg);
+    _srs_lb_servers->on_success(server);
+
+    if (msg->status_code() != SRS_CONSTS_HTTP_OK) {
+        return srs_error_new(ERROR_HTTP_STATUS_INVALID, "get %s%s, status=%d", server.c_str(), url.c_str(), msg->status_code());
+    }
+
+    if ((err = msg->body_read_all(body)) != srs_success) {
+        return srs_error_wrap(err, "read body");
+    }
+
+    return err;
+}
+
+void SrsHlsEdgeCache::remove(SrsHlsEdgeEntry* entry)
+{
+    size_ -= entry->data_->size;
+    lru_.erase(entry->lru_);
+    entries_.erase(entry->url_);
+    srs_freep(entry);
+}
+
+void SrsHlsEdgeCache::shrink()
+{
+    int64_t capacity = (int64_t)_srs_config->get_vhost_edge_hls_cache(vhost_) * 1024 * 1024;
+
+    // Evict the least recently used files, note that the files being served are not freed, because the
+    // buffer is shared by the response.
+    while (size_ > capacity && !lru_.empty()) {
+        SrsHlsEdgeEntry* entry = lru_.back();
+        remove(entry);
+    }
+}
+
+// The max number of samples in MP4 index cache, about 100 bytes per sample, so it's about 100MB.
+#define SRS_MP4_INDEX_CAPACITY (1024 * 1024)
+
+SrsMp4IndexEntry::SrsMp4IndexEntry()
+{
+    mtime_ = 0;
+    size_ = 0;
+    index_ = NULL;
+}
+
+SrsMp4IndexEntry::~SrsMp4IndexEntry()
+{
+    srs_freep(index_);
+}
+
+SrsMp4IndexCache::SrsMp4IndexCache(int64_t capacity)
+{
+    nb_samples_ = 0;
+    capacity_ = capacity;
+}
+
+SrsMp4IndexCache::~SrsMp4IndexCache()
+{
+    std::list<SrsMp4IndexEntry*>::iterator it;
+    for (it = lru_.begin(); it != lru_.end(); ++it) {
+        SrsMp4IndexEntry* entry = *it;
+        srs_freep(entry);
+    }
+    lru_.clear();
+    entries_.clear();
+}
+
+srs_error_t SrsMp4IndexCache::fetch(string path, SrsFileReader* fs, SrsMp4SeekIndex** pindex)
+{
+    srs_error_t err = srs_success;
+
+    // The file might be replaced, so we check the modify time and size. Note that for utest, the file
+    // might not exist, so we ignore the error of stat.
+    int64_t mtime = 0;
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0) {
+        mtime = (int64_t)st.st_mtime;
+    }
+    int64_t size = fs->filesize();
+
+    std::map<std::string, SrsMp4IndexEntry*>::iterator it = entries_.find(path);
+    if (it != entries_.end()) {
+        SrsMp4IndexEntry* entry = it->second;
+        if (entry->mtime_ == mtime && entry->size_ == size) {
+            lru_.erase(entry->lru_);
+            lru_.push_front(entry);
+            entry->lru_ = lru_.begin();
+            *pindex = entry->index_;
+            return err;
+        }
+        remove(entry);
+    }
+
+    SrsMp4SeekIndex* index = new SrsMp4SeekIndex();
+    if ((err = index->initialize(fs)) != srs_success) {
+        srs_freep(index);
+        return srs_error_wrap(err, "parse index of %s", path.c_str());
+    }
+
+    SrsMp4IndexEntry* entry = new SrsMp4IndexEntry();
+    entry->path_ = path;
+    entry->mtime_ = mtime;
+    entry->size_ = size;
+    entry->index_ = index;
+
+    lru_.push_front(entry);
+    entry->lru_ = lru_.begin();
+    entries_[path] = entry;
+    nb_samples_ += index->nb_samples();
+
+    shrink();
+
+    *pindex = index;
+    return err;
+}
+
+int64_t SrsMp4IndexCache::nb_samples()
+{
+    return nb_samples_;
+}
+
+int SrsMp4IndexCache::size()
+{
+    return (int)entries_.size();
+}
+
+void SrsMp4IndexCache::remove(SrsMp4IndexEntry* entry)
+{
+    nb_samples_ -= entry->index_->nb_samples();
+    lru_.erase(entry->lru_);
+    entries_.erase(entry->path_);
+    srs_freep(entry);
+}
+
+void SrsMp4IndexCache::shrink()
+{
+    // Evict the least recently used index, but keep the most recently used one, which is being served.
+    while (nb_samples_ > capacity_ && lru_.size() > 1) {
+        SrsMp4IndexEntry* entry = lru_.back();
+        remove(entry);
+    }
+}
+
 SrsVodStream::SrsVodStream(string root_dir) : SrsHttpFileServer(root_dir)
 {
+    hls_edge_ = NULL;
+    mp4_index_ = new SrsMp4IndexCache(SRS_MP4_INDEX_CAPACITY);
 }
 
 SrsVodStream::~SrsVodStream()
 {
+    srs_freep(hls_edge_);
+    srs_freep(mp4_index_);
+}
+
+void SrsVodStream::set_hls_edge(SrsHlsEdgeCache* v)
+{
+    srs_freep(hls_edge_);
+    hls_edge_ = v;
+}
+
+srs_error_t SrsVodStream::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r)
+{
+    string upath = r->path();
+    if (hls_edge_ && (srs_string_ends_with(upath, ".m3u8") || srs_string_ends_with(upath, ".ts"))) {
+        return serve_hls_edge(w, r);
+    }
+
+    // For in-memory HLS, the files never touch disk, so we serve them before checking the file.
+    if (srs_string_ends_with(upath, ".m3u8") || srs_string_ends_with(upath, ".ts")) {
+        string fullpath = srs_http_fs_fullpath(dir, entry->pattern, upath);
+
+        // For LL-HLS, the playlist and the preload hint part might be requested before written.
+        if (srs_string_ends_with(upath, ".m3u8")) {
+            srs_error_t err = hls_.block_reload(r, fullpath);
+            if (err != srs_success) {
+                srs_warn("LL-HLS reject %s, %s", upath.c_str(), srs_error_desc(err).c_str());
+                srs_freep(err);
+                return srs_go_http_error(w, SRS_CONSTS_HTTP_BadRequest);
+            }
+        } else {
+            hls_.block_part(fullpath);
+        }
+
+        if (_srs_hls_memory->exists(fullpath)) {
+            if (srs_string_ends_with(upath, ".m3u8")) {
+                return serve_m3u8_ctx(w, r, fullpath);
+            }
+            return serve_ts_ctx(w, r, fullpath);
+        }
+    }
+
+    return SrsHttpFileServer::serve_http(w, r);
+}
+
+srs_error_t SrsVodStream::serve_hls_memory(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, string fullpath)
+{
+    srs_error_t err = srs_success;
+
+    SrsSharedPtrMessage* data = _srs_hls_memory->fetch(fullpath);
+    if (!data) {
+        return SrsHttpNotFoundHandler().serve_http(w, r);
+    }
+    SrsAutoFree(SrsSharedPtrMessage, data);
+
+    SrsHttpHeader* hdr = w->header();
+    hdr->set_content_length(data->size);
+    if (srs_string_ends_with(fullpath, ".m3u8")) {
+        hdr->set_content_type("application/vnd.apple.mpegurl");
+    } else {
+        hdr->set_content_type("video/MP2T");
+    }
+    w->write_header(SRS_CONSTS_HTTP_OK);
+
+    // Response the shared buffer directly, without copy.
+    if ((err = w->write(data->payload, data->size)) != srs_success) {
+        return srs_error_wrap(err, "write %s", fullpath.c_str());
+    }
+
+    return err;
+}
+
+srs_error_t SrsVodStream::serve_hls_edge(ISrsHttpResponseWriter* w, ISrsHttpMessage* r)
+{
+    srs_error_t err = srs_success;
+
+    string upath = r->path();
+
+    // Keep the query, because the origin responds by it, for example, the m3u8 of hls_ctx session.
+    string url = upath;
+    if (!r->query().empty()) {
+        url += "?" + r->query();
+    }
+
+    SrsSharedPtrMessage* data = NULL;
+    if ((err = hls_edge_->fetch(url, &data)) != srs_success) {
+        srs_warn("edge hls miss %s, err=%s", upath.c_str(), srs_error_desc(err).c_str());
+        srs_freep(err);
+        return SrsHttpNotFoundHandler().serve_http(w, r);
+    }
+    SrsAutoFree(SrsSharedPtrMessage, data);
+
+    SrsHttpHeader* hdr = w->header();
+    hdr->set_content_length(data->size);
+    if (srs_string_ends_with(upath, ".m3u8")) {
+        hdr->set_content_type("application/vnd.apple.mpegurl");
+        hdr->set("Cache-Control", "max-age=" + srs_int2str(srsu2si(hls_edge_->ttl())));
+    } else {
+        hdr->set_content_type("video/MP2T");
+    }
+    w->write_header(SRS_CONSTS_HTTP_OK);
+
+    if ((err = w->write(data->payload, data->size)) != srs_success) {
+        return srs_error_wrap(err, "write %s", upath.c_str());
+    }
+
+    return err;
 }
 
 srs_error_t SrsVodStream::serve_flv_stream(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, string fullpath, int64_t offset)
@@ -521,6 +1084,52 @@ srs_error_t SrsVodStream::serve_mp4_stream(ISrsHttpResponseWriter* w, ISrsHttpMe
     return err;
 }
 
+srs_error_t SrsVodStream::serve_mp4_seek(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, string fullpath, int64_t start, int64_t end)
+{
+    srs_error_t err = srs_success;
+
+    SrsFileReader* fs = fs_factory->create_file_reader();
+    SrsAutoFree(SrsFileReader, fs);
+
+    if ((err = fs->open(fullpath)) != srs_success) {
+        return srs_error_wrap(err, "fs open");
+    }
+
+    SrsMp4SeekIndex* index = NULL;
+    if ((err = mp4_index_->fetch(fullpath, fs, &index)) != srs_success) {
+        return srs_error_wrap(err, "fetch index");
+    }
+
+    // Build the ftyp and moov for samples in range, then send the mdat data from the file.
+    SrsSimpleStream header;
+    off_t offset = 0;
+    uint64_t size = 0;
+    if ((err = index->seek(start, end, &header, &offset, &size)) != srs_success) {
+        return srs_error_wrap(err, "seek start=%" PRId64 ", end=%" PRId64, start, end);
+    }
+
+    if (offset + (int64_t)size > fs->filesize()) {
+        return srs_error_new(ERROR_HTTP_REMUX_OFFSET_OVERFLOW, "http mp4 seek %s overflow. size=%" PRId64 ", offset=%" PRId64 ", data=%" PRId64,
+            fullpath.c_str(), fs->filesize(), (int64_t)offset, (int64_t)size);
+    }
+
+    w->header()->set_content_length(header.length() + size);
+    w->header()->set_content_type("video/mp4");
+    w->write_header(SRS_CONSTS_HTTP_OK);
+
+    if ((err = w->write(header.bytes(), header.length())) != srs_success) {
+        return srs_error_wrap(err, "write header");
+    }
+
+    fs->seek2(offset);
+
+    if ((err = copy(w, fs, r, size)) != srs_success) {
+        return srs_error_wrap(err, "read mp4=%s size=%" PRId64, fullpath.c_str(), (int64_t)size);
+    }
+
+    return err;
+}
+
 srs_error_t SrsVodStream::serve_m3u8_ctx(ISrsHttpResponseWriter * w, ISrsHttpMessage * r, std::string fullpath)
 {
     srs_error_t err = srs_success;
@@ -545,6 +1154,9 @@ srs_error_t SrsVodStream::serve_m3u8_ctx(ISrsHttpResponseWriter * w, ISrsHttpMes
 
     // Serve by default HLS handler.
     if (!served) {
+        if (_srs_hls_memory->exists(fullpath)) {
+            return serve_hls_memory(w, r, fullpath);
+        }
         return SrsHttpFileServer::serve_m3u8_ctx(w, r, fullpath);
     }
 
@@ -565,8 +1177,12 @@ srs_error_t SrsVodStream::serve_ts_ctx(ISrsHttpResponseWriter * w, ISrsHttpMessa
     // session identified by hls_ctx, which served by an SrsHlsStream object.
     hxc->set_enable_stat(false);
 
-    // Serve by default HLS handler.
-    err = SrsHttpFileServer::serve_ts_ctx(w, r, fullpath);
+    // Serve by default HLS handler, or from memory for in-memory HLS.
+    if (_srs_hls_memory->exists(fullpath)) {
+        err = serve_hls_memory(w, r, fullpath);
+    } else {
+        err = SrsHttpFileServer::serve_ts_ctx(w, r, fullpath);
+    }
 
     // Notify the HLS to stat the ts after serving.
     hls_.on_serve_ts_ctx(w, r);
@@ -634,8 +1250,9 @@ srs_error_t SrsHttpStaticServer::mount_vhost(string vhost, string& pmount)
         return err;
     }
     
-    // when vhost http_static disabled, ignore.
-    if (!_srs_config->get_vhost_http_enabled(vhost)) {
+    // when vhost http_static disabled, ignore, except the edge HLS which also serves by it.
+    bool hls_edge = _srs_config->get_vhost_is_edge(vhost) && _srs_config->get_vhost_edge_hls(vhost);
+    if (!_srs_config->get_vhost_http_enabled(vhost) && !hls_edge) {
         return err;
     }
     
@@ -655,10 +1272,15 @@ srs_error_t SrsHttpStaticServer::mount_vhost(string vhost, string& pmount)
     }
     
     // mount the http of vhost.
-    if ((err = mux.handle(mount, new SrsVodStream(dir))) != srs_success) {
+    SrsVodStream* stream = new SrsVodStream(dir);
+    if (hls_edge) {
+        stream->set_hls_edge(new SrsHlsEdgeCache(vhost));
+    }
+
+    if ((err = mux.handle(mount, stream)) != srs_success) {
         return srs_error_wrap(err, "mux handle");
     }
-    srs_trace("http: vhost=%s mount to %s at %s", vhost.c_str(), mount.c_str(), dir.c_str());
+    srs_trace("http: vhost=%s mount to %s at %s, hls_edge=%d", vhost.c_str(), mount.c_str(), dir.c_str(), hls_edge);
     
     pmount = mount;
     
@@ -11,7 +11,13 @@
 
 #include <srs_app_http_conn.hpp>
 
+#include <list>
+
 class ISrsFileReaderFactory;
+class SrsSharedPtrMessage;
+class ISrsLbBalancer;
+class SrsFileReader;
+class SrsMp4SeekIndex;
 
 // HLS virtual connection, build on query string ctx of hls stream.
 class SrsHlsVirtualConn: public ISrsExpire
@@ -29,6 +35,9 @@ public:
     virtual void expire();
 };
 
+// Rewrite the m3u8 content, append the hls_ctx to the uri of segments and LL-HLS parts.
+extern std::string srs_hls_rewrite_ctx(std::string content, std::string ctx);
+
 // Server HLS streaming.
 class SrsHlsStream : public ISrsFastTimer
 {
@@ -41,6 +50,11 @@ public:
 public:
     virtual srs_error_t serve_m3u8_ctx(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, ISrsFileReaderFactory* factory, std::string fullpath, SrsRequest* req, bool* served);
     virtual void on_serve_ts_ctx(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+public:
+    // For LL-HLS, hold the playlist request of _HLS_msn and _HLS_part, until the part is written.
+    virtual srs_error_t block_reload(ISrsHttpMessage* r, std::string fullpath);
+    // For LL-HLS, hold the request of preload hint part, until the part is written.
+    virtual void block_part(std::string fullpath);
 private:
     srs_error_t serve_new_session(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, SrsRequest *req, std::string& ctx);
     srs_error_t serve_exists_session(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, ISrsFileReaderFactory* factory, std::string fullpath);
@@ -54,14 +68,128 @@ private:
     srs_error_t on_timer(srs_utime_t interval);
 };
 
+// The cached m3u8 or ts file of edge HLS, which is fetched from origin.
+class SrsHlsEdgeEntry
+{
+public:
+    // The path with query, because the origin might respond differently by query, for example, hls_ctx.
+    std::string url_;
+    // The shared buffer of file, NULL when fetching from origin.
+    SrsSharedPtrMessage* data_;
+    // Whether fetching from origin, other requests should wait for it.
+    bool fetching_;
+    // The expire time of m3u8, 0 for ts which never expire.
+    srs_utime_t expire_at_;
+    // The position in LRU list.
+    std::list<SrsHlsEdgeEntry*>::iterator lru_;
+public:
+    SrsHlsEdgeEntry();
+    virtual ~SrsHlsEdgeEntry();
+};
+
+// Get the stream url of HLS file, to select the origin by consistent hash.
+extern std::string srs_hls_edge_stream_url(std::string vhost, std::string url);
+
+// The HLS cache of edge, fetch the m3u8 and ts files from origin, and cache them in memory by LRU, so an edge
+// is able to serve HLS without a proxy cache. The concurrent misses of the same file are collapsed to one
+// upstream fetch.
+class SrsHlsEdgeCache
+{
+private:
+    std::string vhost_;
+    ISrsLbBalancer* lb_;
+    // The total size of cached files, and the LRU list, the front is the most recently used.
+    int64_t size_;
+    std::list<SrsHlsEdgeEntry*> lru_;
+    std::map<std::string, SrsHlsEdgeEntry*> entries_;
+    // To notify the requests waiting for the fetching files.
+    srs_cond_t cond_;
+    // The number of requests fetching or waiting, the cache is freed after all of them quit.
+    int nn_users_;
+    bool disposing_;
+public:
+    SrsHlsEdgeCache(std::string vhost);
+    virtual ~SrsHlsEdgeCache();
+public:
+    // Fetch the file by url, from cache or origin.
+    // @param url The path with query of file, for example, /live/livestream.m3u8?hls_ctx=xxx
+    // @param pdata Output the shared buffer of file, user should free it.
+    virtual srs_error_t fetch(std::string url, SrsSharedPtrMessage** pdata);
+    // Get the total size of cached files.
+    virtual int64_t size();
+    // Get the TTL of m3u8.
+    virtual srs_utime_t ttl();
+protected:
+    // Fetch the file from origin.
+    virtual srs_error_t do_fetch(std::string url, std::string& body);
+private:
+    srs_error_t fetch_or_wait(std::string url, SrsSharedPtrMessage** pdata);
+    void remove(SrsHlsEdgeEntry* entry);
+    void shrink();
+};
+
+// The cached seek index of a MP4 file.
+class SrsMp4IndexEntry
+{
+public:
+    std::string path_;
+    // To detect the file is changed, we check the modify time and size.
+    int64_t mtime_;
+    int64_t size_;
+    SrsMp4SeekIndex* index_;
+    // The position in LRU list.
+    std::list<SrsMp4IndexEntry*>::iterator lru_;
+public:
+    SrsMp4IndexEntry();
+    virtual ~SrsMp4IndexEntry();
+};
+
+// The cache of MP4 seek index, so the moov of a VOD file is only parsed once for all seek requests. The
+// capacity is the total number of samples, because the memory of index is proportional to it.
+class SrsMp4IndexCache
+{
+private:
+    int64_t nb_samples_;
+    int64_t capacity_;
+    // The LRU list, the front is the most recently used.
+    std::list<SrsMp4IndexEntry*> lru_;
+    std::map<std::string, SrsMp4IndexEntry*> entries_;
+public:
+    SrsMp4IndexCache(int64_t capacity);
+    virtual ~SrsMp4IndexCache();
+public:
+    // Fetch the index of file from cache, or parse it from the opened file fs.
+    // @param pindex Output the index, which is valid before next fetch.
+    virtual srs_error_t fetch(std::string path, SrsFileReader* fs, SrsMp4SeekIndex** pindex);
+    // Get the total number of samples in cache.
+    virtual int64_t nb_samples();
+    // Get the number of cached files.
+    virtual int size();
+private:
+    void remove(SrsMp4IndexEntry* entry);
+    void shrink();
+};
+
 // The Vod streaming, like FLV, MP4 or HLS streaming.
 class SrsVodStream : public SrsHttpFileServer
 {
 private:
     SrsHlsStream hls_;
+    // For edge HLS, serve the m3u8 and ts from the cache of origin files.
+    SrsHlsEdgeCache* hls_edge_;
+    // For MP4 seek by time, the cache of parsed index.
+    SrsMp4IndexCache* mp4_index_;
 public:
     SrsVodStream(std::string root_dir);
     virtual ~SrsVodStream();
+public:
+    // Enable the edge HLS, which fetches m3u8 and ts from origin.
+    virtual void set_hls_edge(SrsHlsEdgeCache* v);
+    virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+private:
+    srs_error_t serve_hls_edge(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+    // Serve the in-memory HLS file, the shared buffer is sent without copy.
+    srs_error_t serve_hls_memory(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string fullpath);
 protected:
     // The flv vod stream supports flv?start=offset-bytes.
     // For example, http://server/file.flv?start=10240
@@ -70,6 +198,8 @@ protected:
     virtual srs_error_t serve_flv_stream(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string fullpath, int64_t offset);
     // Support mp4 with start and offset in query string.
     virtual srs_error_t serve_mp4_stream(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string fullpath, int64_t start, int64_t end);
+    // Support mp4 seek by time in query string, the index of file is cached.
+    virtual srs_error_t serve_mp4_seek(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string fullpath, int64_t start, int64_t end);
     // Support HLS streaming with pseudo session id.
     virtual srs_error_t serve_m3u8_ctx(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string fullpath);
     virtual srs_error_t serve_ts_ctx(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string fullpath);
@@ -8,6 +8,14 @@
 
 #define SRS_STREAM_CACHE_CYCLE (30 * SRS_UTIME_SECONDS)
 
+// The ring keeps at least the min chunks, and the chunks from the previous joinable chunk, but never exceed the max.
+#define SRS_STREAM_RING_MIN_CHUNKS 64
+#define SRS_STREAM_RING_MAX_CHUNKS 2048
+// The muxer of ring quits when no player for this duration.
+#define SRS_STREAM_RING_IDLE (30 * SRS_UTIME_SECONDS)
+// For pure audio HTTP-TS, refresh the PAT/PMT in this interval in ms, for player to join.
+#define SRS_STREAM_RING_AUDIO_JOIN 1000
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -33,12 +41,14 @@ using namespace std;
 #include <srs_kernel_aac.hpp>
 #include <srs_kernel_mp3.hpp>
 #include <srs_kernel_ts.hpp>
+#include <srs_kernel_stream.hpp>
 #include <srs_app_pithy_print.hpp>
 #include <srs_app_source.hpp>
 #include <srs_app_server.hpp>
 #include <srs_app_statistic.hpp>
 #include <srs_app_recv_thread.hpp>
 #include <srs_app_http_hooks.hpp>
+#include <srs_app_delivery.hpp>
 
 SrsBufferCache::SrsBufferCache(SrsLiveSource* s, SrsRequest* r)
 {
@@ -243,6 +253,11 @@ void SrsTsStreamEncoder::set_has_video(bool v)
     enc->set_has_video(v);
 }
 
+void SrsTsStreamEncoder::refresh_pat_pmt()
+{
+    enc->refresh_pat_pmt();
+}
+
 SrsFlvStreamEncoder::SrsFlvStreamEncoder()
 {
     header_written = false;
@@ -553,10 +568,401 @@ srs_error_t SrsBufferWriter::writev(const iovec* iov, int iovcnt, ssize_t* pnwri
     return writer->writev(iov, iovcnt, pnwrite);
 }
 
-SrsLiveStream::SrsLiveStream(SrsLiveSource* s, SrsRequest* r, SrsBufferCache* c)
+SrsLiveChunk::SrsLiveChunk()
+{
+    seq = 0;
+    joinable = false;
+    data = NULL;
+}
+
+SrsLiveChunk::~SrsLiveChunk()
+{
+    srs_freep(data);
+}
+
+SrsLiveChunkWriter::SrsLiveChunkWriter()
+{
+    buf_ = new SrsSimpleStream();
+}
+
+SrsLiveChunkWriter::~SrsLiveChunkWriter()
+{
+    srs_freep(buf_);
+}
+
+srs_error_t SrsLiveChunkWriter::open(std::string /*file*/)
+{
+    return srs_success;
+}
+
+void SrsLiveChunkWriter::close()
+{
+}
+
+bool SrsLiveChunkWriter::is_open()
+{
+    return true;
+}
+
+int64_t SrsLiveChunkWriter::tellg()
+{
+    return buf_->length();
+}
+
+srs_error_t SrsLiveChunkWriter::write(void* buf, size_t count, ssize_t* pnwrite)
+{
+    if (count > 0) {
+        buf_->append((const char*)buf, (int)count);
+    }
+
+    if (pnwrite) {
+        *pnwrite = count;
+    }
+
+    return srs_success;
+}
+
+srs_error_t SrsLiveChunkWriter::writev(const iovec* iov, int iovcnt, ssize_t* pnwrite)
+{
+    ssize_t nwrite = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > 0) {
+            buf_->append((const char*)iov[i].iov_base, (int)iov[i].iov_len);
+            nwrite += iov[i].iov_len;
+        }
+    }
+
+    if (pnwrite) {
+        *pnwrite = nwrite;
+    }
+
+    return srs_success;
+}
+
+int SrsLiveChunkWriter::size()
+{
+    return buf_->length();
+}
+
+char* SrsLiveChunkWriter::take()
+{
+    int size = buf_->length();
+    char* data = new char[size];
+    memcpy(data, buf_->bytes(), size);
+    buf_->erase(size);
+    return data;
+}
+
+SrsLiveChunkRing::SrsLiveChunkRing(SrsLiveSource* s, SrsRequest* r, std::string ext)
+{
+    source = s;
+    req = r->copy()->as_http();
+    trd = NULL;
+    running_ = false;
+    ext_ = ext;
+
+    next_seq_ = 0;
+    last_joinable_ = prev_joinable_ = -1;
+    cond_ = srs_cond_new();
+    nn_players_ = 0;
+    last_player_ = 0;
+}
+
+SrsLiveChunkRing::~SrsLiveChunkRing()
+{
+    srs_freep(trd);
+
+    clear();
+    srs_cond_destroy(cond_);
+    srs_freep(req);
+}
+
+srs_error_t SrsLiveChunkRing::update_auth(SrsLiveSource* s, SrsRequest* r)
+{
+    srs_freep(req);
+    req = r->copy()->as_http();
+    source = s;
+
+    return srs_success;
+}
+
+srs_error_t SrsLiveChunkRing::on_player_start()
+{
+    srs_error_t err = srs_success;
+
+    nn_players_++;
+    last_player_ = srs_get_system_time();
+
+    if (running_) {
+        return err;
+    }
+
+    // Restart the muxer, which quits when idle.
+    srs_freep(trd);
+    trd = new SrsSTCoroutine("http-ring", this);
+    running_ = true;
+
+    if ((err = trd->start()) != srs_success) {
+        running_ = false;
+        return srs_error_wrap(err, "coroutine");
+    }
+
+    return err;
+}
+
+void SrsLiveChunkRing::on_player_stop()
+{
+    nn_players_--;
+    last_player_ = srs_get_system_time();
+}
+
+void SrsLiveChunkRing::clear()
+{
+    for (int i = 0; i < (int)chunks_.size(); i++) {
+        SrsLiveChunk* chunk = chunks_.at(i);
+        srs_freep(chunk);
+    }
+    chunks_.clear();
+
+    last_joinable_ = prev_joinable_ = -1;
+}
+
+void SrsLiveChunkRing::append(char* data, int size, bool joinable)
+{
+    SrsLiveChunk* chunk = new SrsLiveChunk();
+    chunk->seq = next_seq_++;
+    chunk->joinable = joinable;
+    chunk->data = new SrsSharedPtrMessage();
+    chunk->data->wrap(data, size);
+    chunks_.push_back(chunk);
+
+    if (joinable) {
+        prev_joinable_ = last_joinable_;
+        last_joinable_ = chunk->seq;
+    }
+
+    shrink();
+
+    srs_cond_broadcast(cond_);
+}
+
+int64_t SrsLiveChunkRing::join()
+{
+    if (chunks_.empty()) {
+        return -1;
+    }
+
+    // For audio stream, join at the oldest chunk for fast startup.
+    if (ext_ != ".ts") {
+        return chunks_.front()->seq;
+    }
+
+    // For TS stream, join at the latest keyframe, where the PAT/PMT is written.
+    if (last_joinable_ < chunks_.front()->seq) {
+        return -1;
+    }
+    return last_joinable_;
+}
+
+void SrsLiveChunkRing::fetch(int64_t& cursor, std::vector<SrsSharedPtrMessage*>& chunks, int max)
+{
+    if (chunks_.empty()) {
+        return;
+    }
+
+    // The player is too slow, skip to the latest joinable chunk.
+    int64_t first = chunks_.front()->seq;
+    if (cursor < first) {
+        int64_t to = join();
+        srs_warn("http: ring skip chunks, cursor=%" PRId64 ", first=%" PRId64 ", to=%" PRId64, cursor, first, to);
+        if (to < 0) {
+            return;
+        }
+        cursor = to;
+    }
+
+    for (int64_t i = cursor - first; i < (int64_t)chunks_.size() && (int)chunks.size() < max; i++) {
+        SrsLiveChunk* chunk = chunks_.at(i);
+        chunks.push_back(chunk->data->copy());
+        cursor = chunk->seq + 1;
+    }
+}
+
+void SrsLiveChunkRing::wait(srs_utime_t timeout)
+{
+    srs_cond_timedwait(cond_, timeout);
+}
+
+int SrsLiveChunkRing::size()
+{
+    return (int)chunks_.size();
+}
+
+srs_error_t SrsLiveChunkRing::cycle()
+{
+    srs_error_t err = do_cycle();
+
+    running_ = false;
+
+    if (err != srs_success) {
+        srs_warn("http: ring muxer quit, err %s", srs_error_desc(err).c_str());
+        srs_freep(err);
+    }
+
+    return srs_success;
+}
+
+srs_error_t SrsLiveChunkRing::do_cycle()
+{
+    srs_error_t err = srs_success;
+
+    // Only the audio or TS stream need muxing, the FLV stream is sent without muxing.
+    ISrsBufferEncoder* enc = NULL;
+    if (ext_ == ".ts") {
+        SrsTsStreamEncoder* tse = new SrsTsStreamEncoder();
+        tse->set_has_audio(_srs_config->get_vhost_http_remux_has_audio(req->vhost));
+        tse->set_has_video(_srs_config->get_vhost_http_remux_has_video(req->vhost));
+        enc = tse;
+    } else if (ext_ == ".aac") {
+        enc = new SrsAacStreamEncoder();
+    } else if (ext_ == ".mp3") {
+        enc = new SrsMp3StreamEncoder();
+    } else {
+        return srs_error_new(ERROR_HTTP_LIVE_STREAM_EXT, "invalid ext=%s", ext_.c_str());
+    }
+    SrsAutoFree(ISrsBufferEncoder, enc);
+
+    SrsLiveChunkWriter writer;
+    if ((err = enc->initialize(&writer, NULL)) != srs_success) {
+        return srs_error_wrap(err, "init encoder");
+    }
+
+    // For TS, write PAT/PMT at keyframe, for player to join.
+    SrsTsStreamEncoder* tse = dynamic_cast<SrsTsStreamEncoder*>(enc);
+
+    // The muxer starts from the gop cache, like a player.
+    SrsLiveConsumer* consumer = NULL;
+    SrsAutoFree(SrsLiveConsumer, consumer);
+    if ((err = source->create_consumer(consumer)) != srs_success) {
+        return srs_error_wrap(err, "create consumer");
+    }
+    if ((err = source->consumer_dumps(consumer, true, true, true)) != srs_success) {
+        return srs_error_wrap(err, "dumps consumer");
+    }
+
+    SrsPithyPrint* pprint = SrsPithyPrint::create_http_stream_cache();
+    SrsAutoFree(SrsPithyPrint, pprint);
+
+    SrsMessageArray msgs(SRS_PERF_MW_MSGS);
+    srs_utime_t mw_sleep = _srs_config->get_mw_sleep(req->vhost);
+    srs_trace("http: ring muxer start, ext=%s, mw_sleep=%dms", ext_.c_str(), srsu2msi(mw_sleep));
+
+    bool has_video = false;
+    bool refreshed = false;
+    int64_t refresh_time = -1;
+
+    while (true) {
+        if ((err = trd->pull()) != srs_success) {
+            return srs_error_wrap(err, "ring muxer");
+        }
+
+        // Quit when no player for a while, and restart when player comes.
+        if (nn_players_ <= 0 && srs_get_system_time() - last_player_ > SRS_STREAM_RING_IDLE) {
+            srs_trace("http: ring muxer quit for idle, chunks=%d", (int)chunks_.size());
+            clear();
+            return err;
+        }
+
+        pprint->elapse();
+
+        // each msg in msgs.msgs must be free, for the SrsMessageArray never free them.
+        int count = 0;
+        if ((err = consumer->dump_packets(&msgs, count)) != srs_success) {
+            return srs_error_wrap(err, "consumer dump packets");
+        }
+
+        if (count <= 0) {
+            srs_usleep(mw_sleep);
+            continue;
+        }
+
+        if (pprint->can_print()) {
+            srs_trace("-> " SRS_CONSTS_LOG_HTTP_STREAM_CACHE " http: ring got %d msgs, age=%d, chunks=%d, players=%d",
+                count, pprint->age(), (int)chunks_.size(), nn_players_);
+        }
+
+        for (int i = 0; i < count && err == srs_success; i++) {
+            SrsSharedPtrMessage* msg = msgs.msgs[i];
+
+            // Refresh PAT/PMT at keyframe, or in interval for pure audio stream.
+            if (tse) {
+                bool refresh = false;
+                if (msg->is_video()) {
+                    has_video = true;
+                    refresh = SrsFlvVideo::keyframe(msg->payload, msg->size) && !SrsFlvVideo::sh(msg->payload, msg->size);
+                } else if (msg->is_audio() && !has_video) {
+                    refresh = refresh_time < 0 || msg->timestamp - refresh_time >= SRS_STREAM_RING_AUDIO_JOIN;
+                }
+
+                if (refresh) {
+                    tse->refresh_pat_pmt();
+                    refresh_time = msg->timestamp;
+                    refreshed = true;
+                }
+            }
+
+            if (msg->is_audio()) {
+                err = enc->write_audio(msg->timestamp, msg->payload, msg->size);
+            } else if (msg->is_video()) {
+                err = enc->write_video(msg->timestamp, msg->payload, msg->size);
+            } else {
+                err = enc->write_metadata(msg->timestamp, msg->payload, msg->size);
+            }
+
+            // The chunk is joinable when it starts with PAT/PMT for TS, or always for audio stream.
+            if (err == srs_success && writer.size() > 0) {
+                int size = writer.size();
+                append(writer.take(), size, tse ? refreshed : true);
+                refreshed = false;
+            }
+        }
+
+        // free the messages.
+        for (int i = 0; i < count; i++) {
+            SrsSharedPtrMessage* msg = msgs.msgs[i];
+            srs_freep(msg);
+        }
+
+        if (err != srs_success) {
+            return srs_error_wrap(err, "mux messages");
+        }
+    }
+
+    return err;
+}
+
+void SrsLiveChunkRing::shrink()
+{
+    while (!chunks_.empty()) {
+        SrsLiveChunk* chunk = chunks_.front();
+
+        // Keep the chunks from previous joinable chunk, for slow players.
+        bool overflow = (int)chunks_.size() > SRS_STREAM_RING_MAX_CHUNKS;
+        bool expired = (int)chunks_.size() > SRS_STREAM_RING_MIN_CHUNKS && chunk->seq < prev_joinable_;
+        if (!overflow && !expired) {
+            break;
+        }
+
+        chunks_.pop_front();
+        srs_freep(chunk);
+    }
+}
+
+SrsLiveStream::SrsLiveStream(SrsLiveSource* s, SrsRequest* r, SrsBufferCache* c, SrsLiveChunkRing* g)
 {
     source = s;
     cache = c;
+    ring = g;
     req = r->copy()->as_http();
 }
 
@@ -606,8 +1012,11 @@ srs_error_t SrsLiveStream::serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage
     }
     
     err = do_serve_http(w, r);
-    
-    http_hooks_on_stop(r);
+
+    // The delivery worker fires on_stop when the player is gone.
+    if (!_srs_delivery->delivered(_srs_context->get_id().c_str())) {
+        http_hooks_on_stop(r);
+    }
     
     return err;
 }
@@ -652,6 +1061,22 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
     }
     SrsAutoFree(ISrsBufferEncoder, enc);
 
+    // Hand off the FLV player of mega stream to the delivery worker, except HTTPS which is not a plain fd.
+    if (enc_desc == "FLV" && _srs_delivery->hot(source, req)) {
+        // Fall back to serve it in coroutine, if not a plain HTTP connection, for example, a mock in utest.
+        SrsHttpMessage* hr = dynamic_cast<SrsHttpMessage*>(r);
+        SrsHttpConn* hc = hr ? dynamic_cast<SrsHttpConn*>(hr->connection()) : NULL;
+        SrsHttpxConn* hxc = hc ? dynamic_cast<SrsHttpxConn*>(hc->handler()) : NULL;
+        if (hxc && hxc->fd() >= 0) {
+            return serve_delivery(w, r, hxc->fd(), has_audio, has_video);
+        }
+    }
+
+    // The stream is muxed once by the ring, shared by all players.
+    if (ring) {
+        return serve_shared(w, r);
+    }
+
     // Enter chunked mode, because we didn't set the content-length.
     w->write_header(SRS_CONSTS_HTTP_OK);
     
@@ -764,6 +1189,132 @@ srs_error_t SrsLiveStream::do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMess
     return srs_error_new(ERROR_HTTP_STREAM_EOF, "Stream EOF");
 }
 
+srs_error_t SrsLiveStream::serve_shared(ISrsHttpResponseWriter* w, ISrsHttpMessage* r)
+{
+    srs_error_t err = srs_success;
+
+    if ((err = ring->on_player_start()) != srs_success) {
+        return srs_error_wrap(err, "start ring");
+    }
+
+    err = do_serve_shared(w, r);
+
+    ring->on_player_stop();
+
+    return err;
+}
+
+srs_error_t SrsLiveStream::do_serve_shared(ISrsHttpResponseWriter* w, ISrsHttpMessage* r)
+{
+    srs_error_t err = srs_success;
+
+    // Enter chunked mode, because we didn't set the content-length.
+    w->write_header(SRS_CONSTS_HTTP_OK);
+
+    SrsPithyPrint* pprint = SrsPithyPrint::create_http_stream();
+    SrsAutoFree(SrsPithyPrint, pprint);
+
+    // Use receive thread to accept the close event to avoid FD leak.
+    SrsHttpMessage* hr = dynamic_cast<SrsHttpMessage*>(r);
+    SrsHttpConn* hc = dynamic_cast<SrsHttpConn*>(hr->connection());
+    SrsHttpxConn* hxc = dynamic_cast<SrsHttpxConn*>(hc->handler());
+    srs_assert(hxc);
+
+    SrsHttpRecvThread* trd = new SrsHttpRecvThread(hxc);
+    SrsAutoFree(SrsHttpRecvThread, trd);
+
+    if ((err = trd->start()) != srs_success) {
+        return srs_error_wrap(err, "start recv thread");
+    }
+
+    srs_utime_t mw_sleep = _srs_config->get_mw_sleep(req->vhost);
+    srs_trace("FLV %s, shared ring, mw_sleep=%dms, chunks=%d", entry->pattern.c_str(), srsu2msi(mw_sleep), ring->size());
+
+    int64_t cursor = -1;
+    std::vector<SrsSharedPtrMessage*> chunks;
+    iovec* iovs = new iovec[SRS_PERF_MW_MSGS];
+    SrsAutoFreeA(iovec, iovs);
+
+    while (entry->enabled) {
+        // Whether client closed the FD.
+        if ((err = trd->pull()) != srs_success) {
+            return srs_error_wrap(err, "recv thread");
+        }
+
+        pprint->elapse();
+
+        if (cursor < 0) {
+            cursor = ring->join();
+        }
+        if (cursor >= 0) {
+            ring->fetch(cursor, chunks, SRS_PERF_MW_MSGS);
+        }
+
+        if (chunks.empty()) {
+            ring->wait(mw_sleep);
+            continue;
+        }
+
+        if (pprint->can_print()) {
+            srs_trace("-> " SRS_CONSTS_LOG_HTTP_STREAM " http: got %d chunks, age=%d, cursor=%" PRId64 ", mw=%d",
+                (int)chunks.size(), pprint->age(), cursor, srsu2msi(mw_sleep));
+        }
+
+        // Send the chunks by one writev, without muxing.
+        for (int i = 0; i < (int)chunks.size(); i++) {
+            SrsSharedPtrMessage* chunk = chunks.at(i);
+            iovs[i].iov_base = chunk->payload;
+            iovs[i].iov_len = chunk->size;
+        }
+        err = w->writev(iovs, (int)chunks.size(), NULL);
+
+        for (int i = 0; i < (int)chunks.size(); i++) {
+            SrsSharedPtrMessage* chunk = chunks.at(i);
+            srs_freep(chunk);
+        }
+        chunks.clear();
+
+        if (err != srs_success) {
+            return srs_error_wrap(err, "send chunks");
+        }
+    }
+
+    // Here, the entry is disabled by encoder un-publishing or reloading,
+    // so we must return a io.EOF error to disconnect the client, or the client will never quit.
+    return srs_error_new(ERROR_HTTP_STREAM_EOF, "Stream EOF");
+}
+
+srs_error_t SrsLiveStream::serve_delivery(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, int fd, bool has_audio, bool has_video)
+{
+    srs_error_t err = srs_success;
+
+    // Enter chunked mode, because we didn't set the content-length.
+    w->write_header(SRS_CONSTS_HTTP_OK);
+
+    // Send the response header with the FLV header, then the worker sends the tags in chunks.
+    SrsBufferWriter writer(w);
+    SrsFlvTransmuxer flv;
+    if ((err = flv.initialize(&writer)) != srs_success) {
+        return srs_error_wrap(err, "init flv");
+    }
+    if ((err = flv.write_header(has_video, has_audio)) != srs_success) {
+        return srs_error_wrap(err, "write flv header");
+    }
+
+    // The player is kept in stat and fires on_stop by the worker, so we use the request of player for hooks.
+    SrsHttpMessage* hr = dynamic_cast<SrsHttpMessage*>(r);
+    SrsRequest* nreq = hr->to_request(req->vhost);
+    SrsAutoFree(SrsRequest, nreq);
+
+    string id = _srs_context->get_id().c_str();
+    if ((err = _srs_delivery->handoff_flv(source, req, nreq, id, fd)) != srs_success) {
+        return srs_error_wrap(err, "handoff");
+    }
+
+    // Never write the final chunk, the connection is closed and the worker serves the player.
+    return srs_error_new(ERROR_SUCCESS, "delivered by worker");
+}
+
 srs_error_t SrsLiveStream::http_hooks_on_play(ISrsHttpMessage* r)
 {
     srs_error_t err = srs_success;
@@ -868,6 +1419,7 @@ SrsLiveEntry::SrsLiveEntry(std::string m)
     
     stream = NULL;
     cache = NULL;
+    ring = NULL;
     
     req = NULL;
     source = NULL;
@@ -979,7 +1531,11 @@ srs_error_t SrsHttpStreamServer::http_mount(SrsLiveSource* s, SrsRequest* r)
         entry->source = s;
         entry->req = r->copy()->as_http();
         entry->cache = new SrsBufferCache(s, r);
-        entry->stream = new SrsLiveStream(s, r, entry->cache);
+        // The HTTP-FLV sends the shared payload directly, so only mux once for HTTP-TS/AAC/MP3.
+        if (!entry->is_flv() && _srs_config->get_vhost_http_remux_shared_mux(r->vhost)) {
+            entry->ring = new SrsLiveChunkRing(s, r, srs_path_filext(mount));
+        }
+        entry->stream = new SrsLiveStream(s, r, entry->cache, entry->ring);
         
         // TODO: FIXME: maybe refine the logic of http remux service.
         // if user push streams followed:
@@ -1011,6 +1567,9 @@ srs_error_t SrsHttpStreamServer::http_mount(SrsLiveSource* s, SrsRequest* r)
         entry = sflvs[sid];
         entry->stream->update_auth(s, r);
         entry->cache->update_auth(s, r);
+        if (entry->ring) {
+            entry->ring->update_auth(s, r);
+        }
     }
     
     if (entry->stream) {
@@ -1031,6 +1590,11 @@ void SrsHttpStreamServer::http_unmount(SrsLiveSource* s, SrsRequest* r)
     
     SrsLiveEntry* entry = sflvs[sid];
     entry->stream->entry->enabled = false;
+
+    // Drop the chunks, which should never be sent to player of next publishing.
+    if (entry->ring) {
+        entry->ring->clear();
+    }
 }
 
 srs_error_t SrsHttpStreamServer::hijack(ISrsHttpMessage* request, ISrsHttpHandler** ph)
@@ -11,10 +11,15 @@
 
 #include <srs_app_http_conn.hpp>
 
+#include <deque>
+#include <vector>
+
 class SrsAacTransmuxer;
 class SrsMp3Transmuxer;
 class SrsFlvTransmuxer;
 class SrsTsTransmuxer;
+class SrsSimpleStream;
+class SrsLiveChunkRing;
 
 // A cache for HTTP Live Streaming encoder, to make android(weixin) happy.
 class SrsBufferCache : public ISrsCoroutineHandler
@@ -113,6 +118,8 @@ public:
 public:
     void set_has_audio(bool v);
     void set_has_video(bool v);
+    // Write the PAT/PMT again, for player to join at the next chunk.
+    void refresh_pat_pmt();
 };
 
 // Transmux RTMP with AAC stream to HTTP AAC Streaming.
@@ -172,6 +179,97 @@ public:
     virtual srs_error_t writev(const iovec* iov, int iovcnt, ssize_t* pnwrite);
 };
 
+// The chunk of encoded bytes in the shared ring, which is muxed from one or more messages.
+class SrsLiveChunk
+{
+public:
+    // The sequence number of chunk in ring.
+    int64_t seq;
+    // Whether player is able to join at this chunk, for example, the TS chunk starts with PAT/PMT and keyframe.
+    bool joinable;
+    // The encoded bytes, shared by all players by ref-count.
+    SrsSharedPtrMessage* data;
+public:
+    SrsLiveChunk();
+    virtual ~SrsLiveChunk();
+};
+
+// The writer to collect the encoded bytes of encoder, to build the chunk.
+class SrsLiveChunkWriter : public SrsFileWriter
+{
+private:
+    SrsSimpleStream* buf_;
+public:
+    SrsLiveChunkWriter();
+    virtual ~SrsLiveChunkWriter();
+public:
+    virtual srs_error_t open(std::string file);
+    virtual void close();
+public:
+    virtual bool is_open();
+    virtual int64_t tellg();
+public:
+    virtual srs_error_t write(void* buf, size_t count, ssize_t* pnwrite);
+    virtual srs_error_t writev(const iovec* iov, int iovcnt, ssize_t* pnwrite);
+public:
+    // The size of collected bytes.
+    virtual int size();
+    // Copy the collected bytes out and reset the writer, user should free the bytes.
+    virtual char* take();
+};
+
+// The shared muxed output of a stream for HTTP-TS/AAC/MP3, which consumes the source and muxes the stream once to a
+// ring of encoded chunks, then each player writes the chunks from its cursor without muxing.
+class SrsLiveChunkRing : public ISrsCoroutineHandler
+{
+private:
+    SrsLiveSource* source;
+    SrsRequest* req;
+    SrsCoroutine* trd;
+    // Whether the muxer coroutine is running, it quits when no player for a while.
+    bool running_;
+    // The extension of stream, such as .ts, .aac or .mp3.
+    std::string ext_;
+private:
+    std::deque<SrsLiveChunk*> chunks_;
+    int64_t next_seq_;
+    // The sequence of the last and previous joinable chunk, -1 if none.
+    int64_t last_joinable_;
+    int64_t prev_joinable_;
+    // To wakeup players when new chunk is appended.
+    srs_cond_t cond_;
+    // The number of players and the last time that has player.
+    int nn_players_;
+    srs_utime_t last_player_;
+public:
+    SrsLiveChunkRing(SrsLiveSource* s, SrsRequest* r, std::string ext);
+    virtual ~SrsLiveChunkRing();
+    virtual srs_error_t update_auth(SrsLiveSource* s, SrsRequest* r);
+public:
+    // When player start or stop, start the muxer coroutine if not running.
+    virtual srs_error_t on_player_start();
+    virtual void on_player_stop();
+    // Drop all chunks, when stream is unpublished.
+    virtual void clear();
+    // Append the encoded bytes as a chunk, the ring takes the ownership of data.
+    virtual void append(char* data, int size, bool joinable);
+    // Get the cursor for a new player, -1 if there is no joinable chunk.
+    virtual int64_t join();
+    // Fetch at most max chunks from cursor, which is updated to the next chunk. The chunks are copies, user should
+    // free them. The player skips to the latest joinable chunk, if it's too slow and the cursor is dropped.
+    virtual void fetch(int64_t& cursor, std::vector<SrsSharedPtrMessage*>& chunks, int max);
+    // Wait for new chunk to append, or timeout.
+    virtual void wait(srs_utime_t timeout);
+    // The number of chunks in ring.
+    virtual int size();
+// Interface ISrsCoroutineHandler
+public:
+    virtual srs_error_t cycle();
+private:
+    virtual srs_error_t do_cycle();
+    virtual void shrink();
+};
+
 // HTTP Live Streaming, to transmux RTMP to HTTP FLV or other format.
 // TODO: FIXME: Rename to SrsHttpLive
 class SrsLiveStream : public ISrsHttpHandler
@@ -180,14 +278,21 @@ private:
     SrsRequest* req;
     SrsLiveSource* source;
     SrsBufferCache* cache;
+    // The shared muxed ring, NULL if disabled.
+    SrsLiveChunkRing* ring;
 public:
-    SrsLiveStream(SrsLiveSource* s, SrsRequest* r, SrsBufferCache* c);
+    SrsLiveStream(SrsLiveSource* s, SrsRequest* r, SrsBufferCache* c, SrsLiveChunkRing* g);
     virtual ~SrsLiveStream();
     virtual srs_error_t update_auth(SrsLiveSource* s, SrsRequest* r);
 public:
     virtual srs_error_t serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
 private:
     virtual srs_error_t do_serve_http(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+    // Serve the player by the shared muxed chunks of ring.
+    virtual srs_error_t serve_shared(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+    virtual srs_error_t do_serve_shared(ISrsHttpResponseWriter* w, ISrsHttpMessage* r);
+    // Hand off the FLV player of mega stream to the delivery worker, after the header is sent.
+    virtual srs_error_t serve_delivery(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, int fd, bool has_audio, bool has_video);
     virtual srs_error_t http_hooks_on_play(ISrsHttpMessage* r);
     virtual void http_hooks_on_stop(ISrsHttpMessage* r);
     virtual srs_error_t streaming_send_messages(ISrsBufferEncoder* enc, SrsSharedPtrMessage** msgs, int nb_msgs);
@@ -213,6 +318,7 @@ public:
     
     SrsLiveStream* stream;
     SrsBufferCache* cache;
+    SrsLiveChunkRing* ring;
     
     SrsLiveEntry(std::string m);
     virtual ~SrsLiveEntry();
@@ -23,6 +23,34 @@ using namespace std;
 
 // the max small bytes to group
 #define SRS_MR_SMALL_BYTES 4096
+// the bitrate to calculate the recv buffer, if not sampled by adaptive mr.
+#define SRS_MR_KBPS 5000
+// for adaptive mr, the bytes to merge for each read, and the sleep is in [10ms, mr_latency].
+#define SRS_MR_ADAPTIVE_BYTES 65536
+#define SRS_MR_ADAPTIVE_MIN_SLEEP (10 * SRS_UTIME_MILLISECONDS)
+// for adaptive mr, the interval to sample the bitrate and tune the sleep.
+#define SRS_MR_ADAPTIVE_INTERVAL (3 * SRS_UTIME_SECONDS)
+
+srs_utime_t srs_mr_adaptive_sleep(int kbps, srs_utime_t latency)
+{
+    if (kbps <= 0) {
+        return latency;
+    }
+
+    // the time in ms to got the bytes is bytes*8/kbps.
+    srs_utime_t sleep_v = (srs_utime_t)SRS_MR_ADAPTIVE_BYTES * 8 * SRS_UTIME_MILLISECONDS / kbps;
+    sleep_v = srs_max(sleep_v, SRS_MR_ADAPTIVE_MIN_SLEEP);
+    return srs_min(sleep_v, latency);
+}
+
+int srs_mr_adaptive_rbuf(int kbps, int read_size, srs_utime_t sleep_v)
+{
+    // the recv buffer is double of the bytes in sleep, for the burst of key frames.
+    int size = srsu2msi(sleep_v) * kbps * 2 / 8;
+
+    // the sampled read size is the bytes really merged, so also hold double of it.
+    return srs_max(size, read_size * 2);
+}
 
 ISrsMessageConsumer::ISrsMessageConsumer()
 {
@@ -279,10 +307,19 @@ SrsPublishRecvThread::SrsPublishRecvThread(SrsRtmpServer* rtmp_sdk, SrsRequest*
     // the mr settings,
     mr = _srs_config->get_mr_enabled(req->vhost);
     mr_sleep = _srs_config->get_mr_sleep(req->vhost);
+    mr_rbuf = mr_erbuf = 0;
+
+    // the adaptive mr, start from the latency budget.
+    mr_adaptive = _srs_config->get_mr_adaptive(req->vhost);
+    mr_latency = mr_sleep;
+    mr_starttime = 0;
+    mr_bytes = mr_reads = 0;
+    mr_kbps = mr_read_size = 0;
+    stat_id = parent_cid.c_str();
     
     realtime = _srs_config->get_realtime_enabled(req->vhost);
     
-    _srs_config->subscribe(this);
+    _srs_config->subscribe_vhost(req->vhost, this);
 }
 
 SrsPublishRecvThread::~SrsPublishRecvThread()
@@ -413,7 +450,8 @@ void SrsPublishRecvThread::on_start()
 #ifdef SRS_PERF_MERGED_READ
     if (mr) {
         // set underlayer buffer size
-        set_socket_buffer(mr_sleep);
+        set_socket_buffer(mr_sleep, SRS_MR_KBPS);
+        update_mr_stat();
         
         // disable the merge read
         rtmp->set_merge_read(true, this);
@@ -447,6 +485,10 @@ void SrsPublishRecvThread::on_read(ssize_t nread)
     if (nread < 0 || mr_sleep <= 0) {
         return;
     }
+
+    if (mr_adaptive) {
+        adapt_mr(nread);
+    }
     
     /**
      * to improve read performance, merge some packets then read,
@@ -470,10 +512,11 @@ srs_error_t SrsPublishRecvThread::on_reload_vhost_publish(string vhost)
     // the mr settings,
     bool mr_enabled = _srs_config->get_mr_enabled(req->vhost);
     srs_utime_t sleep_v = _srs_config->get_mr_sleep(req->vhost);
+    bool adaptive = _srs_config->get_mr_adaptive(req->vhost);
     
     // update buffer when sleep ms changed.
     if (mr_sleep != sleep_v) {
-        set_socket_buffer(sleep_v);
+        set_socket_buffer(sleep_v, SRS_MR_KBPS);
     }
     
 #ifdef SRS_PERF_MERGED_READ
@@ -489,9 +532,13 @@ srs_error_t SrsPublishRecvThread::on_reload_vhost_publish(string vhost)
     }
 #endif
     
-    // update to new state
+    // update to new state, the adaptive mr restart from the latency budget.
     mr = mr_enabled;
     mr_sleep = sleep_v;
+    mr_adaptive = adaptive;
+    mr_latency = sleep_v;
+    mr_starttime = 0;
+    update_mr_stat();
     
     return err;
 }
@@ -511,7 +558,12 @@ srs_error_t SrsPublishRecvThread::on_reload_vhost_realtime(string vhost)
     return err;
 }
 
-void SrsPublishRecvThread::set_socket_buffer(srs_utime_t sleep_v)
+void SrsPublishRecvThread::set_socket_buffer(srs_utime_t sleep_v, int kbps)
+{
+    set_socket_buffer_size(sleep_v, srsu2msi(sleep_v) * kbps / 8);
+}
+
+void SrsPublishRecvThread::set_socket_buffer_size(srs_utime_t sleep_v, int socket_buffer_size)
 {
     // the bytes:
     //      4KB=4096, 8KB=8192, 16KB=16384, 32KB=32768, 64KB=65536,
@@ -523,9 +575,6 @@ void SrsPublishRecvThread::set_socket_buffer(srs_utime_t sleep_v)
     // other examples:
     //      2000*3000/8=750000B(about 732KB).
     //      2000*5000/8=1250000B(about 1220KB).
-    int kbps = 5000;
-    int socket_buffer_size = srsu2msi(sleep_v) * kbps / 8;
-    
     int fd = mr_fd;
     int onb_rbuf = 0;
     socklen_t sock_buf_size = sizeof(int);
@@ -538,11 +587,55 @@ void SrsPublishRecvThread::set_socket_buffer(srs_utime_t sleep_v)
     }
     getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &nb_rbuf, &sock_buf_size);
     
-    srs_trace("mr change sleep %d=>%d, erbuf=%d, rbuf %d=>%d, sbytes=%d, realtime=%d",
+    srs_trace("mr change sleep %d=>%d, erbuf=%d, rbuf %d=>%d, sbytes=%d, realtime=%d, adaptive=%d",
               srsu2msi(mr_sleep), srsu2msi(sleep_v), socket_buffer_size, onb_rbuf, nb_rbuf,
-              SRS_MR_SMALL_BYTES, realtime);
+              SRS_MR_SMALL_BYTES, realtime, mr_adaptive);
     
     rtmp->set_recv_buffer(nb_rbuf);
+    mr_rbuf = nb_rbuf;
+    mr_erbuf = socket_buffer_size;
+}
+
+void SrsPublishRecvThread::adapt_mr(ssize_t nread)
+{
+    srs_utime_t now = srs_get_system_time();
+    if (!mr_starttime) {
+        mr_starttime = now;
+        mr_bytes = mr_reads = 0;
+    }
+
+    mr_bytes += nread;
+    mr_reads++;
+
+    srs_utime_t duration = now - mr_starttime;
+    if (duration < SRS_MR_ADAPTIVE_INTERVAL) {
+        return;
+    }
+
+    mr_kbps = (int)(mr_bytes * 8 * SRS_UTIME_MILLISECONDS / duration);
+    mr_read_size = (int)(mr_bytes / mr_reads);
+    mr_starttime = now;
+    mr_bytes = mr_reads = 0;
+
+    srs_utime_t sleep_v = srs_mr_adaptive_sleep(mr_kbps, mr_latency);
+    int erbuf = srs_mr_adaptive_rbuf(mr_kbps, mr_read_size, sleep_v);
+
+    // ignore the small changes, less than 20%, to avoid resizing the buffer frequently.
+    // @remark Compare the expected recv buffer, for the sleep might be clamped while the bitrate changes.
+    srs_utime_t diff = srs_max(sleep_v, mr_sleep) - srs_min(sleep_v, mr_sleep);
+    int rdiff = srs_max(erbuf, mr_erbuf) - srs_min(erbuf, mr_erbuf);
+    if (diff > mr_sleep / 5 || rdiff > mr_erbuf / 5) {
+        set_socket_buffer_size(sleep_v, erbuf);
+        mr_sleep = sleep_v;
+    }
+
+    update_mr_stat();
+}
+
+void SrsPublishRecvThread::update_mr_stat()
+{
+    SrsStatistic* stat = SrsStatistic::instance();
+    stat->on_client_mr(stat_id, mr, mr_adaptive, mr_sleep, mr_rbuf, mr_kbps, mr_read_size);
 }
 
 SrsHttpRecvThread::SrsHttpRecvThread(SrsHttpxConn* c)
@@ -140,6 +140,17 @@ private:
     bool mr;
     int mr_fd;
     srs_utime_t mr_sleep;
+    int mr_rbuf;
+    // The expected recv buffer, the mr_rbuf might be limited by system.
+    int mr_erbuf;
+    // For adaptive mr, the mr_latency is the budget, and we sample the bitrate and reads to tune the mr_sleep.
+    bool mr_adaptive;
+    srs_utime_t mr_latency;
+    srs_utime_t mr_starttime;
+    int64_t mr_bytes;
+    int64_t mr_reads;
+    int mr_kbps;
+    int mr_read_size;
     // For realtime
     // @see https://github.com/ossrs/srs/issues/257
     bool realtime;
@@ -154,6 +165,8 @@ private:
     // The merged context id.
     SrsContextId cid;
     SrsContextId ncid;
+    // The id of client in stat, the context id of connection.
+    std::string stat_id;
 public:
     SrsPublishRecvThread(SrsRtmpServer* rtmp_sdk, SrsRequest* _req,
         int mr_sock_fd, srs_utime_t tm, SrsRtmpConn* conn, SrsLiveSource* source, SrsContextId parent_cid);
@@ -186,9 +199,19 @@ public:
     virtual srs_error_t on_reload_vhost_publish(std::string vhost);
     virtual srs_error_t on_reload_vhost_realtime(std::string vhost);
 private:
-    virtual void set_socket_buffer(srs_utime_t sleep_v);
+    virtual void set_socket_buffer(srs_utime_t sleep_v, int kbps);
+    virtual void set_socket_buffer_size(srs_utime_t sleep_v, int socket_buffer_size);
+    // Sample the bitrate and reads, then tune the sleep for adaptive mr.
+    virtual void adapt_mr(ssize_t nread);
+    virtual void update_mr_stat();
 };
 
+// Get the sleep of adaptive mr for bitrate in kbps, to merge about some KB for each read,
+// and limited by the latency budget.
+extern srs_utime_t srs_mr_adaptive_sleep(int kbps, srs_utime_t latency);
+// Get the recv buffer in bytes of adaptive mr, by the bitrate in kbps and the sampled read size.
+extern int srs_mr_adaptive_rbuf(int kbps, int read_size, srs_utime_t sleep_v);
+
 // The HTTP receive thread, try to read messages util EOF.
 // For example, the HTTP FLV serving thread will use the receive thread to break
 // when client closed the request, to avoid FD leak.
@@ -189,6 +189,11 @@ srs_error_t SrsSecurityTransport::protect_rtcp(void* packet, int* nb_cipher)
     return srtp_->protect_rtcp(packet, nb_cipher);
 }
 
+srs_error_t SrsSecurityTransport::protect_rtps(iovec* iovs, int nn_iovs)
+{
+    return srtp_->protect_rtps(iovs, nn_iovs);
+}
+
 srs_error_t SrsSecurityTransport::unprotect_rtp(void* packet, int* nb_plaintext)
 {
     return srtp_->unprotect_rtp(packet, nb_plaintext);
@@ -217,6 +222,11 @@ srs_error_t SrsSemiSecurityTransport::protect_rtcp(void* packet, int* nb_cipher)
     return srs_success;
 }
 
+srs_error_t SrsSemiSecurityTransport::protect_rtps(iovec* iovs, int nn_iovs)
+{
+    return srs_success;
+}
+
 SrsPlaintextTransport::SrsPlaintextTransport(ISrsRtcNetwork* s)
 {
     network_ = s;
@@ -272,6 +282,11 @@ srs_error_t SrsPlaintextTransport::protect_rtcp(void* packet, int* nb_cipher)
     return srs_success;
 }
 
+srs_error_t SrsPlaintextTransport::protect_rtps(iovec* iovs, int nn_iovs)
+{
+    return srs_success;
+}
+
 srs_error_t SrsPlaintextTransport::unprotect_rtp(void* packet, int* nb_plaintext)
 {
     return srs_success;
@@ -411,6 +426,7 @@ SrsRtcPlayStream::SrsRtcPlayStream(SrsRtcConnection* s, const SrsContextId& cid)
 
     req_ = NULL;
     source_ = NULL;
+    live_source_ = NULL;
 
     is_started = false;
     session_ = s;
@@ -435,6 +451,10 @@ SrsRtcPlayStream::~SrsRtcPlayStream()
         session_->server_->exec_async_work(new SrsRtcAsyncCallOnStop(cid_, req_));
     }
 
+    if (live_source_) {
+        live_source_->on_bridge_stop();
+    }
+
     _srs_config->unsubscribe(this);
 
     srs_freep(nack_epp);
@@ -586,6 +606,20 @@ srs_error_t SrsRtcPlayStream::start()
         return err;
     }
 
+    // For edge, pull stream from origin by the live source, which is shared with RTMP and FLV players,
+    // and bridged to RTC source, see SrsEdgeIngester::start.
+    if (!live_source_ && _srs_config->get_vhost_is_edge(req_->vhost) && _srs_config->get_rtc_from_rtmp(req_->vhost)) {
+        SrsLiveSource* live_source = NULL;
+        if ((err = _srs_sources->fetch_or_create(req_, _srs_hybrid->srs()->instance(), &live_source)) != srs_success) {
+            return srs_error_wrap(err, "create live source");
+        }
+
+        live_source_ = live_source;
+        if ((err = live_source_->on_bridge_play()) != srs_success) {
+            return srs_error_wrap(err, "edge play");
+        }
+    }
+
     srs_freep(trd_);
     trd_ = new SrsFastCoroutine("rtc_sender", this, cid_);
 
@@ -624,6 +658,13 @@ srs_error_t SrsRtcPlayStream::cycle()
     srs_assert(consumer);
     consumer->set_handler(this);
 
+    // Only consume the FEC packets of source, when negotiated FEC.
+    for (map<uint32_t, SrsRtcVideoSendTrack*>::iterator it = video_tracks_.begin(); it != video_tracks_.end(); ++it) {
+        if (it->second->fec_enabled()) {
+            consumer->set_fec(true);
+        }
+    }
+
     // TODO: FIXME: Dumps the SPS/PPS from gop cache, without other frames.
     if ((err = source->consumer_dumps(consumer)) != srs_success) {
         return srs_error_wrap(err, "dumps consumer, url=%s", req_->get_stream_url().c_str());
@@ -654,19 +695,31 @@ srs_error_t SrsRtcPlayStream::cycle()
             continue;
         }
 
-        // Send-out the RTP packet and do cleanup
-        // @remark Note that the pkt might be set to NULL.
-        if ((err = send_packet(pkt)) != srs_success) {
+        // Send-out all the RTP packets in a batch, which are protected by SRTP in one call.
+        session_->begin_batch();
+        for (; pkt; consumer->dump_packet(&pkt)) {
+            // Send-out the RTP packet and do cleanup
+            // @remark Note that the pkt might be set to NULL.
+            if ((err = send_packet(pkt)) != srs_success) {
+                uint32_t nn = 0;
+                if (epp->can_print(err, &nn)) {
+                    srs_warn("play send packets=%u, nn=%u/%u, err: %s", 1, epp->nn_count, nn, srs_error_desc(err).c_str());
+                }
+                srs_freep(err);
+            }
+
+            // Free the packet.
+            // @remark Note that the pkt might be set to NULL.
+            srs_freep(pkt);
+        }
+
+        if ((err = session_->end_batch()) != srs_success) {
             uint32_t nn = 0;
             if (epp->can_print(err, &nn)) {
-                srs_warn("play send packets=%u, nn=%u/%u, err: %s", 1, epp->nn_count, nn, srs_error_desc(err).c_str());
+                srs_warn("play send batch, nn=%u/%u, err: %s", epp->nn_count, nn, srs_error_desc(err).c_str());
             }
             srs_freep(err);
         }
-
-        // Free the packet.
-        // @remark Note that the pkt might be set to NULL.
-        srs_freep(pkt);
     }
 }
 
@@ -1062,6 +1115,7 @@ SrsRtcPublishStream::SrsRtcPublishStream(SrsRtcConnection* session, const SrsCon
     nack_enabled_ = false;
     nack_no_copy_ = false;
     pt_to_drop_ = 0;
+    fec_red_pt_ = fec_ulpfec_pt_ = 0;
 
     nn_audio_frames = 0;
     twcc_enabled_ = false;
@@ -1160,7 +1214,18 @@ srs_error_t SrsRtcPublishStream::initialize(SrsRequest* r, SrsRtcSourceDescripti
         twcc_enabled_ = false;
     }
 
-    srs_trace("RTC publisher nack=%d, nnc=%d, pt-drop=%u, twcc=%u/%d", nack_enabled_, nack_no_copy_, pt_to_drop_, twcc_enabled_, twcc_id);
+    // The ULPFEC is only negotiated when FEC enabled, see negotiate_publish_capability
+    for (int i = 0; i < (int)stream_desc->video_track_descs_.size(); ++i) {
+        SrsRtcTrackDescription* desc = stream_desc->video_track_descs_.at(i);
+        if (desc->red_ && desc->ulpfec_) {
+            fec_red_pt_ = desc->red_->pt_;
+            fec_ulpfec_pt_ = desc->ulpfec_->pt_;
+            break;
+        }
+    }
+
+    srs_trace("RTC publisher nack=%d, nnc=%d, pt-drop=%u, twcc=%u/%d, fec=%u/%u", nack_enabled_, nack_no_copy_, pt_to_drop_,
+        twcc_enabled_, twcc_id, fec_red_pt_, fec_ulpfec_pt_);
 
     // Setup tracks.
     for (int i = 0; i < (int)audio_tracks_.size(); i++) {
@@ -1363,6 +1428,11 @@ srs_error_t SrsRtcPublishStream::on_rtp_plaintext(char* plaintext, int nb_plaint
         _srs_blackhole->sendto(plaintext, nb_plaintext);
     }
 
+    // Restore the media from RED, because ULPFEC protects the media without RED.
+    if (fec_red_pt_) {
+        nb_plaintext = srs_rtp_red_decapsulate(plaintext, nb_plaintext, fec_red_pt_, fec_ulpfec_pt_);
+    }
+
     // Allocate packet form cache.
     SrsRtpPacket* pkt = new SrsRtpPacket();
 
@@ -1405,7 +1475,12 @@ srs_error_t SrsRtcPublishStream::do_on_rtp_plaintext(SrsRtpPacket*& pkt, SrsBuff
         }
     } else if (video_track) {
         pkt->frame_type = SrsFrameTypeVideo;
-        if ((err = video_track->on_rtp(source, pkt)) != srs_success) {
+        // The FEC is only used to recover packets, never delivered to source.
+        if (pkt->payload_type() == SrsRtspPacketPayloadTypeFEC) {
+            if ((err = on_fec(video_track, pkt)) != srs_success) {
+                return srs_error_wrap(err, "on fec");
+            }
+        } else if ((err = video_track->on_rtp(source, pkt)) != srs_success) {
             return srs_error_wrap(err, "on video");
         }
     } else {
@@ -1435,6 +1510,43 @@ srs_error_t SrsRtcPublishStream::do_on_rtp_plaintext(SrsRtpPacket*& pkt, SrsBuff
     return err;
 }
 
+srs_error_t SrsRtcPublishStream::on_fec(SrsRtcVideoRecvTrack* track, SrsRtpPacket* pkt)
+{
+    srs_error_t err = srs_success;
+
+    // The received packets are in NACK queue.
+    if (!nack_enabled_) {
+        return err;
+    }
+
+    char buf[kRtpPacketSize];
+    int nn_buf = sizeof(buf);
+    if ((err = track->on_fec(pkt, buf, &nn_buf)) != srs_success) {
+        return srs_error_wrap(err, "recover");
+    }
+
+    if (!nn_buf) {
+        return err;
+    }
+
+    srs_info("RTC: FEC recover ssrc=%u, %d bytes", pkt->header.get_ssrc(), nn_buf);
+
+    // Consume the recovered packet, which removes the seq from NACK list. Never use on_rtp_plaintext, because the
+    // packet is not received from peer, so it should not be sent to blackhole or decapsulated from RED again.
+    SrsRtpPacket* recovered = new SrsRtpPacket();
+    SrsAutoFree(SrsRtpPacket, recovered);
+
+    char* p = recovered->wrap(buf, nn_buf);
+    SrsBuffer b(p, nn_buf);
+
+    // @remark Note that the recovered might be set to NULL.
+    if ((err = do_on_rtp_plaintext(recovered, &b)) != srs_success) {
+        return srs_error_wrap(err, "recovered packet");
+    }
+
+    return err;
+}
+
 srs_error_t SrsRtcPublishStream::check_send_nacks()
 {
     srs_error_t err = srs_success;
@@ -1745,10 +1857,14 @@ SrsRtcConnection::SrsRtcConnection(SrsRtcServer* s, const SrsContextId& cid)
     server_ = s;
     networks_ = new SrsRtcNetworks(this);
 
-    cache_iov_ = new iovec();
-    cache_iov_->iov_base = new char[kRtpPacketSize];
-    cache_iov_->iov_len = kRtpPacketSize;
-    cache_buffer_ = new SrsBuffer((char*)cache_iov_->iov_base, kRtpPacketSize);
+    cache_iovs_ = new iovec[SRS_PERF_RTC_SEND_BATCH];
+    for (int i = 0; i < SRS_PERF_RTC_SEND_BATCH; i++) {
+        cache_iovs_[i].iov_base = new char[kRtpPacketSize];
+        cache_iovs_[i].iov_len = kRtpPacketSize;
+    }
+    nn_cache_iovs_ = 0;
+    nn_batch_ = 0;
+    flushing_ = false;
 
     last_stun_time = 0;
     session_timeout = 0;
@@ -1789,12 +1905,11 @@ SrsRtcConnection::~SrsRtcConnection()
     // Free network over UDP or TCP.
     srs_freep(networks_);
 
-    if (true) {
-        char* iov_base = (char*)cache_iov_->iov_base;
+    for (int i = 0; i < SRS_PERF_RTC_SEND_BATCH; i++) {
+        char* iov_base = (char*)cache_iovs_[i].iov_base;
         srs_freepa(iov_base);
-        srs_freep(cache_iov_);
     }
-    srs_freep(cache_buffer_);
+    srs_freepa(cache_iovs_);
 
     srs_freep(req_);
     srs_freep(pli_epp);
@@ -2421,46 +2536,110 @@ srs_error_t SrsRtcConnection::do_send_packet(SrsRtpPacket* pkt)
 {
     srs_error_t err = srs_success;
 
-    // For this message, select the first iovec.
-    iovec* iov = cache_iov_;
-    iov->iov_len = kRtpPacketSize;
-    cache_buffer_->skip(-1 * cache_buffer_->pos());
+    // For NACK simulator, drop packet.
+    if (nn_simulate_player_nack_drop) {
+        simulate_player_drop_packet(&pkt->header, pkt->nb_bytes());
+        return err;
+    }
+
+    // Send the packet directly if not in batch, or the batch is sending by other coroutine.
+    if (!nn_batch_ || flushing_) {
+        char buf[kRtpPacketSize];
+        iovec iov;
+        iov.iov_base = buf;
 
-    // Marshal packet to bytes in iovec.
-    if (true) {
-        if ((err = pkt->encode(cache_buffer_)) != srs_success) {
-            return srs_error_wrap(err, "encode packet");
+        if ((err = encode_packet(pkt, &iov)) != srs_success) {
+            return srs_error_wrap(err, "encode");
         }
-        iov->iov_len = cache_buffer_->pos();
+
+        return send_packets(&iov, 1);
     }
 
-    // Cipher RTP to SRTP packet.
-    if (true) {
-        int nn_encrypt = (int)iov->iov_len;
-        if ((err = networks_->available()->protect_rtp(iov->iov_base, &nn_encrypt)) != srs_success) {
-            return srs_error_wrap(err, "srtp protect");
-        }
-        iov->iov_len = (size_t)nn_encrypt;
+    // Send out the batch if full.
+    if (nn_cache_iovs_ >= SRS_PERF_RTC_SEND_BATCH && (err = flush_packets()) != srs_success) {
+        return srs_error_wrap(err, "flush");
     }
 
-    // For NACK simulator, drop packet.
-    if (nn_simulate_player_nack_drop) {
-        simulate_player_drop_packet(&pkt->header, (int)iov->iov_len);
-        iov->iov_len = 0;
-        return err;
+    if ((err = encode_packet(pkt, cache_iovs_ + nn_cache_iovs_)) != srs_success) {
+        return srs_error_wrap(err, "encode");
     }
+    nn_cache_iovs_++;
 
-    ++_srs_pps_srtps->sugar;
+    return err;
+}
 
-    if ((err = networks_->available()->write(iov->iov_base, iov->iov_len, NULL)) != srs_success) {
-        srs_warn("RTC: Write %d bytes err %s", iov->iov_len, srs_error_desc(err).c_str());
-        srs_freep(err);
-        return err;
+void SrsRtcConnection::begin_batch()
+{
+    nn_batch_++;
+}
+
+srs_error_t SrsRtcConnection::end_batch()
+{
+    // Only send out the batch by the outermost batch.
+    if (--nn_batch_ > 0) {
+        return srs_success;
     }
 
+    return flush_packets();
+}
+
+srs_error_t SrsRtcConnection::encode_packet(SrsRtpPacket* pkt, iovec* iov)
+{
+    srs_error_t err = srs_success;
+
+    // Marshal packet to bytes in iovec.
+    SrsBuffer buf((char*)iov->iov_base, kRtpPacketSize);
+    if ((err = pkt->encode(&buf)) != srs_success) {
+        return srs_error_wrap(err, "encode packet");
+    }
+    iov->iov_len = buf.pos();
+
     // Detail log, should disable it in release version.
-    srs_info("RTC: SEND PT=%u, SSRC=%#x, SEQ=%u, Time=%u, %u/%u bytes", pkt->header.get_payload_type(), pkt->header.get_ssrc(),
-        pkt->header.get_sequence(), pkt->header.get_timestamp(), pkt->nb_bytes(), iov->iov_len);
+    srs_info("RTC: SEND PT=%u, SSRC=%#x, SEQ=%u, Time=%u, %u bytes", pkt->header.get_payload_type(), pkt->header.get_ssrc(),
+        pkt->header.get_sequence(), pkt->header.get_timestamp(), pkt->nb_bytes());
+
+    return err;
+}
+
+srs_error_t SrsRtcConnection::flush_packets()
+{
+    if (!nn_cache_iovs_) {
+        return srs_success;
+    }
+
+    // Never reuse the cache when sending, because the TCP network might yield.
+    flushing_ = true;
+    srs_error_t err = send_packets(cache_iovs_, nn_cache_iovs_);
+    nn_cache_iovs_ = 0;
+    flushing_ = false;
+
+    return err;
+}
+
+srs_error_t SrsRtcConnection::send_packets(iovec* iovs, int nn_iovs)
+{
+    // Cipher RTP to SRTP packets in a batch, the failed packets are dropped.
+    srs_error_t err = networks_->available()->protect_rtps(iovs, nn_iovs);
+
+    // Send the rest of batch even if failed to write a packet, like sending them one by one.
+    for (int i = 0; i < nn_iovs; i++) {
+        iovec* iov = iovs + i;
+        if (!iov->iov_len) {
+            continue;
+        }
+
+        ++_srs_pps_srtps->sugar;
+
+        srs_error_t r0 = srs_success;
+        if ((r0 = networks_->available()->write(iov->iov_base, iov->iov_len, NULL)) != srs_success) {
+            srs_warn("RTC: Write %d bytes err %s", iov->iov_len, srs_error_desc(r0).c_str());
+            srs_freep(r0);
+        }
+    }
+
+    if (err != srs_success) {
+        return srs_error_wrap(err, "srtp protect");
+    }
 
     return err;
 }
@@ -2567,6 +2746,7 @@ srs_error_t SrsRtcConnection::negotiate_publish_capability(SrsRtcUserConfig* ruc
 
     bool nack_enabled = _srs_config->get_rtc_nack_enabled(req->vhost);
     bool twcc_enabled = _srs_config->get_rtc_twcc_enabled(req->vhost);
+    bool fec_enabled = _srs_config->get_rtc_fec_enabled(req->vhost);
     // TODO: FIME: Should check packetization-mode=1 also.
     bool has_42e01f = srs_sdp_has_h264_profile(remote_sdp, "42e01f");
 
@@ -2774,6 +2954,11 @@ srs_error_t SrsRtcConnection::negotiate_publish_capability(SrsRtcUserConfig* ruc
         track_desc->create_auxiliary_payload(remote_media_desc.find_media_with_encoding_name("rtx"));
         track_desc->create_auxiliary_payload(remote_media_desc.find_media_with_encoding_name("ulpfec"));
 
+        // For video, only accept the ULPFEC in RED when FEC enabled, see SrsRtcPublishStream::on_rtp_plaintext
+        if (remote_media_desc.is_video() && (!fec_enabled || !track_desc->red_)) {
+            srs_freep(track_desc->ulpfec_);
+        }
+
         std::string track_id;
         for (int j = 0; j < (int)remote_media_desc.ssrc_infos_.size(); ++j) {
             const SrsSSRCInfo& ssrc_info = remote_media_desc.ssrc_infos_.at(j);
@@ -2942,6 +3127,10 @@ srs_error_t SrsRtcConnection::generate_publish_local_sdp_for_video(SrsSdp& local
             local_media_desc.payload_types_.push_back(payload->generate_media_payload_type());
         }
 
+        if (video_track->ulpfec_) {
+            local_media_desc.payload_types_.push_back(video_track->ulpfec_->generate_media_payload_type());
+        }
+
         if(!unified_plan) {
             // For PlanB, only need media desc info, not ssrc info;
             break;
@@ -2960,6 +3149,8 @@ srs_error_t SrsRtcConnection::negotiate_play_capability(SrsRtcUserConfig* ruc, s
 
     bool nack_enabled = _srs_config->get_rtc_nack_enabled(req->vhost);
     bool twcc_enabled = _srs_config->get_rtc_twcc_enabled(req->vhost);
+    bool fec_enabled = _srs_config->get_rtc_fec_enabled(req->vhost);
+    bool red_enabled = _srs_config->get_rtc_red_enabled(req->vhost);
     // TODO: FIME: Should check packetization-mode=1 also.
     bool has_42e01f = srs_sdp_has_h264_profile(remote_sdp, "42e01f");
 
@@ -3065,6 +3256,30 @@ srs_error_t SrsRtcConnection::negotiate_play_capability(SrsRtcUserConfig* ruc, s
                 track->red_->pt_ = red_pt.payload_type_;
             }
 
+            // Use ULPFEC in RED for subscriber, only when FEC enabled and remote supports it. Note that
+            // the ULPFEC is in the same SSRC of media, see SrsRtcVideoSendTrack::build_fec
+            if (remote_media_desc.is_video()) {
+                vector<SrsMediaPayloadType> ulpfec_pts = remote_media_desc.find_media_with_encoding_name("ulpfec");
+                srs_freep(track->ulpfec_);
+                if (fec_enabled && !red_pts.empty() && !ulpfec_pts.empty()) {
+                    const SrsMediaPayloadType& red_pt = red_pts.at(0);
+                    const SrsMediaPayloadType& ulpfec_pt = ulpfec_pts.at(0);
+
+                    if (!track->red_) {
+                        track->red_ = new SrsRedPayload(red_pt.payload_type_, "red", red_pt.clock_rate_, 0);
+                    }
+                    track->ulpfec_ = new SrsCodecPayload(ulpfec_pt.payload_type_, "ulpfec", ulpfec_pt.clock_rate_);
+                    track->fec_ssrc_ = 0;
+                }
+            }
+
+            // Use RED generated by source for audio subscriber, only when RED enabled and remote supports
+            // it, and the publisher doesn't send RED, see SrsRtcSource::on_red
+            if (remote_media_desc.is_audio() && red_enabled && !red_pts.empty() && !track->red_) {
+                const SrsMediaPayloadType& red_pt = red_pts.at(0);
+                track->red_ = new SrsRedPayload(red_pt.payload_type_, "red", red_pt.clock_rate_, ::atol(red_pt.encoding_param_.c_str()));
+            }
+
             track->mid_ = remote_media_desc.mid_;
             uint32_t publish_ssrc = track->ssrc_;
 
@@ -3151,6 +3366,10 @@ void video_track_generate_play_offer(SrsRtcTrackDescription* track, string mid,
         SrsRedPayload* red_payload = (SrsRedPayload*)track->red_;
         local_media_desc.payload_types_.push_back(red_payload->generate_media_payload_type());
     }
+
+    if (track->ulpfec_) {
+        local_media_desc.payload_types_.push_back(track->ulpfec_->generate_media_payload_type());
+    }
 }
 
 srs_error_t SrsRtcConnection::generate_play_local_sdp(SrsRequest* req, SrsSdp& local_sdp, SrsRtcSourceDescription* stream_desc, bool unified_plan, bool audio_before_video)
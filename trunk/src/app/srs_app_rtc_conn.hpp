@@ -32,6 +32,7 @@
 
 class SrsUdpMuxSocket;
 class SrsLiveConsumer;
+class SrsLiveSource;
 class SrsStunPacket;
 class SrsRtcServer;
 class SrsRtcConnection;
@@ -84,6 +85,8 @@ public:
     // The nb_cipher should be initialized to the size of cipher, with some paddings.
     virtual srs_error_t protect_rtp(void* packet, int* nb_cipher) = 0;
     virtual srs_error_t protect_rtcp(void* packet, int* nb_cipher) = 0;
+    // Encrypt a batch of RTP packets, the iov_len is updated to the size of cipher.
+    virtual srs_error_t protect_rtps(iovec* iovs, int nn_iovs) = 0;
     // Decrypt the packet(cipher) to plaintext, which is also the packet ptr.
     // The nb_plaintext should be initialized to the size of cipher.
     virtual srs_error_t unprotect_rtp(void* packet, int* nb_plaintext) = 0;
@@ -112,6 +115,7 @@ public:
     // The nb_cipher should be initialized to the size of cipher, with some paddings.
     srs_error_t protect_rtp(void* packet, int* nb_cipher);
     srs_error_t protect_rtcp(void* packet, int* nb_cipher);
+    srs_error_t protect_rtps(iovec* iovs, int nn_iovs);
     // Decrypt the packet(cipher) to plaintext, which is also the packet ptr.
     // The nb_plaintext should be initialized to the size of cipher.
     srs_error_t unprotect_rtp(void* packet, int* nb_plaintext);
@@ -134,6 +138,7 @@ public:
 public:
     srs_error_t protect_rtp(void* packet, int* nb_cipher);
     srs_error_t protect_rtcp(void* packet, int* nb_cipher);
+    srs_error_t protect_rtps(iovec* iovs, int nn_iovs);
 };
 
 // Plaintext transport, without DTLS or SRTP.
@@ -155,6 +160,7 @@ public:
 public:
     srs_error_t protect_rtp(void* packet, int* nb_cipher);
     srs_error_t protect_rtcp(void* packet, int* nb_cipher);
+    srs_error_t protect_rtps(iovec* iovs, int nn_iovs);
     srs_error_t unprotect_rtp(void* packet, int* nb_plaintext);
     srs_error_t unprotect_rtcp(void* packet, int* nb_plaintext);
 };
@@ -216,6 +222,8 @@ private:
 private:
     SrsRequest* req_;
     SrsRtcSource* source_;
+    // For edge, the live source to pull stream from origin, which is bridged to RTC source.
+    SrsLiveSource* live_source_;
     // key: publish_ssrc, value: send track to process rtp/rtcp
     std::map<uint32_t, SrsRtcAudioSendTrack*> audio_tracks_;
     std::map<uint32_t, SrsRtcVideoSendTrack*> video_tracks_;
@@ -332,6 +340,9 @@ private:
 private:
     SrsRtcConnection* session_;
     uint16_t pt_to_drop_;
+    // The PT of RED and ULPFEC for video, to restore media from RED and recover packets, 0 to disable FEC.
+    uint8_t fec_red_pt_;
+    uint8_t fec_ulpfec_pt_;
     // Whether enabled nack.
     bool nack_enabled_;
     bool nack_no_copy_;
@@ -372,6 +383,8 @@ public:
     srs_error_t on_rtp_plaintext(char* buf, int nb_buf);
 private:
     srs_error_t do_on_rtp_plaintext(SrsRtpPacket*& pkt, SrsBuffer* buf);
+    // Recover the lost packet by FEC, and consume the recovered packet as received.
+    srs_error_t on_fec(SrsRtcVideoRecvTrack* track, SrsRtpPacket* pkt);
 public:
     srs_error_t check_send_nacks();
 public:
@@ -428,8 +441,12 @@ public:
 private:
     SrsRtcServer* server_;
 private:
-    iovec* cache_iov_;
-    SrsBuffer* cache_buffer_;
+    // The RTP packets to protect by SRTP in a batch then send out, see begin_batch.
+    iovec* cache_iovs_;
+    int nn_cache_iovs_;
+    // The depth of batch, and whether the batch is sending, which might yield for TCP network.
+    int nn_batch_;
+    bool flushing_;
 private:
     // key: stream id
     std::map<std::string, SrsRtcPlayStream*> players_;
@@ -532,6 +549,15 @@ public:
     void simulate_nack_drop(int nn);
     void simulate_player_drop_packet(SrsRtpHeader* h, int nn_bytes);
     srs_error_t do_send_packet(SrsRtpPacket* pkt);
+    // Start to cache the packets of do_send_packet, which are protected by SRTP in a batch and sent
+    // out when the batch is full or end_batch, so that the cost of SRTP calls is amortized.
+    void begin_batch();
+    srs_error_t end_batch();
+private:
+    srs_error_t encode_packet(SrsRtpPacket* pkt, iovec* iov);
+    srs_error_t flush_packets();
+    srs_error_t send_packets(iovec* iovs, int nn_iovs);
+public:
     // Directly set the status of play track, generally for init to set the default value.
     void set_all_tracks_status(std::string stream_uri, bool is_publish, bool status);
 public:
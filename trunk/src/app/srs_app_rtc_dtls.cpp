@@ -9,6 +9,8 @@
 using namespace std;
 
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 #include <srs_kernel_log.hpp>
 #include <srs_kernel_error.hpp>
@@ -20,6 +22,7 @@ using namespace std;
 #include <srs_app_log.hpp>
 #include <srs_kernel_utility.hpp>
 #include <srs_protocol_utility.hpp>
+#include <srs_app_threads.hpp>
 
 #include <srtp2/srtp.h>
 #include <openssl/ssl.h>
@@ -114,9 +117,38 @@ void ssl_on_info(const SSL* dtls, int where, int ret)
     }
 }
 
+// The timer callback when handshake in worker thread, which never touch the DTLS object, because
+// it might be freed in ST thread. Note that only DTLS server does handshake in worker thread, which
+// never reset the timer, see SrsDtlsServerImpl::should_reset_timer
+unsigned int dtls_timer_cb_in_worker(SSL* dtls, unsigned int previous_us)
+{
+    unsigned int timeout_us = previous_us * 2;
+    if (previous_us == 0) {
+        timeout_us =  50 * 1000; // in us
+    }
+    return srs_min(timeout_us, 30 * 1000 * 1000); // in us
+}
+
+// The index of SSL ex_data for the handshake job, allocated once, see SSL_get_ex_new_index.
+int srs_dtls_job_index()
+{
+    static int index = SSL_get_ex_new_index(0, (void*)"dtls-job", NULL, NULL, NULL);
+    return index;
+}
+
+// The info callback when handshake in worker thread, which only collects the alerts to the job,
+// and the DTLS is notified in ST thread, see SrsDtlsImpl::on_handshake_job_done
+void ssl_on_info_in_worker(const SSL* dtls, int where, int ret)
+{
+    SrsDtlsHandshakeJob* job = (SrsDtlsHandshakeJob*)SSL_get_ex_data(dtls, srs_dtls_job_index());
+    if (job && (where & SSL_CB_ALERT)) {
+        job->alerts_.push_back(make_pair(SSL_alert_type_string_long(ret), SSL_alert_desc_string(ret)));
+    }
+}
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-SSL_CTX* srs_build_dtls_ctx(SrsDtlsVersion version, std::string role)
+SSL_CTX* srs_build_dtls_ctx(SrsDtlsCertificate* cert, SrsDtlsVersion version, std::string role, bool srtp_gcm)
 {
     SSL_CTX* dtls_ctx;
 #if OPENSSL_VERSION_NUMBER < 0x10002000L // v1.0.2
@@ -140,7 +172,7 @@ SSL_CTX* srs_build_dtls_ctx(SrsDtlsVersion version, std::string role)
     }
 #endif
 
-    if (_srs_rtc_dtls_certificate->is_ecdsa()) { // By ECDSA, https://stackoverflow.com/a/6006898
+    if (cert->is_ecdsa()) { // By ECDSA, https://stackoverflow.com/a/6006898
 #if OPENSSL_VERSION_NUMBER >= 0x10002000L // v1.0.2
         // For ECDSA, we could set the curves list.
         // @see https://www.openssl.org/docs/man1.0.2/man3/SSL_CTX_set1_curves_list.html
@@ -151,7 +183,7 @@ SSL_CTX* srs_build_dtls_ctx(SrsDtlsVersion version, std::string role)
         // @see https://stackoverrun.com/cn/q/10791887
 #if OPENSSL_VERSION_NUMBER < 0x10100000L // v1.1.x
     #if OPENSSL_VERSION_NUMBER < 0x10002000L // v1.0.2
-        SSL_CTX_set_tmp_ecdh(dtls_ctx, _srs_rtc_dtls_certificate->get_ecdsa_key());
+        SSL_CTX_set_tmp_ecdh(dtls_ctx, cert->get_ecdsa_key());
     #else
         SSL_CTX_set_ecdh_auto(dtls_ctx, 1);
     #endif
@@ -165,8 +197,8 @@ SSL_CTX* srs_build_dtls_ctx(SrsDtlsVersion version, std::string role)
         srs_assert(SSL_CTX_set_cipher_list(dtls_ctx, "ALL") == 1);
 
         // Setup the certificate.
-        srs_assert(SSL_CTX_use_certificate(dtls_ctx, _srs_rtc_dtls_certificate->get_cert()) == 1);
-        srs_assert(SSL_CTX_use_PrivateKey(dtls_ctx, _srs_rtc_dtls_certificate->get_public_key()) == 1);
+        srs_assert(SSL_CTX_use_certificate(dtls_ctx, cert->get_cert()) == 1);
+        srs_assert(SSL_CTX_use_PrivateKey(dtls_ctx, cert->get_public_key()) == 1);
 
         // Server will send Certificate Request.
         // @see https://www.openssl.org/docs/man1.0.2/man3/SSL_CTX_set_verify.html
@@ -181,11 +213,17 @@ SSL_CTX* srs_build_dtls_ctx(SrsDtlsVersion version, std::string role)
         // @see https://www.openssl.org/docs/man1.0.2/man3/SSL_CTX_set_read_ahead.html
         SSL_CTX_set_read_ahead(dtls_ctx, 1);
 
-        // TODO: Maybe we can use SRTP-GCM in future.
+        // Prefer SRTP-GCM, which is much faster by AES-NI, only when libsrtp is built with openssl.
         // @see https://bugs.chromium.org/p/chromium/issues/detail?id=713701
         // @see https://groups.google.com/forum/#!topic/discuss-webrtc/PvCbWSetVAQ
-        // @remark Only support SRTP_AES128_CM_SHA1_80, please read ssl/d1_srtp.c
-        srs_assert(SSL_CTX_set_tlsext_use_srtp(dtls_ctx, "SRTP_AES128_CM_SHA1_80") == 0);
+        // @remark The key length depends on the profile, see SrsDtlsImpl::get_srtp_key
+        string profiles = "SRTP_AES128_CM_SHA1_80";
+#ifdef SRS_SRTP_OPENSSL
+        if (srtp_gcm) {
+            profiles = "SRTP_AEAD_AES_128_GCM:" + profiles;
+        }
+#endif
+        srs_assert(SSL_CTX_set_tlsext_use_srtp(dtls_ctx, profiles.c_str()) == 0);
     }
 
     return dtls_ctx;
@@ -202,6 +240,11 @@ SrsDtlsCertificate::SrsDtlsCertificate()
 
 SrsDtlsCertificate::~SrsDtlsCertificate()
 {
+    for (map<string, SSL_CTX*>::iterator it = dtls_ctxs.begin(); it != dtls_ctxs.end(); ++it) {
+        SSL_CTX_free(it->second);
+    }
+    dtls_ctxs.clear();
+
     if (eckey) {
         EC_KEY_free(eckey);
     }
@@ -380,6 +423,25 @@ bool SrsDtlsCertificate::is_ecdsa()
     return ecdsa_mode;
 }
 
+SSL_CTX* SrsDtlsCertificate::get_dtls_ctx(int version, std::string role)
+{
+    // The SRTP profiles is baked in SSL_CTX, so the setting is part of key, to apply it when reload.
+    bool srtp_gcm = _srs_config->get_rtc_server_srtp_gcm();
+
+    // For version-flexible DTLS methods, the role is not used.
+    string key = srs_fmt("%d/%s/%d", version, (version == SrsDtlsVersionAuto? "" : role.c_str()), srtp_gcm);
+
+    map<string, SSL_CTX*>::iterator it = dtls_ctxs.find(key);
+    if (it != dtls_ctxs.end()) {
+        return it->second;
+    }
+
+    SSL_CTX* dtls_ctx = srs_build_dtls_ctx(this, (SrsDtlsVersion)version, role, srtp_gcm);
+    dtls_ctxs[key] = dtls_ctx;
+
+    return dtls_ctx;
+}
+
 ISrsDtlsCallback::ISrsDtlsCallback()
 {
 }
@@ -388,6 +450,304 @@ ISrsDtlsCallback::~ISrsDtlsCallback()
 {
 }
 
+SrsDtlsHandshakeJob::SrsDtlsHandshakeJob()
+{
+    dtls_ = NULL;
+    ssl_ = NULL;
+    r0_ = r1_ = 0;
+}
+
+SrsDtlsHandshakeJob::~SrsDtlsHandshakeJob()
+{
+    // The DTLS is freed before job done, so we own the SSL.
+    if (!dtls_ && ssl_) {
+        SSL_free(ssl_);
+    }
+}
+
+SrsDtlsWorkers* _srs_dtls_workers = NULL;
+
+SrsDtlsWorkers::SrsDtlsWorkers()
+{
+    nn_workers_ = 0;
+    rate_ = 0;
+    window_ = 0;
+    nn_admitted_ = 0;
+
+    jobs_pipe_[0] = jobs_pipe_[1] = -1;
+    done_pipe_[0] = done_pipe_[1] = -1;
+    done_fd_ = NULL;
+    trd_ = NULL;
+
+    lock_ = new SrsThreadMutex();
+    quit_ = false;
+    nn_running_ = 0;
+}
+
+SrsDtlsWorkers::~SrsDtlsWorkers()
+{
+    // Stop the ST coroutine first, which reads the done pipe.
+    srs_freep(trd_);
+
+    stop_workers();
+
+    srs_close_stfd(done_fd_);
+    if (done_pipe_[1] >= 0) {
+        ::close(done_pipe_[1]);
+    }
+    if (jobs_pipe_[0] >= 0) {
+        ::close(jobs_pipe_[0]);
+    }
+
+    // Free the jobs not done or not consumed, detach the DTLS which still owns the SSL.
+    vector<SrsDtlsHandshakeJob*> jobs = jobs_;
+    jobs.insert(jobs.end(), done_.begin(), done_.end());
+    for (int i = 0; i < (int)jobs.size(); i++) {
+        SrsDtlsHandshakeJob* job = jobs.at(i);
+        if (job->dtls_) {
+            job->dtls_->on_handshake_job_abort(job);
+        }
+        srs_freep(job);
+    }
+    jobs_.clear();
+    done_.clear();
+
+    srs_freep(lock_);
+}
+
+void SrsDtlsWorkers::stop_workers()
+{
+    if (true) {
+        SrsThreadLocker(lock_);
+        quit_ = true;
+    }
+
+    // Wake up all workers by EOF of pipe, see do_work.
+    if (jobs_pipe_[1] >= 0) {
+        ::close(jobs_pipe_[1]);
+        jobs_pipe_[1] = -1;
+    }
+
+    // Wait for all workers to quit, because they use this object. Note that the worker threads are
+    // detached by thread pool, so we check the number of running workers.
+    while (true) {
+        if (true) {
+            SrsThreadLocker(lock_);
+            if (nn_running_ <= 0) {
+                break;
+            }
+        }
+        ::usleep(10 * 1000);
+    }
+}
+
+srs_error_t SrsDtlsWorkers::initialize()
+{
+    srs_error_t err = srs_success;
+
+    rate_ = _srs_config->get_rtc_server_dtls_rate();
+
+    // Ignore if already started, for example, reload.
+    if (trd_) {
+        return err;
+    }
+
+    nn_workers_ = _srs_config->get_rtc_server_dtls_workers();
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L // v1.1.x
+    // For openssl <1.1, the locking callbacks are required for multiple threads.
+    if (nn_workers_ > 0) {
+        srs_warn("DTLS: Disable %d workers for openssl %s", nn_workers_, OPENSSL_VERSION_TEXT);
+        nn_workers_ = 0;
+    }
+#endif
+
+    if (nn_workers_ <= 0) {
+        srs_trace("DTLS: Handshake in ST thread, rate=%d", rate_);
+        return err;
+    }
+
+    if (::pipe(jobs_pipe_) < 0 || ::pipe(done_pipe_) < 0) {
+        return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "create pipe");
+    }
+
+    // Never block the ST thread when submit job, see submit.
+    int flags = fcntl(jobs_pipe_[1], F_GETFL, 0);
+    if (flags == -1 || fcntl(jobs_pipe_[1], F_SETFL, flags | O_NONBLOCK) == -1) {
+        return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "nonblock pipe fd=%d", jobs_pipe_[1]);
+    }
+
+    if ((done_fd_ = srs_netfd_open(done_pipe_[0])) == NULL) {
+        return srs_error_new(ERROR_ST_OPEN_SOCKET, "open pipe fd=%d", done_pipe_[0]);
+    }
+
+    trd_ = new SrsSTCoroutine("dtls", this);
+    if ((err = trd_->start()) != srs_success) {
+        return srs_error_wrap(err, "start coroutine");
+    }
+
+    // Allocate the index of SSL ex_data in ST thread, before any worker uses it.
+    srs_dtls_job_index();
+
+    for (int i = 0; i < nn_workers_; i++) {
+        // Count the worker before it starts, so that it's never freed when worker is starting.
+        if (true) {
+            SrsThreadLocker(lock_);
+            nn_running_++;
+        }
+
+        if ((err = _srs_thread_pool->execute("dtls", SrsDtlsWorkers::start, this)) != srs_success) {
+            SrsThreadLocker(lock_);
+            nn_running_--;
+            return srs_error_wrap(err, "start worker #%d", i);
+        }
+    }
+
+    srs_trace("DTLS: Handshake in %d workers, rate=%d", nn_workers_, rate_);
+
+    return err;
+}
+
+bool SrsDtlsWorkers::enabled()
+{
+    return trd_ != NULL;
+}
+
+bool SrsDtlsWorkers::admit()
+{
+    if (rate_ <= 0) {
+        return true;
+    }
+
+    srs_utime_t now = srs_get_system_time();
+    if (now - window_ >= SRS_UTIME_SECONDS) {
+        window_ = now;
+        nn_admitted_ = 0;
+    }
+
+    if (nn_admitted_ >= rate_) {
+        return false;
+    }
+
+    nn_admitted_++;
+    return true;
+}
+
+void SrsDtlsWorkers::submit(SrsDtlsHandshakeJob* job)
+{
+    if (true) {
+        SrsThreadLocker(lock_);
+        jobs_.push_back(job);
+    }
+
+    // Wake up a worker, ignore if pipe is full, because workers consume all jobs when wake up.
+    char c = 0;
+    ssize_t nn = ::write(jobs_pipe_[1], &c, 1);
+    srs_info("DTLS: Submit job, nn=%d", (int)nn);
+    (void)nn;
+}
+
+srs_error_t SrsDtlsWorkers::cycle()
+{
+    srs_error_t err = srs_success;
+
+    while (true) {
+        if ((err = trd_->pull()) != srs_success) {
+            return srs_error_wrap(err, "pull");
+        }
+
+        char buf[128];
+        ssize_t nn = srs_read(done_fd_, buf, sizeof(buf), SRS_UTIME_NO_TIMEOUT);
+        if (nn <= 0) {
+            return srs_error_new(ERROR_SOCKET_READ, "read pipe, nn=%d", (int)nn);
+        }
+
+        vector<SrsDtlsHandshakeJob*> jobs;
+        if (true) {
+            SrsThreadLocker(lock_);
+            jobs.swap(done_);
+        }
+
+        for (int i = 0; i < (int)jobs.size(); i++) {
+            SrsDtlsHandshakeJob* job = jobs.at(i);
+            SrsAutoFree(SrsDtlsHandshakeJob, job);
+
+            // Ignore if the DTLS is freed, the job will free the SSL.
+            if (!job->dtls_) {
+                continue;
+            }
+
+            // Restore the context of session, because there is only one coroutine for all sessions.
+            SrsContextRestore(_srs_context->get_id());
+            _srs_context->set_id(job->cid_);
+
+            if ((err = job->dtls_->on_handshake_job_done(job)) != srs_success) {
+                srs_warn("DTLS: Handshake err %s", srs_error_desc(err).c_str());
+                srs_freep(err);
+            }
+        }
+    }
+
+    return err;
+}
+
+srs_error_t SrsDtlsWorkers::start(void* arg)
+{
+    SrsDtlsWorkers* workers = (SrsDtlsWorkers*)arg;
+    workers->do_work();
+    return srs_success;
+}
+
+void SrsDtlsWorkers::do_work()
+{
+    while (true) {
+        // Block the worker thread until there is job, or the pipe is closed to quit.
+        char c = 0;
+        ssize_t r0 = ::read(jobs_pipe_[0], &c, 1);
+
+        if (true) {
+            SrsThreadLocker(lock_);
+            if (quit_) {
+                break;
+            }
+        }
+
+        if (r0 <= 0) {
+            continue;
+        }
+
+        while (true) {
+            SrsDtlsHandshakeJob* job = NULL;
+            if (true) {
+                SrsThreadLocker(lock_);
+                if (quit_ || jobs_.empty()) {
+                    break;
+                }
+                job = jobs_.front();
+                jobs_.erase(jobs_.begin());
+            }
+
+            // The error queue of openssl is thread-local, so we must get the error in this thread.
+            ERR_clear_error();
+            job->r0_ = SSL_do_handshake(job->ssl_);
+            job->r1_ = SSL_get_error(job->ssl_, job->r0_);
+
+            if (true) {
+                SrsThreadLocker(lock_);
+                done_.push_back(job);
+            }
+
+            // Notify the ST thread, which reads all done jobs when wake up.
+            ssize_t nn = ::write(done_pipe_[1], &c, 1);
+            (void)nn;
+        }
+    }
+
+    // Never touch this object after the worker is not running, because it might be freed.
+    SrsThreadLocker(lock_);
+    nn_running_--;
+}
+
 SrsDtlsImpl::SrsDtlsImpl(ISrsDtlsCallback* callback)
 {
     dtls_ctx = NULL;
@@ -401,18 +761,27 @@ SrsDtlsImpl::SrsDtlsImpl(ISrsDtlsCallback* callback)
     nn_arq_packets = 0;
 
     version_ = SrsDtlsVersionAuto;
+
+    handshake_admitted_ = false;
+    nn_dropped_ = 0;
+    job_ = NULL;
 }
 
 SrsDtlsImpl::~SrsDtlsImpl()
 {
     if (!handshake_done_for_us) {
-        srs_warn2(TAG_DTLS_HANG, "DTLS: Hang, done=%u, version=%d, arq=%u", handshake_done_for_us,
-            version_, nn_arq_packets);
+        srs_warn2(TAG_DTLS_HANG, "DTLS: Hang, done=%u, version=%d, arq=%u, dropped=%d", handshake_done_for_us,
+            version_, nn_arq_packets, nn_dropped_);
     }
 
-    if (dtls_ctx) {
-        SSL_CTX_free(dtls_ctx);
-        dtls_ctx = NULL;
+    // The SSL_CTX is shared, see SrsDtlsCertificate::get_dtls_ctx
+    dtls_ctx = NULL;
+
+    // The SSL is used by worker thread, so the job owns it and frees it when done.
+    if (job_) {
+        job_->dtls_ = NULL;
+        job_ = NULL;
+        dtls = NULL;
     }
 
     if (dtls) {
@@ -434,7 +803,7 @@ srs_error_t SrsDtlsImpl::initialize(std::string version, std::string role)
         version_ = SrsDtlsVersionAuto;
     }
 
-    dtls_ctx = srs_build_dtls_ctx(version_, role);
+    dtls_ctx = _srs_rtc_dtls_certificate->get_dtls_ctx(version_, role);
 
     if ((dtls = SSL_new(dtls_ctx)) == NULL) {
         return srs_error_new(ERROR_OpenSslCreateSSL, "SSL_new dtls");
@@ -497,6 +866,23 @@ srs_error_t SrsDtlsImpl::do_on_dtls(char* data, int nb_data)
         srs_info("DTLS: After done, got %d bytes", nb_data);
     }
 
+    // Limit the rate of new handshakes, drop the ClientHello and the peer will retransmit it.
+    if (!handshake_admitted_) {
+        if (!is_dtls_client() && !_srs_dtls_workers->admit()) {
+            if (nn_dropped_++ == 0) {
+                srs_warn("DTLS: Drop handshake for rate limit, size=%d", nb_data);
+            }
+            return err;
+        }
+        handshake_admitted_ = true;
+    }
+
+    // The packets should wait for the handshake in worker thread, to keep the order.
+    if (job_) {
+        pending_.push_back(string(data, nb_data));
+        return err;
+    }
+
     int r0 = 0;
     // TODO: FIXME: Why reset it before writing?
     if ((r0 = BIO_reset(bio_in)) != 1) {
@@ -514,12 +900,29 @@ srs_error_t SrsDtlsImpl::do_on_dtls(char* data, int nb_data)
         return srs_error_new(ERROR_OpenSslBIOWrite, "BIO_write r0=%d", r0);
     }
 
+    // Do the handshake in worker thread, only for DTLS server, because the ARQ of client depends on
+    // the timer of SSL. Note that the result is handled by on_handshake_job_done.
+    if (!handshake_done_for_us && !is_dtls_client() && _srs_dtls_workers->enabled()) {
+        return do_handshake_async();
+    }
+
     // Always do handshake, even the handshake is done, because the last DTLS packet maybe dropped,
     // so we thought the DTLS is done, but client need us to retransmit the last packet.
     if ((err = do_handshake()) != srs_success) {
         return srs_error_wrap(err, "do handshake");
     }
 
+    if ((err = read_application_data()) != srs_success) {
+        return srs_error_wrap(err, "read");
+    }
+
+    return err;
+}
+
+srs_error_t SrsDtlsImpl::read_application_data()
+{
+    srs_error_t err = srs_success;
+
     // If there is data in bio_in, read it to let SSL consume it.
     // @remark Limit the max loop, to avoid the dead loop.
     for (int i = 0; i < 1024 && BIO_ctrl_pending(bio_in) > 0; i++) {
@@ -579,6 +982,13 @@ srs_error_t SrsDtlsImpl::do_handshake()
     int r0 = SSL_do_handshake(dtls);
     int r1 = SSL_get_error(dtls, r0);
 
+    return on_handshake_result(r0, r1);
+}
+
+srs_error_t SrsDtlsImpl::on_handshake_result(int r0, int r1)
+{
+    srs_error_t err = srs_success;
+
     // Fatal SSL error, for example, no available suite when peer is DTLS 1.0 while we are DTLS 1.2.
     if (r0 < 0 && (r1 != SSL_ERROR_NONE && r1 != SSL_ERROR_WANT_READ && r1 != SSL_ERROR_WANT_WRITE)) {
         return srs_error_new(ERROR_RTC_DTLS, "handshake r0=%d, r1=%d", r0, r1);
@@ -615,6 +1025,73 @@ srs_error_t SrsDtlsImpl::do_handshake()
     return err;
 }
 
+srs_error_t SrsDtlsImpl::do_handshake_async()
+{
+    srs_error_t err = srs_success;
+
+    job_ = new SrsDtlsHandshakeJob();
+    job_->dtls_ = this;
+    job_->ssl_ = dtls;
+    job_->cid_ = _srs_context->get_id();
+
+    // Never touch this object in worker thread, see ssl_on_info_in_worker.
+    SSL_set_ex_data(dtls, srs_dtls_job_index(), job_);
+    SSL_set_info_callback(dtls, ssl_on_info_in_worker);
+#if OPENSSL_VERSION_NUMBER >= 0x1010102fL // 1.1.1b
+    DTLS_set_timer_cb(dtls, dtls_timer_cb_in_worker);
+#endif
+
+    _srs_dtls_workers->submit(job_);
+
+    return err;
+}
+
+srs_error_t SrsDtlsImpl::on_handshake_job_done(SrsDtlsHandshakeJob* job)
+{
+    srs_error_t err = srs_success;
+
+    on_handshake_job_abort(job);
+
+    for (int i = 0; i < (int)job->alerts_.size(); i++) {
+        const pair<string, string>& alert = job->alerts_.at(i);
+        srs_warn("DTLS: SSL3 alert in worker type=%s, desc=%s", alert.first.c_str(), alert.second.c_str());
+        callback_by_ssl(alert.first, alert.second);
+    }
+
+    if ((err = on_handshake_result(job->r0_, job->r1_)) != srs_success) {
+        return srs_error_wrap(err, "do handshake");
+    }
+
+    if ((err = read_application_data()) != srs_success) {
+        return srs_error_wrap(err, "read");
+    }
+
+    // Consume the packets received during handshake, which might start a new job.
+    vector<string> pending;
+    pending.swap(pending_);
+    for (int i = 0; i < (int)pending.size(); i++) {
+        string& pkt = pending.at(i);
+        if ((err = on_dtls((char*)pkt.data(), (int)pkt.size())) != srs_success) {
+            return srs_error_wrap(err, "pending %d/%d", i, (int)pending.size());
+        }
+    }
+
+    return err;
+}
+
+void SrsDtlsImpl::on_handshake_job_abort(SrsDtlsHandshakeJob* job)
+{
+    srs_assert(job == job_);
+    job_ = NULL;
+
+    // Restore the callbacks in ST thread.
+    SSL_set_ex_data(dtls, srs_dtls_job_index(), NULL);
+    SSL_set_info_callback(dtls, ssl_on_info);
+#if OPENSSL_VERSION_NUMBER >= 0x1010102fL // 1.1.1b
+    DTLS_set_timer_cb(dtls, dtls_timer_cb);
+#endif
+}
+
 void SrsDtlsImpl::state_trace(uint8_t* data, int length, bool incoming, int r0, int r1, bool arq)
 {
     // change_cipher_spec(20), alert(21), handshake(22), application_data(23)
@@ -645,9 +1122,17 @@ srs_error_t SrsDtlsImpl::get_srtp_key(std::string& recv_key, std::string& send_k
 {
     srs_error_t err = srs_success;
 
+    // For AEAD_AES_128_GCM, the salt is 12 bytes, see https://www.rfc-editor.org/rfc/rfc7714#section-12
+    int salt_len = SRTP_MASTER_KEY_SALT_LEN;
+    SRTP_PROTECTION_PROFILE* profile = SSL_get_selected_srtp_profile(dtls);
+    if (profile && profile->id == SRTP_AEAD_AES_128_GCM) {
+        salt_len = SRTP_AEAD_SALT_LEN;
+    }
+
     unsigned char material[SRTP_MASTER_KEY_LEN * 2] = {0};  // client(SRTP_MASTER_KEY_KEY_LEN + SRTP_MASTER_KEY_SALT_LEN) + server
+    int nn_material = (SRTP_MASTER_KEY_KEY_LEN + salt_len) * 2;
     static const string dtls_srtp_lable = "EXTRACTOR-dtls_srtp";
-    if (!SSL_export_keying_material(dtls, material, sizeof(material), dtls_srtp_lable.c_str(), dtls_srtp_lable.size(), NULL, 0, 0)) {
+    if (!SSL_export_keying_material(dtls, material, nn_material, dtls_srtp_lable.c_str(), dtls_srtp_lable.size(), NULL, 0, 0)) {
         return srs_error_new(ERROR_RTC_SRTP_INIT, "SSL export key r0=%lu", ERR_get_error());
     }
 
@@ -657,9 +1142,9 @@ srs_error_t SrsDtlsImpl::get_srtp_key(std::string& recv_key, std::string& send_k
     offset += SRTP_MASTER_KEY_KEY_LEN;
     std::string server_master_key(reinterpret_cast<char*>(material + offset), SRTP_MASTER_KEY_KEY_LEN);
     offset += SRTP_MASTER_KEY_KEY_LEN;
-    std::string client_master_salt(reinterpret_cast<char*>(material + offset), SRTP_MASTER_KEY_SALT_LEN);
-    offset += SRTP_MASTER_KEY_SALT_LEN;
-    std::string server_master_salt(reinterpret_cast<char*>(material + offset), SRTP_MASTER_KEY_SALT_LEN);
+    std::string client_master_salt(reinterpret_cast<char*>(material + offset), salt_len);
+    offset += salt_len;
+    std::string server_master_salt(reinterpret_cast<char*>(material + offset), salt_len);
 
     if (is_dtls_client()) {
         recv_key = server_master_key + server_master_salt;
@@ -1067,11 +1552,16 @@ srs_error_t SrsSRTP::initialize(string recv_key, std::string send_key)
     srtp_policy_t policy;
     bzero(&policy, sizeof(policy));
 
-    // TODO: Maybe we can use SRTP-GCM in future.
+    // The policy depends on the length of key, see SrsDtlsImpl::get_srtp_key
     // @see https://bugs.chromium.org/p/chromium/issues/detail?id=713701
     // @see https://groups.google.com/forum/#!topic/discuss-webrtc/PvCbWSetVAQ
-    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtp);
-    srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtcp);
+    if (recv_key.size() == SRTP_AES_GCM_128_KEY_LEN_WSALT) {
+        srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy.rtp);
+        srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy.rtcp);
+    } else {
+        srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtp);
+        srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtcp);
+    }
 
     policy.ssrc.value = 0;
     // TODO: adjust window_size
@@ -1121,6 +1611,39 @@ srs_error_t SrsSRTP::protect_rtp(void* packet, int* nb_cipher)
     return err;
 }
 
+srs_error_t SrsSRTP::protect_rtps(iovec* iovs, int nn_iovs)
+{
+    srs_error_t err = srs_success;
+
+    // If DTLS/SRTP is not ready, fail, and never send the plaintext packets.
+    if (!send_ctx_) {
+        for (int i = 0; i < nn_iovs; i++) {
+            iovs[i].iov_len = 0;
+        }
+        return srs_error_new(ERROR_RTC_SRTP_PROTECT, "not ready");
+    }
+
+    // TODO: FIXME: It's still a srtp_protect per packet, because libsrtp has no batch API.
+    for (int i = 0; i < nn_iovs; i++) {
+        iovec* iov = iovs + i;
+
+        int nb_cipher = (int)iov->iov_len;
+        srtp_err_status_t r0 = srtp_protect(send_ctx_, iov->iov_base, &nb_cipher);
+        if (r0 != srtp_err_status_ok) {
+            // Drop the packet only, like protecting them one by one.
+            iov->iov_len = 0;
+            if (err == srs_success) {
+                err = srs_error_new(ERROR_RTC_SRTP_PROTECT, "rtp protect %d/%d r0=%u", i, nn_iovs, r0);
+            }
+            continue;
+        }
+
+        iov->iov_len = (size_t)nb_cipher;
+    }
+
+    return err;
+}
+
 srs_error_t SrsSRTP::protect_rtcp(void* packet, int* nb_cipher)
 {
     srs_error_t err = srs_success;
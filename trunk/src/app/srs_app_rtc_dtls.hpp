@@ -11,6 +11,9 @@
 
 #include <string>
 #include <vector>
+#include <map>
+
+#include <sys/uio.h>
 
 #include <openssl/ssl.h>
 #include <srtp2/srtp.h>
@@ -18,6 +21,8 @@
 #include <srs_app_st.hpp>
 
 class SrsRequest;
+class SrsThreadMutex;
+class SrsDtlsImpl;
 
 class SrsDtlsCertificate
 {
@@ -27,6 +32,8 @@ private:
     X509* dtls_cert;
     EVP_PKEY* dtls_pkey;
     EC_KEY* eckey;
+    // The prebuilt SSL_CTX for each version and role, shared by all DTLS sessions.
+    std::map<std::string, SSL_CTX*> dtls_ctxs;
 public:
     SrsDtlsCertificate();
     virtual ~SrsDtlsCertificate();
@@ -43,6 +50,10 @@ public:
     std::string get_fingerprint();
     // whether is ecdsa
     bool is_ecdsa();
+    // Get the shared SSL_CTX of certificate, build it if not exists. Note that the SSL_CTX is
+    // ref-counted by SSL_new, so user should never free it.
+    // @param version The DTLS version, see SrsDtlsVersion.
+    SSL_CTX* get_dtls_ctx(int version, std::string role);
 };
 
 // @global config object.
@@ -80,6 +91,78 @@ public:
     virtual srs_error_t on_dtls_alert(std::string type, std::string desc) = 0;
 };
 
+// The DTLS handshake job, the SSL_do_handshake is done by worker thread.
+class SrsDtlsHandshakeJob
+{
+public:
+    // The DTLS which owns the SSL, NULL if freed before the job done, then the job owns the SSL.
+    SrsDtlsImpl* dtls_;
+    SSL* ssl_;
+    // The context id of session, for logging when job done.
+    SrsContextId cid_;
+    // The result of SSL_do_handshake and SSL_get_error.
+    int r0_;
+    int r1_;
+    // The alerts got by SSL info callback in worker thread, in type and desc.
+    std::vector< std::pair<std::string, std::string> > alerts_;
+public:
+    SrsDtlsHandshakeJob();
+    virtual ~SrsDtlsHandshakeJob();
+};
+
+// The worker threads to do the DTLS handshake, which is CPU intensive for ECDHE and signing, and
+// the result is notified to the ST thread by a pipe. It also limits the rate of new handshakes.
+class SrsDtlsWorkers : public ISrsCoroutineHandler
+{
+private:
+    // The number of worker threads, 0 to do handshake in ST thread.
+    int nn_workers_;
+    // The max number of new handshakes per second, 0 for no limit.
+    int rate_;
+    // The start time and the number of admitted handshakes in current window.
+    srs_utime_t window_;
+    int nn_admitted_;
+private:
+    // The pipe to wake up workers when a job is submitted, and the pipe to notify the ST thread.
+    int jobs_pipe_[2];
+    int done_pipe_[2];
+    srs_netfd_t done_fd_;
+    SrsCoroutine* trd_;
+private:
+    // To protect the jobs, which are accessed by multiple threads.
+    SrsThreadMutex* lock_;
+    std::vector<SrsDtlsHandshakeJob*> jobs_;
+    std::vector<SrsDtlsHandshakeJob*> done_;
+    // Whether the workers should quit, and the number of running workers, protected by lock.
+    bool quit_;
+    int nn_running_;
+public:
+    SrsDtlsWorkers();
+    virtual ~SrsDtlsWorkers();
+public:
+    // Start the worker threads by config, in the ST thread of RTC server.
+    srs_error_t initialize();
+    // Whether do handshake in worker threads.
+    bool enabled();
+    // Whether the new handshake is allowed, by the rate limit.
+    bool admit();
+    // Submit the job to worker threads, the DTLS is notified by SrsDtlsImpl::on_handshake_job_done
+    void submit(SrsDtlsHandshakeJob* job);
+// Interface ISrsCoroutineHandler
+public:
+    // Consume the done jobs in the ST thread.
+    virtual srs_error_t cycle();
+private:
+    static srs_error_t start(void* arg);
+    // The cycle of worker thread.
+    void do_work();
+    // Notify the workers to quit, and wait for all workers to quit.
+    void stop_workers();
+};
+
+// @global The workers for DTLS handshake.
+extern SrsDtlsWorkers* _srs_dtls_workers;
+
 // The state for DTLS client.
 enum SrsDtlsState {
     SrsDtlsStateInit, // Start.
@@ -106,6 +189,13 @@ protected:
     bool handshake_done_for_us;
     // The stat for ARQ packets.
     int nn_arq_packets;
+protected:
+    // Whether the handshake is admitted by the rate limit, or the ClientHello is dropped.
+    bool handshake_admitted_;
+    int nn_dropped_;
+    // The handshake in worker thread, and the DTLS packets waiting for it.
+    SrsDtlsHandshakeJob* job_;
+    std::vector<std::string> pending_;
 public:
     SrsDtlsImpl(ISrsDtlsCallback* callback);
     virtual ~SrsDtlsImpl();
@@ -117,6 +207,18 @@ public:
 protected:
     srs_error_t do_on_dtls(char* data, int nb_data);
     srs_error_t do_handshake();
+    // Handle the result of SSL_do_handshake, send out the data and notify when done.
+    srs_error_t on_handshake_result(int r0, int r1);
+    // Read the application data after handshake.
+    srs_error_t read_application_data();
+    // Do the SSL_do_handshake in worker thread.
+    srs_error_t do_handshake_async();
+public:
+    // When the handshake job is done by worker thread, in the ST thread.
+    srs_error_t on_handshake_job_done(SrsDtlsHandshakeJob* job);
+    // Detach the handshake job and restore the callbacks in ST thread, for job done or workers quit.
+    void on_handshake_job_abort(SrsDtlsHandshakeJob* job);
+protected:
     void state_trace(uint8_t* data, int length, bool incoming, int r0, int r1, bool arq);
 public:
     srs_error_t get_srtp_key(std::string& recv_key, std::string& send_key);
@@ -228,6 +330,13 @@ public:
     srs_error_t protect_rtcp(void* packet, int* nb_cipher);
     srs_error_t unprotect_rtp(void* packet, int* nb_plaintext);
     srs_error_t unprotect_rtcp(void* packet, int* nb_plaintext);
+public:
+    // Protect a batch of RTP packets of this session in place, in one call, and the iov_len is
+    // updated to the size of cipher, see SrsRtcConnection::begin_batch
+    // @remark User must make sure each buffer is large enough, for the SRTP trailer.
+    // @remark The iov_len is set to 0 if failed to protect the packet, which should be dropped,
+    //      and the error of the first failed packet is returned.
+    srs_error_t protect_rtps(iovec* iovs, int nn_iovs);
 };
 
 #endif
@@ -142,6 +142,11 @@ srs_error_t SrsRtcDummyNetwork::protect_rtcp(void* packet, int* nb_cipher)
     return srs_success;
 }
 
+srs_error_t SrsRtcDummyNetwork::protect_rtps(iovec* iovs, int nn_iovs)
+{
+    return srs_success;
+}
+
 srs_error_t SrsRtcDummyNetwork::write(void* buf, size_t size, ssize_t* nwrite)
 {
     return srs_success;
@@ -233,6 +238,11 @@ srs_error_t SrsRtcUdpNetwork::protect_rtcp(void* packet, int* nb_cipher)
     return transport_->protect_rtcp(packet, nb_cipher);
 }
 
+srs_error_t SrsRtcUdpNetwork::protect_rtps(iovec* iovs, int nn_iovs)
+{
+    return transport_->protect_rtps(iovs, nn_iovs);
+}
+
 srs_error_t SrsRtcUdpNetwork::on_rtcp(char* data, int nb_data)
 {
     srs_error_t err = srs_success;
@@ -489,6 +499,11 @@ srs_error_t SrsRtcTcpNetwork::protect_rtcp(void* packet, int* nb_cipher)
     return transport_->protect_rtcp(packet, nb_cipher);
 }
 
+srs_error_t SrsRtcTcpNetwork::protect_rtps(iovec* iovs, int nn_iovs)
+{
+    return transport_->protect_rtps(iovs, nn_iovs);
+}
+
 srs_error_t SrsRtcTcpNetwork::on_stun(SrsStunPacket* r, char* data, int nb_data)
 {
    srs_error_t err = srs_success;
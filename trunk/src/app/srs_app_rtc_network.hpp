@@ -94,6 +94,8 @@ public:
     virtual srs_error_t protect_rtp(void* packet, int* nb_cipher) = 0;
     // Protect RTCP packet by SRTP context.
     virtual srs_error_t protect_rtcp(void* packet, int* nb_cipher) = 0;
+    // Protect a batch of RTP packets by SRTP context.
+    virtual srs_error_t protect_rtps(iovec* iovs, int nn_iovs) = 0;
 public:
     virtual bool is_establelished() = 0;
 };
@@ -112,6 +114,7 @@ public:
 public:
     virtual srs_error_t protect_rtp(void* packet, int* nb_cipher);
     virtual srs_error_t protect_rtcp(void* packet, int* nb_cipher);
+    virtual srs_error_t protect_rtps(iovec* iovs, int nn_iovs);
     virtual bool is_establelished();
 // Interface ISrsStreamWriter.
 public:
@@ -154,6 +157,7 @@ public:
     srs_error_t on_dtls_handshake_done();
     srs_error_t protect_rtp(void* packet, int* nb_cipher);
     srs_error_t protect_rtcp(void* packet, int* nb_cipher);
+    srs_error_t protect_rtps(iovec* iovs, int nn_iovs);
 // When got data from socket.
 public:
     srs_error_t on_rtcp(char* data, int nb_data);
@@ -202,6 +206,8 @@ public:
     virtual srs_error_t protect_rtp(void* packet, int* nb_cipher);
     // Protect RTCP packet by SRTP context.
     virtual srs_error_t protect_rtcp(void* packet, int* nb_cipher);
+    // Protect a batch of RTP packets by SRTP context.
+    virtual srs_error_t protect_rtps(iovec* iovs, int nn_iovs);
 
     // When got STUN ping message. The peer address may change, we can identify that by STUN messages.
     srs_error_t on_stun(SrsStunPacket* r, char* data, int nb_data);
@@ -197,19 +197,40 @@ SrsRtpNackInfo::SrsRtpNackInfo()
     req_nack_count_ = 0;
 }
 
-SrsRtpNackForReceiver::SrsRtpNackForReceiver(SrsRtpRingBuffer* rtp, size_t queue_size)
+SrsRtpNackForReceiver::SrsRtpNackForReceiver(SrsRtpRingBuffer* rtp, size_t queue_size, SrsWallClock* clk)
 {
     max_queue_size_ = queue_size;
     rtp_ = rtp;
+    clk_ = clk ? clk : _srs_clock;
     pre_check_time_ = 0;
     rtt_ = 0;
 
-    srs_info("max_queue_size=%u, nack opt: max_count=%d, max_alive_time=%us, first_nack_interval=%" PRId64 ", nack_interval=%" PRId64,
-        max_queue_size_, opts_.max_count, opts_.max_alive_time, opts_.first_nack_interval, opts_.nack_interval);
+    // The window should be large enough to hold the lost sequences, which might not be
+    // continuous, so we use about 3x of queue size, and align to the bitmap word.
+    capacity_ = 64;
+    while (capacity_ < 32768 && capacity_ < queue_size * 3) {
+        capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+
+    bitmap_ = new uint64_t[capacity_ / 64];
+    memset(bitmap_, 0, sizeof(uint64_t) * (capacity_ / 64));
+    seqs_ = new uint16_t[capacity_];
+    memset(seqs_, 0, sizeof(uint16_t) * capacity_);
+    infos_ = new SrsRtpNackInfo[capacity_];
+
+    head_ = tail_ = 0;
+    size_ = 0;
+
+    srs_info("max_queue_size=%u, capacity=%u, nack opt: max_count=%d, max_alive_time=%us, first_nack_interval=%" PRId64 ", nack_interval=%" PRId64,
+        max_queue_size_, capacity_, opts_.max_count, opts_.max_alive_time, opts_.first_nack_interval, opts_.nack_interval);
 }
 
 SrsRtpNackForReceiver::~SrsRtpNackForReceiver()
 {
+    srs_freepa(bitmap_);
+    srs_freepa(seqs_);
+    srs_freepa(infos_);
 }
 
 void SrsRtpNackForReceiver::insert(uint16_t first, uint16_t last)
@@ -221,44 +242,49 @@ void SrsRtpNackForReceiver::insert(uint16_t first, uint16_t last)
     }
 
     for (uint16_t s = first; s != last; ++s) {
-        queue_[s] = SrsRtpNackInfo();
+        insert_seq(s);
     }
 }
 
 void SrsRtpNackForReceiver::remove(uint16_t seq)
 {
-    queue_.erase(seq);
+    if (is_lost(seq)) {
+        clear_lost(seq);
+    }
 }
 
 SrsRtpNackInfo* SrsRtpNackForReceiver::find(uint16_t seq)
 {
-    std::map<uint16_t, SrsRtpNackInfo>::iterator iter = queue_.find(seq);
-
-    if (iter == queue_.end()) {
+    if (!is_lost(seq)) {
         return NULL;
     }
 
-    return &(iter->second);
+    return &infos_[seq & mask_];
 }
 
 void SrsRtpNackForReceiver::check_queue_size()
 {
-    if (queue_.size() >= max_queue_size_) {
+    if (size_ >= max_queue_size_) {
         rtp_->notify_nack_list_full();
-        queue_.clear();
+        clear();
     }
 }
 
+size_t SrsRtpNackForReceiver::size()
+{
+    return size_;
+}
+
 void SrsRtpNackForReceiver::get_nack_seqs(SrsRtcpNack& seqs, uint32_t& timeout_nacks)
 {
     // If circuit-breaker is enabled, disable nack.
     if (_srs_circuit_breaker->hybrid_high_water_level()) {
-        queue_.clear();
+        clear();
         ++_srs_pps_snack4->sugar;
         return;
     }
 
-    srs_utime_t now = srs_get_system_time();
+    srs_utime_t now = clk_->now();
 
     srs_utime_t interval = now - pre_check_time_;
     if (interval < opts_.nack_check_interval) {
@@ -266,16 +292,29 @@ void SrsRtpNackForReceiver::get_nack_seqs(SrsRtcpNack& seqs, uint32_t& timeout_n
     }
     pre_check_time_ = now;
 
-    std::map<uint16_t, SrsRtpNackInfo>::iterator iter = queue_.begin();
-    while (iter != queue_.end()) {
-        const uint16_t& seq = iter->first;
-        SrsRtpNackInfo& nack_info = iter->second;
+    if (!size_) {
+        return;
+    }
+
+    srs_utime_t nack_interval = srs_max(opts_.min_nack_interval, opts_.nack_interval / 3);
+    if(opts_.nack_interval < 50 * SRS_UTIME_MILLISECONDS){
+        nack_interval = srs_max(opts_.min_nack_interval, opts_.nack_interval);
+    }
+
+    // Build the FCI of NACK directly, the PID and a bitmask of following 16 lost packets.
+    uint16_t pid = 0, blp = 0;
+    bool in_use = false;
+
+    int n = srs_rtp_seq_distance(head_, tail_);
+    for (int offset = next_lost(0, n); offset < n; offset = next_lost(offset + 1, n)) {
+        uint16_t seq = head_ + offset;
+        SrsRtpNackInfo& nack_info = infos_[seq & mask_];
 
         int alive_time = now - nack_info.generate_time_;
         if (alive_time > opts_.max_alive_time || nack_info.req_nack_count_ > opts_.max_count) {
             ++timeout_nacks;
             rtp_->notify_drop_seq(seq);
-            queue_.erase(iter++);
+            clear_lost(seq);
             continue;
         }
 
@@ -284,19 +323,118 @@ void SrsRtpNackForReceiver::get_nack_seqs(SrsRtcpNack& seqs, uint32_t& timeout_n
             break;
         }
 
-        srs_utime_t nack_interval = srs_max(opts_.min_nack_interval, opts_.nack_interval / 3);
-        if(opts_.nack_interval < 50 * SRS_UTIME_MILLISECONDS){
-            nack_interval = srs_max(opts_.min_nack_interval, opts_.nack_interval);
+        if (now - nack_info.pre_req_nack_time_ < nack_interval) {
+            continue;
+        }
+
+        ++nack_info.req_nack_count_;
+        nack_info.pre_req_nack_time_ = now;
+
+        if (in_use && srs_rtp_seq_distance(pid, seq) <= 16) {
+            blp |= 1 << (uint16_t)(seq - pid - 1);
+            continue;
         }
 
-        if (now - nack_info.pre_req_nack_time_ >= nack_interval ) {
-            ++nack_info.req_nack_count_;
-            nack_info.pre_req_nack_time_ = now;
-            seqs.add_lost_sn(seq);
+        if (in_use) {
+            seqs.add_lost_pid_blp(pid, blp);
+        }
+        pid = seq;
+        blp = 0;
+        in_use = true;
+    }
+
+    if (in_use) {
+        seqs.add_lost_pid_blp(pid, blp);
+    }
+
+    // Skip the received or dropped sequences at head.
+    if (size_) {
+        head_ += next_lost(0, n);
+    }
+}
+
+void SrsRtpNackForReceiver::insert_seq(uint16_t seq)
+{
+    if (!size_) {
+        head_ = seq;
+        tail_ = seq + 1;
+    } else if (srs_rtp_seq_distance(tail_, seq) >= 0) {
+        // Newer sequence, move the tail, and drop the oldest ones which are out of window.
+        tail_ = seq + 1;
+
+        int overflow = srs_rtp_seq_distance(head_, tail_) - capacity_;
+        for (int i = 0; i < overflow; i++) {
+            uint16_t old = head_ + i;
+            if (is_lost(old)) {
+                // Give up the sequence, the same as timeout in get_nack_seqs.
+                rtp_->notify_drop_seq(old);
+                clear_lost(old);
+            }
+        }
+        if (overflow > 0) {
+            head_ += overflow;
         }
+    } else if (srs_rtp_seq_distance(seq, head_) > 0) {
+        // Older sequence, ignore if out of window.
+        if (srs_rtp_seq_distance(seq, tail_) > capacity_) {
+            return;
+        }
+        head_ = seq;
+    }
+
+    if (!is_lost(seq)) {
+        set_lost(seq);
+    }
+
+    SrsRtpNackInfo& info = infos_[seq & mask_];
+    info = SrsRtpNackInfo();
+    info.generate_time_ = clk_->now();
+}
+
+void SrsRtpNackForReceiver::clear()
+{
+    memset(bitmap_, 0, sizeof(uint64_t) * (capacity_ / 64));
+    head_ = tail_ = 0;
+    size_ = 0;
+}
 
-        ++iter;
+bool SrsRtpNackForReceiver::is_lost(uint16_t seq)
+{
+    uint16_t idx = seq & mask_;
+    return (bitmap_[idx >> 6] & (1ULL << (idx & 63))) && seqs_[idx] == seq;
+}
+
+void SrsRtpNackForReceiver::set_lost(uint16_t seq)
+{
+    uint16_t idx = seq & mask_;
+    uint64_t bit = 1ULL << (idx & 63);
+
+    // The slot is used by an alias sequence, which is too old, so we reuse it.
+    if ((bitmap_[idx >> 6] & bit) == 0) {
+        bitmap_[idx >> 6] |= bit;
+        size_++;
+    }
+    seqs_[idx] = seq;
+}
+
+void SrsRtpNackForReceiver::clear_lost(uint16_t seq)
+{
+    uint16_t idx = seq & mask_;
+    bitmap_[idx >> 6] &= ~(1ULL << (idx & 63));
+    size_--;
+}
+
+int SrsRtpNackForReceiver::next_lost(int offset, int n)
+{
+    while (offset < n) {
+        uint16_t idx = (uint16_t)(head_ + offset) & mask_;
+        uint64_t word = bitmap_[idx >> 6] >> (idx & 63);
+        if (word) {
+            return srs_min(offset + __builtin_ctzll(word), n);
+        }
+        offset += 64 - (idx & 63);
     }
+    return n;
 }
 
 void SrsRtpNackForReceiver::update_rtt(int rtt)
@@ -16,6 +16,8 @@
 #include <srs_kernel_rtc_rtp.hpp>
 #include <srs_kernel_rtc_rtcp.hpp>
 
+class SrsWallClock;
+
 class SrsRtpPacket;
 class SrsRtpQueue;
 class SrsRtpRingBuffer;
@@ -101,31 +103,62 @@ struct SrsRtpNackInfo
     SrsRtpNackInfo();
 };
 
+// The NACK list of receiver, which tracks the lost sequences in a flat window indexed by
+// seq modulo the window size. There is a bitmap to mark the lost slots, so that insert and
+// remove are O(1), and we scan the due NACKs by 64 slots a time, without any allocation.
+//      [head_ ... seq(lost) ... tail_)
+//      * head_: The oldest lost sequence in window, might be received.
+//      * tail_: The newest lost sequence plus one.
 class SrsRtpNackForReceiver
 {
 private:
-    // Nack queue, seq order, oldest to newest.
-    std::map<uint16_t, SrsRtpNackInfo, SrsSeqCompareLess> queue_;
+    // The number of slots in window, must be power of 2 and multiple of 64.
+    uint16_t capacity_;
+    uint16_t mask_;
+    // The bitmap of lost slots, a bit for a slot.
+    uint64_t* bitmap_;
+    // The sequence of each slot, to detect the alias sequence.
+    uint16_t* seqs_;
+    // The nack info of each slot, valid only when the bit is set.
+    SrsRtpNackInfo* infos_;
+    // The range of lost sequences, seq order, oldest to newest.
+    uint16_t head_;
+    uint16_t tail_;
+    // The number of lost sequences in window.
+    size_t size_;
     // Max nack count.
     size_t max_queue_size_;
     SrsRtpRingBuffer* rtp_;
     SrsNackOption opts_;
+    // The clock to generate and check the nack, use _srs_clock if not specified.
+    SrsWallClock* clk_;
 private:
     srs_utime_t pre_check_time_;
 private:
     int rtt_;
 public:
-    SrsRtpNackForReceiver(SrsRtpRingBuffer* rtp, size_t queue_size);
+    SrsRtpNackForReceiver(SrsRtpRingBuffer* rtp, size_t queue_size, SrsWallClock* clk = NULL);
     virtual ~SrsRtpNackForReceiver();
 public:
     void insert(uint16_t first, uint16_t last);
     void remove(uint16_t seq);
     SrsRtpNackInfo* find(uint16_t seq);
     void check_queue_size();
+    // Get the number of lost sequences.
+    size_t size();
 public:
     void get_nack_seqs(SrsRtcpNack& seqs, uint32_t& timeout_nacks);
 public:
     void update_rtt(int rtt);
+private:
+    void insert_seq(uint16_t seq);
+    void clear();
+    // Whether the slot is lost, and the seq of slot matches.
+    bool is_lost(uint16_t seq);
+    void set_lost(uint16_t seq);
+    void clear_lost(uint16_t seq);
+    // Find the first lost slot in [head_+offset, head_+n), return n if not found.
+    int next_lost(int offset, int n);
 };
 
 #endif
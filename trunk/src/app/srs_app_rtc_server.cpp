@@ -735,6 +735,10 @@ srs_error_t RtcServerAdapter::initialize()
         return srs_error_wrap(err, "rtc dtls certificate initialize");
     }
 
+    if ((err = _srs_dtls_workers->initialize()) != srs_success) {
+        return srs_error_wrap(err, "rtc dtls workers initialize");
+    }
+
     if ((err = rtc->initialize()) != srs_success) {
         return srs_error_wrap(err, "rtc server initialize");
     }
@@ -165,6 +165,7 @@ SrsRtcConsumer::SrsRtcConsumer(SrsRtcSource* s)
     mw_wait = srs_cond_new();
     mw_min_msgs = 0;
     mw_waiting = false;
+    fec_ = false;
 }
 
 SrsRtcConsumer::~SrsRtcConsumer()
@@ -343,6 +344,9 @@ SrsRtcSource::SrsRtcSource()
     bridge_ = NULL;
 
     pli_for_rtmp_ = pli_elapsed_ = 0;
+
+    fec_group_ = 0;
+    red_encoder_ = NULL;
 }
 
 SrsRtcSource::~SrsRtcSource()
@@ -354,6 +358,13 @@ SrsRtcSource::~SrsRtcSource()
     srs_freep(bridge_);
     srs_freep(req);
     srs_freep(stream_desc_);
+
+    for (map<uint32_t, SrsRtpFecEncoder*>::iterator it = fec_encoders_.begin(); it != fec_encoders_.end(); ++it) {
+        SrsRtpFecEncoder* encoder = it->second;
+        srs_freep(encoder);
+    }
+    fec_encoders_.clear();
+    srs_freep(red_encoder_);
 }
 
 srs_error_t SrsRtcSource::initialize(SrsRequest* r)
@@ -362,6 +373,13 @@ srs_error_t SrsRtcSource::initialize(SrsRequest* r)
 
     req = r->copy();
 
+    if (_srs_config->get_rtc_fec_enabled(req->vhost)) {
+        fec_group_ = _srs_config->get_rtc_fec_group(req->vhost);
+    }
+    if (_srs_config->get_rtc_red_enabled(req->vhost)) {
+        red_encoder_ = new SrsRtpRedEncoder(_srs_config->get_rtc_red_distance(req->vhost));
+    }
+
 	// Create default relations to allow play before publishing.
 	// @see https://github.com/ossrs/srs/issues/2362
 	init_for_play_before_publishing();
@@ -575,6 +593,18 @@ void SrsRtcSource::on_unpublish()
     }
     _source_id = SrsContextId();
 
+    // Reset the FEC groups, because the new publisher starts from another sequence.
+    for (map<uint32_t, SrsRtpFecEncoder*>::iterator it = fec_encoders_.begin(); it != fec_encoders_.end(); ++it) {
+        SrsRtpFecEncoder* encoder = it->second;
+        srs_freep(encoder);
+    }
+    fec_encoders_.clear();
+
+    if (red_encoder_) {
+        srs_freep(red_encoder_);
+        red_encoder_ = new SrsRtpRedEncoder(_srs_config->get_rtc_red_distance(req->vhost));
+    }
+
     for (size_t i = 0; i < event_handlers_.size(); i++) {
         ISrsRtcSourceEventHandler* h = event_handlers_.at(i);
         h->on_unpublish();
@@ -629,13 +659,32 @@ srs_error_t SrsRtcSource::on_rtp(SrsRtpPacket* pkt)
         return err;
     }
 
+    // Generate RED only when there are consumers, the bridge never consumes RED.
+    SrsRtpPacket* red = NULL;
+    if (red_encoder_ && pkt->is_audio() && !consumers.empty()) {
+        if ((err = on_red(pkt, &red)) != srs_success) {
+            return srs_error_wrap(err, "red");
+        }
+    }
+    SrsAutoFree(SrsRtpPacket, red);
+
+    // The RED packet is shared by all consumers, and unpacked for consumer without RED.
+    // @see SrsRtcAudioSendTrack::on_rtp
+    SrsRtpPacket* shared = red? red : pkt;
     for (int i = 0; i < (int)consumers.size(); i++) {
         SrsRtcConsumer* consumer = consumers.at(i);
-        if ((err = consumer->enqueue(pkt->copy())) != srs_success) {
+        if ((err = consumer->enqueue(shared->copy())) != srs_success) {
             return srs_error_wrap(err, "consume message");
         }
     }
 
+    // Generate FEC only when there are consumers negotiated FEC, the bridge never consumes FEC.
+    if (fec_group_ > 0 && !pkt->is_audio() && has_fec_consumer()) {
+        if ((err = on_fec(pkt)) != srs_success) {
+            return srs_error_wrap(err, "fec");
+        }
+    }
+
     if (bridge_ && (err = bridge_->on_rtp(pkt)) != srs_success) {
         return srs_error_wrap(err, "bridge consume message");
     }
@@ -643,6 +692,73 @@ srs_error_t SrsRtcSource::on_rtp(SrsRtpPacket* pkt)
     return err;
 }
 
+srs_error_t SrsRtcSource::on_fec(SrsRtpPacket* pkt)
+{
+    srs_error_t err = srs_success;
+
+    uint32_t ssrc = pkt->header.get_ssrc();
+
+    SrsRtpFecEncoder* encoder = NULL;
+    map<uint32_t, SrsRtpFecEncoder*>::iterator it = fec_encoders_.find(ssrc);
+    if (it != fec_encoders_.end()) {
+        encoder = it->second;
+    } else {
+        encoder = new SrsRtpFecEncoder(fec_group_);
+        fec_encoders_[ssrc] = encoder;
+    }
+
+    // The FEC packet is XOR of packets of source, which is shared by all consumers. Each consumer
+    // updates the header of FEC, because the sequence and timestamp of packets are changed.
+    // @see SrsRtcVideoSendTrack::build_fec
+    vector<SrsRtpPacket*> fecs;
+    err = encoder->encode(pkt, fecs);
+
+    for (int i = 0; i < (int)fecs.size(); i++) {
+        SrsRtpPacket* fec = fecs.at(i);
+        for (int j = 0; err == srs_success && j < (int)consumers.size(); j++) {
+            SrsRtcConsumer* consumer = consumers.at(j);
+            if (consumer->fec()) {
+                err = consumer->enqueue(fec->copy());
+            }
+        }
+        srs_freep(fec);
+    }
+
+    if (err != srs_success) {
+        return srs_error_wrap(err, "consume fec, ssrc=%u", ssrc);
+    }
+
+    return err;
+}
+
+bool SrsRtcSource::has_fec_consumer()
+{
+    for (int i = 0; i < (int)consumers.size(); i++) {
+        SrsRtcConsumer* consumer = consumers.at(i);
+        if (consumer->fec()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+srs_error_t SrsRtcSource::on_red(SrsRtpPacket* pkt, SrsRtpPacket** pred)
+{
+    srs_error_t err = srs_success;
+
+    // Ignore if not the media of audio, for example, the RED from publisher.
+    SrsRtcTrackDescription* track = stream_desc_? stream_desc_->audio_track_desc_ : NULL;
+    if (!track || !track->media_ || pkt->header.get_payload_type() != track->media_->pt_) {
+        return err;
+    }
+
+    if ((err = red_encoder_->encode(pkt, pred)) != srs_success) {
+        return srs_error_wrap(err, "encode red, ssrc=%u, seq=%u", pkt->header.get_ssrc(), pkt->header.get_sequence());
+    }
+
+    return err;
+}
+
 bool SrsRtcSource::has_stream_desc()
 {
     return stream_desc_;
@@ -2555,6 +2671,13 @@ void SrsRtcVideoRecvTrack::on_before_decode_payload(SrsRtpPacket* pkt, SrsBuffer
         return;
     }
 
+    // The media in RED is restored by SrsRtcPublishStream::on_rtp_plaintext, so it's FEC if still in RED.
+    if (track_desc_->red_ && track_desc_->ulpfec_ && pkt->header.get_payload_type() == track_desc_->red_->pt_) {
+        *ppayload = new SrsRtpUlpfecPayload();
+        *ppt = SrsRtspPacketPayloadTypeFEC;
+        return;
+    }
+
     uint8_t v = (uint8_t)(buf->head()[0] & kNalTypeMask);
     pkt->nalu_type = SrsAvcNaluType(v);
 
@@ -2583,6 +2706,49 @@ srs_error_t SrsRtcVideoRecvTrack::on_rtp(SrsRtcSource* source, SrsRtpPacket* pkt
     return err;
 }
 
+srs_error_t SrsRtcVideoRecvTrack::on_fec(SrsRtpPacket* pkt, char* buf, int* nn_buf)
+{
+    srs_error_t err = srs_success;
+
+    SrsRtpUlpfecPayload* fec = dynamic_cast<SrsRtpUlpfecPayload*>(pkt->payload());
+    if (!fec) {
+        *nn_buf = 0;
+        return err;
+    }
+
+    // Collect the received packets, FEC only recovers one lost packet.
+    int nn_lost = 0;
+    uint16_t lost_seq = 0;
+    vector<SrsRtpPacket*> pkts;
+    for (int i = 0; i < 16; i++) {
+        uint16_t seq = fec->sn_base + i;
+        if (!fec->is_protected(seq)) {
+            continue;
+        }
+
+        SrsRtpPacket* p = rtp_queue_->at(seq);
+        if (p && p->header.get_sequence() == seq) {
+            pkts.push_back(p);
+        } else {
+            lost_seq = seq;
+            nn_lost++;
+        }
+    }
+
+    if (nn_lost != 1) {
+        *nn_buf = 0;
+        return err;
+    }
+
+    SrsBuffer b(buf, *nn_buf);
+    if ((err = fec->recover(lost_seq, pkt->header.get_ssrc(), pkts, &b)) != srs_success) {
+        return srs_error_wrap(err, "recover seq=%u", lost_seq);
+    }
+    *nn_buf = b.pos();
+
+    return err;
+}
+
 srs_error_t SrsRtcVideoRecvTrack::check_send_nacks()
 {
     srs_error_t err = srs_success;
@@ -2732,6 +2898,11 @@ srs_error_t SrsRtcSendTrack::on_nack(SrsRtpPacket** ppkt)
     SrsRtpPacket* pkt = *ppkt;
     uint16_t seq = pkt->header.get_sequence();
 
+    // Ignore the FEC of source which is dropped by subscriber, see SrsRtcVideoSendTrack::build_fec
+    if (pkt->payload_type() == SrsRtspPacketPayloadTypeFEC && !pkt->header.get_payload_type()) {
+        return err;
+    }
+
     // insert into video_queue and audio_queue
     // We directly use the pkt, never copy it, so we should set the pkt to NULL.
     if (nack_no_copy_) {
@@ -2750,6 +2921,9 @@ srs_error_t SrsRtcSendTrack::on_recv_nack(const vector<uint16_t>& lost_seqs)
 
     ++_srs_pps_rnack2->sugar;
 
+    // Retransmit the lost packets in a batch, which are protected by SRTP in one call.
+    session_->begin_batch();
+
     for(int i = 0; i < (int)lost_seqs.size(); ++i) {
         uint16_t seq = lost_seqs.at(i);
         SrsRtpPacket* pkt = fetch_rtp_packet(seq);
@@ -2763,12 +2937,21 @@ srs_error_t SrsRtcSendTrack::on_recv_nack(const vector<uint16_t>& lost_seqs)
                 pkt->header.get_ssrc(), pkt->header.get_timestamp(), nn, nack_epp->nn_count, pkt->nb_bytes());
         }
 
-        // By default, we send packets by sendmmsg.
         if ((err = session_->do_send_packet(pkt)) != srs_success) {
-            return srs_error_wrap(err, "raw send");
+            break;
         }
     }
 
+    srs_error_t r0 = session_->end_batch();
+    if (err != srs_success) {
+        srs_freep(r0);
+        return srs_error_wrap(err, "raw send");
+    }
+
+    if (r0 != srs_success) {
+        return srs_error_wrap(r0, "flush");
+    }
+
     return err;
 }
 
@@ -2791,8 +2974,25 @@ srs_error_t SrsRtcAudioSendTrack::on_rtp(SrsRtpPacket* pkt)
 
     pkt->header.set_ssrc(track_desc_->ssrc_);
 
+    // For RED generated by source, use the PT of RED for subscriber, or unpack it to the primary
+    // block if subscriber doesn't support RED, see SrsRtcSource::on_red
+    if (pkt->payload_type() == SrsRtspPacketPayloadTypeRED) {
+        SrsRtpRedPayload* red = dynamic_cast<SrsRtpRedPayload*>(pkt->payload());
+        if (red && track_desc_->red_ && track_desc_->media_) {
+            red->primary_pt = track_desc_->media_->pt_;
+            pkt->header.set_payload_type(track_desc_->red_->pt_);
+        } else if (red) {
+            ISrsRtpPayloader* primary = red->primary;
+            red->primary = NULL;
+            pkt->set_payload(primary, SrsRtspPacketPayloadTypeRaw);
+            srs_freep(red);
+        }
+    }
+
     // Should update PT, because subscriber may use different PT to publisher.
-    if (track_desc_->media_ && pkt->header.get_payload_type() == track_desc_->media_->pt_of_publisher_) {
+    if (pkt->payload_type() == SrsRtspPacketPayloadTypeRED) {
+        // Already updated for RED generated by source.
+    } else if (track_desc_->media_ && pkt->header.get_payload_type() == track_desc_->media_->pt_of_publisher_) {
         // If PT is media from publisher, change to PT of media for subscriber.
         pkt->header.set_payload_type(track_desc_->media_->pt_);
     } else if (track_desc_->red_ && pkt->header.get_payload_type() == track_desc_->red_->pt_of_publisher_) {
@@ -2822,13 +3022,22 @@ srs_error_t SrsRtcAudioSendTrack::on_rtcp(SrsRtpPacket* pkt)
     return err;
 }
 
+// The max number of sent packets to build FEC, should be larger than the span of FEC group.
+#define SRS_RTC_FEC_SENTS 64
+
 SrsRtcVideoSendTrack::SrsRtcVideoSendTrack(SrsRtcConnection* session, SrsRtcTrackDescription* track_desc)
     : SrsRtcSendTrack(session, track_desc, false)
 {
+    fec_sents_ = new SrsRtcFecSentPacket[SRS_RTC_FEC_SENTS];
+    memset(fec_sents_, 0, sizeof(SrsRtcFecSentPacket) * SRS_RTC_FEC_SENTS);
+    fec_seq_offset_ = 0;
+    last_seq_ = 0;
+    last_ts_ = 0;
 }
 
 SrsRtcVideoSendTrack::~SrsRtcVideoSendTrack()
 {
+    srs_freepa(fec_sents_);
 }
 
 srs_error_t SrsRtcVideoSendTrack::on_rtp(SrsRtpPacket* pkt)
@@ -2838,6 +3047,18 @@ srs_error_t SrsRtcVideoSendTrack::on_rtp(SrsRtpPacket* pkt)
     if (!track_desc_->is_active_) {
         return err;
     }
+
+    // Build the FEC packet for subscriber, or drop it if not negotiated.
+    if (pkt->payload_type() == SrsRtspPacketPayloadTypeFEC) {
+        if (!build_fec(pkt)) {
+            return err;
+        }
+
+        if ((err = session_->do_send_packet(pkt)) != srs_success) {
+            return srs_error_wrap(err, "raw send");
+        }
+        return err;
+    }
     
     pkt->header.set_ssrc(track_desc_->ssrc_);
 
@@ -2853,8 +3074,28 @@ srs_error_t SrsRtcVideoSendTrack::on_rtp(SrsRtpPacket* pkt)
     }
 
     // Rebuild the sequence number and timestamp of packet, see https://github.com/ossrs/srs/issues/3167
+    uint16_t source_seq = pkt->header.get_sequence();
     rebuild_packet(pkt);
 
+    // Wrap the media in RED for FEC, and shift the sequence by the FEC packets.
+    if (fec_enabled()) {
+        pkt->header.set_sequence(pkt->header.get_sequence() + fec_seq_offset_);
+
+        SrsRtcFecSentPacket& sent = fec_sents_[source_seq % SRS_RTC_FEC_SENTS];
+        sent.valid_ = true;
+        sent.source_seq_ = source_seq;
+        sent.seq_ = last_seq_ = pkt->header.get_sequence();
+        sent.ts_ = last_ts_ = pkt->header.get_timestamp();
+
+        if (pkt->header.get_payload_type() == track_desc_->media_->pt_) {
+            SrsRtpRedPayload* red = new SrsRtpRedPayload();
+            red->primary_pt = track_desc_->media_->pt_;
+            red->primary = pkt->payload();
+            pkt->set_payload(red, SrsRtspPacketPayloadTypeRED);
+            pkt->header.set_payload_type(track_desc_->red_->pt_);
+        }
+    }
+
     if ((err = session_->do_send_packet(pkt)) != srs_success) {
         return srs_error_wrap(err, "raw send");
     }
@@ -2872,6 +3113,73 @@ srs_error_t SrsRtcVideoSendTrack::on_rtcp(SrsRtpPacket* pkt)
     return err;
 }
 
+bool SrsRtcVideoSendTrack::fec_enabled()
+{
+    return track_desc_->media_ && track_desc_->red_ && track_desc_->ulpfec_;
+}
+
+bool SrsRtcVideoSendTrack::build_fec(SrsRtpPacket* pkt)
+{
+    SrsRtpUlpfecPayload* fec = dynamic_cast<SrsRtpUlpfecPayload*>(pkt->payload());
+
+    // Mark the FEC of source as dropped, see SrsRtcSendTrack::on_nack
+    pkt->header.set_payload_type(0);
+    if (!fec || !fec_enabled()) {
+        return false;
+    }
+
+    // The XOR of payload is the same for all subscribers, because ULPFEC protects the media
+    // without RED, so we only need to update the sequence, timestamp and PT of subscriber.
+    int nn = 0;
+    uint16_t sn_base = 0, mask = 0;
+    uint32_t ts_recovery = 0;
+    for (int i = 0; i < 16; i++) {
+        uint16_t source_seq = fec->sn_base + i;
+        if (!fec->is_protected(source_seq)) {
+            continue;
+        }
+
+        // Drop if any protected packet is not sent, or sequence not continuous.
+        SrsRtcFecSentPacket& sent = fec_sents_[source_seq % SRS_RTC_FEC_SENTS];
+        if (!sent.valid_ || sent.source_seq_ != source_seq) {
+            return false;
+        }
+
+        if (nn++ == 0) {
+            sn_base = sent.seq_;
+        }
+
+        uint16_t offset = sent.seq_ - sn_base;
+        if (offset >= 16) {
+            return false;
+        }
+
+        mask |= 0x8000 >> offset;
+        ts_recovery ^= sent.ts_;
+    }
+
+    if (!nn) {
+        return false;
+    }
+
+    fec->fec_pt = track_desc_->ulpfec_->pt_;
+    fec->sn_base = sn_base;
+    fec->mask = mask;
+    fec->ts_recovery = ts_recovery;
+    // Keep the XOR of marker, all protected packets are in the PT of media.
+    fec->mpt_recovery = (fec->mpt_recovery & 0x80) | ((nn % 2)? track_desc_->media_->pt_ : 0);
+
+    // The FEC packet is in the same SSRC and sequence space of media.
+    pkt->header.set_ssrc(track_desc_->ssrc_);
+    pkt->header.set_payload_type(track_desc_->red_->pt_);
+    pkt->header.set_sequence(last_seq_ = last_seq_ + 1);
+    pkt->header.set_timestamp(last_ts_);
+    pkt->header.set_marker(false);
+    fec_seq_offset_++;
+
+    return true;
+}
+
 SrsRtcSSRCGenerator* SrsRtcSSRCGenerator::_instance = NULL;
 
 SrsRtcSSRCGenerator::SrsRtcSSRCGenerator()
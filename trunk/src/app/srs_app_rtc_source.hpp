@@ -78,6 +78,8 @@ private:
     srs_cond_t mw_wait;
     bool mw_waiting;
     int mw_min_msgs;
+    // Whether the player negotiated FEC, that is, the ULPFEC in RED, to consume the FEC packets.
+    bool fec_;
 private:
     // The callback for stream change event.
     ISrsRtcSourceChangeCallback* handler_;
@@ -96,6 +98,8 @@ public:
     virtual void wait(int nb_msgs);
 public:
     void set_handler(ISrsRtcSourceChangeCallback* h) { handler_ = h; } // SrsRtcConsumer::set_handler()
+    void set_fec(bool v) { fec_ = v; } // SrsRtcConsumer::set_fec()
+    bool fec() { return fec_; } // SrsRtcConsumer::fec()
     void on_stream_change(SrsRtcSourceDescription* desc);
 };
 
@@ -187,6 +191,13 @@ private:
     // The PLI for RTC2RTMP.
     srs_utime_t pli_for_rtmp_;
     srs_utime_t pli_elapsed_;
+private:
+    // The number of packets protected by a FEC packet, 0 to disable FEC.
+    int fec_group_;
+    // The FEC encoder for each video SSRC, generate FEC packets once for all consumers.
+    std::map<uint32_t, SrsRtpFecEncoder*> fec_encoders_;
+    // The RED encoder for audio, generate RED packets once for all consumers, NULL to disable RED.
+    SrsRtpRedEncoder* red_encoder_;
 public:
     SrsRtcSource();
     virtual ~SrsRtcSource();
@@ -235,6 +246,14 @@ public:
     void set_publish_stream(ISrsRtcPublishStream* v);
     // Consume the shared RTP packet, user must free it.
     srs_error_t on_rtp(SrsRtpPacket* pkt);
+private:
+    // Generate FEC packets for video, which is only delivered to consumers negotiated FEC.
+    srs_error_t on_fec(SrsRtpPacket* pkt);
+    // Whether any consumer negotiated FEC.
+    bool has_fec_consumer();
+    // Pack audio with previous packets as RED, which is only delivered to consumers.
+    srs_error_t on_red(SrsRtpPacket* pkt, SrsRtpPacket** pred);
+public:
     // Set and get stream description for souce
     bool has_stream_desc();
     void set_stream_desc(SrsRtcSourceDescription* stream_desc);
@@ -577,6 +596,9 @@ public:
 public:
     virtual srs_error_t on_rtp(SrsRtcSource* source, SrsRtpPacket* pkt);
     virtual srs_error_t check_send_nacks();
+    // Recover the lost packet by FEC and the received packets in NACK queue, write the RTP packet to buf.
+    // @remark Set the nn_buf to 0 if no packet recovered, because FEC only recovers one lost packet.
+    srs_error_t on_fec(SrsRtpPacket* pkt, char* buf, int* nn_buf);
 };
 
 // RTC jitter for TS or sequence number, only reset the base, and keep in original order.
@@ -712,14 +734,39 @@ public:
     virtual srs_error_t on_rtcp(SrsRtpPacket* pkt);
 };
 
+// The sent video packet, which maps the sequence of publisher to subscriber, for FEC.
+struct SrsRtcFecSentPacket
+{
+    bool valid_;
+    // The sequence of source, that is, the publisher.
+    uint16_t source_seq_;
+    // The sequence and timestamp of subscriber.
+    uint16_t seq_;
+    uint32_t ts_;
+};
+
 class SrsRtcVideoSendTrack : public SrsRtcSendTrack
 {
+private:
+    // The recent sent packets, indexed by source sequence, to build FEC for subscriber.
+    SrsRtcFecSentPacket* fec_sents_;
+    // The number of FEC packets sent, which are in the same sequence space of media.
+    uint16_t fec_seq_offset_;
+    // The last sequence and timestamp of subscriber.
+    uint16_t last_seq_;
+    uint32_t last_ts_;
 public:
     SrsRtcVideoSendTrack(SrsRtcConnection* session, SrsRtcTrackDescription* track_desc);
     virtual ~SrsRtcVideoSendTrack();
 public:
     virtual srs_error_t on_rtp(SrsRtpPacket* pkt);
     virtual srs_error_t on_rtcp(SrsRtpPacket* pkt);
+public:
+    // Whether subscriber negotiated FEC, that is, the ULPFEC in RED.
+    bool fec_enabled();
+private:
+    // Build the FEC packet for subscriber from the FEC of source, return false to drop it.
+    bool build_fec(SrsRtpPacket* pkt);
 };
 
 class SrsRtcSSRCGenerator
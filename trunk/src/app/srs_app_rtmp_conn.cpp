@@ -12,6 +12,7 @@
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
 using namespace std;
 
 #include <srs_kernel_error.hpp>
@@ -39,6 +40,7 @@ using namespace std;
 #include <srs_protocol_json.hpp>
 #include <srs_app_rtc_source.hpp>
 #include <srs_app_tencentcloud.hpp>
+#include <srs_app_delivery.hpp>
 
 // the timeout in srs_utime_t to wait encoder to republish
 // if timeout, close the connection.
@@ -88,6 +90,117 @@ SrsClientInfo::~SrsClientInfo()
     srs_freep(res);
 }
 
+// For adaptive mw, the min duration to wait, and the interval to sample.
+#define SRS_MW_ADAPTIVE_MIN_SLEEP (10 * SRS_UTIME_MILLISECONDS)
+#define SRS_MW_ADAPTIVE_INTERVAL (3 * SRS_UTIME_SECONDS)
+
+SrsMwAdaptive::SrsMwAdaptive(srs_utime_t latency)
+{
+    latency_ = sleep_ = latency;
+    starttime_ = 0;
+    send_bytes_ = 0;
+    outq_ = 0;
+    kbps_ = drain_kbps_ = 0;
+}
+
+SrsMwAdaptive::~SrsMwAdaptive()
+{
+}
+
+void SrsMwAdaptive::set_latency(srs_utime_t v)
+{
+    if (latency_ != v) {
+        latency_ = sleep_ = v;
+    }
+}
+
+bool SrsMwAdaptive::sample(srs_utime_t now, int64_t send_bytes, int outq)
+{
+    if (!starttime_) {
+        starttime_ = now;
+        send_bytes_ = send_bytes;
+        outq_ = outq;
+        return false;
+    }
+
+    srs_utime_t duration = now - starttime_;
+    if (duration < SRS_MW_ADAPTIVE_INTERVAL) {
+        return false;
+    }
+
+    // The bytes drained by socket, is the bytes sent plus the changed bytes in socket send buffer.
+    int64_t nn_sent = send_bytes - send_bytes_;
+    int64_t nn_drained = nn_sent + outq_ - outq;
+    kbps_ = (int)(nn_sent * 8 * SRS_UTIME_MILLISECONDS / duration);
+    drain_kbps_ = (int)(srs_max(0, nn_drained) * 8 * SRS_UTIME_MILLISECONDS / duration);
+
+    starttime_ = now;
+    send_bytes_ = send_bytes;
+    outq_ = outq;
+
+    // Wait for the time to got the min bytes, limited by the latency budget.
+    srs_utime_t sleep_v = latency_;
+    if (kbps_ > 0) {
+        srs_utime_t fill = (srs_utime_t)SRS_PERF_MW_MIN_BYTES * 8 * SRS_UTIME_MILLISECONDS / kbps_;
+        // For low bitrate, we never got the min bytes in budget, so the writev always send less bytes, then we
+        // decrease the wait by the ratio of bytes we got in budget, for example, 64kbps audio waits 60ms.
+        sleep_v = (fill <= latency_) ? fill : latency_ * latency_ / fill;
+        sleep_v = srs_max(sleep_v, SRS_MW_ADAPTIVE_MIN_SLEEP);
+        sleep_v = srs_min(sleep_v, latency_);
+    }
+
+    // When the socket send buffer does not drain, the player is slower than the stream, and the latency is
+    // dominated by the socket, so we merge more messages for each writev.
+    if (outq > SRS_PERF_MW_MIN_BYTES && drain_kbps_ < kbps_) {
+        sleep_v = latency_;
+    }
+
+    // Ignore the small changes, less than 20%.
+    srs_utime_t diff = srs_max(sleep_v, sleep_) - srs_min(sleep_v, sleep_);
+    if (diff > sleep_ / 5) {
+        sleep_ = sleep_v;
+    }
+
+    return true;
+}
+
+srs_utime_t SrsMwAdaptive::sleep()
+{
+    return sleep_;
+}
+
+int SrsMwAdaptive::bytes()
+{
+    return SRS_PERF_MW_MIN_BYTES;
+}
+
+int SrsMwAdaptive::kbps()
+{
+    return kbps_;
+}
+
+int SrsMwAdaptive::drain_kbps()
+{
+    return drain_kbps_;
+}
+
+int SrsMwAdaptive::outq()
+{
+    return outq_;
+}
+
+// Get the bytes in socket send buffer, which is not sent or not acked by peer.
+static int srs_get_send_queued(int fd)
+{
+    int v = 0;
+#ifdef TIOCOUTQ
+    if (ioctl(fd, TIOCOUTQ, &v) < 0) {
+        return 0;
+    }
+#endif
+    return v;
+}
+
 SrsRtmpConn::SrsRtmpConn(SrsServer* svr, srs_netfd_t c, string cip, int cport)
 {
     // Create a identify for this client.
@@ -128,8 +241,6 @@ SrsRtmpConn::SrsRtmpConn(SrsServer* svr, srs_netfd_t c, string cip, int cport)
 
     publish_1stpkt_timeout = 0;
     publish_normal_timeout = 0;
-    
-    _srs_config->subscribe(this);
 }
 
 SrsRtmpConn::~SrsRtmpConn()
@@ -442,7 +553,13 @@ srs_error_t SrsRtmpConn::service_cycle()
             return srs_error_wrap(err, "rtmp: thread quit");
         }
         
-        err = stream_service_cycle();
+        bool delivered = false;
+        err = stream_service_cycle(delivered);
+
+        // The connection is served by the delivery worker, so we should never use it.
+        if (err == srs_success && delivered) {
+            return err;
+        }
         
         // stream service must terminated with error, never success.
         // when terminated with success, it's user required to stop.
@@ -487,7 +604,7 @@ srs_error_t SrsRtmpConn::service_cycle()
     return err;
 }
 
-srs_error_t SrsRtmpConn::stream_service_cycle()
+srs_error_t SrsRtmpConn::stream_service_cycle(bool& delivered)
 {
     srs_error_t err = srs_success;
 
@@ -538,6 +655,9 @@ srs_error_t SrsRtmpConn::stream_service_cycle()
         return srs_error_wrap(err, "check vhost");
     }
 
+    // Only subscribe the reload of the connected vhost, which is resolved by check_vhost.
+    _srs_config->subscribe_vhost(req->vhost, this);
+
     srs_trace("connected stream, tcUrl=%s, pageUrl=%s, swfUrl=%s, schema=%s, vhost=%s, port=%d, app=%s, stream=%s, param=%s, args=%s",
         req->tcUrl.c_str(), req->pageUrl.c_str(), req->swfUrl.c_str(), req->schema.c_str(), req->vhost.c_str(), req->port,
         req->app.c_str(), req->stream.c_str(), req->param.c_str(), (req->args? "(obj)":"null"));
@@ -609,8 +729,12 @@ srs_error_t SrsRtmpConn::stream_service_cycle()
             span_main_->end();
 #endif
             
-            err = playing(source);
-            http_hooks_on_stop();
+            err = playing(source, delivered);
+
+            // The delivery worker fires on_stop when the player is gone.
+            if (!delivered) {
+                http_hooks_on_stop();
+            }
             
             return err;
         }
@@ -698,7 +822,7 @@ srs_error_t SrsRtmpConn::check_vhost(bool try_default_vhost)
     return err;
 }
 
-srs_error_t SrsRtmpConn::playing(SrsLiveSource* source)
+srs_error_t SrsRtmpConn::playing(SrsLiveSource* source, bool& delivered)
 {
     srs_error_t err = srs_success;
     
@@ -752,6 +876,19 @@ srs_error_t SrsRtmpConn::playing(SrsLiveSource* source)
     
     // Set the socket options for transport.
     set_sock_options();
+
+    // For mega stream, hand off the player to delivery worker, which serves it by a replica of stream.
+    if (_srs_delivery->hot(source, req)) {
+        int chunk_size = _srs_config->get_chunk_size(req->vhost);
+        string id = _srs_context->get_id().c_str();
+        if ((err = _srs_delivery->handoff(source, req, id, srs_netfd_fileno(stfd), chunk_size, info->res->stream_id)) != srs_success) {
+            return srs_error_wrap(err, "rtmp: delivery handoff");
+        }
+
+        delivered = true;
+        srs_trace("rtmp: player delivered by worker");
+        return err;
+    }
     
     // Create a consumer of source.
     SrsLiveConsumer* consumer = NULL;
@@ -811,8 +948,15 @@ srs_error_t SrsRtmpConn::do_playing(SrsLiveSource* source, SrsLiveConsumer* cons
     // initialize the send_min_interval
     send_min_interval = _srs_config->get_send_min_interval(req->vhost);
     
-    srs_trace("start play smi=%dms, mw_sleep=%d, mw_msgs=%d, realtime=%d, tcp_nodelay=%d",
-        srsu2msi(send_min_interval), srsu2msi(mw_sleep), mw_msgs, realtime, tcp_nodelay);
+    // the adaptive mw, the mw_sleep is the latency budget, disabled for realtime which never wait.
+    SrsMwAdaptive* amw = NULL;
+    if (!realtime && _srs_config->get_mw_adaptive(req->vhost)) {
+        amw = new SrsMwAdaptive(mw_sleep);
+    }
+    SrsAutoFree(SrsMwAdaptive, amw);
+    
+    srs_trace("start play smi=%dms, mw_sleep=%d, mw_msgs=%d, realtime=%d, tcp_nodelay=%d, mw_adaptive=%d",
+        srsu2msi(send_min_interval), srsu2msi(mw_sleep), mw_msgs, realtime, tcp_nodelay, (amw != NULL));
 
 #ifdef SRS_APM
     ISrsApmSpan* span = _srs_apm->span("play-cycle")->set_kind(SrsApmKindProducer)->as_child(span_client_)
@@ -845,7 +989,11 @@ srs_error_t SrsRtmpConn::do_playing(SrsLiveSource* source, SrsLiveConsumer* cons
 #ifdef SRS_PERF_QUEUE_COND_WAIT
         // wait for message to incoming.
         // @see https://github.com/ossrs/srs/issues/257
-        consumer->wait(mw_msgs, mw_sleep);
+        if (amw) {
+            consumer->wait(0, amw->sleep(), amw->bytes());
+        } else {
+            consumer->wait(mw_msgs, mw_sleep);
+        }
 #endif
         
         // get messages from consumer.
@@ -861,7 +1009,8 @@ srs_error_t SrsRtmpConn::do_playing(SrsLiveSource* source, SrsLiveConsumer* cons
             kbps->sample();
             srs_trace("-> " SRS_CONSTS_LOG_PLAY " time=%d, msgs=%d, okbps=%d,%d,%d, ikbps=%d,%d,%d, mw=%d/%d",
                 (int)pprint->age(), count, kbps->get_send_kbps(), kbps->get_send_kbps_30s(), kbps->get_send_kbps_5m(),
-                kbps->get_recv_kbps(), kbps->get_recv_kbps_30s(), kbps->get_recv_kbps_5m(), srsu2msi(mw_sleep), mw_msgs);
+                kbps->get_recv_kbps(), kbps->get_recv_kbps_30s(), kbps->get_recv_kbps_5m(),
+                srsu2msi(amw ? amw->sleep() : mw_sleep), mw_msgs);
 
 #ifdef SRS_APM
             // TODO: Do not use pithy print for frame span.
@@ -900,6 +1049,16 @@ srs_error_t SrsRtmpConn::do_playing(SrsLiveSource* source, SrsLiveConsumer* cons
         if (count > 0 && (err = rtmp->send_and_free_messages(msgs.msgs, count, info->res->stream_id)) != srs_success) {
             return srs_error_wrap(err, "rtmp: send %d messages", count);
         }
+
+        // sample the bitrate and socket send buffer, for adaptive mw.
+        if (amw) {
+            amw->set_latency(mw_sleep);
+            if (amw->sample(srs_get_system_time(), skt->get_send_bytes(), srs_get_send_queued(srs_netfd_fileno(stfd)))) {
+                SrsStatistic* stat = SrsStatistic::instance();
+                stat->on_client_mw(_srs_context->get_id().c_str(), amw->sleep(), amw->bytes(), amw->kbps(),
+                    amw->drain_kbps(), amw->outq());
+            }
+        }
         
         // if duration specified, and exceed it, stop play live.
         // @see: https://github.com/ossrs/srs/issues/45
@@ -1598,7 +1757,10 @@ srs_error_t SrsRtmpConn::cycle()
     // Update statistic when done.
     SrsStatistic* stat = SrsStatistic::instance();
     stat->kbps_add_delta(get_id().c_str(), delta_);
-    stat->on_disconnect(get_id().c_str(), err);
+    // The player delivered by worker is kept in stat, util the worker reports it's gone.
+    if (!_srs_delivery->delivered(get_id().c_str())) {
+        stat->on_disconnect(get_id().c_str(), err);
+    }
 
     // Notify manager to remove it.
     // Note that we create this object, so we use manager to remove it.
@@ -67,6 +67,40 @@ public:
     virtual ~SrsClientInfo();
 };
 
+// The adaptive merged-write for RTMP player, which samples the bitrate of player and the drain rate of socket
+// send buffer, to choose the duration and bytes to wait for SrsLiveConsumer::wait.
+class SrsMwAdaptive
+{
+private:
+    // The budget of added latency, the mw_latency.
+    srs_utime_t latency_;
+    // The chosen duration to wait.
+    srs_utime_t sleep_;
+    // The last sample, the total bytes sent and the bytes in socket send buffer.
+    srs_utime_t starttime_;
+    int64_t send_bytes_;
+    int outq_;
+    // The sampled bitrate of player, and the bitrate drained by socket.
+    int kbps_;
+    int drain_kbps_;
+public:
+    SrsMwAdaptive(srs_utime_t latency);
+    virtual ~SrsMwAdaptive();
+public:
+    // Update the latency budget, for reload.
+    virtual void set_latency(srs_utime_t v);
+    // Sample by the total bytes sent, and the bytes in socket send buffer not sent yet.
+    // @return Whether got a new sample, and the wait maybe updated.
+    virtual bool sample(srs_utime_t now, int64_t send_bytes, int outq);
+public:
+    // The duration and bytes to wait.
+    virtual srs_utime_t sleep();
+    virtual int bytes();
+    virtual int kbps();
+    virtual int drain_kbps();
+    virtual int outq();
+};
+
 // The client provides the main logic control for RTMP clients.
 class SrsRtmpConn : public ISrsConnection, public ISrsStartable, public ISrsReloadHandler
     , public ISrsCoroutineHandler, public ISrsExpire
@@ -143,9 +177,10 @@ private:
     // When valid and connected to vhost/app, service the client.
     virtual srs_error_t service_cycle();
     // The stream(play/publish) service cycle, identify client first.
-    virtual srs_error_t stream_service_cycle();
+    // @param delivered Whether the player is handed off to the delivery worker, which owns the connection.
+    virtual srs_error_t stream_service_cycle(bool& delivered);
     virtual srs_error_t check_vhost(bool try_default_vhost);
-    virtual srs_error_t playing(SrsLiveSource* source);
+    virtual srs_error_t playing(SrsLiveSource* source, bool& delivered);
     virtual srs_error_t do_playing(SrsLiveSource* source, SrsLiveConsumer* consumer, SrsQueueRecvThread* trd);
     virtual srs_error_t publishing(SrsLiveSource* source);
     virtual srs_error_t do_publishing(SrsLiveSource* source, SrsPublishRecvThread* trd);
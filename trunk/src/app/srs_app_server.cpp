@@ -37,6 +37,7 @@ using namespace std;
 #include <srs_protocol_log.hpp>
 #include <srs_app_latest_version.hpp>
 #include <srs_app_conn.hpp>
+#include <srs_app_delivery.hpp>
 #ifdef SRS_RTC
 #include <srs_app_rtc_network.hpp>
 #endif
@@ -748,6 +749,9 @@ srs_error_t SrsServer::http_handle()
     if ((err = http_api_mux->handle("/api/v1/clusters", new SrsGoApiClusters())) != srs_success) {
         return srs_error_wrap(err, "handle clusters");
     }
+    if ((err = http_api_mux->handle("/api/v1/heartbeats", new SrsGoApiHeartbeats())) != srs_success) {
+        return srs_error_wrap(err, "handle heartbeats");
+    }
     
     // test the request info.
     if ((err = http_api_mux->handle("/api/v1/tests/requests", new SrsGoApiRequests())) != srs_success) {
@@ -993,10 +997,14 @@ srs_error_t SrsServer::do_cycle()
             signal_reload = false;
             srs_info("get signal to reload the config.");
 
+            srs_utime_t starttime = srs_update_system_time();
             if ((err = _srs_config->reload()) != srs_success) {
                 return srs_error_wrap(err, "config reload");
             }
-            srs_trace("reload config success.");
+
+            srs_utime_t duration = srs_update_system_time() - starttime;
+            SrsStatistic::instance()->on_config_reload(duration);
+            srs_trace("reload config success, cost=%dms.", srsu2msi(duration));
         }
 
         srs_usleep(1 * SRS_UTIME_SECONDS);
@@ -1342,6 +1350,10 @@ srs_error_t SrsServerAdapter::run(SrsWaitGroup* wg)
         return srs_error_wrap(err, "start");
     }
 
+    if ((err = _srs_delivery->initialize()) != srs_success) {
+        return srs_error_wrap(err, "delivery initialize");
+    }
+
 #ifdef SRS_GB28181
     if ((err = _srs_gb_manager->start()) != srs_success) {
         return srs_error_wrap(err, "start manager");
@@ -418,6 +418,8 @@ SrsLiveConsumer::SrsLiveConsumer(SrsLiveSource* s)
     mw_min_msgs = 0;
     mw_duration = 0;
     mw_waiting = false;
+    mw_min_bytes = 0;
+    mw_bytes = 0;
 #endif
 }
 
@@ -459,6 +461,10 @@ srs_error_t SrsLiveConsumer::enqueue(SrsSharedPtrMessage* shared_msg, bool atc,
         }
     }
 
+#ifdef SRS_PERF_QUEUE_COND_WAIT
+    mw_bytes += msg->size;
+#endif
+
     if ((err = queue->enqueue(msg, NULL)) != srs_success) {
         return srs_error_wrap(err, "enqueue message");
     }
@@ -466,21 +472,17 @@ srs_error_t SrsLiveConsumer::enqueue(SrsSharedPtrMessage* shared_msg, bool atc,
 #ifdef SRS_PERF_QUEUE_COND_WAIT
     // fire the mw when msgs is enough.
     if (mw_waiting) {
-        // For RTMP, we wait for messages and duration.
-        srs_utime_t duration = queue->duration();
-        bool match_min_msgs = queue->size() > mw_min_msgs;
-        
         // For ATC, maybe the SH timestamp bigger than A/V packet,
         // when encoder republish or overflow.
         // @see https://github.com/ossrs/srs/pull/749
-        if (atc && duration < 0) {
+        if (atc && queue->duration() < 0) {
             srs_cond_signal(mw_wait);
             mw_waiting = false;
             return err;
         }
         
-        // when duration ok, signal to flush.
-        if (match_min_msgs && duration > mw_duration) {
+        // when duration or bytes ok, signal to flush.
+        if (mw_ready()) {
             srs_cond_signal(mw_wait);
             mw_waiting = false;
             return err;
@@ -519,12 +521,22 @@ srs_error_t SrsLiveConsumer::dump_packets(SrsMessageArray* msgs, int& count)
     if ((err = queue->dump_packets(max, msgs->msgs, count)) != srs_success) {
         return srs_error_wrap(err, "dump packets");
     }
+
+#ifdef SRS_PERF_QUEUE_COND_WAIT
+    // the bytes left in queue, reset when empty, because the queue maybe shrinked.
+    for (int i = 0; i < count; i++) {
+        mw_bytes -= msgs->msgs[i]->size;
+    }
+    if (mw_bytes < 0 || queue->size() == 0) {
+        mw_bytes = 0;
+    }
+#endif
     
     return err;
 }
 
 #ifdef SRS_PERF_QUEUE_COND_WAIT
-void SrsLiveConsumer::wait(int nb_msgs, srs_utime_t msgs_duration)
+void SrsLiveConsumer::wait(int nb_msgs, srs_utime_t msgs_duration, int nb_bytes)
 {
     if (paused) {
         srs_usleep(SRS_CONSTS_RTMP_PULSE);
@@ -533,12 +545,10 @@ void SrsLiveConsumer::wait(int nb_msgs, srs_utime_t msgs_duration)
     
     mw_min_msgs = nb_msgs;
     mw_duration = msgs_duration;
+    mw_min_bytes = nb_bytes;
     
-    srs_utime_t duration = queue->duration();
-    bool match_min_msgs = queue->size() > mw_min_msgs;
-    
-    // when duration ok, signal to flush.
-    if (match_min_msgs && duration > mw_duration) {
+    // when duration or bytes ok, signal to flush.
+    if (mw_ready()) {
         return;
     }
     
@@ -548,6 +558,19 @@ void SrsLiveConsumer::wait(int nb_msgs, srs_utime_t msgs_duration)
     // use cond block wait for high performance mode.
     srs_cond_wait(mw_wait);
 }
+
+bool SrsLiveConsumer::mw_ready()
+{
+    // For RTMP, we wait for messages and duration.
+    srs_utime_t duration = queue->duration();
+    bool match_min_msgs = queue->size() > mw_min_msgs;
+    if (match_min_msgs && duration > mw_duration) {
+        return true;
+    }
+
+    // For adaptive mw, flush when got enough bytes, for example, the large key frame.
+    return mw_min_bytes > 0 && mw_bytes >= mw_min_bytes;
+}
 #endif
 
 srs_error_t SrsLiveConsumer::on_play_client_pause(bool is_pause)
@@ -834,8 +857,6 @@ SrsOriginHub::SrsOriginHub()
     hds = new SrsHds();
 #endif
     ng_exec = new SrsNgExec();
-    
-    _srs_config->subscribe(this);
 }
 
 SrsOriginHub::~SrsOriginHub()
@@ -867,6 +888,9 @@ srs_error_t SrsOriginHub::initialize(SrsLiveSource* s, SrsRequest* r)
     
     req_ = r;
     source = s;
+
+    // Only care about the reload of vhost of stream.
+    _srs_config->subscribe_vhost(req_->vhost, this);
     
     if ((err = hls->initialize(this, req_)) != srs_success) {
         return srs_error_wrap(err, "hls initialize");
@@ -1928,6 +1952,7 @@ SrsLiveSource::SrsLiveSource()
     _can_publish = true;
     stream_die_at_ = 0;
     publisher_idle_at_ = 0;
+    nn_bridge_players_ = 0;
 
     handler = NULL;
     bridge_ = NULL;
@@ -1942,7 +1967,6 @@ SrsLiveSource::SrsLiveSource()
     is_monotonically_increase = false;
     last_packet_time = 0;
     
-    _srs_config->subscribe(this);
     atc = false;
 }
 
@@ -1997,7 +2021,7 @@ bool SrsLiveSource::stream_is_dead()
     }
     
     // has any consumers?
-    if (!consumers.empty()) {
+    if (!consumers.empty() || nn_bridge_players_ > 0) {
         return false;
     }
     
@@ -2033,6 +2057,9 @@ srs_error_t SrsLiveSource::initialize(SrsRequest* r, ISrsLiveSourceHandler* h)
     req = r->copy();
     atc = _srs_config->get_atc(req->vhost);
 
+    // Only care about the reload of vhost of stream.
+    _srs_config->subscribe_vhost(req->vhost, this);
+
     if ((err = format_->initialize()) != srs_success) {
         return srs_error_wrap(err, "format initialize");
     }
@@ -2066,6 +2093,38 @@ void SrsLiveSource::set_bridge(ISrsLiveSourceBridge* v)
     bridge_ = v;
 }
 
+srs_error_t SrsLiveSource::attach_bridge(ISrsLiveSourceBridge* v)
+{
+    srs_error_t err = srs_success;
+
+    set_bridge(v);
+
+    // Not publishing, the bridge will be notified by on_publish.
+    if (_can_publish) {
+        return err;
+    }
+
+    if ((err = bridge_->on_publish()) != srs_success) {
+        srs_freep(bridge_);
+        return srs_error_wrap(err, "bridge publish");
+    }
+
+    // The sequence headers are required to decode the following frames.
+    if (meta->ash() && (err = bridge_->on_audio(meta->ash())) != srs_success) {
+        return srs_error_wrap(err, "bridge audio sh");
+    }
+    if (meta->vsh() && (err = bridge_->on_video(meta->vsh())) != srs_success) {
+        return srs_error_wrap(err, "bridge video sh");
+    }
+
+    return err;
+}
+
+bool SrsLiveSource::has_bridge()
+{
+    return bridge_ != NULL;
+}
+
 srs_error_t SrsLiveSource::on_reload_vhost_play(string vhost)
 {
     srs_error_t err = srs_success;
@@ -2776,7 +2835,7 @@ void SrsLiveSource::on_consumer_destroy(SrsLiveConsumer* consumer)
         it = consumers.erase(it);
     }
 
-    if (consumers.empty()) {
+    if (consumers.empty() && !nn_bridge_players_) {
         play_edge->on_all_client_stop();
 
         // For edge server, the stream die when the last player quit, because the edge stream is created by player
@@ -2790,6 +2849,51 @@ void SrsLiveSource::on_consumer_destroy(SrsLiveConsumer* consumer)
     }
 }
 
+int SrsLiveSource::nb_consumers()
+{
+    return (int)consumers.size();
+}
+
+srs_error_t SrsLiveSource::on_bridge_play()
+{
+    srs_error_t err = srs_success;
+
+    nn_bridge_players_++;
+
+    stream_die_at_ = 0;
+    publisher_idle_at_ = 0;
+
+    // For edge, start to pull stream for the first client, shared with RTMP and FLV players.
+    if (_srs_config->get_vhost_is_edge(req->vhost)) {
+        if ((err = play_edge->on_bridge_play()) != srs_success) {
+            return srs_error_wrap(err, "play edge");
+        }
+    }
+
+    return err;
+}
+
+void SrsLiveSource::on_bridge_stop()
+{
+    nn_bridge_players_--;
+    srs_assert(nn_bridge_players_ >= 0);
+
+    if (consumers.empty() && !nn_bridge_players_) {
+        play_edge->on_all_client_stop();
+
+        if (_srs_config->get_vhost_is_edge(req->vhost)) {
+            stream_die_at_ = srs_get_system_time();
+        }
+
+        publisher_idle_at_ = srs_get_system_time();
+    }
+}
+
+int SrsLiveSource::nb_bridge_players()
+{
+    return nn_bridge_players_;
+}
+
 void SrsLiveSource::set_cache(bool enabled)
 {
     gop_cache->set(enabled);
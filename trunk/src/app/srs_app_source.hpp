@@ -180,6 +180,9 @@ private:
     bool mw_waiting;
     int mw_min_msgs;
     srs_utime_t mw_duration;
+    // The bytes to wait, and the bytes in queue, 0 to ignore.
+    int mw_min_bytes;
+    int64_t mw_bytes;
 #endif
 public:
     SrsLiveConsumer(SrsLiveSource* s);
@@ -206,8 +209,13 @@ public:
     // wait for messages incomming, atleast nb_msgs and in duration.
     // @param nb_msgs the messages count to wait.
     // @param msgs_duration the messages duration to wait.
-    virtual void wait(int nb_msgs, srs_utime_t msgs_duration);
+    // @param nb_bytes the messages bytes to wait, ignore if 0, or wakeup when got bytes even the duration is not ok.
+    virtual void wait(int nb_msgs, srs_utime_t msgs_duration, int nb_bytes = 0);
+private:
+    // Whether the messages in queue is ok to flush, match the msgs and duration, or the bytes.
+    virtual bool mw_ready();
 #endif
+public:
     // when client send the pause message.
     virtual srs_error_t on_play_client_pause(bool is_pause);
 // Interface ISrsWakable
@@ -500,6 +508,9 @@ private:
     SrsRequest* req;
     // To delivery stream to clients.
     std::vector<SrsLiveConsumer*> consumers;
+    // For edge, the players of other protocols, such as RTC, which consume the stream by bridge, so they
+    // share the same upstream pull with the consumers.
+    int nn_bridge_players_;
     // The time jitter algorithm for vhost.
     SrsRtmpJitterAlgorithm jitter_algorithm;
     // For play, whether use interlaced/mixed algorithm to correct timestamp.
@@ -552,6 +563,11 @@ public:
     virtual srs_error_t initialize(SrsRequest* r, ISrsLiveSourceHandler* h);
     // Bridge to other source, forward packets to it.
     void set_bridge(ISrsLiveSourceBridge* v);
+    // Bridge to other source, which might be publishing, for example, the first RTC player of edge, so
+    // the bridge is notified to publish and fed with the sequence headers.
+    virtual srs_error_t attach_bridge(ISrsLiveSourceBridge* v);
+    // Whether bridged to other source.
+    virtual bool has_bridge();
 // Interface ISrsReloadHandler
 public:
     virtual srs_error_t on_reload_vhost_play(std::string vhost);
@@ -596,6 +612,13 @@ public:
     // @param dg, whether dumps the gop cache.
     virtual srs_error_t consumer_dumps(SrsLiveConsumer* consumer, bool ds = true, bool dm = true, bool dg = true);
     virtual void on_consumer_destroy(SrsLiveConsumer* consumer);
+    // Get the number of consumers, that is, the players in ST thread.
+    virtual int nb_consumers();
+    // For edge, when the player of other protocol starts or stops, to pull the stream from origin.
+    virtual srs_error_t on_bridge_play();
+    virtual void on_bridge_stop();
+    // The number of players of other protocols, see on_bridge_play.
+    virtual int nb_bridge_players();
     virtual void set_cache(bool enabled);
     virtual void set_gop_cache_max_frames(int v);
     virtual SrsRtmpJitterAlgorithm jitter();
@@ -13,7 +13,15 @@ using namespace std;
 #include <srs_protocol_log.hpp>
 #include <srs_app_config.hpp>
 #include <srs_app_srt_conn.hpp>
+#include <srs_app_srt_source.hpp>
 #include <srs_app_statistic.hpp>
+#include <srs_app_threads.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// The timeout for the poller thread to wait for SRT events, then check whether to quit.
+#define SRS_SRT_PROBE_TIMEOUT (100 * SRS_UTIME_MILLISECONDS)
 
 #ifdef SRS_SRT
 SrsSrtEventLoop* _srt_eventloop = NULL;
@@ -345,6 +353,10 @@ srs_error_t SrsSrtServerAdapter::initialize()
         return srs_error_wrap(err, "srt poller start");
     }
 
+    if ((err = _srs_srt_demuxers->initialize()) != srs_success) {
+        return srs_error_wrap(err, "srt demuxers initialize");
+    }
+
     return err;
 }
 
@@ -377,12 +389,66 @@ SrsSrtEventLoop::SrsSrtEventLoop()
 {
     srt_poller_ = NULL;
     trd_ = NULL;
+
+    ready_pipe_[0] = ready_pipe_[1] = -1;
+    wake_pipe_[0] = wake_pipe_[1] = -1;
+    wake_fd_ = NULL;
+
+    lock_ = new SrsThreadMutex();
+    quit_ = false;
+    running_ = false;
 }
 
 SrsSrtEventLoop::~SrsSrtEventLoop()
 {
+    // Stop the ST coroutine first, which reads the wake pipe.
     srs_freep(trd_);
+
+    // The poller thread uses the poller, so we must wait for it to quit before free the poller.
+    stop_poller();
+
+    srs_close_stfd(wake_fd_);
+    int fds[] = {ready_pipe_[0], wake_pipe_[1]};
+    for (int i = 0; i < (int)(sizeof(fds) / sizeof(int)); i++) {
+        if (fds[i] >= 0) {
+            ::close(fds[i]);
+        }
+    }
+
     srs_freep(srt_poller_);
+    srs_freep(lock_);
+}
+
+void SrsSrtEventLoop::stop_poller()
+{
+    if (true) {
+        SrsThreadLocker(lock_);
+        quit_ = true;
+    }
+
+    // Wake up the thread which waits for the coroutine, by EOF of pipe, see do_poll.
+    if (ready_pipe_[1] >= 0) {
+        ::close(ready_pipe_[1]);
+        ready_pipe_[1] = -1;
+    }
+
+    // Wait for the thread to quit. Note that the thread is detached by thread pool, and it checks the quit flag
+    // every SRS_SRT_PROBE_TIMEOUT when waiting for the SRT events, so we check whether it's running.
+    while (true) {
+        if (true) {
+            SrsThreadLocker(lock_);
+            if (!running_) {
+                break;
+            }
+        }
+        ::usleep(10 * 1000);
+    }
+}
+
+bool SrsSrtEventLoop::quit()
+{
+    SrsThreadLocker(lock_);
+    return quit_;
 }
 
 srs_error_t SrsSrtEventLoop::initialize()
@@ -395,6 +461,34 @@ srs_error_t SrsSrtEventLoop::initialize()
         return srs_error_wrap(err, "srt poller initialize");
     }
 
+    if (!_srs_config->get_srt_poller_thread()) {
+        srs_trace("SRT: Poll events by sleep in coroutine");
+        return err;
+    }
+
+    if (::pipe(ready_pipe_) < 0 || ::pipe(wake_pipe_) < 0) {
+        return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "create pipe");
+    }
+
+    // Never block the ST thread when notify the poller thread.
+    int flags = fcntl(ready_pipe_[1], F_GETFL, 0);
+    if (flags == -1 || fcntl(ready_pipe_[1], F_SETFL, flags | O_NONBLOCK) == -1) {
+        return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "nonblock pipe fd=%d", ready_pipe_[1]);
+    }
+
+    if ((wake_fd_ = srs_netfd_open(wake_pipe_[0])) == NULL) {
+        return srs_error_new(ERROR_ST_OPEN_SOCKET, "open pipe fd=%d", wake_pipe_[0]);
+    }
+
+    // Mark it running before the thread starts, so we are able to wait for it even if it's not scheduled.
+    running_ = true;
+    if ((err = _srs_thread_pool->execute("srt", SrsSrtEventLoop::start_poller, this)) != srs_success) {
+        running_ = false;
+        return srs_error_wrap(err, "start poller thread");
+    }
+
+    srs_trace("SRT: Poll events in thread");
+
     return err;
 }
 
@@ -411,6 +505,14 @@ srs_error_t SrsSrtEventLoop::start()
 }
 
 srs_error_t SrsSrtEventLoop::cycle()
+{
+    if (wake_fd_) {
+        return do_cycle_thread();
+    }
+    return do_cycle_sleep();
+}
+
+srs_error_t SrsSrtEventLoop::do_cycle_sleep()
 {
     srs_error_t err = srs_success;
 
@@ -437,3 +539,83 @@ srs_error_t SrsSrtEventLoop::cycle()
     return err;
 }
 
+srs_error_t SrsSrtEventLoop::do_cycle_thread()
+{
+    srs_error_t err = srs_success;
+
+    while (true) {
+        if ((err = trd_->pull()) != srs_success) {
+            return srs_error_wrap(err, "srt listener");
+        }
+
+        // Let the poller thread to wait for the SRT events.
+        char c = 0;
+        if (::write(ready_pipe_[1], &c, 1) <= 0) {
+            return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "write pipe fd=%d", ready_pipe_[1]);
+        }
+
+        // Block the coroutine until the SRT events fired, other coroutines are able to run.
+        char buf[128];
+        ssize_t nn = srs_read(wake_fd_, buf, sizeof(buf), SRS_UTIME_NO_TIMEOUT);
+        if (nn <= 0) {
+            return srs_error_new(ERROR_SOCKET_READ, "read pipe, nn=%d", (int)nn);
+        }
+
+        // Notify the fired SRT sockets, always use timeout(0) because the events are ready.
+        int n_fds = 0;
+        if ((err = srt_poller_->wait(0, &n_fds)) != srs_success) {
+            srs_warn("srt poll wait failed, n_fds=%d, err=%s", n_fds, srs_error_desc(err).c_str());
+            srs_error_reset(err);
+
+            // Avoid the busy loop for error.
+            srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+            continue;
+        }
+
+        // Switch to the notified coroutines to consume the events, before the poller thread waits again, or the
+        // events which are level triggered will wake up us again. If only the errors which are already notified,
+        // it's level triggered until the socket is closed, so we wait for a while like the sleep mode.
+        srs_usleep(n_fds ? 0 : 10 * SRS_UTIME_MILLISECONDS);
+    }
+
+    return err;
+}
+
+srs_error_t SrsSrtEventLoop::start_poller(void* arg)
+{
+    SrsSrtEventLoop* loop = (SrsSrtEventLoop*)arg;
+    loop->do_poll();
+    return srs_success;
+}
+
+void SrsSrtEventLoop::do_poll()
+{
+    while (!quit()) {
+        // Block the thread until the coroutine is ready to handle the events, or the pipe is closed to quit.
+        char c = 0;
+        if (::read(ready_pipe_[0], &c, 1) <= 0) {
+            continue;
+        }
+
+        // Block the thread until any SRT socket fired, the libsrt wakes up it when packets arrive. Because the SRT
+        // epoll is not able to be woken up by other fds, we wait with timeout to check the quit flag. Note that we
+        // should never write log in this thread, the error is logged by the coroutine.
+        int n_fds = 0;
+        while (n_fds == 0 && !quit()) {
+            srs_error_t err = srt_poller_->probe(srsu2msi(SRS_SRT_PROBE_TIMEOUT), &n_fds);
+            if (err != srs_success) {
+                srs_freep(err);
+                break;
+            }
+        }
+
+        // Wake up the coroutine to notify the fired sockets.
+        if (::write(wake_pipe_[1], &c, 1) <= 0) {
+            continue;
+        }
+    }
+
+    // Never touch this object after the thread is not running, because it might be freed.
+    SrsThreadLocker(lock_);
+    running_ = false;
+}
@@ -15,6 +15,7 @@
 
 class SrsSrtServer;
 class SrsHourGlass;
+class SrsThreadMutex;
 
 // A common srt acceptor, for SRT server.
 class SrsSrtAcceptor : public ISrsSrtHandler
@@ -93,6 +94,10 @@ public:
 };
 
 // Start a coroutine to drive the SRT events with state-threads.
+//
+// Because the SRT epoll is not able to wake up ST, a dedicated thread waits for the SRT events, then wakes up
+// the coroutine by a pipe, which notifies the fired sockets. If the thread is disabled, the coroutine polls the
+// SRT events and sleeps 1~10ms to switch to other coroutines.
 class SrsSrtEventLoop : public ISrsCoroutineHandler
 {
 public:
@@ -106,9 +111,28 @@ public:
 // Interface ISrsCoroutineHandler.
 public:
     virtual srs_error_t cycle();
+private:
+    srs_error_t do_cycle_sleep();
+    srs_error_t do_cycle_thread();
+private:
+    // The entry of poller thread.
+    static srs_error_t start_poller(void* arg);
+    void do_poll();
+    // Notify the poller thread to quit, and wait for it to quit.
+    void stop_poller();
+    bool quit();
 private:
     ISrsSrtPoller* srt_poller_;
     SrsCoroutine* trd_;
+    // The coroutine writes to ready pipe when ready to handle events, and the poller thread writes to wake pipe
+    // when events fired, so there is at most one wake up for each round.
+    int ready_pipe_[2];
+    int wake_pipe_[2];
+    srs_netfd_t wake_fd_;
+    // Whether the poller thread should quit, and whether it's running, protected by lock.
+    SrsThreadMutex* lock_;
+    bool quit_;
+    bool running_;
 };
 
 // SrsSrtEventLoop is global singleton instance.
@@ -6,6 +6,8 @@
 
 #include <srs_app_srt_source.hpp>
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <algorithm>
 using namespace std;
 
@@ -19,6 +21,9 @@ using namespace std;
 #include <srs_app_source.hpp>
 #include <srs_app_statistic.hpp>
 #include <srs_app_pithy_print.hpp>
+#include <srs_app_config.hpp>
+#include <srs_app_threads.hpp>
+#include <srs_protocol_log.hpp>
 
 SrsSrtPacket::SrsSrtPacket()
 {
@@ -258,10 +263,17 @@ SrsRtmpFromSrtBridge::SrsRtmpFromSrtBridge(SrsLiveSource* source) : ISrsSrtSourc
     audio_streamid_ = 2;
 
     pp_audio_duration_ = new SrsAlonePithyPrint();
+
+    demux_id_ = 0;
+    frames_ = NULL;
 }
 
 SrsRtmpFromSrtBridge::~SrsRtmpFromSrtBridge()
 {
+    if (demux_id_) {
+        _srs_srt_demuxers->unsubscribe(demux_id_);
+    }
+
     srs_freep(ts_ctx_);
     srs_freep(req_);
 
@@ -283,6 +295,15 @@ srs_error_t SrsRtmpFromSrtBridge::on_packet(SrsSrtPacket *pkt)
 {
     srs_error_t err = srs_success;
 
+    // Demux in worker thread, the frames are delivered to live source by on_frame in ST thread.
+    if (_srs_srt_demuxers->enabled()) {
+        if (!demux_id_) {
+            demux_id_ = _srs_srt_demuxers->subscribe(this);
+        }
+        _srs_srt_demuxers->submit(demux_id_, pkt->data(), pkt->size());
+        return err;
+    }
+
     char* buf = pkt->data();
     int nb_buf = pkt->size();
 
@@ -308,6 +329,12 @@ srs_error_t SrsRtmpFromSrtBridge::on_packet(SrsSrtPacket *pkt)
 
 void SrsRtmpFromSrtBridge::on_unpublish()
 {
+    // Drop the frames in worker, and reset the demuxer for next publish.
+    if (demux_id_) {
+        _srs_srt_demuxers->unsubscribe(demux_id_);
+        demux_id_ = 0;
+    }
+
     live_source_->on_unpublish();
 }
 
@@ -321,6 +348,46 @@ srs_error_t SrsRtmpFromSrtBridge::initialize(SrsRequest* req)
     return err;
 }
 
+void SrsRtmpFromSrtBridge::demux(SrsSrtDemuxJob* job)
+{
+    frames_ = &job->frames_;
+
+    int nb_packet = job->size_ / SRS_TS_PACKET_SIZE;
+    for (int i = 0; i < nb_packet; i++) {
+        SrsBuffer stream(job->data_ + (i * SRS_TS_PACKET_SIZE), SRS_TS_PACKET_SIZE);
+
+        // Never log in worker thread, so we collect the error for ST thread.
+        srs_error_t err = ts_ctx_->decode(&stream, this);
+        if (err != srs_success) {
+            job->nb_errors_++;
+            job->error_ = srs_error_desc(err);
+            srs_freep(err);
+        }
+    }
+
+    frames_ = NULL;
+}
+
+srs_error_t SrsRtmpFromSrtBridge::on_frame(SrsCommonMessage* msg)
+{
+    // In worker thread, take the payload of message, which is delivered to live source in ST thread.
+    if (frames_) {
+        SrsCommonMessage* frame = new SrsCommonMessage();
+        frame->header = msg->header;
+        frame->size = msg->size;
+        frame->payload = msg->payload;
+        msg->payload = NULL;
+        msg->size = 0;
+        frames_->push_back(frame);
+        return srs_success;
+    }
+
+    if (msg->header.is_video()) {
+        return live_source_->on_video(msg);
+    }
+    return live_source_->on_audio(msg);
+}
+
 srs_error_t SrsRtmpFromSrtBridge::on_ts_message(SrsTsMessage* msg)
 {
     srs_error_t err = srs_success;
@@ -470,7 +537,7 @@ srs_error_t SrsRtmpFromSrtBridge::check_sps_pps_change(SrsTsMessage* msg)
         return srs_error_wrap(err, "create rtmp");
     }
 
-    if ((err = live_source_->on_video(&rtmp)) != srs_success) {
+    if ((err = on_frame(&rtmp)) != srs_success) {
         return srs_error_wrap(err, "srt to rtmp sps/pps");
     }
 
@@ -526,7 +593,7 @@ srs_error_t SrsRtmpFromSrtBridge::on_h264_frame(SrsTsMessage* msg, vector<pair<c
         payload.write_bytes(nal, nal_size);
     }
 
-    if ((err = live_source_->on_video(&rtmp)) != srs_success) {
+    if ((err = on_frame(&rtmp)) != srs_success) {
         return srs_error_wrap(err ,"srt ts video to rtmp");
     }
 
@@ -650,7 +717,7 @@ srs_error_t SrsRtmpFromSrtBridge::check_vps_sps_pps_change(SrsTsMessage* msg)
         return srs_error_wrap(err, "create rtmp");
     }
 
-    if ((err = live_source_->on_video(&rtmp)) != srs_success) {
+    if ((err = on_frame(&rtmp)) != srs_success) {
         return srs_error_wrap(err, "srt to rtmp vps/sps/pps");
     }
 
@@ -713,7 +780,7 @@ srs_error_t SrsRtmpFromSrtBridge::on_hevc_frame(SrsTsMessage* msg, vector<pair<c
         payload.write_bytes(nal, nal_size);
     }
 
-    if ((err = live_source_->on_video(&rtmp)) != srs_success) {
+    if ((err = on_frame(&rtmp)) != srs_success) {
         return srs_error_wrap(err ,"srt ts hevc video to rtmp");
     }
 
@@ -818,7 +885,7 @@ srs_error_t SrsRtmpFromSrtBridge::check_audio_sh_change(SrsTsMessage* msg, uint3
     stream.write_1bytes(0);
     stream.write_bytes((char*)audio_sh_.data(), audio_sh_.size());
     
-    if ((err = live_source_->on_audio(&rtmp)) != srs_success) {
+    if ((err = on_frame(&rtmp)) != srs_success) {
         return srs_error_wrap(err, "srt to rtmp audio sh");
     }
 
@@ -844,13 +911,390 @@ srs_error_t SrsRtmpFromSrtBridge::on_aac_frame(SrsTsMessage* msg, uint32_t pts,
     // Write audio frame.
     stream.write_bytes(frame, frame_size);
     
-    if ((err = live_source_->on_audio(&rtmp)) != srs_success) {
+    if ((err = on_frame(&rtmp)) != srs_success) {
         return srs_error_wrap(err, "srt to rtmp audio sh");
     }
 
     return err;
 }
 
+SrsSrtDemuxJob::SrsSrtDemuxJob()
+{
+    id_ = 0;
+    close_ = false;
+    data_ = NULL;
+    size_ = 0;
+    nb_errors_ = 0;
+}
+
+SrsSrtDemuxJob::~SrsSrtDemuxJob()
+{
+    srs_freepa(data_);
+
+    for (int i = 0; i < (int)frames_.size(); i++) {
+        SrsCommonMessage* frame = frames_.at(i);
+        srs_freep(frame);
+    }
+}
+
+SrsSrtDemuxWorker::SrsSrtDemuxWorker(SrsSrtDemuxWorkers* owner)
+{
+    owner_ = owner;
+    jobs_pipe_[0] = jobs_pipe_[1] = -1;
+    lock_ = new SrsThreadMutex();
+}
+
+SrsSrtDemuxWorker::~SrsSrtDemuxWorker()
+{
+    for (int i = 0; i < 2; i++) {
+        if (jobs_pipe_[i] >= 0) {
+            ::close(jobs_pipe_[i]);
+        }
+    }
+
+    for (int i = 0; i < (int)jobs_.size(); i++) {
+        SrsSrtDemuxJob* job = jobs_.at(i);
+        srs_freep(job);
+    }
+    jobs_.clear();
+
+    std::map<uint64_t, SrsRtmpFromSrtBridge*>::iterator it;
+    for (it = demuxers_.begin(); it != demuxers_.end(); ++it) {
+        SrsRtmpFromSrtBridge* demuxer = it->second;
+        srs_freep(demuxer);
+    }
+    demuxers_.clear();
+
+    srs_freep(lock_);
+}
+
+SrsSrtDemuxWorkers* _srs_srt_demuxers = NULL;
+
+SrsSrtDemuxWorkers::SrsSrtDemuxWorkers()
+{
+    done_pipe_[0] = done_pipe_[1] = -1;
+    done_fd_ = NULL;
+    trd_ = NULL;
+    next_id_ = 0;
+
+    lock_ = new SrsThreadMutex();
+    quit_ = false;
+    nn_running_ = 0;
+}
+
+SrsSrtDemuxWorkers::~SrsSrtDemuxWorkers()
+{
+    // Stop the ST coroutine first, which reads the done pipe.
+    srs_freep(trd_);
+
+    // The workers use the worker objects and the done pipe, so we must wait for them to quit.
+    stop_workers();
+
+    for (int i = 0; i < (int)workers_.size(); i++) {
+        SrsSrtDemuxWorker* worker = workers_.at(i);
+        srs_freep(worker);
+    }
+    workers_.clear();
+
+    srs_close_stfd(done_fd_);
+    if (done_pipe_[1] >= 0) {
+        ::close(done_pipe_[1]);
+    }
+
+    // Free the done jobs which are not consumed.
+    for (int i = 0; i < (int)done_.size(); i++) {
+        SrsSrtDemuxJob* job = done_.at(i);
+        srs_freep(job);
+    }
+    done_.clear();
+
+    srs_freep(lock_);
+}
+
+void SrsSrtDemuxWorkers::stop_workers()
+{
+    if (true) {
+        SrsThreadLocker(lock_);
+        quit_ = true;
+    }
+
+    // Wake up all workers by EOF of pipe, see do_work.
+    for (int i = 0; i < (int)workers_.size(); i++) {
+        SrsSrtDemuxWorker* worker = workers_.at(i);
+        if (worker->jobs_pipe_[1] >= 0) {
+            ::close(worker->jobs_pipe_[1]);
+            worker->jobs_pipe_[1] = -1;
+        }
+    }
+
+    // Wait for all workers to quit, because they use this object. Note that the worker threads are
+    // detached by thread pool, so we check the number of running workers.
+    while (true) {
+        if (true) {
+            SrsThreadLocker(lock_);
+            if (nn_running_ <= 0) {
+                break;
+            }
+        }
+        ::usleep(10 * 1000);
+    }
+}
+
+srs_error_t SrsSrtDemuxWorkers::initialize()
+{
+    srs_error_t err = srs_success;
+
+    // Ignore if already started, for example, reload.
+    if (trd_) {
+        return err;
+    }
+
+    int nn_workers = _srs_config->get_srt_workers();
+    if (nn_workers <= 0) {
+        srs_trace("SRT: Demux in ST thread");
+        return err;
+    }
+
+    if (::pipe(done_pipe_) < 0) {
+        return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "create pipe");
+    }
+
+    if ((done_fd_ = srs_netfd_open(done_pipe_[0])) == NULL) {
+        return srs_error_new(ERROR_ST_OPEN_SOCKET, "open pipe fd=%d", done_pipe_[0]);
+    }
+
+    for (int i = 0; i < nn_workers; i++) {
+        SrsSrtDemuxWorker* worker = new SrsSrtDemuxWorker(this);
+        workers_.push_back(worker);
+
+        if (::pipe(worker->jobs_pipe_) < 0) {
+            return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "create pipe");
+        }
+
+        // Never block the ST thread when submit job, see submit.
+        int flags = fcntl(worker->jobs_pipe_[1], F_GETFL, 0);
+        if (flags == -1 || fcntl(worker->jobs_pipe_[1], F_SETFL, flags | O_NONBLOCK) == -1) {
+            return srs_error_new(ERROR_SYSTEM_CREATE_PIPE, "nonblock pipe fd=%d", worker->jobs_pipe_[1]);
+        }
+    }
+
+    trd_ = new SrsSTCoroutine("srt-demux", this);
+    if ((err = trd_->start()) != srs_success) {
+        return srs_error_wrap(err, "start coroutine");
+    }
+
+    for (int i = 0; i < (int)workers_.size(); i++) {
+        // Count the worker before it starts, so that it's never freed when worker is starting.
+        if (true) {
+            SrsThreadLocker(lock_);
+            nn_running_++;
+        }
+
+        if ((err = _srs_thread_pool->execute("srt", SrsSrtDemuxWorkers::start, workers_.at(i))) != srs_success) {
+            SrsThreadLocker(lock_);
+            nn_running_--;
+            return srs_error_wrap(err, "start worker #%d", i);
+        }
+    }
+
+    srs_trace("SRT: Demux in %d workers", nn_workers);
+
+    return err;
+}
+
+bool SrsSrtDemuxWorkers::enabled()
+{
+    return trd_ != NULL;
+}
+
+uint64_t SrsSrtDemuxWorkers::subscribe(SrsRtmpFromSrtBridge* bridge)
+{
+    uint64_t id = ++next_id_;
+    bridges_[id] = bridge;
+    return id;
+}
+
+void SrsSrtDemuxWorkers::unsubscribe(uint64_t id)
+{
+    if (bridges_.erase(id) == 0 || workers_.empty()) {
+        return;
+    }
+
+    SrsSrtDemuxJob* job = new SrsSrtDemuxJob();
+    job->id_ = id;
+    job->close_ = true;
+    submit(job);
+}
+
+void SrsSrtDemuxWorkers::submit(uint64_t id, char* data, int size)
+{
+    SrsSrtDemuxJob* job = new SrsSrtDemuxJob();
+    job->id_ = id;
+    job->cid_ = _srs_context->get_id();
+    job->data_ = new char[size];
+    job->size_ = size;
+    memcpy(job->data_, data, size);
+    submit(job);
+}
+
+void SrsSrtDemuxWorkers::submit(SrsSrtDemuxJob* job)
+{
+    // The stream is sticky to a worker, to keep the order of TS packets.
+    SrsSrtDemuxWorker* worker = workers_.at(job->id_ % workers_.size());
+
+    bool wakeup = false;
+    if (true) {
+        SrsThreadMutex* lock = worker->lock_;
+        SrsThreadLocker(lock);
+        wakeup = worker->jobs_.empty();
+        worker->jobs_.push_back(job);
+    }
+
+    // Wake up the worker if it might be idle, ignore if pipe is full, because worker consumes all jobs when wake up.
+    if (wakeup) {
+        char c = 0;
+        ssize_t nn = ::write(worker->jobs_pipe_[1], &c, 1);
+        (void)nn;
+    }
+}
+
+srs_error_t SrsSrtDemuxWorkers::cycle()
+{
+    srs_error_t err = srs_success;
+
+    while (true) {
+        if ((err = trd_->pull()) != srs_success) {
+            return srs_error_wrap(err, "pull");
+        }
+
+        char buf[128];
+        ssize_t nn = srs_read(done_fd_, buf, sizeof(buf), SRS_UTIME_NO_TIMEOUT);
+        if (nn <= 0) {
+            return srs_error_new(ERROR_SOCKET_READ, "read pipe, nn=%d", (int)nn);
+        }
+
+        vector<SrsSrtDemuxJob*> jobs;
+        if (true) {
+            SrsThreadLocker(lock_);
+            jobs.swap(done_);
+        }
+
+        for (int i = 0; i < (int)jobs.size(); i++) {
+            SrsSrtDemuxJob* job = jobs.at(i);
+            SrsAutoFree(SrsSrtDemuxJob, job);
+
+            // Ignore if the stream is unpublished or the bridge is freed.
+            std::map<uint64_t, SrsRtmpFromSrtBridge*>::iterator it = bridges_.find(job->id_);
+            if (it == bridges_.end()) {
+                continue;
+            }
+            SrsRtmpFromSrtBridge* bridge = it->second;
+
+            // Restore the context of connection, because there is only one coroutine for all streams.
+            SrsContextRestore(_srs_context->get_id());
+            _srs_context->set_id(job->cid_);
+
+            if (job->nb_errors_) {
+                srs_warn("SRT: Drop %d ts packets, err %s", job->nb_errors_, job->error_.c_str());
+            }
+
+            for (int j = 0; j < (int)job->frames_.size(); j++) {
+                SrsCommonMessage* frame = job->frames_.at(j);
+                if ((err = bridge->on_frame(frame)) != srs_success) {
+                    srs_warn("SRT: Deliver frame err %s", srs_error_desc(err).c_str());
+                    srs_freep(err);
+                }
+            }
+        }
+    }
+
+    return err;
+}
+
+srs_error_t SrsSrtDemuxWorkers::start(void* arg)
+{
+    SrsSrtDemuxWorker* worker = (SrsSrtDemuxWorker*)arg;
+    worker->owner_->do_work(worker);
+    return srs_success;
+}
+
+void SrsSrtDemuxWorkers::do_work(SrsSrtDemuxWorker* worker)
+{
+    while (true) {
+        // Block the worker thread until there is job, or the pipe is closed to quit.
+        char c = 0;
+        ssize_t r0 = ::read(worker->jobs_pipe_[0], &c, 1);
+
+        if (true) {
+            SrsThreadLocker(lock_);
+            if (quit_) {
+                break;
+            }
+        }
+
+        if (r0 <= 0) {
+            continue;
+        }
+
+        while (true) {
+            vector<SrsSrtDemuxJob*> jobs;
+            if (true) {
+                SrsThreadMutex* lock = worker->lock_;
+                SrsThreadLocker(lock);
+                jobs.swap(worker->jobs_);
+            }
+
+            if (jobs.empty()) {
+                break;
+            }
+
+            for (int i = 0; i < (int)jobs.size(); i++) {
+                SrsSrtDemuxJob* job = jobs.at(i);
+
+                std::map<uint64_t, SrsRtmpFromSrtBridge*>::iterator it = worker->demuxers_.find(job->id_);
+                if (job->close_) {
+                    if (it != worker->demuxers_.end()) {
+                        SrsRtmpFromSrtBridge* demuxer = it->second;
+                        srs_freep(demuxer);
+                        worker->demuxers_.erase(it);
+                    }
+                    srs_freep(job);
+                    jobs[i] = NULL;
+                    continue;
+                }
+
+                // The demuxer has its own TS context and codec state, never touch the live source.
+                SrsRtmpFromSrtBridge* demuxer = NULL;
+                if (it != worker->demuxers_.end()) {
+                    demuxer = it->second;
+                } else {
+                    demuxer = new SrsRtmpFromSrtBridge(NULL);
+                    worker->demuxers_[job->id_] = demuxer;
+                }
+
+                demuxer->demux(job);
+            }
+
+            if (true) {
+                SrsThreadLocker(lock_);
+                for (int i = 0; i < (int)jobs.size(); i++) {
+                    if (jobs.at(i)) {
+                        done_.push_back(jobs.at(i));
+                    }
+                }
+            }
+
+            // Notify the ST thread, which reads all done jobs when wake up.
+            ssize_t nn = ::write(done_pipe_[1], &c, 1);
+            (void)nn;
+        }
+    }
+
+    // Never touch this object after the worker is not running, because it might be freed.
+    SrsThreadLocker(lock_);
+    nn_running_--;
+}
+
 SrsSrtSource::SrsSrtSource()
 {
     req = NULL;
@@ -15,8 +15,13 @@
 #include <srs_kernel_ts.hpp>
 #include <srs_protocol_st.hpp>
 #include <srs_app_source.hpp>
+#include <srs_app_st.hpp>
 
 class SrsSharedPtrMessage;
+class SrsCommonMessage;
+class SrsThreadMutex;
+class SrsSrtDemuxJob;
+class SrsSrtDemuxWorkers;
 class SrsRequest;
 class SrsLiveSource;
 class SrsSrtSource;
@@ -113,6 +118,10 @@ public:
     virtual void on_unpublish();
 public:
     srs_error_t initialize(SrsRequest* req);
+    // Demux the TS packets of job to RTMP frames, in the worker thread, see SrsSrtDemuxWorkers.
+    void demux(SrsSrtDemuxJob* job);
+    // Deliver the RTMP frame to live source, or collect it when demux in worker thread.
+    srs_error_t on_frame(SrsCommonMessage* msg);
 // Interface ISrsTsHandler
 public:
     virtual srs_error_t on_ts_message(SrsTsMessage* msg);
@@ -158,8 +167,103 @@ private:
     int audio_streamid_;
     // Cycle print when audio duration too large because mpegts may merge multi audio frame in one pes packet.
     SrsAlonePithyPrint* pp_audio_duration_;
+
+    // The id of demuxer in worker thread, 0 if demux in ST thread.
+    uint64_t demux_id_;
+    // The frames collected by on_frame, only for the demuxer in worker thread.
+    std::vector<SrsCommonMessage*>* frames_;
+};
+
+// The demux job of SRT stream, the TS packets are demuxed to RTMP frames by worker thread.
+class SrsSrtDemuxJob
+{
+public:
+    // The id of stream, to find the demuxer in worker and the bridge in ST thread.
+    uint64_t id_;
+    // Whether close the demuxer in worker, when stream unpublish.
+    bool close_;
+    // The context id of connection, for logging when job done.
+    SrsContextId cid_;
+    // The TS packets, copied from the SRT packet.
+    char* data_;
+    int size_;
+    // The RTMP frames demuxed by worker thread.
+    std::vector<SrsCommonMessage*> frames_;
+    // The number of dropped TS packets and the last error, because we never log in worker thread.
+    int nb_errors_;
+    std::string error_;
+public:
+    SrsSrtDemuxJob();
+    virtual ~SrsSrtDemuxJob();
+};
+
+// The worker thread to demux TS streams, each stream is sticky to one worker to keep the order of frames.
+class SrsSrtDemuxWorker
+{
+public:
+    SrsSrtDemuxWorkers* owner_;
+    // The pipe to wake up the worker when a job is submitted.
+    int jobs_pipe_[2];
+    // To protect the jobs, which are accessed by ST thread and worker thread.
+    SrsThreadMutex* lock_;
+    std::vector<SrsSrtDemuxJob*> jobs_;
+    // The demuxers of streams, only accessed by the worker thread.
+    std::map<uint64_t, SrsRtmpFromSrtBridge*> demuxers_;
+public:
+    SrsSrtDemuxWorker(SrsSrtDemuxWorkers* owner);
+    virtual ~SrsSrtDemuxWorker();
 };
 
+// The worker threads to demux the TS of SRT streams, which is CPU intensive for many contribution feeds, and the
+// RTMP frames are notified to the ST thread by a pipe, then delivered to live source, which is not thread-safe.
+class SrsSrtDemuxWorkers : public ISrsCoroutineHandler
+{
+private:
+    std::vector<SrsSrtDemuxWorker*> workers_;
+    // The pipe to notify the ST thread.
+    int done_pipe_[2];
+    srs_netfd_t done_fd_;
+    SrsCoroutine* trd_;
+    // To protect the done jobs, which are accessed by multiple threads.
+    SrsThreadMutex* lock_;
+    std::vector<SrsSrtDemuxJob*> done_;
+    // Whether the workers should quit, and the number of running workers, protected by lock.
+    bool quit_;
+    int nn_running_;
+private:
+    // The bridges in ST thread, by the id of stream.
+    std::map<uint64_t, SrsRtmpFromSrtBridge*> bridges_;
+    uint64_t next_id_;
+public:
+    SrsSrtDemuxWorkers();
+    virtual ~SrsSrtDemuxWorkers();
+public:
+    // Start the worker threads by config, in the ST thread of SRT server.
+    srs_error_t initialize();
+    // Whether demux in worker threads.
+    bool enabled();
+    // Alloc the id of stream for bridge, and pick a worker for it.
+    uint64_t subscribe(SrsRtmpFromSrtBridge* bridge);
+    // Remove the bridge, and close the demuxer in worker.
+    void unsubscribe(uint64_t id);
+    // Submit the TS packets to the worker of stream, the frames are delivered by SrsRtmpFromSrtBridge::on_frame.
+    void submit(uint64_t id, char* data, int size);
+// Interface ISrsCoroutineHandler
+public:
+    // Consume the done jobs in the ST thread.
+    virtual srs_error_t cycle();
+private:
+    void submit(SrsSrtDemuxJob* job);
+    static srs_error_t start(void* arg);
+    // The cycle of worker thread.
+    void do_work(SrsSrtDemuxWorker* worker);
+    // Notify the workers to quit, and wait for all workers to quit.
+    void stop_workers();
+};
+
+// @global The workers to demux SRT streams.
+extern SrsSrtDemuxWorkers* _srs_srt_demuxers;
+
 class SrsSrtSource
 {
 public:
@@ -212,6 +212,20 @@ SrsStatisticClient::SrsStatisticClient()
     create = srs_get_system_time();
 
     kbps = new SrsKbps();
+
+    mr = false;
+    mr_adaptive = false;
+    mr_sleep = 0;
+    mr_rbuf = 0;
+    mr_kbps = 0;
+    mr_read_size = 0;
+
+    mw = false;
+    mw_sleep = 0;
+    mw_bytes = 0;
+    mw_kbps = 0;
+    mw_drain_kbps = 0;
+    mw_outq = 0;
 }
 
 SrsStatisticClient::~SrsStatisticClient()
@@ -244,6 +258,29 @@ srs_error_t SrsStatisticClient::dumps(SrsJsonObject* obj)
 
     okbps->set("recv_30s", SrsJsonAny::integer(kbps->get_recv_kbps_30s()));
     okbps->set("send_30s", SrsJsonAny::integer(kbps->get_send_kbps_30s()));
+
+    if (mr) {
+        SrsJsonObject* omr = SrsJsonAny::object();
+        obj->set("mr", omr);
+
+        omr->set("adaptive", SrsJsonAny::boolean(mr_adaptive));
+        omr->set("sleep", SrsJsonAny::integer(srsu2msi(mr_sleep)));
+        omr->set("rbuf", SrsJsonAny::integer(mr_rbuf));
+        omr->set("kbps", SrsJsonAny::integer(mr_kbps));
+        omr->set("read_size", SrsJsonAny::integer(mr_read_size));
+    }
+
+    if (mw) {
+        SrsJsonObject* omw = SrsJsonAny::object();
+        obj->set("mw", omw);
+
+        omw->set("adaptive", SrsJsonAny::boolean(true));
+        omw->set("sleep", SrsJsonAny::integer(srsu2msi(mw_sleep)));
+        omw->set("bytes", SrsJsonAny::integer(mw_bytes));
+        omw->set("kbps", SrsJsonAny::integer(mw_kbps));
+        omw->set("drain_kbps", SrsJsonAny::integer(mw_drain_kbps));
+        omw->set("outq", SrsJsonAny::integer(mw_outq));
+    }
     
     return err;
 }
@@ -256,6 +293,9 @@ SrsStatistic::SrsStatistic()
 
     nb_clients_ = 0;
     nb_errs_ = 0;
+
+    nb_reloads_ = 0;
+    reload_duration_ = 0;
 }
 
 SrsStatistic::~SrsStatistic()
@@ -419,6 +459,12 @@ void SrsStatistic::on_stream_close(SrsRequest* req)
     stream->close();
 }
 
+void SrsStatistic::on_config_reload(srs_utime_t duration)
+{
+    nb_reloads_++;
+    reload_duration_ = duration;
+}
+
 srs_error_t SrsStatistic::on_client(std::string id, SrsRequest* req, ISrsExpire* conn, SrsRtmpConnType type)
 {
     srs_error_t err = srs_success;
@@ -475,6 +521,46 @@ void SrsStatistic::on_disconnect(std::string id, srs_error_t err)
     cleanup_stream(stream);
 }
 
+void SrsStatistic::on_client_handoff(std::string id)
+{
+    SrsStatisticClient* client = find_client(id);
+    if (!client) {
+        return;
+    }
+
+    client->conn = NULL;
+}
+
+void SrsStatistic::on_client_mr(std::string id, bool enabled, bool adaptive, srs_utime_t sleep, int rbuf, int kbps, int read_size)
+{
+    SrsStatisticClient* client = find_client(id);
+    if (!client) {
+        return;
+    }
+
+    client->mr = enabled;
+    client->mr_adaptive = adaptive;
+    client->mr_sleep = sleep;
+    client->mr_rbuf = rbuf;
+    client->mr_kbps = kbps;
+    client->mr_read_size = read_size;
+}
+
+void SrsStatistic::on_client_mw(std::string id, srs_utime_t sleep, int bytes, int kbps, int drain_kbps, int outq)
+{
+    SrsStatisticClient* client = find_client(id);
+    if (!client) {
+        return;
+    }
+
+    client->mw = true;
+    client->mw_sleep = sleep;
+    client->mw_bytes = bytes;
+    client->mw_kbps = kbps;
+    client->mw_drain_kbps = drain_kbps;
+    client->mw_outq = outq;
+}
+
 void SrsStatistic::cleanup_stream(SrsStatisticStream* stream)
 {
     // If stream has publisher(not active) or player(clients), never cleanup it.
@@ -800,3 +886,9 @@ srs_error_t SrsStatistic::dumps_metrics(int64_t& send_bytes, int64_t& recv_bytes
     return err;
 }
 
+void SrsStatistic::dumps_reload_metrics(int64_t& nreloads, srs_utime_t& duration)
+{
+    nreloads = nb_reloads_;
+    duration = reload_duration_;
+}
+
@@ -115,6 +115,23 @@ public:
 public:
     // The stream total kbps.
     SrsKbps* kbps;
+public:
+    // The merged-read of publisher, the sleep and recv buffer chosen by mr.
+    bool mr;
+    bool mr_adaptive;
+    srs_utime_t mr_sleep;
+    int mr_rbuf;
+    // The bitrate and average read size sampled by adaptive mr.
+    int mr_kbps;
+    int mr_read_size;
+public:
+    // The adaptive merged-write of player, the wait chosen by sampled bitrate and socket drain rate.
+    bool mw;
+    srs_utime_t mw_sleep;
+    int mw_bytes;
+    int mw_kbps;
+    int mw_drain_kbps;
+    int mw_outq;
 public:
     SrsStatisticClient();
     virtual ~SrsStatisticClient();
@@ -154,6 +171,11 @@ private:
     int64_t nb_clients_;
     // The total of clients errors.
     int64_t nb_errs_;
+private:
+    // The total of config reloads.
+    int64_t nb_reloads_;
+    // The duration of last config reload.
+    srs_utime_t reload_duration_;
 private:
     SrsStatistic();
     virtual ~SrsStatistic();
@@ -180,6 +202,8 @@ public:
     virtual void on_stream_publish(SrsRequest* req, std::string publisher_id);
     // When close stream.
     virtual void on_stream_close(SrsRequest* req);
+    // When config reloaded, with the duration of reload.
+    virtual void on_config_reload(srs_utime_t duration);
 public:
     // When got a client to publish/play stream,
     // @param id, the client srs id.
@@ -192,6 +216,23 @@ public:
     //      only got the request object, so the client specified by id maybe not
     //      exists in stat.
     virtual void on_disconnect(std::string id, srs_error_t err);
+    // When the client is handed off to other thread, the connection object is freed, so it can't be kicked off,
+    // and the client is kept in stat util on_disconnect.
+    virtual void on_client_handoff(std::string id);
+    // When the merged-read of publisher changed.
+    // @param enabled, whether mr is enabled, the stat is ignored if disabled.
+    // @param sleep, the sleep for small bytes.
+    // @param rbuf, the socket recv buffer in bytes.
+    // @param kbps, the bitrate of publisher, sampled by adaptive mr.
+    // @param read_size, the average bytes of each read, sampled by adaptive mr.
+    virtual void on_client_mr(std::string id, bool enabled, bool adaptive, srs_utime_t sleep, int rbuf, int kbps, int read_size);
+    // When the adaptive merged-write of player sampled.
+    // @param sleep, the duration to wait.
+    // @param bytes, the bytes to wait.
+    // @param kbps, the bitrate of player.
+    // @param drain_kbps, the bitrate drained by socket send buffer.
+    // @param outq, the bytes in socket send buffer.
+    virtual void on_client_mw(std::string id, srs_utime_t sleep, int bytes, int kbps, int drain_kbps, int outq);
 private:
     // Cleanup the stream if stream is not active and for the last client.
     void cleanup_stream(SrsStatisticStream* stream);
@@ -233,6 +274,8 @@ private:
 public:
     // Dumps exporter metrics.
     virtual srs_error_t dumps_metrics(int64_t& send_bytes, int64_t& recv_bytes, int64_t& nstreams, int64_t& nclients, int64_t& total_nclients, int64_t& nerrs);
+    // Dumps the reload metrics, the total of reloads and duration of last reload.
+    virtual void dumps_reload_metrics(int64_t& nreloads, srs_utime_t& duration);
 };
 
 // Generate a random string id, with constant prefix.
@@ -18,6 +18,9 @@
 #include <srs_app_async_call.hpp>
 #include <srs_app_tencentcloud.hpp>
 #include <srs_app_conn.hpp>
+#include <srs_kernel_balance.hpp>
+#include <srs_app_hls.hpp>
+#include <srs_app_delivery.hpp>
 #ifdef SRS_RTC
 #include <srs_app_rtc_dtls.hpp>
 #include <srs_app_rtc_conn.hpp>
@@ -66,6 +69,7 @@ extern SrsResourceManager* _srs_rtc_manager;
 
 extern SrsResourceManager* _srs_rtc_manager;
 extern SrsDtlsCertificate* _srs_rtc_dtls_certificate;
+extern SrsDtlsWorkers* _srs_dtls_workers;
 #endif
 
 #include <srs_protocol_kbps.hpp>
@@ -321,9 +325,13 @@ srs_error_t srs_global_initialize()
     _srs_sources = new SrsLiveSourceManager();
     _srs_stages = new SrsStageManager();
     _srs_circuit_breaker = new SrsCircuitBreaker();
+    _srs_lb_servers = new SrsLbServers();
+    _srs_hls_memory = new SrsHlsMemoryStore();
+    _srs_delivery = new SrsDeliveryWorkers();
 
 #ifdef SRS_SRT
     _srs_srt_sources = new SrsSrtSourceManager();
+    _srs_srt_demuxers = new SrsSrtDemuxWorkers();
 #endif
 
 #ifdef SRS_RTC
@@ -332,6 +340,7 @@ srs_error_t srs_global_initialize()
 
     _srs_rtc_manager = new SrsResourceManager("RTC", true);
     _srs_rtc_dtls_certificate = new SrsDtlsCertificate();
+    _srs_dtls_workers = new SrsDtlsWorkers();
 #endif
 #ifdef SRS_GB28181
     _srs_gb_manager = new SrsResourceManager("GB", true);
@@ -796,6 +805,9 @@ void* SrsThreadPool::start(void* arg)
         entry->err = srs_error_new(ERROR_THREAD_FINISHED, "finished normally");
     }
 
+    // Free the thread-local objects of ST, because the thread is going to quit.
+    srs_st_destroy();
+
     // We do not use the return value, the err has been set to entry->err.
     return NULL;
 }
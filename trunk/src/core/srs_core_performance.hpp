@@ -38,6 +38,8 @@
 // the default config of mr.
 #define SRS_PERF_MR_ENABLED false
 #define SRS_PERF_MR_SLEEP (350 * SRS_UTIME_MILLISECONDS)
+// Whether adaptive mr, which tunes the sleep in [10ms, mr_sleep] by the bitrate of publisher.
+#define SRS_PERF_MR_ADAPTIVE false
 
 // For tcmalloc, set the default release rate.
 // @see https://gperftools.github.io/gperftools/tcmalloc.html
@@ -76,6 +78,10 @@
  */
 // the default config of mw.
 #define SRS_PERF_MW_SLEEP (350 * SRS_UTIME_MILLISECONDS)
+// Whether adaptive mw, which tunes the wait in [10ms, mw_sleep] by the bitrate of player.
+#define SRS_PERF_MW_ADAPTIVE false
+// For adaptive mw, the min bytes for each writev.
+#define SRS_PERF_MW_MIN_BYTES 16384
 /**
  * how many msgs can be send entirely.
  * for play clients to get msgs then totally send out.
@@ -121,6 +127,24 @@
  */
 #define SRS_PERF_MIN_LATENCY_ENABLED false
 
+/**
+ * For RTC player, the max number of RTP packets to protect by SRTP in a batch, then send out.
+ * @remark Each RTC connection allocates the buffers of kRtpPacketSize for the batch.
+ */
+#define SRS_PERF_RTC_SEND_BATCH 16
+
+/**
+ * For mega stream, deliver the players in worker threads, each holds a replica of stream.
+ * @remark Only enabled when the players of stream exceed the threshold.
+ */
+#define SRS_PERF_DELIVERY_ENABLED false
+// The number of delivery worker threads.
+#define SRS_PERF_DELIVERY_WORKERS 4
+// The number of players of stream, to deliver the new players in workers.
+#define SRS_PERF_DELIVERY_PLAYERS 20000
+// The max number of messages in replica, for stream without video, or very large gop.
+#define SRS_PERF_DELIVERY_MSGS 8192
+
 /**
  * how many chunk stream to cache, [0, N].
  * to imporove about 10% performance when chunk size small, and 5% for large chunk.
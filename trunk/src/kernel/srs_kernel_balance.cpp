@@ -7,9 +7,163 @@
 #include <srs_kernel_balance.hpp>
 
 #include <srs_kernel_error.hpp>
+#include <srs_kernel_utility.hpp>
 
 using namespace std;
 
+// The load of server is expired if not updated by heartbeat.
+#define SRS_LB_LOAD_EXPIRE (30 * SRS_UTIME_SECONDS)
+// The min and max time to mark server as down, doubled for continuous failures.
+#define SRS_LB_DOWN_MIN (3 * SRS_UTIME_SECONDS)
+#define SRS_LB_DOWN_MAX (30 * SRS_UTIME_SECONDS)
+
+SrsLbServers* _srs_lb_servers = NULL;
+
+SrsLbServerState::SrsLbServerState()
+{
+    load_ = -1;
+    load_at_ = 0;
+    failures_ = 0;
+    down_until_ = 0;
+}
+
+SrsLbServerState::~SrsLbServerState()
+{
+}
+
+SrsLbServers::SrsLbServers()
+{
+}
+
+SrsLbServers::~SrsLbServers()
+{
+    map<string, SrsLbServerState*>::iterator it;
+    for (it = servers_.begin(); it != servers_.end(); ++it) {
+        SrsLbServerState* state = it->second;
+        srs_freep(state);
+    }
+    servers_.clear();
+}
+
+void SrsLbServers::on_load(string server, int load)
+{
+    SrsLbServerState* state = fetch(server, true);
+    state->load_ = load;
+    state->load_at_ = srs_get_system_time();
+}
+
+void SrsLbServers::on_failure(string server)
+{
+    SrsLbServerState* state = fetch(server, true);
+
+    srs_utime_t duration = SRS_LB_DOWN_MIN;
+    for (int i = 0; i < state->failures_ && duration < SRS_LB_DOWN_MAX; i++) {
+        duration *= 2;
+    }
+    duration = srs_min(duration, SRS_LB_DOWN_MAX);
+
+    state->failures_++;
+    state->down_until_ = srs_get_system_time() + duration;
+}
+
+void SrsLbServers::on_success(string server)
+{
+    SrsLbServerState* state = fetch(server, false);
+    if (state) {
+        state->failures_ = 0;
+        state->down_until_ = 0;
+    }
+}
+
+bool SrsLbServers::healthy(string server)
+{
+    SrsLbServerState* state = fetch(server, false);
+    return !state || state->down_until_ <= srs_get_system_time();
+}
+
+int SrsLbServers::load(string server)
+{
+    SrsLbServerState* state = fetch(server, false);
+    if (!state || state->load_ < 0) {
+        return -1;
+    }
+
+    if (state->load_at_ + SRS_LB_LOAD_EXPIRE < srs_get_system_time()) {
+        return -1;
+    }
+
+    return state->load_;
+}
+
+SrsLbServerState* SrsLbServers::fetch(string server, bool create)
+{
+    // Key by the server as it is, the host:port, because there might be multiple servers in a host.
+    map<string, SrsLbServerState*>::iterator it = servers_.find(server);
+    if (it != servers_.end()) {
+        return it->second;
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    SrsLbServerState* state = new SrsLbServerState();
+    servers_[server] = state;
+    return state;
+}
+
+// Whether server is healthy, if no global servers, for example, in utest, all servers are healthy.
+bool srs_lb_healthy(const string& server)
+{
+    return !_srs_lb_servers || _srs_lb_servers->healthy(server);
+}
+
+// The weight is by 64bits FNV-1a over server and key, with the finalizer of murmur3, which is
+// non-linear so that the weights of servers are uniform and independent for each key.
+uint64_t srs_lb_weight(const string& server, const string& key)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < (int)server.length(); i++) {
+        h = (h ^ (uint8_t)server.at(i)) * 0x100000001b3ULL;
+    }
+
+    // Separate the server and key, so that server "ab" with key "c" differs from "a" with "bc".
+    h = (h ^ 0xff) * 0x100000001b3ULL;
+    for (int i = 0; i < (int)key.length(); i++) {
+        h = (h ^ (uint8_t)key.at(i)) * 0x100000001b3ULL;
+    }
+
+    // The fmix64 of murmur3, see https://github.com/aappleby/smhasher/wiki/MurmurHash3
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+ISrsLbBalancer::ISrsLbBalancer()
+{
+}
+
+ISrsLbBalancer::~ISrsLbBalancer()
+{
+}
+
+ISrsLbBalancer* srs_lb_create(string algorithm, string key)
+{
+    if (algorithm == "hash") {
+        return new SrsLbConsistentHash(key);
+    }
+
+    if (algorithm == "least_load") {
+        return new SrsLbLeastLoad();
+    }
+
+    return new SrsLbRoundRobin();
+}
+
 SrsLbRoundRobin::SrsLbRoundRobin()
 {
     index = -1;
@@ -35,8 +189,119 @@ string SrsLbRoundRobin::select(const vector<string>& servers)
     srs_assert(!servers.empty());
     
     index = (int)(count++ % servers.size());
+
+    // Skip the unhealthy servers, and use the next one if all servers are down.
+    for (int i = 0; i < (int)servers.size() - 1 && !srs_lb_healthy(servers.at(index)); i++) {
+        index = (int)(count++ % servers.size());
+    }
+
     elem = servers.at(index);
     
     return elem;
 }
 
+SrsLbConsistentHash::SrsLbConsistentHash(string key)
+{
+    key_ = key;
+    index_ = -1;
+}
+
+SrsLbConsistentHash::~SrsLbConsistentHash()
+{
+}
+
+uint32_t SrsLbConsistentHash::current()
+{
+    return index_;
+}
+
+string SrsLbConsistentHash::selected()
+{
+    return elem_;
+}
+
+string SrsLbConsistentHash::select(const vector<string>& servers)
+{
+    srs_assert(!servers.empty());
+
+    // Select the healthy server with the highest weight, which is the hash of server and key. If all
+    // servers are down, ignore the health and select the one with the highest weight.
+    int best = -1, fallback = -1;
+    uint64_t best_weight = 0, fallback_weight = 0;
+    for (int i = 0; i < (int)servers.size(); i++) {
+        const string& server = servers.at(i);
+        uint64_t weight = srs_lb_weight(server, key_);
+
+        if (fallback == -1 || weight > fallback_weight) {
+            fallback = i;
+            fallback_weight = weight;
+        }
+
+        if (!srs_lb_healthy(server)) {
+            continue;
+        }
+
+        if (best == -1 || weight > best_weight) {
+            best = i;
+            best_weight = weight;
+        }
+    }
+
+    index_ = (best != -1) ? best : fallback;
+    elem_ = servers.at(index_);
+
+    return elem_;
+}
+
+SrsLbLeastLoad::SrsLbLeastLoad()
+{
+    index_ = -1;
+    count_ = 0;
+}
+
+SrsLbLeastLoad::~SrsLbLeastLoad()
+{
+}
+
+uint32_t SrsLbLeastLoad::current()
+{
+    return index_;
+}
+
+string SrsLbLeastLoad::selected()
+{
+    return elem_;
+}
+
+string SrsLbLeastLoad::select(const vector<string>& servers)
+{
+    srs_assert(!servers.empty());
+
+    // Start from a different server each time, so the servers with the same load are round-robin.
+    int nn_servers = (int)servers.size();
+    int start = (int)(count_++ % nn_servers);
+
+    int best = -1, best_load = 0;
+    for (int i = 0; i < nn_servers; i++) {
+        int index = (start + i) % nn_servers;
+        const string& server = servers.at(index);
+
+        if (!srs_lb_healthy(server)) {
+            continue;
+        }
+
+        // The server without load is regarded as idle, for example, the heartbeat is not enabled.
+        int load = _srs_lb_servers ? srs_max(0, _srs_lb_servers->load(server)) : 0;
+        if (best == -1 || load < best_load) {
+            best = index;
+            best_load = load;
+        }
+    }
+
+    // All servers are down, use round-robin.
+    index_ = (best != -1) ? best : start;
+    elem_ = servers.at(index_);
+
+    return elem_;
+}
+
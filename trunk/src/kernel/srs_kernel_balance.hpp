@@ -11,12 +11,81 @@
 
 #include <vector>
 #include <string>
+#include <map>
+
+// The state of a upstream server, for health check and load balance.
+class SrsLbServerState
+{
+public:
+    // The load of server, from heartbeat, -1 for unknown.
+    int load_;
+    // The update time of load, the load is expired if too old.
+    srs_utime_t load_at_;
+    // The continuous failures, and the server is down before the time.
+    int failures_;
+    srs_utime_t down_until_;
+public:
+    SrsLbServerState();
+    virtual ~SrsLbServerState();
+};
+
+// The health and load of upstream servers, shared by all balancers. The health is checked by the
+// result of connecting to server, and the load is fed by heartbeat of server.
+class SrsLbServers
+{
+private:
+    // The state of server, key is the server as it is, generally host:port.
+    std::map<std::string, SrsLbServerState*> servers_;
+public:
+    SrsLbServers();
+    virtual ~SrsLbServers();
+public:
+    // When got the load of server, for example, the cpu percent in heartbeat.
+    void on_load(std::string server, int load);
+    // When connect to server failed, the server is marked as down for a while, which is doubled
+    // for continuous failures, then we will try it again.
+    void on_failure(std::string server);
+    // When connect to server ok, reset the health of server.
+    void on_success(std::string server);
+public:
+    // Whether server is healthy, that is not marked as down.
+    bool healthy(std::string server);
+    // Get the load of server, -1 if unknown or expired.
+    int load(std::string server);
+private:
+    SrsLbServerState* fetch(std::string server, bool create);
+};
+
+// @global The health and load of upstream servers.
+extern SrsLbServers* _srs_lb_servers;
+
+// The load balance algorithm, used for edge pull and other multiple server feature.
+class ISrsLbBalancer
+{
+public:
+    ISrsLbBalancer();
+    virtual ~ISrsLbBalancer();
+public:
+    // Get the index of selected server.
+    virtual uint32_t current() = 0;
+    // Get the selected server.
+    virtual std::string selected() = 0;
+    // Select a server, the unhealthy servers are skipped if possible.
+    virtual std::string select(const std::vector<std::string>& servers) = 0;
+};
+
+// The weight of server for key, used by consistent hash to select the server with the highest weight.
+extern uint64_t srs_lb_weight(const std::string& server, const std::string& key);
+
+// Create the balancer by algorithm, the key is used by hash algorithm, for example, the stream url.
+// @param algorithm The algorithm, round_robin, hash or least_load, default to round_robin.
+extern ISrsLbBalancer* srs_lb_create(std::string algorithm, std::string key);
 
 /**
  * the round-robin load balance algorithm,
  * used for edge pull and other multiple server feature.
  */
-class SrsLbRoundRobin
+class SrsLbRoundRobin : public ISrsLbBalancer
 {
 private:
     // current selected index.
@@ -34,5 +103,40 @@ public:
     virtual std::string select(const std::vector<std::string>& servers);
 };
 
+// The consistent hash algorithm, by rendezvous(HRW) hashing of the key, for example, the stream url,
+// so all edges pull the same stream from the same origin, and only the streams of a failed origin are
+// moved to other origins.
+class SrsLbConsistentHash : public ISrsLbBalancer
+{
+private:
+    std::string key_;
+    int index_;
+    std::string elem_;
+public:
+    SrsLbConsistentHash(std::string key);
+    virtual ~SrsLbConsistentHash();
+public:
+    virtual uint32_t current();
+    virtual std::string selected();
+    virtual std::string select(const std::vector<std::string>& servers);
+};
+
+// The least load algorithm, select the server with the lowest load from heartbeat, and use round-robin
+// for servers with the same load, or if no load.
+class SrsLbLeastLoad : public ISrsLbBalancer
+{
+private:
+    int index_;
+    uint32_t count_;
+    std::string elem_;
+public:
+    SrsLbLeastLoad();
+    virtual ~SrsLbLeastLoad();
+public:
+    virtual uint32_t current();
+    virtual std::string selected();
+    virtual std::string select(const std::vector<std::string>& servers);
+};
+
 #endif
 
@@ -276,7 +276,9 @@
     XX(ERROR_HEVC_DISABLED                 , 3098, "HevcDisabled", "HEVC is disabled") \
     XX(ERROR_HEVC_DECODE_ERROR             , 3099, "HevcDecode", "HEVC decode av stream failed")  \
     XX(ERROR_MP4_HVCC_CHANGE               , 3100, "Mp4HvcCChange", "MP4 does not support video HvcC change") \
-    XX(ERROR_HEVC_API_NO_PREFIXED          , 3101, "HevcAnnexbPrefix", "No annexb prefix for HEVC decoder")
+    XX(ERROR_HEVC_API_NO_PREFIXED          , 3101, "HevcAnnexbPrefix", "No annexb prefix for HEVC decoder") \
+    XX(ERROR_HLS_EDGE_TIMEOUT              , 3102, "HlsEdgeTimeout", "Timeout for edge HLS to wait for fetching from origin") \
+    XX(ERROR_HLS_BLOCKING_RELOAD           , 3103, "HlsBlockingReload", "The LL-HLS blocking playlist reload is invalid")
 
 /**************************************************/
 /* HTTP/StreamConverter protocol error. */
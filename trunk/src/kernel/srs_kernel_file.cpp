@@ -249,6 +249,11 @@ bool SrsFileReader::is_open()
     return fd > 0;
 }
 
+int SrsFileReader::fileno()
+{
+    return is_open() ? fd : -1;
+}
+
 int64_t SrsFileReader::tellg()
 {
     return (int64_t)_srs_lseek_fn(fd, 0, SEEK_CUR);
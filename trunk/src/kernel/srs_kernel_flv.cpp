@@ -354,6 +354,28 @@ SrsSharedPtrMessage* SrsSharedPtrMessage::copy2()
     return copy;
 }
 
+SrsSharedPtrMessage* SrsSharedPtrMessage::deep_copy()
+{
+    srs_assert(ptr);
+
+    SrsSharedPtrMessage* copy = new SrsSharedPtrMessage();
+
+    copy->ptr = new SrsSharedPtrPayload();
+    copy->ptr->header = ptr->header;
+    copy->ptr->size = ptr->size;
+    if (ptr->size > 0) {
+        copy->ptr->payload = new char[ptr->size];
+        memcpy(copy->ptr->payload, ptr->payload, ptr->size);
+    }
+
+    copy->payload = copy->ptr->payload;
+    copy->size = copy->ptr->size;
+    copy->timestamp = timestamp;
+    copy->stream_id = stream_id;
+
+    return copy;
+}
+
 SrsFlvTransmuxer::SrsFlvTransmuxer()
 {
     writer = NULL;
@@ -330,6 +330,8 @@ public:
     virtual SrsSharedPtrMessage* copy();
     // Only copy the buffer, without header fields.
     virtual SrsSharedPtrMessage* copy2();
+    // Copy the header and payload without sharing, for other threads, because the ref-count is not thread-safe.
+    virtual SrsSharedPtrMessage* deep_copy();
 };
 
 // Transmux RTMP packets to FLV stream.
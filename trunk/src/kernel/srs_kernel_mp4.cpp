@@ -17,6 +17,7 @@
 #include <string.h>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 using namespace std;
 
 // For CentOS 6 or C++98, @see https://github.com/ossrs/srs/issues/2815
@@ -341,6 +342,7 @@ srs_error_t SrsMp4Box::discovery(SrsBuffer* buf, SrsMp4Box** ppbox)
         case SrsMp4BoxTypeSTSZ: box = new SrsMp4SampleSizeBox(); break;
         case SrsMp4BoxTypeAVC1: box = new SrsMp4VisualSampleEntry(SrsMp4BoxTypeAVC1); break;
         case SrsMp4BoxTypeHEV1: box = new SrsMp4VisualSampleEntry(SrsMp4BoxTypeHEV1); break;
+        case SrsMp4BoxTypeHVC1: box = new SrsMp4VisualSampleEntry(SrsMp4BoxTypeHVC1); break;
         case SrsMp4BoxTypeAVCC: box = new SrsMp4AvccBox(); break;
         case SrsMp4BoxTypeHVCC: box = new SrsMp4HvcCBox(); break;
         case SrsMp4BoxTypeMP4A: box = new SrsMp4AudioSampleEntry(); break;
@@ -5711,6 +5713,323 @@ srs_error_t SrsMp4Decoder::do_load_next_box(SrsMp4Box** ppbox, uint32_t required
     return err;
 }
 
+SrsMp4SeekIndex::SrsMp4SeekIndex()
+{
+    ftyp_ = NULL;
+    moov_ = NULL;
+    samples_ = new SrsMp4SampleManager();
+}
+
+SrsMp4SeekIndex::~SrsMp4SeekIndex()
+{
+    srs_freep(ftyp_);
+    srs_freep(moov_);
+    srs_freep(samples_);
+}
+
+// Sort the sync samples by dts.
+bool srs_mp4_sample_dts_less(SrsMp4Sample* a, SrsMp4Sample* b)
+{
+    return a->dts_ms() < b->dts_ms();
+}
+
+// For binary search of sync samples by time.
+bool srs_mp4_time_less_sample(int64_t v, SrsMp4Sample* s)
+{
+    return v < (int64_t)s->dts_ms();
+}
+
+bool srs_mp4_sample_less_time(SrsMp4Sample* s, int64_t v)
+{
+    return (int64_t)s->dts_ms() < v;
+}
+
+// For binary search of samples by offset.
+bool srs_mp4_sample_less_offset(SrsMp4Sample* s, off_t v)
+{
+    return s->offset < v;
+}
+
+srs_error_t SrsMp4SeekIndex::initialize(ISrsReadSeeker* rs)
+{
+    srs_error_t err = srs_success;
+
+    SrsMp4BoxReader br;
+    if ((err = br.initialize(rs)) != srs_success) {
+        return srs_error_wrap(err, "init box reader");
+    }
+
+    SrsSimpleStream stream;
+    while (!moov_) {
+        SrsMp4Box* box = NULL;
+        if ((err = br.read(&stream, &box)) != srs_success) {
+            return srs_error_wrap(err, "read box");
+        }
+        SrsAutoFree(SrsMp4Box, box);
+
+        // Only decode the ftyp and moov, skip others such as mdat.
+        if (box->is_ftyp() || box->is_moov()) {
+            SrsBuffer buffer(stream.bytes(), stream.length());
+            if ((err = box->decode(&buffer)) != srs_success) {
+                return srs_error_wrap(err, "decode box");
+            }
+        }
+
+        if ((err = br.skip(box, &stream)) != srs_success) {
+            return srs_error_wrap(err, "skip box");
+        }
+
+        if (box->is_ftyp()) {
+            srs_freep(ftyp_);
+            ftyp_ = dynamic_cast<SrsMp4FileTypeBox*>(box);
+            box = NULL;
+        } else if (box->is_moov()) {
+            moov_ = dynamic_cast<SrsMp4MovieBox*>(box);
+            box = NULL;
+        }
+    }
+
+    if (!ftyp_) {
+        return srs_error_new(ERROR_MP4_BOX_ILLEGAL_SCHEMA, "missing ftyp");
+    }
+    if (!moov_->mvhd() || moov_->mvex()) {
+        return srs_error_new(ERROR_MP4_ILLEGAL_MOOV, "missing mvhd or fragmented");
+    }
+    if (moov_->nb_vide_tracks() > 1 || moov_->nb_soun_tracks() > 1) {
+        return srs_error_new(ERROR_MP4_ILLEGAL_MOOV, "multiple tracks, video=%d, audio=%d",
+            moov_->nb_vide_tracks(), moov_->nb_soun_tracks());
+    }
+
+    SrsMp4TrackBox* vide = moov_->video();
+    SrsMp4TrackBox* soun = moov_->audio();
+    if (!vide && !soun) {
+        return srs_error_new(ERROR_MP4_ILLEGAL_MOOV, "missing audio and video track");
+    }
+
+    if ((err = samples_->load(moov_)) != srs_success) {
+        return srs_error_wrap(err, "load samples");
+    }
+    if (samples_->samples.empty()) {
+        return srs_error_new(ERROR_MP4_ILLEGAL_SAMPLES, "no samples");
+    }
+
+    // The edit list is invalid for the cut file, so we remove it, and the samples start from zero.
+    if (vide) {
+        vide->remove(SrsMp4BoxTypeEDTS);
+    }
+    if (soun) {
+        soun->remove(SrsMp4BoxTypeEDTS);
+    }
+
+    // Build the sync points, video keyframes, or all audio samples for pure audio file.
+    for (int i = 0; i < (int)samples_->samples.size(); i++) {
+        SrsMp4Sample* sample = samples_->samples.at(i);
+        if (vide && (sample->type != SrsFrameTypeVideo || sample->frame_type != SrsVideoAvcFrameTypeKeyFrame)) {
+            continue;
+        }
+        syncs_.push_back(sample);
+    }
+    if (syncs_.empty()) {
+        return srs_error_new(ERROR_MP4_ILLEGAL_SAMPLES, "no sync samples");
+    }
+    std::stable_sort(syncs_.begin(), syncs_.end(), srs_mp4_sample_dts_less);
+
+    return err;
+}
+
+int SrsMp4SeekIndex::nb_samples()
+{
+    return (int)samples_->samples.size();
+}
+
+int64_t SrsMp4SeekIndex::duration()
+{
+    SrsMp4MovieHeaderBox* mvhd = moov_? moov_->mvhd() : NULL;
+    if (!mvhd || !mvhd->timescale) {
+        return 0;
+    }
+    return (int64_t)(mvhd->duration_in_tbn * 1000 / mvhd->timescale);
+}
+
+srs_error_t SrsMp4SeekIndex::seek(int64_t start, int64_t end, SrsSimpleStream* header, off_t* poffset, uint64_t* psize)
+{
+    srs_error_t err = srs_success;
+
+    if (!moov_) {
+        return srs_error_new(ERROR_MP4_ILLEGAL_MOOV, "not initialized");
+    }
+
+    // Find the last sync point at or before start, or the first one.
+    vector<SrsMp4Sample*>::iterator it = std::upper_bound(syncs_.begin(), syncs_.end(), start, srs_mp4_time_less_sample);
+    if (it != syncs_.begin()) {
+        --it;
+    }
+    off_t start_offset = (*it)->offset;
+
+    // Find the first sync point at or after end, the samples before it are included.
+    off_t end_offset = -1;
+    if (end >= 0) {
+        it = std::lower_bound(syncs_.begin(), syncs_.end(), end, srs_mp4_sample_less_time);
+        if (it != syncs_.end() && (*it)->offset > start_offset) {
+            end_offset = (*it)->offset;
+        }
+    }
+
+    vector<SrsMp4Sample*>& samples = samples_->samples;
+    int first = (int)(std::lower_bound(samples.begin(), samples.end(), start_offset, srs_mp4_sample_less_offset) - samples.begin());
+    int last = (int)samples.size();
+    if (end_offset >= 0) {
+        last = (int)(std::lower_bound(samples.begin(), samples.end(), end_offset, srs_mp4_sample_less_offset) - samples.begin());
+    }
+
+    // Copy the samples in range, the index is renumbered for each track.
+    SrsMp4SampleManager sm;
+    SrsMp4Sample* vfirst = NULL;
+    SrsMp4Sample* afirst = NULL;
+    uint32_t nn_videos = 0;
+    uint32_t nn_audios = 0;
+    for (int i = first; i < last; i++) {
+        SrsMp4Sample* sample = samples.at(i);
+
+        SrsMp4Sample* ps = new SrsMp4Sample();
+        ps->type = sample->type;
+        ps->index = (sample->type == SrsFrameTypeVideo)? nn_videos++ : nn_audios++;
+        ps->offset = sample->offset - start_offset;
+        ps->dts = sample->dts;
+        ps->pts = sample->pts;
+        ps->tbn = sample->tbn;
+        ps->frame_type = sample->frame_type;
+        ps->nb_data = sample->nb_data;
+        sm.append(ps);
+
+        if (sample->type == SrsFrameTypeVideo && !vfirst) {
+            vfirst = sample;
+        } else if (sample->type == SrsFrameTypeAudio && !afirst) {
+            afirst = sample;
+        }
+    }
+
+    // The duration of track, to the first sample not included, or the end of track.
+    SrsMp4TrackBox* vide = moov_->video();
+    SrsMp4TrackBox* soun = moov_->audio();
+    uint64_t vend = (vide && vide->mdhd())? vide->mdhd()->duration : 0;
+    uint64_t aend = (soun && soun->mdhd())? soun->mdhd()->duration : 0;
+    bool vfound = false, afound = false;
+    for (int i = last; i < (int)samples.size() && (!vfound || !afound); i++) {
+        SrsMp4Sample* sample = samples.at(i);
+        if (sample->type == SrsFrameTypeVideo && !vfound) {
+            vend = sample->dts;
+            vfound = true;
+        } else if (sample->type == SrsFrameTypeAudio && !afound) {
+            aend = sample->dts;
+            afound = true;
+        }
+    }
+    uint64_t vduration = (vfirst && vend > vfirst->dts)? vend - vfirst->dts : 0;
+    uint64_t aduration = (afirst && aend > afirst->dts)? aend - afirst->dts : 0;
+
+    // Write the moov, and rewrite it with the offset of mdat data, which depends on the size of moov.
+    // Generally the size of moov is not changed, unless the offset of sample overflows the stco.
+    int nb_header = 0;
+    bool done = false;
+    for (int i = 0; i < 3 && !done; i++) {
+        if ((err = write_moov(&sm, vduration, aduration)) != srs_success) {
+            return srs_error_wrap(err, "write moov");
+        }
+
+        uint64_t size = 0;
+        if (!sm.samples.empty()) {
+            SrsMp4Sample* ps = *sm.samples.rbegin();
+            size = ps->offset - nb_header + ps->nb_data;
+        }
+
+        int nn = (int)(ftyp_->nb_bytes() + moov_->nb_bytes()) + ((8 + size > 0xffffffff)? 16 : 8);
+        if (nn == nb_header) {
+            *poffset = start_offset;
+            *psize = size;
+            done = true;
+            break;
+        }
+
+        for (int j = 0; j < (int)sm.samples.size(); j++) {
+            sm.samples.at(j)->offset += nn - nb_header;
+        }
+        nb_header = nn;
+    }
+
+    if (!done) {
+        return srs_error_new(ERROR_MP4_ILLEGAL_MOOV, "moov size not stable, header=%d", nb_header);
+    }
+
+    // Encode the ftyp, moov and mdat header.
+    char* data = new char[nb_header];
+    SrsAutoFreeA(char, data);
+
+    SrsBuffer buffer(data, nb_header);
+    if ((err = ftyp_->encode(&buffer)) != srs_success) {
+        return srs_error_wrap(err, "encode ftyp");
+    }
+    if ((err = moov_->encode(&buffer)) != srs_success) {
+        return srs_error_wrap(err, "encode moov");
+    }
+
+    if (buffer.left() == 16) {
+        buffer.write_4bytes(1);
+        buffer.write_4bytes(SrsMp4BoxTypeMDAT);
+        buffer.write_8bytes(16 + *psize);
+    } else {
+        buffer.write_4bytes((int32_t)(8 + *psize));
+        buffer.write_4bytes(SrsMp4BoxTypeMDAT);
+    }
+
+    header->append(data, nb_header);
+
+    return err;
+}
+
+srs_error_t SrsMp4SeekIndex::write_moov(SrsMp4SampleManager* sm, uint64_t vduration, uint64_t aduration)
+{
+    srs_error_t err = srs_success;
+
+    SrsMp4MovieHeaderBox* mvhd = moov_->mvhd();
+    uint64_t duration = 0;
+
+    SrsMp4TrackBox* traks[] = {moov_->video(), moov_->audio()};
+    uint64_t durations[] = {vduration, aduration};
+    for (int i = 0; i < 2; i++) {
+        SrsMp4TrackBox* trak = traks[i];
+        if (!trak) {
+            continue;
+        }
+
+        // The optional tables are not always written, so we must remove them.
+        SrsMp4SampleTableBox* stbl = trak->stbl();
+        stbl->remove(SrsMp4BoxTypeSTCO);
+        stbl->remove(SrsMp4BoxTypeCO64);
+        stbl->remove(SrsMp4BoxTypeCTTS);
+        stbl->remove(SrsMp4BoxTypeSTSS);
+
+        SrsMp4MediaHeaderBox* mdhd = trak->mdhd();
+        if (mdhd) {
+            mdhd->duration = durations[i];
+        }
+
+        // The duration of tkhd is in timescale of mvhd.
+        uint64_t v = (mdhd && mdhd->timescale)? durations[i] * mvhd->timescale / mdhd->timescale : 0;
+        if (trak->tkhd()) {
+            trak->tkhd()->duration = v;
+        }
+        duration = srs_max(duration, v);
+    }
+    mvhd->duration_in_tbn = duration;
+
+    if ((err = sm->write(moov_)) != srs_success) {
+        return srs_error_wrap(err, "write samples");
+    }
+
+    return err;
+}
+
 SrsMp4Encoder::SrsMp4Encoder()
 {
     wsio = NULL;
@@ -6213,6 +6532,7 @@ SrsMp4ObjectType SrsMp4Encoder::get_audio_object_type()
 SrsMp4M2tsInitEncoder::SrsMp4M2tsInitEncoder()
 {
     writer = NULL;
+    hvc1_ = false;
 }
 
 SrsMp4M2tsInitEncoder::~SrsMp4M2tsInitEncoder()
@@ -6225,6 +6545,11 @@ srs_error_t SrsMp4M2tsInitEncoder::initialize(ISrsWriter* w)
     return srs_success;
 }
 
+void SrsMp4M2tsInitEncoder::set_hvc1(bool v)
+{
+    hvc1_ = v;
+}
+
 srs_error_t SrsMp4M2tsInitEncoder::write(SrsFormat* format, bool video, int tid)
 {
     srs_error_t err = srs_success;
@@ -6319,15 +6644,16 @@ srs_error_t SrsMp4M2tsInitEncoder::write(SrsFormat* format, bool video, int tid)
 
                 avcC->avc_config = format->vcodec->avc_extra_data;
             } else {
-                SrsMp4VisualSampleEntry* hev1 = new SrsMp4VisualSampleEntry(SrsMp4BoxTypeHEV1);
-                stsd->append(hev1);
+                // The hvc1 is required by Safari for CMAF HLS, see set_hvc1.
+                SrsMp4VisualSampleEntry* hvc1 = new SrsMp4VisualSampleEntry(hvc1_ ? SrsMp4BoxTypeHVC1 : SrsMp4BoxTypeHEV1);
+                stsd->append(hvc1);
 
-                hev1->width = format->vcodec->width;
-                hev1->height = format->vcodec->height;
-                hev1->data_reference_index = 1;
+                hvc1->width = format->vcodec->width;
+                hvc1->height = format->vcodec->height;
+                hvc1->data_reference_index = 1;
 
                 SrsMp4HvcCBox* hvcC = new SrsMp4HvcCBox();
-                hev1->set_hvcC(hvcC);
+                hvc1->set_hvcC(hvcC);
 
                 hvcC->hevc_config = format->vcodec->avc_extra_data;
             }
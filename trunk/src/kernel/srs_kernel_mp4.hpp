@@ -112,6 +112,7 @@ enum SrsMp4BoxType
     SrsMp4BoxTypeTRUN = 0x7472756e, // 'trun'
     SrsMp4BoxTypeSIDX = 0x73696478, // 'sidx'
     SrsMp4BoxTypeHEV1 = 0x68657631, // 'hev1'
+    SrsMp4BoxTypeHVC1 = 0x68766331, // 'hvc1'
     SrsMp4BoxTypeHVCC = 0x68766343, // 'hvcC'
 };
 
@@ -2041,6 +2042,41 @@ private:
     virtual srs_error_t do_load_next_box(SrsMp4Box** ppbox, uint32_t required_box_type);
 };
 
+// The index of a MP4 file to seek by time, which parses the moov and samples once, then cut the file for
+// each request without parsing it again. The cut file is a new ftyp, moov and mdat header, followed by
+// a range of the original mdat.
+class SrsMp4SeekIndex
+{
+private:
+    SrsMp4FileTypeBox* ftyp_;
+    // The moov is used as template to build the moov of cut file.
+    SrsMp4MovieBox* moov_;
+    // The samples sorted by offset in file.
+    SrsMp4SampleManager* samples_;
+    // The points to seek, sorted by dts. It's the video keyframes, or all samples for pure audio.
+    std::vector<SrsMp4Sample*> syncs_;
+public:
+    SrsMp4SeekIndex();
+    virtual ~SrsMp4SeekIndex();
+public:
+    // Parse the ftyp and moov from reader rs, and build the samples.
+    virtual srs_error_t initialize(ISrsReadSeeker* rs);
+    // Get the number of samples, to measure the memory of index.
+    virtual int nb_samples();
+    // Get the duration in milliseconds.
+    virtual int64_t duration();
+    // Cut the file from the sync point at or before start, to the sync point at or after end.
+    // @param start The start time in milliseconds.
+    // @param end The end time in milliseconds, -1 to the end of file.
+    // @param header Output the ftyp, moov and mdat header of the cut file.
+    // @param poffset Output the offset of mdat data in original file, to send after header.
+    // @param psize Output the size of mdat data.
+    virtual srs_error_t seek(int64_t start, int64_t end, SrsSimpleStream* header, off_t* poffset, uint64_t* psize);
+private:
+    // Write the samples to moov, update the durations of tracks.
+    virtual srs_error_t write_moov(SrsMp4SampleManager* sm, uint64_t vduration, uint64_t aduration);
+};
+
 // The MP4 muxer.
 class SrsMp4Encoder
 {
@@ -2115,12 +2151,17 @@ class SrsMp4M2tsInitEncoder
 {
 private:
     ISrsWriter* writer;
+    // Whether write HEVC as hvc1, default to hev1.
+    bool hvc1_;
 public:
     SrsMp4M2tsInitEncoder();
     virtual ~SrsMp4M2tsInitEncoder();
 public:
     // Initialize the encoder with a writer w.
     virtual srs_error_t initialize(ISrsWriter* w);
+    // Write HEVC as hvc1 sample entry, which is required by Safari for HLS. The parameter sets are always
+    // in the hvcC of init mp4, so both hev1 and hvc1 are ok for fmp4.
+    virtual void set_hvc1(bool v);
     // Write the sequence header.
     virtual srs_error_t write(SrsFormat* format, bool video, int tid);
 };
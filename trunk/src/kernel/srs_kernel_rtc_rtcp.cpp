@@ -1228,12 +1228,20 @@ vector<uint16_t> SrsRtcpNack::get_lost_sns() const
     for(set<uint16_t, SrsSeqCompareLess>::iterator it = lost_sns_.begin(); it != lost_sns_.end(); ++it) {
         sn.push_back(*it);
     }
+    for(vector<SrsPidBlp>::const_iterator it = pid_blps_.begin(); it != pid_blps_.end(); ++it) {
+        sn.push_back(it->pid);
+        for(int j = 0; j < 16; j++) {
+            if(it->blp & (1 << j)) {
+                sn.push_back(it->pid + j + 1);
+            }
+        }
+    }
     return sn;
 }
 
 bool SrsRtcpNack::empty()
 {
-    return lost_sns_.empty();
+    return lost_sns_.empty() && pid_blps_.empty();
 }
 
 void SrsRtcpNack::set_media_ssrc(uint32_t ssrc)
@@ -1246,6 +1254,15 @@ void SrsRtcpNack::add_lost_sn(uint16_t sn)
     lost_sns_.insert(sn);
 }
 
+void SrsRtcpNack::add_lost_pid_blp(uint16_t pid, uint16_t blp)
+{
+    SrsPidBlp chunk;
+    chunk.pid = pid;
+    chunk.blp = blp;
+    chunk.in_use = true;
+    pid_blps_.push_back(chunk);
+}
+
 srs_error_t SrsRtcpNack::decode(SrsBuffer *buffer)
 {
     /*
@@ -1360,6 +1377,7 @@ srs_error_t SrsRtcpNack::encode(SrsBuffer *buffer)
         if(chunk.in_use) {
             chunks.push_back(chunk);
         }
+        chunks.insert(chunks.end(), pid_blps_.begin(), pid_blps_.end());
 
         header_.length = 2 + chunks.size();
         if(srs_success != (err = encode_header(buffer))) {
@@ -323,6 +323,8 @@ private:
 
     uint32_t media_ssrc_;
     std::set<uint16_t, SrsSeqCompareLess> lost_sns_;
+    // The FCI generated by caller, encode it directly.
+    std::vector<SrsPidBlp> pid_blps_;
 public:
     SrsRtcpNack(uint32_t sender_ssrc = 0);
     virtual ~SrsRtcpNack();
@@ -333,6 +335,8 @@ public:
 
     void set_media_ssrc(uint32_t ssrc);
     void add_lost_sn(uint16_t sn);
+    // Add the FCI, the pid is the lost seq, and each bit of blp is a lost seq following pid.
+    void add_lost_pid_blp(uint16_t pid, uint16_t blp);
 // interface ISrsCodec
 public:
     virtual srs_error_t decode(SrsBuffer *buffer);
@@ -18,6 +18,7 @@ using namespace std;
 #include <srs_kernel_flv.hpp>
 
 #include <srs_kernel_kbps.hpp>
+#include <srs_core_autofree.hpp>
 
 SrsPps* _srs_pps_objs_rtps = NULL;
 SrsPps* _srs_pps_objs_rraw = NULL;
@@ -841,6 +842,16 @@ SrsRtpPacket* SrsRtpPacket::copy()
     return cp;
 }
 
+char* SrsRtpPacket::buffer_bytes()
+{
+    return shared_buffer_? shared_buffer_->payload : NULL;
+}
+
+int SrsRtpPacket::buffer_size()
+{
+    return shared_buffer_? actual_buffer_size_ : 0;
+}
+
 void SrsRtpPacket::set_padding(int size)
 {
     header.set_padding(size);
@@ -949,12 +960,12 @@ bool SrsRtpPacket::is_keyframe()
     // It's normal H264 video rtp packet
     if (nalu_type == kStapA) {
         SrsRtpSTAPPayload* stap_payload = dynamic_cast<SrsRtpSTAPPayload*>(payload_);
-        if(NULL != stap_payload->get_sps() || NULL != stap_payload->get_pps()) {
+        if(stap_payload && (NULL != stap_payload->get_sps() || NULL != stap_payload->get_pps())) {
             return true;
         }
     } else if (nalu_type == kFuA) {
         SrsRtpFUAPayload2* fua_payload = dynamic_cast<SrsRtpFUAPayload2*>(payload_);
-        if(SrsAvcNaluTypeIDR == fua_payload->nalu_type) {
+        if(fua_payload && SrsAvcNaluTypeIDR == fua_payload->nalu_type) {
             return true;
         }
     } else {
@@ -1516,3 +1527,604 @@ ISrsRtpPayloader* SrsRtpFUAPayload2::copy()
 
     return cp;
 }
+
+// XOR the src to dst, 8 bytes a time, the memcpy will be optimized to load and store.
+static void srs_rtp_fec_xor(char* dst, const char* src, int size)
+{
+    int i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t a, b;
+        memcpy(&a, dst + i, 8);
+        memcpy(&b, src + i, 8);
+        a ^= b;
+        memcpy(dst + i, &a, 8);
+    }
+    for (; i < size; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+// Get the protected bytes of packet, which is the CSRC list at [kRtpHeaderFixedSize, offset) and the
+// payload with padding at [payload, size), the header extensions are excluded if normalized.
+// Return the size of protected bytes, or -1 if invalid packet.
+static int srs_rtp_fec_protected(const char* data, int size, bool normalized, int& offset, int& payload)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    offset = payload = kRtpHeaderFixedSize + 4 * (p[0] & 0x0f);
+    if (payload > size) {
+        return -1;
+    }
+
+    // Skip the header extensions, @see https://tools.ietf.org/html/rfc3550#section-5.3.1
+    if (normalized && (p[0] & 0x10) != 0) {
+        if (payload + 4 > size) {
+            return -1;
+        }
+        payload += 4 + 4 * ((p[payload + 2] << 8) | p[payload + 3]);
+        if (payload > size) {
+            return -1;
+        }
+    }
+
+    return offset - kRtpHeaderFixedSize + size - payload;
+}
+
+// XOR the protected bytes of packet to dst, see srs_rtp_fec_protected.
+static void srs_rtp_fec_xor_protected(char* dst, const char* data, int size, int offset, int payload)
+{
+    int nn_csrc = offset - kRtpHeaderFixedSize;
+    srs_rtp_fec_xor(dst, data + kRtpHeaderFixedSize, nn_csrc);
+    srs_rtp_fec_xor(dst + nn_csrc, data + payload, size - payload);
+}
+
+SrsRtpRedPayload::SrsRtpRedPayload()
+{
+    primary_pt = 0;
+    primary = NULL;
+
+    ++_srs_pps_objs_rothers->sugar;
+}
+
+SrsRtpRedPayload::~SrsRtpRedPayload()
+{
+    srs_freep(primary);
+}
+
+/* @see https://www.rfc-editor.org/rfc/rfc2198#section-3
+  0                   1                    2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |F|   block PT  |  timestamp offset         |   block length    |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ The last block header is only one byte, F=0 and the block PT.
+*/
+uint64_t SrsRtpRedPayload::nb_bytes()
+{
+    int size = 1 + (primary? primary->nb_bytes() : 0);
+    for (int i = 0; i < (int)redundants.size(); i++) {
+        size += 4 + redundants[i].size;
+    }
+    return size;
+}
+
+srs_error_t SrsRtpRedPayload::encode(SrsBuffer* buf)
+{
+    srs_error_t err = srs_success;
+
+    int size = 1;
+    for (int i = 0; i < (int)redundants.size(); i++) {
+        size += 4 + redundants[i].size;
+    }
+    if (!buf->require(size)) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "requires %d bytes", size);
+    }
+
+    // The headers of redundant blocks, F=1.
+    for (int i = 0; i < (int)redundants.size(); i++) {
+        const SrsRtpRedBlock& block = redundants[i];
+        buf->write_1bytes(0x80 | (primary_pt & 0x7f));
+        buf->write_3bytes(((block.ts_offset & 0x3fff) << 10) | (block.size & 0x3ff));
+    }
+
+    // The RED header, F=0 for the last block.
+    buf->write_1bytes(primary_pt & 0x7f);
+
+    for (int i = 0; i < (int)redundants.size(); i++) {
+        const SrsRtpRedBlock& block = redundants[i];
+        buf->write_bytes(block.payload, block.size);
+    }
+
+    if (primary && (err = primary->encode(buf)) != srs_success) {
+        return srs_error_wrap(err, "encode primary");
+    }
+
+    return err;
+}
+
+srs_error_t SrsRtpRedPayload::decode(SrsBuffer* buf)
+{
+    srs_error_t err = srs_success;
+
+    redundants.clear();
+
+    while (true) {
+        if (!buf->require(1)) {
+            return srs_error_new(ERROR_RTC_RTP_MUXER, "requires %d bytes", 1);
+        }
+
+        uint8_t v = buf->read_1bytes();
+        if ((v & 0x80) == 0) {
+            primary_pt = v & 0x7f;
+            break;
+        }
+
+        if (!buf->require(3)) {
+            return srs_error_new(ERROR_RTC_RTP_MUXER, "requires %d bytes", 3);
+        }
+
+        int32_t offset_length = buf->read_3bytes();
+        SrsRtpRedBlock block;
+        block.ts_offset = (offset_length >> 10) & 0x3fff;
+        block.size = offset_length & 0x3ff;
+        block.payload = NULL;
+        redundants.push_back(block);
+    }
+
+    for (int i = 0; i < (int)redundants.size(); i++) {
+        SrsRtpRedBlock& block = redundants[i];
+        if (!buf->require(block.size)) {
+            return srs_error_new(ERROR_RTC_RTP_MUXER, "requires %d bytes", block.size);
+        }
+        block.payload = buf->head();
+        buf->skip(block.size);
+    }
+
+    srs_freep(primary);
+    primary = new SrsRtpRawPayload();
+    if ((err = primary->decode(buf)) != srs_success) {
+        return srs_error_wrap(err, "decode primary");
+    }
+
+    return err;
+}
+
+ISrsRtpPayloader* SrsRtpRedPayload::copy()
+{
+    SrsRtpRedPayload* cp = new SrsRtpRedPayload();
+
+    cp->primary_pt = primary_pt;
+    cp->primary = primary? primary->copy() : NULL;
+    cp->redundants = redundants;
+
+    return cp;
+}
+
+SrsRtpRedEncoder::SrsRtpRedEncoder(int distance)
+{
+    distance_ = distance;
+}
+
+SrsRtpRedEncoder::~SrsRtpRedEncoder()
+{
+    clear();
+}
+
+srs_error_t SrsRtpRedEncoder::encode(SrsRtpPacket* pkt, SrsRtpPacket** pred)
+{
+    srs_error_t err = srs_success;
+
+    // Reset the history if SSRC changed.
+    if (!history_.empty() && history_.back()->header.get_ssrc() != pkt->header.get_ssrc()) {
+        clear();
+    }
+
+    uint16_t seq = pkt->header.get_sequence();
+    uint32_t ts = pkt->header.get_timestamp();
+    int nn_primary = pkt->payload()? pkt->payload()->nb_bytes() : 0;
+
+    // Choose the previous packets, the newest first, which should be recent and fit the block header.
+    int size = nn_primary;
+    int nn_max = kRtpPacketSize - pkt->header.nb_bytes() - 1;
+    vector<SrsRtpPacket*> blocks;
+    for (int i = (int)history_.size() - 1; i >= 0; i--) {
+        SrsRtpPacket* p = history_.at(i);
+
+        int16_t distance = srs_rtp_seq_distance(p->header.get_sequence(), seq);
+        int32_t ts_offset = (int32_t)(ts - p->header.get_timestamp());
+        int nn = p->payload()? p->payload()->nb_bytes() : 0;
+        if (distance <= 0 || distance > distance_ || ts_offset <= 0 || ts_offset > 0x3fff) {
+            continue;
+        }
+        if (nn <= 0 || nn > 0x3ff || size + 4 + nn > nn_max) {
+            continue;
+        }
+
+        size += 4 + nn;
+        blocks.insert(blocks.begin(), p);
+    }
+
+    // Copy the payloads to a new buffer, the redundant blocks then the primary.
+    SrsRtpPacket* red = new SrsRtpPacket();
+    SrsAutoFree(SrsRtpPacket, red);
+
+    red->header = pkt->header;
+    red->header.set_padding(0);
+    red->frame_type = pkt->frame_type;
+    red->set_avsync_time(pkt->get_avsync_time());
+
+    int nn_buf = size - 4 * (int)blocks.size();
+    char* p = red->wrap(nn_buf);
+    SrsBuffer b(p, nn_buf);
+
+    SrsRtpRedPayload* payload = new SrsRtpRedPayload();
+    red->set_payload(payload, SrsRtspPacketPayloadTypeRED);
+    payload->primary_pt = pkt->header.get_payload_type();
+
+    for (int i = 0; i < (int)blocks.size(); i++) {
+        SrsRtpPacket* block_pkt = blocks.at(i);
+
+        SrsRtpRedBlock block;
+        block.ts_offset = (uint16_t)(ts - block_pkt->header.get_timestamp());
+        block.payload = b.head();
+        block.size = block_pkt->payload()->nb_bytes();
+        if ((err = block_pkt->payload()->encode(&b)) != srs_success) {
+            return srs_error_wrap(err, "encode block seq=%u", block_pkt->header.get_sequence());
+        }
+        payload->redundants.push_back(block);
+    }
+
+    SrsRtpRawPayload* primary = new SrsRtpRawPayload();
+    payload->primary = primary;
+    primary->payload = b.head();
+    primary->nn_payload = nn_primary;
+    if (pkt->payload() && (err = pkt->payload()->encode(&b)) != srs_success) {
+        return srs_error_wrap(err, "encode primary seq=%u", seq);
+    }
+
+    // Keep the packet as history, which shares the buffer.
+    history_.push_back(pkt->copy());
+    while ((int)history_.size() > distance_) {
+        SrsRtpPacket* p = history_.front();
+        srs_freep(p);
+        history_.erase(history_.begin());
+    }
+
+    *pred = red;
+    red = NULL;
+
+    return err;
+}
+
+void SrsRtpRedEncoder::clear()
+{
+    for (int i = 0; i < (int)history_.size(); i++) {
+        SrsRtpPacket* p = history_.at(i);
+        srs_freep(p);
+    }
+    history_.clear();
+}
+
+int srs_rtp_red_decapsulate(char* data, int size, uint8_t red_pt, uint8_t fec_pt)
+{
+    if (size < kRtpHeaderFixedSize || (uint8_t)(data[1] & 0x7f) != red_pt) {
+        return size;
+    }
+
+    // Skip the CSRC and extensions, @see https://tools.ietf.org/html/rfc3550#section-5.3.1
+    uint8_t* p = (uint8_t*)data;
+    int offset = kRtpHeaderFixedSize + 4 * (p[0] & 0x0f);
+    if ((p[0] & 0x10) != 0) {
+        if (offset + 4 > size) {
+            return size;
+        }
+        offset += 4 + 4 * ((p[offset + 2] << 8) | p[offset + 3]);
+    }
+    if (offset >= size) {
+        return size;
+    }
+
+    // Ignore the FEC block, or multiple blocks.
+    uint8_t block = p[offset];
+    if ((block & 0x80) != 0 || (block & 0x7f) == fec_pt) {
+        return size;
+    }
+
+    // Restore the PT of media, keep the marker.
+    p[1] = (p[1] & 0x80) | (block & 0x7f);
+    memmove(data + offset, data + offset + 1, size - offset - 1);
+
+    return size - 1;
+}
+
+SrsRtpUlpfecPayload::SrsRtpUlpfecPayload()
+{
+    fec_pt = 0;
+    pxcc_recovery = mpt_recovery = 0;
+    sn_base = 0;
+    ts_recovery = 0;
+    length_recovery = 0;
+    mask = 0;
+
+    payload = NULL;
+    nn_payload = 0;
+    normalized = false;
+
+    ++_srs_pps_objs_rothers->sugar;
+}
+
+SrsRtpUlpfecPayload::~SrsRtpUlpfecPayload()
+{
+}
+
+bool SrsRtpUlpfecPayload::is_protected(uint16_t seq)
+{
+    uint16_t offset = (uint16_t)(seq - sn_base);
+    return offset < 16 && (mask & (0x8000 >> offset)) != 0;
+}
+
+srs_error_t SrsRtpUlpfecPayload::recover(uint16_t seq, uint32_t ssrc, const std::vector<SrsRtpPacket*>& pkts, SrsBuffer* buf)
+{
+    srs_error_t err = srs_success;
+
+    uint8_t pxcc = pxcc_recovery;
+    uint8_t mpt = mpt_recovery;
+    uint32_t ts = ts_recovery;
+    uint16_t length = length_recovery;
+
+    char data[kRtpPacketSize];
+    memcpy(data, payload, nn_payload);
+
+    for (int i = 0; i < (int)pkts.size(); i++) {
+        SrsRtpPacket* pkt = pkts.at(i);
+
+        // Use the received bytes, because the unknown extensions are dropped when encoding.
+        char* p = pkt->buffer_bytes();
+        int offset = 0, start = 0;
+        int size = p ? srs_rtp_fec_protected(p, pkt->buffer_size(), normalized, offset, start) : -1;
+        if (size < 0 || size > nn_payload) {
+            return srs_error_new(ERROR_RTC_RTP_MUXER, "seq=%u size=%d exceed %d", pkt->header.get_sequence(), size, nn_payload);
+        }
+
+        pxcc ^= (uint8_t)(normalized ? (p[0] & 0xef) : p[0]);
+        mpt ^= (uint8_t)p[1];
+        ts ^= pkt->header.get_timestamp();
+        length ^= (uint16_t)size;
+        srs_rtp_fec_xor_protected(data, p, pkt->buffer_size(), offset, start);
+    }
+
+    if (length > nn_payload) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "seq=%u length=%d exceed %d", seq, length, nn_payload);
+    }
+
+    if (!buf->require(kRtpHeaderFixedSize + length)) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "requires %d bytes", kRtpHeaderFixedSize + length);
+    }
+
+    // The version is always 2, @see https://www.rfc-editor.org/rfc/rfc5109#section-9.1
+    buf->write_1bytes(0x80 | (pxcc & 0x3f));
+    buf->write_1bytes(mpt);
+    buf->write_2bytes(seq);
+    buf->write_4bytes(ts);
+    buf->write_4bytes(ssrc);
+    buf->write_bytes(data, length);
+
+    return err;
+}
+
+/* @see https://www.rfc-editor.org/rfc/rfc5109#section-7.3
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |E|L|P|X|  CC   |M| PT recovery |            SN base            |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                          TS recovery                          |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |        length recovery        |       Protection Length       |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |             mask              |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ The FEC header is after the one byte RED header(F=0, block PT).
+*/
+uint64_t SrsRtpUlpfecPayload::nb_bytes()
+{
+    return 1 + 10 + 4 + nn_payload;
+}
+
+srs_error_t SrsRtpUlpfecPayload::encode(SrsBuffer* buf)
+{
+    if (!buf->require(1 + 10 + 4 + nn_payload)) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "requires %d bytes", 1 + 10 + 4 + nn_payload);
+    }
+
+    // The RED header, F=0 for the last block.
+    buf->write_1bytes(fec_pt & 0x7f);
+
+    // The FEC header, E=0 and L=0.
+    buf->write_1bytes(pxcc_recovery & 0x3f);
+    buf->write_1bytes(mpt_recovery);
+    buf->write_2bytes(sn_base);
+    buf->write_4bytes(ts_recovery);
+    buf->write_2bytes(length_recovery);
+
+    // The ULP level 0 header and payload.
+    buf->write_2bytes(nn_payload);
+    buf->write_2bytes(mask);
+    buf->write_bytes(payload, nn_payload);
+
+    return srs_success;
+}
+
+srs_error_t SrsRtpUlpfecPayload::decode(SrsBuffer* buf)
+{
+    if (!buf->require(1 + 10 + 4)) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "requires %d bytes", 1 + 10 + 4);
+    }
+
+    uint8_t v = buf->read_1bytes();
+    if ((v & 0x80) != 0) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "RED with multiple blocks");
+    }
+    fec_pt = v & 0x7f;
+
+    v = buf->read_1bytes();
+    if ((v & 0xc0) != 0) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "FEC with E=%d, L=%d", (v >> 7) & 0x01, (v >> 6) & 0x01);
+    }
+    pxcc_recovery = v & 0x3f;
+    mpt_recovery = buf->read_1bytes();
+    sn_base = buf->read_2bytes();
+    ts_recovery = buf->read_4bytes();
+    length_recovery = buf->read_2bytes();
+
+    nn_payload = buf->read_2bytes();
+    mask = buf->read_2bytes();
+
+    if (nn_payload > kRtpPacketSize || !buf->require(nn_payload)) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "requires %d bytes", nn_payload);
+    }
+    payload = buf->head();
+    buf->skip(nn_payload);
+
+    return srs_success;
+}
+
+ISrsRtpPayloader* SrsRtpUlpfecPayload::copy()
+{
+    SrsRtpUlpfecPayload* cp = new SrsRtpUlpfecPayload();
+
+    cp->fec_pt = fec_pt;
+    cp->pxcc_recovery = pxcc_recovery;
+    cp->mpt_recovery = mpt_recovery;
+    cp->sn_base = sn_base;
+    cp->ts_recovery = ts_recovery;
+    cp->length_recovery = length_recovery;
+    cp->mask = mask;
+    cp->payload = payload;
+    cp->nn_payload = nn_payload;
+    cp->normalized = normalized;
+
+    return cp;
+}
+
+SrsRtpFecEncoder::SrsRtpFecEncoder(int group_size)
+{
+    group_size_ = srs_max(2, srs_min(16, group_size));
+    nn_packets_ = 0;
+
+    pxcc_ = mpt_ = 0;
+    sn_base_ = 0;
+    ts_ = 0;
+    length_ = 0;
+    mask_ = 0;
+    data_ = new char[kRtpPacketSize];
+    nn_data_ = 0;
+
+    ssrc_ = 0;
+    last_seq_ = 0;
+    last_ts_ = 0;
+}
+
+SrsRtpFecEncoder::~SrsRtpFecEncoder()
+{
+    srs_freepa(data_);
+}
+
+srs_error_t SrsRtpFecEncoder::encode(SrsRtpPacket* pkt, std::vector<SrsRtpPacket*>& fecs)
+{
+    srs_error_t err = srs_success;
+
+    uint16_t seq = pkt->header.get_sequence();
+
+    // Start a new group if the packet is out of the mask, or from other SSRC.
+    if (nn_packets_ > 0) {
+        int16_t distance = srs_rtp_seq_distance(sn_base_, seq);
+        if (ssrc_ != pkt->header.get_ssrc() || distance <= 0 || distance >= 16) {
+            fecs.push_back(flush());
+        }
+    }
+
+    char tmp[kRtpPacketSize];
+    SrsBuffer b(tmp, sizeof(tmp));
+    if ((err = pkt->encode(&b)) != srs_success) {
+        return srs_error_wrap(err, "encode seq=%u", seq);
+    }
+
+    // Protect the CSRC list and payload, without the header extensions which are changed by subscriber.
+    int offset = 0, start = 0;
+    int size = srs_rtp_fec_protected(tmp, b.pos(), true, offset, start);
+    if (size < 0) {
+        return srs_error_new(ERROR_RTC_RTP_MUXER, "invalid seq=%u", seq);
+    }
+
+    // Ignore the packet if the FEC packet is too large, which is the RTP header, RED header and FEC header.
+    if (kRtpHeaderFixedSize + 1 + 10 + 4 + size > kRtpPacketSize) {
+        if (nn_packets_ > 0) {
+            fecs.push_back(flush());
+        }
+        return err;
+    }
+
+    if (nn_packets_ == 0) {
+        sn_base_ = seq;
+        ssrc_ = pkt->header.get_ssrc();
+    }
+
+    // Zero the bytes beyond the longest packet, so we XOR as padding by zero.
+    if (size > nn_data_) {
+        memset(data_ + nn_data_, 0, size - nn_data_);
+        nn_data_ = size;
+    }
+    srs_rtp_fec_xor_protected(data_, tmp, b.pos(), offset, start);
+
+    pxcc_ ^= (uint8_t)(tmp[0] & 0xef);
+    mpt_ ^= (uint8_t)tmp[1];
+    ts_ ^= pkt->header.get_timestamp();
+    length_ ^= (uint16_t)size;
+    mask_ |= 0x8000 >> (uint16_t)(seq - sn_base_);
+
+    last_seq_ = seq;
+    last_ts_ = pkt->header.get_timestamp();
+    nn_packets_++;
+
+    if (nn_packets_ >= group_size_ || pkt->header.get_marker()) {
+        fecs.push_back(flush());
+    }
+
+    return err;
+}
+
+SrsRtpPacket* SrsRtpFecEncoder::flush()
+{
+    if (nn_packets_ == 0) {
+        return NULL;
+    }
+
+    SrsRtpPacket* fec = new SrsRtpPacket();
+    fec->frame_type = SrsFrameTypeVideo;
+    fec->header.set_ssrc(ssrc_);
+    fec->header.set_sequence(last_seq_);
+    fec->header.set_timestamp(last_ts_);
+
+    char* p = fec->wrap(data_, nn_data_);
+
+    SrsRtpUlpfecPayload* payload = new SrsRtpUlpfecPayload();
+    payload->pxcc_recovery = pxcc_;
+    payload->mpt_recovery = mpt_;
+    payload->sn_base = sn_base_;
+    payload->ts_recovery = ts_;
+    payload->length_recovery = length_;
+    payload->mask = mask_;
+    payload->payload = p;
+    payload->nn_payload = nn_data_;
+    payload->normalized = true;
+    fec->set_payload(payload, SrsRtspPacketPayloadTypeFEC);
+
+    nn_packets_ = 0;
+    pxcc_ = mpt_ = 0;
+    ts_ = 0;
+    length_ = 0;
+    mask_ = 0;
+    nn_data_ = 0;
+
+    return fec;
+}
@@ -41,6 +41,7 @@ const uint8_t kEnd              = 0x40; // Fu-header end bit
 class SrsBuffer;
 class SrsRtpRawPayload;
 class SrsRtpFUAPayload2;
+class SrsRtpUlpfecPayload;
 class SrsSharedPtrMessage;
 class SrsRtpExtensionTypes;
 
@@ -256,6 +257,8 @@ enum SrsRtspPacketPayloadType
     SrsRtspPacketPayloadTypeFUA,
     SrsRtspPacketPayloadTypeNALU,
     SrsRtspPacketPayloadTypeSTAP,
+    SrsRtspPacketPayloadTypeRED,
+    SrsRtspPacketPayloadTypeFEC,
     SrsRtspPacketPayloadTypeUnknown,
 };
 
@@ -311,13 +314,17 @@ public:
     char* wrap(SrsSharedPtrMessage* msg);
     // Copy the RTP packet.
     virtual SrsRtpPacket* copy();
+    // Get the bytes and size of the under-layer buffer, which is the whole RTP packet if decoded from bytes.
+    char* buffer_bytes();
+    int buffer_size();
 public:
     // Parse the TWCC extension, ignore by default.
     void enable_twcc_decode() { header.enable_twcc_decode(); } // SrsRtpPacket::enable_twcc_decode
     // Get and set the payload of packet.
     // @remark Note that return NULL if no payload.
-    void set_payload(ISrsRtpPayloader* p, SrsRtspPacketPayloadType pt) { payload_ = p; payload_type_ = pt; }
+    void set_payload(ISrsRtpPayloader* p, SrsRtspPacketPayloadType pt) { payload_ = p; payload_type_ = pt; cached_payload_size = 0; }
     ISrsRtpPayloader* payload() { return payload_; }
+    SrsRtspPacketPayloadType payload_type() { return payload_type_; }
     // Set the padding of RTP packet.
     void set_padding(int size);
     // Increase the padding of RTP packet.
@@ -456,4 +463,142 @@ public:
     virtual ISrsRtpPayloader* copy();
 };
 
+// The redundant block of RED, which is the payload of a previous packet.
+struct SrsRtpRedBlock
+{
+    // The timestamp offset to the primary block, 14 bits.
+    uint16_t ts_offset;
+    // @remark We only refer to the memory, user must free its bytes.
+    char* payload;
+    int size;
+};
+
+// The RED payload, which wraps the media payload as the primary block, with optional
+// redundant blocks, all blocks are in the PT of media.
+// @see https://www.rfc-editor.org/rfc/rfc2198#section-3
+class SrsRtpRedPayload : public ISrsRtpPayloader
+{
+public:
+    // The PT of primary block, which is the PT of media.
+    uint8_t primary_pt;
+    // The primary payload, we manage it.
+    ISrsRtpPayloader* primary;
+    // The redundant blocks, the oldest first.
+    std::vector<SrsRtpRedBlock> redundants;
+public:
+    SrsRtpRedPayload();
+    virtual ~SrsRtpRedPayload();
+// interface ISrsRtpPayloader
+public:
+    virtual uint64_t nb_bytes();
+    virtual srs_error_t encode(SrsBuffer* buf);
+    virtual srs_error_t decode(SrsBuffer* buf);
+    virtual ISrsRtpPayloader* copy();
+};
+
+// The RED encoder for audio, which packs the previous packets as redundant blocks, so that
+// the player recovers the lost packet without retransmission.
+// @see https://www.rfc-editor.org/rfc/rfc2198
+class SrsRtpRedEncoder
+{
+private:
+    // The max number of redundant blocks.
+    int distance_;
+    // The previous packets, the oldest first.
+    std::vector<SrsRtpPacket*> history_;
+public:
+    SrsRtpRedEncoder(int distance);
+    virtual ~SrsRtpRedEncoder();
+public:
+    // Pack the packet with previous packets to a RED packet, which is in the PT of media, and
+    // the payload is copied to a new buffer, so it's safe to share it. User must free it.
+    srs_error_t encode(SrsRtpPacket* pkt, SrsRtpPacket** pred);
+private:
+    void clear();
+};
+
+// Remove the RED header of packet in place, to restore the media packet, return the new size.
+// @remark Ignore if not RED, or the block is FEC, or there are multiple blocks.
+extern int srs_rtp_red_decapsulate(char* data, int size, uint8_t red_pt, uint8_t fec_pt);
+
+// The ULPFEC payload in RED, with one protection level and 16 bits mask(L=0), which protects
+// at most 16 packets by XOR, and the FEC packet is in the same SSRC and sequence space.
+// @see https://www.rfc-editor.org/rfc/rfc5109#section-7
+// @see https://www.rfc-editor.org/rfc/rfc2198#section-3
+class SrsRtpUlpfecPayload : public ISrsRtpPayloader
+{
+public:
+    // The block PT in RED header, which is the PT of ULPFEC.
+    uint8_t fec_pt;
+    // The FEC header, XOR of the protected packets.
+    // The P, X and CC of RTP header.
+    uint8_t pxcc_recovery;
+    // The marker and PT of RTP header.
+    uint8_t mpt_recovery;
+    uint16_t sn_base;
+    uint32_t ts_recovery;
+    // The XOR of size of packets, exclude the RTP fixed header.
+    uint16_t length_recovery;
+    // The ULP level 0 mask, the MSB is the sn_base, and the LSB is sn_base+15.
+    uint16_t mask;
+    // The ULP level 0 payload, XOR of packets after the RTP fixed header.
+    // @remark We only refer to the memory, user must free its bytes.
+    char* payload;
+    int nn_payload;
+    // Whether the header extensions are normalized, that is, excluded from the protected bytes with
+    // the X bit cleared, so only the CSRC list and payload are protected, see SrsRtpFecEncoder.
+    // @remark It's not in the packet, the FEC of publisher protects all bytes after the fixed header.
+    bool normalized;
+public:
+    SrsRtpUlpfecPayload();
+    virtual ~SrsRtpUlpfecPayload();
+public:
+    // Whether the packet of seq is protected by this FEC.
+    bool is_protected(uint16_t seq);
+    // Recover the packet of seq, by all other protected packets, write the RTP packet to buf.
+    // @remark The pkts must be exactly the protected packets except the lost one, and decoded from bytes.
+    srs_error_t recover(uint16_t seq, uint32_t ssrc, const std::vector<SrsRtpPacket*>& pkts, SrsBuffer* buf);
+// interface ISrsRtpPayloader
+public:
+    virtual uint64_t nb_bytes();
+    virtual srs_error_t encode(SrsBuffer* buf);
+    virtual srs_error_t decode(SrsBuffer* buf);
+    virtual ISrsRtpPayloader* copy();
+};
+
+// The ULPFEC encoder, which XOR a group of packets to generate a FEC packet. The group is done
+// when got group size packets, or the marker packet, or the packet is out of the 16 bits mask.
+// @remark The header extensions are normalized, because they are changed by each subscriber, for
+//      example, the twcc sequence, so the packet is recovered without header extensions.
+// @remark The generated FEC packet is a template, the user should set the FEC PT, and the SN base
+//      and TS recovery if the sequence or timestamp of packets are changed, see SrsRtcVideoSendTrack.
+class SrsRtpFecEncoder
+{
+private:
+    // The max number of packets in group, in [2, 16].
+    int group_size_;
+    int nn_packets_;
+    // The FEC header and payload of group.
+    uint8_t pxcc_;
+    uint8_t mpt_;
+    uint16_t sn_base_;
+    uint32_t ts_;
+    uint16_t length_;
+    uint16_t mask_;
+    char* data_;
+    int nn_data_;
+    // The last packet of group.
+    uint32_t ssrc_;
+    uint16_t last_seq_;
+    uint32_t last_ts_;
+public:
+    SrsRtpFecEncoder(int group_size);
+    virtual ~SrsRtpFecEncoder();
+public:
+    // Protect the packet, append the FEC packets to fecs when group is done, user must free them.
+    srs_error_t encode(SrsRtpPacket* pkt, std::vector<SrsRtpPacket*>& fecs);
+    // Generate the FEC packet for the current group, NULL if group is empty.
+    SrsRtpPacket* flush();
+};
+
 #endif
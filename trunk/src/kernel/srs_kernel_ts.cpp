@@ -188,6 +188,9 @@ SrsTsContext::SrsTsContext()
     sync_byte = 0x47; // ts default sync byte.
     vcodec = SrsVideoCodecIdReserved;
     acodec = SrsAudioCodecIdReserved1;
+    arena_ = NULL;
+    iovs_ = NULL;
+    nn_iovs_ = nn_packets_ = 0;
 }
 
 SrsTsContext::~SrsTsContext()
@@ -198,6 +201,9 @@ SrsTsContext::~SrsTsContext()
         srs_freep(channel);
     }
     pids.clear();
+
+    srs_freepa(arena_);
+    srs_freepa(iovs_);
 }
 
 bool SrsTsContext::is_pure_audio()
@@ -455,13 +461,26 @@ srs_error_t SrsTsContext::encode_pes(ISrsStreamWriter* writer, SrsTsMessage* msg
     
     SrsTsChannel* channel = get(pid);
     srs_assert(channel);
+
+    if (!arena_) {
+        arena_ = new char[SRS_TS_ARENA_PACKETS * SRS_TS_PACKET_SIZE];
+        iovs_ = new iovec[SRS_TS_ARENA_PACKETS * 2];
+    }
     
     char* start = msg->payload->bytes();
     char* end = start + msg->payload->length();
     char* p = start;
     
     while (p < end) {
-        SrsTsPacket* pkt = NULL;
+        // Flush when the arena is full, generally for the large video frame.
+        if (nn_packets_ >= SRS_TS_ARENA_PACKETS && (err = flush_packets(writer)) != srs_success) {
+            return srs_error_wrap(err, "ts: flush packets");
+        }
+
+        char* buf = arena_ + nn_packets_ * SRS_TS_PACKET_SIZE;
+        int nb_buf = 0;
+        int left = 0;
+
         if (p == start) {
             // write pcr according to message.
             bool write_pcr = msg->write_pcr;
@@ -485,53 +504,115 @@ srs_error_t SrsTsContext::encode_pes(ISrsStreamWriter* writer, SrsTsMessage* msg
             int64_t pcr = write_pcr? msg->dts : -1;
             
             // TODO: FIXME: finger it why use discontinuity of msg.
-            pkt = SrsTsPacket::create_pes_first(this,
+            SrsTsPacket* pkt = SrsTsPacket::create_pes_first(this,
                 pid, msg->sid, channel->continuity_counter++, msg->is_discontinuity,
                 pcr, msg->dts, msg->pts, msg->payload->length()
             );
-        } else {
-            pkt = SrsTsPacket::create_pes_continue(this, pid, msg->sid, channel->continuity_counter++);
-        }
-        SrsAutoFree(SrsTsPacket, pkt);
-        
-        pkt->sync_byte = sync_byte;
-        
-        char* buf = new char[SRS_TS_PACKET_SIZE];
-        SrsAutoFreeA(char, buf);
-        
-        // set the left bytes with 0xFF.
-        int nb_buf = pkt->size();
-        srs_assert(nb_buf < SRS_TS_PACKET_SIZE);
-        
-        int left = (int)srs_min(end - p, SRS_TS_PACKET_SIZE - nb_buf);
-        int nb_stuffings = SRS_TS_PACKET_SIZE - nb_buf - left;
-        if (nb_stuffings > 0) {
-            // set all bytes to stuffings.
-            memset(buf, 0xFF, SRS_TS_PACKET_SIZE);
+            SrsAutoFree(SrsTsPacket, pkt);
             
-            // padding with stuffings.
-            pkt->padding(nb_stuffings);
+            pkt->sync_byte = sync_byte;
             
-            // size changed, recalc it.
             nb_buf = pkt->size();
             srs_assert(nb_buf < SRS_TS_PACKET_SIZE);
             
             left = (int)srs_min(end - p, SRS_TS_PACKET_SIZE - nb_buf);
-            nb_stuffings = SRS_TS_PACKET_SIZE - nb_buf - left;
-            srs_assert(nb_stuffings == 0);
+            int nb_stuffings = SRS_TS_PACKET_SIZE - nb_buf - left;
+            if (nb_stuffings > 0) {
+                // set all bytes to stuffings.
+                memset(buf, 0xFF, SRS_TS_PACKET_SIZE);
+                
+                // padding with stuffings.
+                pkt->padding(nb_stuffings);
+                
+                // size changed, recalc it.
+                nb_buf = pkt->size();
+                srs_assert(nb_buf < SRS_TS_PACKET_SIZE);
+                
+                left = (int)srs_min(end - p, SRS_TS_PACKET_SIZE - nb_buf);
+                nb_stuffings = SRS_TS_PACKET_SIZE - nb_buf - left;
+                srs_assert(nb_stuffings == 0);
+            }
+            
+            SrsBuffer stream(buf, nb_buf);
+            if ((err = pkt->encode(&stream)) != srs_success) {
+                return srs_error_wrap(err, "ts: encode packet");
+            }
+        } else {
+            // For the continue packets, which is the most of packets, only the continuity counter and
+            // stuffing bytes are generated, see SrsTsPacket::create_pes_continue and padding.
+            int8_t cc = (channel->continuity_counter++) & 0x0f;
+            buf[0] = sync_byte;
+            buf[1] = (char)((pid >> 8) & 0x1f);
+            buf[2] = (char)(pid & 0xff);
+            buf[3] = (char)((SrsTsAdaptationFieldTypePayloadOnly << 4) | cc);
+            nb_buf = 4;
+
+            left = (int)srs_min(end - p, SRS_TS_PACKET_SIZE - nb_buf);
+            int nb_stuffings = SRS_TS_PACKET_SIZE - nb_buf - left;
+            if (nb_stuffings > 0) {
+                // The adaptation field is at least 2 bytes, the length and flags, so the last byte of
+                // payload is moved to the next packet when only 1 byte to stuff.
+                nb_stuffings = srs_max(2, nb_stuffings);
+                buf[3] = (char)((SrsTsAdaptationFieldTypeBoth << 4) | cc);
+                buf[4] = (char)(nb_stuffings - 1);
+                buf[5] = 0x00;
+                memset(buf + 6, 0xFF, nb_stuffings - 2);
+                nb_buf += nb_stuffings;
+                left = SRS_TS_PACKET_SIZE - nb_buf;
+            }
         }
-        memcpy(buf + nb_buf, p, left);
+
+        // The payload is pointed to the message, without copy.
+        iovs_[nn_iovs_].iov_base = buf;
+        iovs_[nn_iovs_++].iov_len = nb_buf;
+        iovs_[nn_iovs_].iov_base = p;
+        iovs_[nn_iovs_++].iov_len = left;
+        nn_packets_++;
         p += left;
-        
-        SrsBuffer stream(buf, nb_buf);
-        if ((err = pkt->encode(&stream)) != srs_success) {
-            return srs_error_wrap(err, "ts: encode packet");
+    }
+
+    // Flush all packets, because the message payload is only valid in this call.
+    if ((err = flush_packets(writer)) != srs_success) {
+        return srs_error_wrap(err, "ts: flush packets");
+    }
+    
+    return err;
+}
+
+srs_error_t SrsTsContext::flush_packets(ISrsStreamWriter* writer)
+{
+    srs_error_t err = srs_success;
+
+    if (!nn_packets_) {
+        return err;
+    }
+
+    // Write all packets by one writev, for example, the HTTP-TS stream.
+    ISrsVectorWriter* vw = dynamic_cast<ISrsVectorWriter*>(writer);
+    if (vw) {
+        int nn_packets = nn_packets_;
+        err = vw->writev(iovs_, nn_iovs_, NULL);
+        nn_iovs_ = nn_packets_ = 0;
+        if (err != srs_success) {
+            return srs_error_wrap(err, "ts: writev %d packets", nn_packets);
         }
+        return err;
+    }
+
+    // Copy the payload to the slot after header, then write each packet.
+    for (int i = 0; i < nn_packets_; i++) {
+        iovec* header = iovs_ + 2 * i;
+        iovec* payload = header + 1;
+        char* buf = (char*)header->iov_base;
+        memcpy(buf + header->iov_len, payload->iov_base, payload->iov_len);
+
         if ((err = writer->write(buf, SRS_TS_PACKET_SIZE, NULL)) != srs_success) {
+            nn_iovs_ = nn_packets_ = 0;
             return srs_error_wrap(err, "ts: write packet");
         }
     }
-    
+    nn_iovs_ = nn_packets_ = 0;
+
     return err;
 }
 
@@ -2783,6 +2864,42 @@ srs_error_t SrsEncFileWriter::write(void* data, size_t count, ssize_t* pnwrite)
     return err;
 }
 
+srs_error_t SrsEncFileWriter::writev(const iovec* iov, int iovcnt, ssize_t* pnwrite)
+{
+    srs_error_t err = srs_success;
+
+    char pkt[SRS_TS_PACKET_SIZE];
+    int nb_pkt = 0;
+    ssize_t nwrite = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        char* p = (char*)iov[i].iov_base;
+        int size = (int)iov[i].iov_len;
+
+        while (size > 0) {
+            int n = srs_min(size, SRS_TS_PACKET_SIZE - nb_pkt);
+            memcpy(pkt + nb_pkt, p, n);
+            nb_pkt += n; p += n; size -= n; nwrite += n;
+
+            if (nb_pkt == SRS_TS_PACKET_SIZE) {
+                nb_pkt = 0;
+                if ((err = write(pkt, SRS_TS_PACKET_SIZE, NULL)) != srs_success) {
+                    return srs_error_wrap(err, "write packet");
+                }
+            }
+        }
+    }
+
+    // The iovecs must be whole TS packets.
+    srs_assert(nb_pkt == 0);
+
+    if (pnwrite) {
+        *pnwrite = nwrite;
+    }
+
+    return err;
+}
+
 srs_error_t SrsEncFileWriter::config_cipher(unsigned char* key, unsigned char* iv)
 {
     srs_error_t err = srs_success;
@@ -3198,6 +3315,11 @@ void SrsTsTransmuxer::set_has_video(bool v)
     has_video_ = v;
 }
 
+void SrsTsTransmuxer::refresh_pat_pmt()
+{
+    context->reset();
+}
+
 srs_error_t SrsTsTransmuxer::initialize(ISrsStreamWriter* fw)
 {
     srs_error_t err = srs_success;
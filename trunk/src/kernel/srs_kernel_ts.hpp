@@ -33,6 +33,9 @@ class SrsPsPacket;
 // Transport Stream packets are 188 bytes in length.
 #define SRS_TS_PACKET_SIZE          188
 
+// The max number of TS packets to encode in the header arena, then flush by one writev.
+#define SRS_TS_ARENA_PACKETS        128
+
 // The aggregate pure audio for hls, in ts tbn(ms * 90).
 #define SRS_CONSTS_HLS_PURE_AUDIO_AGGREGATE 720 * 90
 
@@ -306,6 +309,13 @@ private:
     // when any codec changed, write the PAT/PMT.
     SrsVideoCodecId vcodec;
     SrsAudioCodecId acodec;
+private:
+    // The arena for TS packet headers, each packet takes a slot of SRS_TS_PACKET_SIZE, allocated when
+    // encode the first PES, and the payload of packet is pointed to the message by iovec without copy.
+    char* arena_;
+    iovec* iovs_;
+    int nn_iovs_;
+    int nn_packets_;
 public:
     SrsTsContext();
     virtual ~SrsTsContext();
@@ -341,6 +351,8 @@ public:
 private:
     virtual srs_error_t encode_pat_pmt(ISrsStreamWriter* writer, int16_t vpid, SrsTsStream vs, int16_t apid, SrsTsStream as);
     virtual srs_error_t encode_pes(ISrsStreamWriter* writer, SrsTsMessage* msg, int16_t pid, SrsTsStream sid, bool pure_audio);
+    // Flush the packets in arena to writer, by writev if supported.
+    virtual srs_error_t flush_packets(ISrsStreamWriter* writer);
 };
 
 // The packet in ts stream,
@@ -1291,6 +1303,8 @@ public:
     virtual ~SrsEncFileWriter();
 public:
     virtual srs_error_t write(void* data, size_t count, ssize_t* pnwrite);
+    // Gather the iovecs to TS packets, because the AES encrypts the whole TS packets.
+    virtual srs_error_t writev(const iovec* iov, int iovcnt, ssize_t* pnwrite);
     virtual void close();
 public:
     srs_error_t config_cipher(unsigned char* key, unsigned char* iv);
@@ -1345,6 +1359,8 @@ public:
 public:
     void set_has_audio(bool v);
     void set_has_video(bool v);
+    // Write the PAT/PMT again before the next PES, so that a player is able to join the stream there.
+    void refresh_pat_pmt();
 public:
     // Initialize the underlayer file stream.
     // @param fw the writer to use for ts encoder, user must free it.
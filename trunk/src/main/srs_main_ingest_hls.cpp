@@ -1285,7 +1285,7 @@ int SrsIngestHlsOutput::connect()
     }
     
     // publish.
-    if ((err = sdk->publish(SRS_CONSTS_RTMP_PROTOCOL_CHUNK_SIZE)) != srs_success) {
+    if ((err = sdk->publish(SRS_CONSTS_RTMP_SRS_CHUNK_SIZE)) != srs_success) {
         // TODO: FIXME: Use error
         ret = srs_error_code(err);
         srs_freep(err);
@@ -15,6 +15,7 @@ using namespace std;
 #include <srs_kernel_error.hpp>
 #include <srs_kernel_buffer.hpp>
 #include <srs_protocol_json.hpp>
+#include <srs_core_autofree.hpp>
 
 using namespace srs_internal;
 
@@ -434,6 +435,8 @@ srs_error_t SrsAmf0Any::discovery(SrsBuffer* stream, SrsAmf0Any** ppvalue)
 
 SrsUnSortedHashtable::SrsUnSortedHashtable()
 {
+    raw_ = NULL;
+    nb_raw_ = 0;
 }
 
 SrsUnSortedHashtable::~SrsUnSortedHashtable()
@@ -443,6 +446,7 @@ SrsUnSortedHashtable::~SrsUnSortedHashtable()
 
 int SrsUnSortedHashtable::count()
 {
+    decode_lazy();
     return (int)properties.size();
 }
 
@@ -455,6 +459,16 @@ void SrsUnSortedHashtable::clear()
         srs_freep(any);
     }
     properties.clear();
+
+    std::map<int, SrsAmf0Any*>::iterator it2;
+    for (it2 = lazy_values_.begin(); it2 != lazy_values_.end(); ++it2) {
+        SrsAmf0Any* any = it2->second;
+        srs_freep(any);
+    }
+    lazy_values_.clear();
+
+    srs_freepa(raw_);
+    nb_raw_ = 0;
 }
 
 string SrsUnSortedHashtable::key_at(int index)
@@ -480,15 +494,15 @@ SrsAmf0Any* SrsUnSortedHashtable::value_at(int index)
 
 void SrsUnSortedHashtable::set(string key, SrsAmf0Any* value)
 {
+    decode_lazy();
+
     std::vector<SrsAmf0ObjectPropertyType>::iterator it;
     
     for (it = properties.begin(); it != properties.end(); ++it) {
         SrsAmf0ObjectPropertyType& elem = *it;
-        std::string name = elem.first;
-        SrsAmf0Any* any = elem.second;
         
-        if (key == name) {
-            srs_freep(any);
+        if (key == elem.first) {
+            srs_freep(elem.second);
             it = properties.erase(it);
             break;
         }
@@ -501,14 +515,37 @@ void SrsUnSortedHashtable::set(string key, SrsAmf0Any* value)
 
 SrsAmf0Any* SrsUnSortedHashtable::get_property(string name)
 {
+    srs_error_t err = srs_success;
+
+    // Decode the property only, for most properties are never used.
+    if (raw_) {
+        int offset = find_lazy(name);
+        if (offset < 0) {
+            return NULL;
+        }
+
+        std::map<int, SrsAmf0Any*>::iterator it = lazy_values_.find(offset);
+        if (it != lazy_values_.end()) {
+            return it->second;
+        }
+
+        SrsBuffer stream(raw_ + offset, nb_raw_ - offset);
+        SrsAmf0Any* any = NULL;
+        if ((err = srs_amf0_read_any(&stream, &any)) != srs_success) {
+            srs_freep(err);
+            return NULL;
+        }
+
+        lazy_values_[offset] = any;
+        return any;
+    }
+
     std::vector<SrsAmf0ObjectPropertyType>::iterator it;
     
     for (it = properties.begin(); it != properties.end(); ++it) {
         SrsAmf0ObjectPropertyType& elem = *it;
-        std::string key = elem.first;
-        SrsAmf0Any* any = elem.second;
-        if (key == name) {
-            return any;
+        if (elem.first == name) {
+            return elem.second;
         }
     }
     
@@ -547,14 +584,15 @@ SrsAmf0Any* SrsUnSortedHashtable::ensure_property_number(string name)
 
 void SrsUnSortedHashtable::remove(string name)
 {
+    decode_lazy();
+
     std::vector<SrsAmf0ObjectPropertyType>::iterator it;
     
     for (it = properties.begin(); it != properties.end();) {
-        std::string key = it->first;
-        SrsAmf0Any* any = it->second;
+        SrsAmf0ObjectPropertyType& elem = *it;
         
-        if (key == name) {
-            srs_freep(any);
+        if (elem.first == name) {
+            srs_freep(elem.second);
             
             it = properties.erase(it);
         } else {
@@ -565,13 +603,187 @@ void SrsUnSortedHashtable::remove(string name)
 
 void SrsUnSortedHashtable::copy(SrsUnSortedHashtable* src)
 {
+    // Copy the raw bytes, which keeps lazy for the copied one.
+    if (src->raw()) {
+        attach(src->raw(), src->nb_raw());
+        return;
+    }
+
     std::vector<SrsAmf0ObjectPropertyType>::iterator it;
     for (it = src->properties.begin(); it != src->properties.end(); ++it) {
         SrsAmf0ObjectPropertyType& elem = *it;
-        std::string key = elem.first;
-        SrsAmf0Any* any = elem.second;
-        set(key, any->copy());
+        set(elem.first, elem.second->copy());
+    }
+}
+
+void SrsUnSortedHashtable::swap(SrsUnSortedHashtable* other)
+{
+    properties.swap(other->properties);
+    lazy_values_.swap(other->lazy_values_);
+    std::swap(raw_, other->raw_);
+    std::swap(nb_raw_, other->nb_raw_);
+}
+
+void SrsUnSortedHashtable::attach(const char* data, int size)
+{
+    if (size <= 0) {
+        return;
+    }
+
+    // Decode the existing properties, then append the new ones, to keep the order.
+    bool append = raw_ || !properties.empty();
+    if (append) {
+        decode_lazy();
+    }
+
+    raw_ = new char[size];
+    nb_raw_ = size;
+    memcpy(raw_, data, size);
+
+    if (append) {
+        decode_lazy();
+    }
+}
+
+const char* SrsUnSortedHashtable::raw()
+{
+    // The got values are mutable, so drop the stale raw bytes if any of them is changed.
+    if (raw_ && !lazy_values_.empty() && lazy_dirty()) {
+        decode_lazy();
     }
+    return raw_;
+}
+
+int SrsUnSortedHashtable::nb_raw()
+{
+    return raw() ? nb_raw_ : 0;
+}
+
+bool SrsUnSortedHashtable::lazy_dirty()
+{
+    srs_error_t err = srs_success;
+
+    std::map<int, SrsAmf0Any*>::iterator it;
+    for (it = lazy_values_.begin(); it != lazy_values_.end(); ++it) {
+        int offset = it->first;
+        SrsAmf0Any* any = it->second;
+
+        // Locate the original bytes of value in raw bytes.
+        SrsBuffer stream(raw_ + offset, nb_raw_ - offset);
+        if ((err = srs_amf0_skip_any(&stream)) != srs_success) {
+            srs_freep(err);
+            return true;
+        }
+
+        int size = stream.pos();
+        if (any->total_size() != size) {
+            return true;
+        }
+
+        // Encode the value again, which is cheap for only few values are got.
+        char* buf = new char[size];
+        SrsAutoFreeA(char, buf);
+
+        SrsBuffer b(buf, size);
+        if ((err = any->write(&b)) != srs_success) {
+            srs_freep(err);
+            return true;
+        }
+
+        if (memcmp(buf, raw_ + offset, size) != 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SrsUnSortedHashtable::decode_lazy()
+{
+    srs_error_t err = srs_success;
+
+    if (!raw_) {
+        return;
+    }
+
+    // Reset the raw bytes first, because set() also decodes lazily.
+    char* raw = raw_;
+    SrsAutoFreeA(char, raw);
+    SrsBuffer stream(raw, nb_raw_);
+
+    raw_ = NULL;
+    nb_raw_ = 0;
+
+    std::map<int, SrsAmf0Any*> lazy_values;
+    lazy_values.swap(lazy_values_);
+
+    // The raw bytes is validated, so never fail, and never contains the object EOF.
+    while (!stream.empty()) {
+        std::string name;
+        if ((err = srs_amf0_read_utf8(&stream, name)) != srs_success) {
+            srs_freep(err);
+            break;
+        }
+
+        // Reuse the decoded value, which might be used by others.
+        SrsAmf0Any* any = NULL;
+        std::map<int, SrsAmf0Any*>::iterator it = lazy_values.find(stream.pos());
+        if (it != lazy_values.end()) {
+            any = it->second;
+            lazy_values.erase(it);
+            err = srs_amf0_skip_any(&stream);
+        } else {
+            err = srs_amf0_read_any(&stream, &any);
+        }
+
+        if (err != srs_success) {
+            srs_freep(err);
+            srs_freep(any);
+            break;
+        }
+
+        set(name, any);
+    }
+
+    std::map<int, SrsAmf0Any*>::iterator it;
+    for (it = lazy_values.begin(); it != lazy_values.end(); ++it) {
+        SrsAmf0Any* any = it->second;
+        srs_freep(any);
+    }
+}
+
+int SrsUnSortedHashtable::find_lazy(const std::string& name)
+{
+    srs_error_t err = srs_success;
+
+    int offset = -1;
+    SrsBuffer stream(raw_, nb_raw_);
+
+    while (!stream.empty()) {
+        // Compare the name with raw bytes, without decoding it.
+        if (!stream.require(2)) {
+            break;
+        }
+
+        int16_t len = stream.read_2bytes();
+        int size = len > 0 ? len : 0;
+        if (!stream.require(size)) {
+            break;
+        }
+
+        // The last one wins, same to set().
+        if (size == (int)name.length() && memcmp(stream.head(), name.data(), size) == 0) {
+            offset = stream.pos() + size;
+        }
+        stream.skip(size);
+
+        if ((err = srs_amf0_skip_any(&stream)) != srs_success) {
+            srs_freep(err);
+            break;
+        }
+    }
+
+    return offset;
 }
 
 SrsAmf0ObjectEOF::SrsAmf0ObjectEOF()
@@ -655,6 +867,11 @@ SrsAmf0Object::~SrsAmf0Object()
 int SrsAmf0Object::total_size()
 {
     int size = 1;
+
+    // The raw bytes of properties, which is not decoded.
+    if (properties->raw()) {
+        return size + properties->nb_raw() + SrsAmf0Size::object_eof();
+    }
     
     for (int i = 0; i < properties->count(); i++){
         std::string name = key_at(i);
@@ -683,32 +900,13 @@ srs_error_t SrsAmf0Object::read(SrsBuffer* stream)
         return srs_error_new(ERROR_RTMP_AMF0_DECODE, "object invalid marker=%#x", marker);
     }
     
-    // value
-    while (!stream->empty()) {
-        // detect whether is eof.
-        if (srs_amf0_is_object_eof(stream)) {
-            SrsAmf0ObjectEOF pbj_eof;
-            if ((err = pbj_eof.read(stream)) != srs_success) {
-                return srs_error_wrap(err, "read EOF");
-            }
-            break;
-        }
-        
-        // property-name: utf8 string
-        std::string property_name;
-        if ((err = srs_amf0_read_utf8(stream, property_name)) != srs_success) {
-            return srs_error_wrap(err, "read property name");
-        }
-        // property-value: any
-        SrsAmf0Any* property_value = NULL;
-        if ((err = srs_amf0_read_any(stream, &property_value)) != srs_success) {
-            srs_freep(property_value);
-            return srs_error_wrap(err, "read property value, name=%s", property_name.c_str());
-        }
-        
-        // add property
-        this->set(property_name, property_value);
+    // value, validate the properties, then decode each property when get it.
+    char* start = stream->head();
+    int size = 0;
+    if ((err = srs_amf0_skip_properties(stream, &size)) != srs_success) {
+        return srs_error_wrap(err, "read properties");
     }
+    properties->attach(start, size);
     
     return err;
 }
@@ -724,8 +922,15 @@ srs_error_t SrsAmf0Object::write(SrsBuffer* stream)
     
     stream->write_1bytes(RTMP_AMF0_Object);
     
-    // value
-    for (int i = 0; i < properties->count(); i++) {
+    // value, the raw bytes if not decoded.
+    if (properties->raw()) {
+        if (!stream->require(properties->nb_raw())) {
+            return srs_error_new(ERROR_RTMP_AMF0_ENCODE, "requires %d only %d bytes", properties->nb_raw(), stream->left());
+        }
+        stream->write_bytes((char*)properties->raw(), properties->nb_raw());
+    }
+
+    for (int i = 0; !properties->raw() && i < properties->count(); i++) {
         std::string name = this->key_at(i);
         SrsAmf0Any* any = this->value_at(i);
         
@@ -833,6 +1038,11 @@ SrsAmf0EcmaArray::~SrsAmf0EcmaArray()
 int SrsAmf0EcmaArray::total_size()
 {
     int size = 1 + 4;
+
+    // The raw bytes of properties, which is not decoded.
+    if (properties->raw()) {
+        return size + properties->nb_raw() + SrsAmf0Size::object_eof();
+    }
     
     for (int i = 0; i < properties->count(); i++){
         std::string name = key_at(i);
@@ -871,30 +1081,13 @@ srs_error_t SrsAmf0EcmaArray::read(SrsBuffer* stream)
     // value
     this->_count = count;
     
-    while (!stream->empty()) {
-        // detect whether is eof.
-        if (srs_amf0_is_object_eof(stream)) {
-            SrsAmf0ObjectEOF pbj_eof;
-            if ((err = pbj_eof.read(stream)) != srs_success) {
-                return srs_error_wrap(err, "read EOF");
-            }
-            break;
-        }
-        
-        // property-name: utf8 string
-        std::string property_name;
-        if ((err =srs_amf0_read_utf8(stream, property_name)) != srs_success) {
-            return srs_error_wrap(err, "read property name");
-        }
-        // property-value: any
-        SrsAmf0Any* property_value = NULL;
-        if ((err = srs_amf0_read_any(stream, &property_value)) != srs_success) {
-            return srs_error_wrap(err, "read property value, name=%s", property_name.c_str());
-        }
-        
-        // add property
-        this->set(property_name, property_value);
+    // Validate the properties, then decode each property when get it.
+    char* start = stream->head();
+    int size = 0;
+    if ((err = srs_amf0_skip_properties(stream, &size)) != srs_success) {
+        return srs_error_wrap(err, "read properties");
     }
+    properties->attach(start, size);
     
     return err;
 }
@@ -917,8 +1110,15 @@ srs_error_t SrsAmf0EcmaArray::write(SrsBuffer* stream)
     
     stream->write_4bytes(this->_count);
     
-    // value
-    for (int i = 0; i < properties->count(); i++) {
+    // value, the raw bytes if not decoded.
+    if (properties->raw()) {
+        if (!stream->require(properties->nb_raw())) {
+            return srs_error_new(ERROR_RTMP_AMF0_ENCODE, "requires %d only %d bytes", properties->nb_raw(), stream->left());
+        }
+        stream->write_bytes((char*)properties->raw(), properties->nb_raw());
+    }
+
+    for (int i = 0; !properties->raw() && i < properties->count(); i++) {
         std::string name = this->key_at(i);
         SrsAmf0Any* any = this->value_at(i);
         
@@ -1005,6 +1205,12 @@ SrsAmf0Any* SrsAmf0EcmaArray::ensure_property_number(string name)
     return properties->ensure_property_number(name);
 }
 
+void SrsAmf0EcmaArray::move_to(SrsAmf0Object* obj)
+{
+    obj->clear();
+    obj->properties->swap(properties);
+}
+
 SrsAmf0StrictArray::SrsAmf0StrictArray()
 {
     marker = RTMP_AMF0_StrictArray;
@@ -1775,5 +1981,136 @@ namespace srs_internal
         srs_assert(value != NULL);
         return value->write(stream);
     }
+
+    srs_error_t srs_amf0_skip_utf8(SrsBuffer* stream)
+    {
+        srs_error_t err = srs_success;
+
+        // len
+        if (!stream->require(2)) {
+            return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 2 only %d bytes", stream->left());
+        }
+        int16_t len = stream->read_2bytes();
+
+        // empty string
+        if (len <= 0) {
+            return err;
+        }
+
+        // data
+        if (!stream->require(len)) {
+            return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires %d only %d bytes", len, stream->left());
+        }
+        stream->skip(len);
+
+        return err;
+    }
+
+    // Skip the bytes of value after marker.
+    srs_error_t srs_amf0_skip_bytes(SrsBuffer* stream, int size)
+    {
+        if (!stream->require(size)) {
+            return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires %d only %d bytes", size, stream->left());
+        }
+        stream->skip(size);
+        return srs_success;
+    }
+
+    srs_error_t srs_amf0_skip_any(SrsBuffer* stream)
+    {
+        srs_error_t err = srs_success;
+
+        // detect the object-eof specially, see SrsAmf0Any::discovery
+        if (srs_amf0_is_object_eof(stream)) {
+            stream->skip(3);
+            return err;
+        }
+
+        // marker
+        if (!stream->require(1)) {
+            return srs_error_new(ERROR_RTMP_AMF0_DECODE, "marker requires 1 only %d bytes", stream->left());
+        }
+
+        char marker = stream->read_1bytes();
+        switch (marker) {
+            case RTMP_AMF0_String: {
+                return srs_amf0_skip_utf8(stream);
+            }
+            case RTMP_AMF0_Boolean: {
+                return srs_amf0_skip_bytes(stream, 1);
+            }
+            case RTMP_AMF0_Number: {
+                return srs_amf0_skip_bytes(stream, 8);
+            }
+            case RTMP_AMF0_Null:
+            case RTMP_AMF0_Undefined: {
+                return err;
+            }
+            case RTMP_AMF0_Object: {
+                return srs_amf0_skip_properties(stream, NULL);
+            }
+            case RTMP_AMF0_EcmaArray: {
+                if ((err = srs_amf0_skip_bytes(stream, 4)) != srs_success) {
+                    return srs_error_wrap(err, "count");
+                }
+                return srs_amf0_skip_properties(stream, NULL);
+            }
+            case RTMP_AMF0_StrictArray: {
+                if (!stream->require(4)) {
+                    return srs_error_new(ERROR_RTMP_AMF0_DECODE, "requires 4 only %d bytes", stream->left());
+                }
+
+                int32_t count = stream->read_4bytes();
+                for (int i = 0; i < count && !stream->empty(); i++) {
+                    if ((err = srs_amf0_skip_any(stream)) != srs_success) {
+                        return srs_error_wrap(err, "skip property");
+                    }
+                }
+                return err;
+            }
+            case RTMP_AMF0_Date: {
+                // date value and time zone.
+                return srs_amf0_skip_bytes(stream, 8 + 2);
+            }
+            case RTMP_AMF0_Invalid:
+            default: {
+                return srs_error_new(ERROR_RTMP_AMF0_INVALID, "invalid amf0 message, marker=%#x", marker);
+            }
+        }
+    }
+
+    srs_error_t srs_amf0_skip_properties(SrsBuffer* stream, int* psize)
+    {
+        srs_error_t err = srs_success;
+
+        int start = stream->pos();
+        int size = -1;
+
+        while (!stream->empty()) {
+            // detect whether is eof.
+            if (srs_amf0_is_object_eof(stream)) {
+                size = stream->pos() - start;
+                stream->skip(3);
+                break;
+            }
+
+            // property-name: utf8 string
+            if ((err = srs_amf0_skip_utf8(stream)) != srs_success) {
+                return srs_error_wrap(err, "read property name");
+            }
+
+            // property-value: any
+            if ((err = srs_amf0_skip_any(stream)) != srs_success) {
+                return srs_error_wrap(err, "read property value");
+            }
+        }
+
+        // Allow the object without EOF, at the end of stream.
+        if (psize) {
+            *psize = (size >= 0) ? size : stream->pos() - start;
+        }
+
+        return err;
+    }
 }
 
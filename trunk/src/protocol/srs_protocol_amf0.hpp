@@ -11,6 +11,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 class SrsBuffer;
 class SrsAmf0Object;
@@ -322,6 +323,7 @@ private:
     srs_internal::SrsAmf0ObjectEOF* eof;
 private:
     friend class SrsAmf0Any;
+    friend class SrsAmf0EcmaArray;
     /**
      * make amf0 object to private,
      * use should never declare it, use SrsAmf0Any::object() to create it.
@@ -484,6 +486,11 @@ public:
      * @remark user should never free the returned value, copy it if needed.
      */
     virtual SrsAmf0Any* ensure_property_number(std::string name);
+    /**
+     * move all properties to object, without copy, the array is empty after moved.
+     * @remark the properties of object are replaced.
+     */
+    virtual void move_to(SrsAmf0Object* obj);
 };
 
 /**
@@ -785,6 +792,13 @@ namespace srs_internal
     private:
         typedef std::pair<std::string, SrsAmf0Any*> SrsAmf0ObjectPropertyType;
         std::vector<SrsAmf0ObjectPropertyType> properties;
+    private:
+        // The raw bytes of properties to decode lazily, NULL if decoded.
+        // @remark Only decode the property when get it, and decode all when iterate or modify properties.
+        char* raw_;
+        int nb_raw_;
+        // The lazily decoded values, the key is the offset of value in raw bytes.
+        std::map<int, SrsAmf0Any*> lazy_values_;
     public:
         SrsUnSortedHashtable();
         virtual ~SrsUnSortedHashtable();
@@ -806,6 +820,22 @@ namespace srs_internal
         virtual void remove(std::string name);
     public:
         virtual void copy(SrsUnSortedHashtable* src);
+        // Swap all properties with other, without copy.
+        virtual void swap(SrsUnSortedHashtable* other);
+    public:
+        // Attach the raw bytes of properties, which is validated by srs_amf0_skip_properties, to decode lazily.
+        virtual void attach(const char* data, int size);
+        // Get the raw bytes of properties, NULL if decoded.
+        // @remark Decode all if any got value is modified, because the raw bytes is stale.
+        virtual const char* raw();
+        virtual int nb_raw();
+    private:
+        // Whether any got value differs from its raw bytes.
+        virtual bool lazy_dirty();
+        // Decode all properties from raw bytes.
+        virtual void decode_lazy();
+        // Find the property in raw bytes, return the offset of value, -1 if not found.
+        virtual int find_lazy(const std::string& name);
     };
     
     /**
@@ -840,6 +870,13 @@ namespace srs_internal
     extern srs_error_t srs_amf0_write_object_eof(SrsBuffer* stream, SrsAmf0ObjectEOF* value);
     
     extern srs_error_t srs_amf0_write_any(SrsBuffer* stream, SrsAmf0Any* value);
+
+    // Skip the utf8 string, any value, without decoding it.
+    extern srs_error_t srs_amf0_skip_utf8(SrsBuffer* stream);
+    extern srs_error_t srs_amf0_skip_any(SrsBuffer* stream);
+    // Skip the properties of object or ecma array, util the object EOF.
+    // @param psize Output the bytes of properties, excluding the object EOF.
+    extern srs_error_t srs_amf0_skip_properties(SrsBuffer* stream, int* psize);
 };
 
 #endif
@@ -896,6 +896,40 @@ srs_error_t SrsHttpMessageWriter::send_header(char* data, int size)
     return skt->write((void*)buf.c_str(), buf.length(), NULL);
 }
 
+bool SrsHttpMessageWriter::sendfile_enabled()
+{
+    // For chunked encoding, we must wrap each chunk, so never send file directly.
+    if (!header_wrote_ || content_length == -1) {
+        return false;
+    }
+
+    ISrsProtocolFileWriter* fw = dynamic_cast<ISrsProtocolFileWriter*>(skt);
+    return fw && fw->sendfile_enabled();
+}
+
+srs_error_t SrsHttpMessageWriter::sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite)
+{
+    srs_error_t err = srs_success;
+
+    if (!sendfile_enabled()) {
+        return srs_error_new(ERROR_HTTP_CONTENT_LENGTH, "sendfile disabled, content-length=%" PRId64, content_length);
+    }
+
+    // whatever header is wrote, we should try to send header.
+    if ((err = send_header(NULL, 0)) != srs_success) {
+        return srs_error_wrap(err, "send header");
+    }
+
+    // check the bytes send and content length.
+    written += count;
+    if (written > content_length) {
+        return srs_error_new(ERROR_HTTP_CONTENT_LENGTH, "overflow writen=%" PRId64 ", max=%" PRId64, written, content_length);
+    }
+
+    ISrsProtocolFileWriter* fw = dynamic_cast<ISrsProtocolFileWriter*>(skt);
+    return fw->sendfile(fd, offset, count, nwrite);
+}
+
 bool SrsHttpMessageWriter::header_wrote()
 {
     return header_wrote_;
@@ -942,6 +976,16 @@ srs_error_t SrsHttpResponseWriter::writev(const iovec* iov, int iovcnt, ssize_t*
     return writer_->writev(iov, iovcnt, pnwrite);
 }
 
+bool SrsHttpResponseWriter::sendfile_enabled()
+{
+    return writer_->sendfile_enabled();
+}
+
+srs_error_t SrsHttpResponseWriter::sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite)
+{
+    return writer_->sendfile(fd, offset, count, nwrite);
+}
+
 void SrsHttpResponseWriter::write_header(int code)
 {
     if (writer_->header_wrote()) {
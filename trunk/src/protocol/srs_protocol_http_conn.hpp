@@ -13,6 +13,7 @@
 #include <sstream>
 
 #include <srs_protocol_http_stack.hpp>
+#include <srs_protocol_io.hpp>
 
 class ISrsConnection;
 class SrsFastStream;
@@ -249,13 +250,18 @@ public:
     virtual srs_error_t writev(const iovec* iov, int iovcnt, ssize_t* pnwrite);
     virtual void write_header();
     virtual srs_error_t send_header(char* data, int size);
+public:
+    // Whether able to send file, only for response with content-length over plaintext TCP.
+    virtual bool sendfile_enabled();
+    // Send the header if not sent, then send the file as body.
+    virtual srs_error_t sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite);
 public:
     bool header_wrote();
     void set_header_filter(ISrsHttpHeaderFilter* hf);
 };
 
 // Response writer use st socket
-class SrsHttpResponseWriter : public ISrsHttpResponseWriter, public ISrsHttpFirstLineWriter
+class SrsHttpResponseWriter : public ISrsHttpResponseWriter, public ISrsHttpFirstLineWriter, public ISrsProtocolFileWriter
 {
 protected:
     SrsHttpMessageWriter* writer_;
@@ -273,6 +279,10 @@ public:
     virtual srs_error_t write(char* data, int size);
     virtual srs_error_t writev(const iovec* iov, int iovcnt, ssize_t* pnwrite);
     virtual void write_header(int code);
+// Interface ISrsProtocolFileWriter
+public:
+    virtual bool sendfile_enabled();
+    virtual srs_error_t sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite);
 // Interface ISrsHttpFirstLineWriter
 public:
     virtual srs_error_t build_first_line(std::stringstream& ss, char* data, int size);
@@ -18,6 +18,7 @@ using namespace std;
 #include <srs_protocol_json.hpp>
 #include <srs_core_autofree.hpp>
 #include <srs_protocol_utility.hpp>
+#include <srs_protocol_io.hpp>
 
 #define SRS_HTTP_DEFAULT_PAGE "index.html"
 
@@ -509,6 +510,22 @@ srs_error_t SrsHttpFileServer::serve_flv_file(ISrsHttpResponseWriter* w, ISrsHtt
 
 srs_error_t SrsHttpFileServer::serve_mp4_file(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, string fullpath)
 {
+    // for player to seek mp4 by time in seconds, for example, x.mp4?start=10.5&end=20
+    std::string start_time = r->query_get("start");
+    if (!start_time.empty()) {
+        int64_t start = (int64_t)(::atof(start_time.c_str()) * 1000);
+
+        std::string end_time = r->query_get("end");
+        int64_t end = end_time.empty()? -1 : (int64_t)(::atof(end_time.c_str()) * 1000);
+
+        // invalid param, serve as whole mp4 file.
+        if (start < 0 || (end != -1 && start >= end)) {
+            return serve_file(w, r, fullpath);
+        }
+
+        return serve_mp4_seek(w, r, fullpath, start, end);
+    }
+
     // for flash to request mp4 range in query string.
     std::string range = r->query_get("range");
     // or, use bytes to request range.
@@ -575,6 +592,12 @@ srs_error_t SrsHttpFileServer::serve_mp4_stream(ISrsHttpResponseWriter* w, ISrsH
     return serve_file(w, r, fullpath);
 }
 
+srs_error_t SrsHttpFileServer::serve_mp4_seek(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, string fullpath, int64_t start, int64_t end)
+{
+    // @remark For common http file server, we don't support stream request, please use SrsVodStream instead.
+    return serve_file(w, r, fullpath);
+}
+
 srs_error_t SrsHttpFileServer::serve_m3u8_ctx(ISrsHttpResponseWriter * w, ISrsHttpMessage * r, std::string fullpath)
 {
     // @remark For common http file server, we don't support stream request, please use SrsVodStream instead.
@@ -591,6 +614,19 @@ srs_error_t SrsHttpFileServer::copy(ISrsHttpResponseWriter* w, SrsFileReader* fs
 {
     srs_error_t err = srs_success;
     
+    // Send the file by zero-copy, without reading to user space, if the response is able to.
+    ISrsProtocolFileWriter* fw = dynamic_cast<ISrsProtocolFileWriter*>(w);
+    if (size > 0 && fs->fileno() >= 0 && fw && fw->sendfile_enabled()) {
+        int64_t offset = fs->tellg();
+        if ((err = fw->sendfile(fs->fileno(), (off_t)offset, (size_t)size, NULL)) != srs_success) {
+            return srs_error_wrap(err, "sendfile offset=%" PRId64 ", size=%" PRId64, offset, size);
+        }
+
+        // Keep the file offset as read.
+        fs->seek2(offset + size);
+        return err;
+    }
+
     int64_t left = size;
     char* buf = new char[SRS_HTTP_TS_SEND_BUFFER_SIZE];
     SrsAutoFreeA(char, buf);
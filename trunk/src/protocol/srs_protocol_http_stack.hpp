@@ -363,6 +363,11 @@ protected:
     // @param end the end offset in bytes. -1 to end of file.
     // @remark response data in [start, end].
     virtual srs_error_t serve_mp4_stream(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string fullpath, int64_t start, int64_t end);
+    // When access mp4 file with x.mp4?start=seconds&end=seconds
+    // @param start the start time in ms.
+    // @param end the end time in ms. -1 to end of file.
+    // @remark response a new mp4 file, from the keyframe at or before start.
+    virtual srs_error_t serve_mp4_seek(ISrsHttpResponseWriter* w, ISrsHttpMessage* r, std::string fullpath, int64_t start, int64_t end);
     // For HLS protocol.
     // When the request url, like as "http://127.0.0.1:8080/live/livestream.m3u8", 
     // returns the response like as "http://127.0.0.1:8080/live/livestream.m3u8?hls_ctx=12345678" .
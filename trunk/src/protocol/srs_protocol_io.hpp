@@ -104,5 +104,25 @@ public:
     virtual ~ISrsProtocolReadWriter();
 };
 
+/**
+ * The writer to send file without copying to user space, for example, by sendfile.
+ */
+class ISrsProtocolFileWriter
+{
+public:
+    ISrsProtocolFileWriter();
+    virtual ~ISrsProtocolFileWriter();
+public:
+    /**
+     * Whether able to send file, for example, the SSL connection or chunked response is not.
+     */
+    virtual bool sendfile_enabled() = 0;
+    /**
+     * Send count bytes of file fd from offset, the file offset of fd is not changed.
+     * @param nwrite, the actual write bytes, ignore if NULL.
+     */
+    virtual srs_error_t sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite) = 0;
+};
+
 #endif
 
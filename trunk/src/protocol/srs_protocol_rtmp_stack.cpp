@@ -1211,6 +1211,9 @@ srs_error_t SrsProtocol::read_message_payload(SrsChunkStream* chunk, SrsCommonMe
     memcpy(chunk->msg->payload + chunk->msg->size, in_buffer->read_slice(payload_size), payload_size);
     chunk->msg->size += payload_size;
     
+    // fast path for the continuous chunks of message in buffer.
+    gather_message_payload(chunk);
+    
     // got entire RTMP message?
     if (chunk->header.payload_length == chunk->msg->size) {
         *pmsg = chunk->msg;
@@ -1221,6 +1224,48 @@ srs_error_t SrsProtocol::read_message_payload(SrsChunkStream* chunk, SrsCommonMe
     return err;
 }
 
+void SrsProtocol::gather_message_payload(SrsChunkStream* chunk)
+{
+    SrsCommonMessage* msg = chunk->msg;
+    
+    // for the extended timestamp, each chunk maybe has a 4bytes timestamp, so use the normal path.
+    if (chunk->extended_timestamp || msg->size >= chunk->header.payload_length) {
+        return;
+    }
+    
+    // the basic header of fmt=3 chunk for this chunk stream, @see read_basic_header
+    char bh[2];
+    int nb_bh = 0;
+    if (chunk->cid < 64) {
+        bh[nb_bh++] = (char)(0xC0 | chunk->cid);
+    } else if (chunk->cid < 320) {
+        bh[nb_bh++] = (char)0xC0;
+        bh[nb_bh++] = (char)(chunk->cid - 64);
+    } else {
+        return;
+    }
+    
+    // for fmt=3 chunk in the middle of message, without extended timestamp, the message header is empty and
+    // nothing changed except the msg_count, so we only need to check the basic header and copy the payload.
+    while (msg->size < chunk->header.payload_length) {
+        int payload_size = srs_min(chunk->header.payload_length - msg->size, in_chunk_size);
+        if (in_buffer->size() < nb_bh + payload_size) {
+            break;
+        }
+        
+        // interlaced by other chunk stream or message, use the normal path.
+        char* p = in_buffer->bytes();
+        if (p[0] != bh[0] || (nb_bh > 1 && p[1] != bh[1])) {
+            break;
+        }
+        
+        in_buffer->skip(nb_bh);
+        memcpy(msg->payload + msg->size, in_buffer->read_slice(payload_size), payload_size);
+        msg->size += payload_size;
+        chunk->msg_count++;
+    }
+}
+
 srs_error_t SrsProtocol::on_recv_message(SrsCommonMessage* msg)
 {
     srs_error_t err = srs_success;
@@ -4308,10 +4353,8 @@ srs_error_t SrsOnMetaDataPacket::decode(SrsBuffer* stream)
     if (any->is_ecma_array()) {
         SrsAmf0EcmaArray* arr = any->to_ecma_array();
         
-        // if ecma array, copy to object.
-        for (int i = 0; i < arr->count(); i++) {
-            metadata->set(arr->key_at(i), arr->value_at(i)->copy());
-        }
+        // if ecma array, move to object, without copy and decode the properties.
+        arr->move_to(metadata);
     }
     
     return err;
@@ -353,6 +353,9 @@ private:
     // Read the chunk payload, remove the used bytes in buffer,
     // if got entire message, set the pmsg.
     virtual srs_error_t read_message_payload(SrsChunkStream* chunk, SrsCommonMessage** pmsg);
+    // Gather the payload of the following fmt=3 chunks of the same chunk stream, which are already in buffer, without
+    // parsing each chunk by read_basic_header and read_message_header, for large message in small chunk size.
+    virtual void gather_message_payload(SrsChunkStream* chunk);
     // When recv message, update the context.
     virtual srs_error_t on_recv_message(SrsCommonMessage* msg);
     // When message sentout, update the context.
@@ -532,6 +532,7 @@ public:
     srs_error_t mod_socket(SrsSrtSocket* srt_skt);
     srs_error_t del_socket(SrsSrtSocket* srt_skt);
     srs_error_t wait(int timeout_ms, int* pn_fds);
+    srs_error_t probe(int timeout_ms, int* pn_fds);
 public:
     virtual int size();
 private:
@@ -625,8 +626,12 @@ srs_error_t SrsSrtPoller::wait(int timeout_ms, int* pn_fds)
         SrsSrtSocket* srt_skt = iter->second;
         srs_assert(srt_skt != NULL);
 
-        // notify error, don't notify read/write event.
+        // notify error, don't notify read/write event. The error is level triggered until the socket is closed,
+        // so we don't count the error which is already notified.
         if (event.events & SRT_EPOLL_ERR) {
+            if (srt_skt->has_error()) {
+                (*pn_fds)--;
+            }
             srt_skt->notify_error();
         } else {
             if (event.events & SRT_EPOLL_IN) {
@@ -641,6 +646,22 @@ srs_error_t SrsSrtPoller::wait(int timeout_ms, int* pn_fds)
     return err;
 }
 
+srs_error_t SrsSrtPoller::probe(int timeout_ms, int* pn_fds)
+{
+    srs_error_t err = srs_success;
+
+    // Without the events, the uwait only returns the number of fired fds, and the fds_sockets_ is not
+    // accessed, so it's thread-safe because the epoll of libsrt is protected by lock.
+    int ret = srt_epoll_uwait(srt_epoller_fd_, NULL, 0, timeout_ms);
+    *pn_fds = ret;
+
+    if (ret < 0) {
+        return srs_error_new(ERROR_SRT_EPOLL, "srt_epoll_uwait, ret=%d, err=%s", ret, srt_getlasterror_str());
+    }
+
+    return err;
+}
+
 int SrsSrtPoller::size()
 {
     return (int)fd_sockets_.size();
@@ -767,6 +788,15 @@ srs_error_t SrsSrtSocket::accept(srs_srt_t* client_srt_fd)
             return srs_error_new(ERROR_SRT_IO, "srt_accept, err=%s", srt_getlasterror_str());
         }
 
+        // The libsrt never checks the pending connections when subscribing a listener, so the connection which
+        // arrives before subscribed is not notified. We subscribe the listener then try to accept again.
+        if ((events_ & SRT_EPOLL_IN) == 0) {
+            if ((err = enable_read()) != srs_success) {
+                return srs_error_wrap(err, "enable read");
+            }
+            continue;
+        }
+
         // Accept would block, wait until new client connect or error.
         if ((err = wait_readable()) != srs_success) {
             return srs_error_wrap(err, "wait readable");
@@ -104,7 +104,11 @@ public:
     virtual srs_error_t del_socket(SrsSrtSocket* srt_skt) = 0;
     // Wait for the fds in its epoll to be fired in specified timeout_ms, where the pn_fds is the number of active fds.
     // Note that for ST, please always use timeout_ms(0) and switch coroutine by yourself.
+    // Note that the error of socket which is already notified, is not counted in pn_fds.
     virtual srs_error_t wait(int timeout_ms, int* pn_fds) = 0;
+    // Block until any fd in its epoll is fired or timeout, but never notify the sockets, so it's safe to call
+    // it in another thread, to wake up ST when SRT events fired. Use timeout_ms(-1) to wait for ever.
+    virtual srs_error_t probe(int timeout_ms, int* pn_fds) = 0;
 public:
     virtual int size() = 0;
 };
@@ -124,6 +128,7 @@ public: // IO API
 public:
     srs_srt_t fd() const { return srt_fd_; }
     int events() const { return events_; }
+    bool has_error() const { return has_error_; }
 public:
     void set_recv_timeout(srs_utime_t tm) { recv_timeout_ = tm; }
     void set_send_timeout(srs_utime_t tm) { send_timeout_ = tm; }
@@ -10,6 +10,7 @@
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <poll.h>
 using namespace std;
 
 #include <srs_core_autofree.hpp>
@@ -23,6 +24,7 @@ using namespace std;
 
 #ifdef __linux__
 #include <sys/epoll.h>
+#include <sys/sendfile.h>
 
 bool srs_st_epoll_is_supported(void)
 {
@@ -478,6 +480,47 @@ ssize_t srs_read(srs_netfd_t stfd, void *buf, size_t nbyte, srs_utime_t timeout)
     return st_read((st_netfd_t)stfd, buf, nbyte, (st_utime_t)timeout);
 }
 
+ssize_t srs_writev(srs_netfd_t stfd, const iovec *iov, int iov_size, srs_utime_t timeout)
+{
+    return st_writev((st_netfd_t)stfd, iov, iov_size, (st_utime_t)timeout);
+}
+
+ssize_t srs_sendfile(srs_netfd_t stfd, int fd, off_t offset, size_t count, srs_utime_t timeout)
+{
+#ifdef __linux__
+    size_t left = count;
+    while (left > 0) {
+        ssize_t nn = ::sendfile(st_netfd_fileno((st_netfd_t)stfd), fd, &offset, left);
+        if (nn > 0) {
+            left -= nn;
+            continue;
+        }
+
+        // EOF of file, the file is truncated.
+        if (nn == 0) {
+            break;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN) {
+            return -1;
+        }
+
+        // Wait for socket to be writable, the errno is ETIME if timeout.
+        if (st_netfd_poll((st_netfd_t)stfd, POLLOUT, (st_utime_t)timeout) == -1) {
+            return -1;
+        }
+    }
+
+    return count - left;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
 bool srs_is_never_timeout(srs_utime_t tm)
 {
     return tm == SRS_UTIME_NO_TIMEOUT;
@@ -672,6 +715,49 @@ srs_error_t SrsStSocket::writev(const iovec *iov, int iov_size, ssize_t* nwrite)
     return err;
 }
 
+bool SrsStSocket::sendfile_enabled()
+{
+#ifdef __linux__
+    return stfd_ != NULL;
+#else
+    return false;
+#endif
+}
+
+srs_error_t SrsStSocket::sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite)
+{
+    srs_error_t err = srs_success;
+
+    srs_assert(stfd_);
+
+    ssize_t nb_write;
+    if (stm == SRS_UTIME_NO_TIMEOUT) {
+        nb_write = srs_sendfile(stfd_, fd, offset, count, ST_UTIME_NO_TIMEOUT);
+    } else {
+        nb_write = srs_sendfile(stfd_, fd, offset, count, stm);
+    }
+
+    if (nwrite) {
+        *nwrite = nb_write;
+    }
+
+    if (nb_write < 0) {
+        if (errno == ETIME) {
+            return srs_error_new(ERROR_SOCKET_TIMEOUT, "sendfile timeout %d ms", srsu2msi(stm));
+        }
+
+        return srs_error_new(ERROR_SOCKET_WRITE, "sendfile");
+    }
+
+    sbytes += nb_write;
+
+    if ((size_t)nb_write < count) {
+        return srs_error_new(ERROR_SOCKET_WRITE, "sendfile eof, count=%d, sent=%d", (int)count, (int)nb_write);
+    }
+
+    return err;
+}
+
 SrsTcpClient::SrsTcpClient(string h, int p, srs_utime_t tm)
 {
     stfd_ = NULL;
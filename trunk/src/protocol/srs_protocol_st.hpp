@@ -95,6 +95,12 @@ extern int srs_sendmsg(srs_netfd_t stfd, const struct msghdr *msg, int flags, sr
 extern srs_netfd_t srs_accept(srs_netfd_t stfd, struct sockaddr *addr, int *addrlen, srs_utime_t timeout);
 
 extern ssize_t srs_read(srs_netfd_t stfd, void *buf, size_t nbyte, srs_utime_t timeout);
+extern ssize_t srs_writev(srs_netfd_t stfd, const iovec *iov, int iov_size, srs_utime_t timeout);
+
+// Send count bytes of file fd from offset to socket, wait for the socket to be writable if EAGAIN.
+// @return the bytes sent, which is less than count if EOF of file, or -1 if error, with errno set.
+// @remark Only available for linux, or -1 with errno ENOSYS.
+extern ssize_t srs_sendfile(srs_netfd_t stfd, int fd, off_t offset, size_t count, srs_utime_t timeout);
 
 extern bool srs_is_never_timeout(srs_utime_t tm);
 
@@ -120,7 +126,7 @@ public:
 
 // the socket provides TCP socket over st,
 // that is, the sync socket mechanism.
-class SrsStSocket : public ISrsProtocolReadWriter
+class SrsStSocket : public ISrsProtocolReadWriter, public ISrsProtocolFileWriter
 {
 private:
     // The recv/send timeout in srs_utime_t.
@@ -152,6 +158,10 @@ public:
     // @param nwrite, the actual write bytes, ignore if NULL.
     virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite);
     virtual srs_error_t writev(const iovec *iov, int iov_size, ssize_t* nwrite);
+// Interface ISrsProtocolFileWriter
+public:
+    virtual bool sendfile_enabled();
+    virtual srs_error_t sendfile(int fd, off_t offset, size_t count, ssize_t* nwrite);
 };
 
 // The client to connect to server over TCP.
@@ -2481,6 +2481,165 @@ VOID TEST(ProtocolAMF0Test, Amf0Object2)
     }
 }
 
+VOID TEST(ProtocolAMF0Test, Amf0ObjectLazy)
+{
+    srs_error_t err;
+
+    // Encode an object with duplicated property, and nested object.
+    char buf[256];
+    int size = 0;
+    if (true) {
+        SrsAmf0Object* o = SrsAmf0Any::object();
+        SrsAutoFree(SrsAmf0Object, o);
+
+        SrsAmf0Object* child = SrsAmf0Any::object();
+        child->set("codec", SrsAmf0Any::str("h264"));
+        o->set("tcUrl", SrsAmf0Any::str("rtmp://ossrs.net/live"));
+        o->set("width", SrsAmf0Any::number(1920));
+        o->set("video", child);
+        o->set("audio", SrsAmf0Any::boolean(true));
+
+        size = o->total_size();
+        SrsBuffer b(buf, sizeof(buf));
+        HELPER_ASSERT_SUCCESS(o->write(&b));
+        EXPECT_EQ(size, b.pos());
+    }
+
+    // Get property without decoding others, and write the raw bytes.
+    if (true) {
+        SrsAmf0Any* p = NULL;
+        SrsBuffer b(buf, size);
+        HELPER_ASSERT_SUCCESS(srs_amf0_read_any(&b, &p));
+        SrsAutoFree(SrsAmf0Any, p);
+
+        SrsAmf0Object* o = p->to_object();
+        EXPECT_TRUE(o->ensure_property_number("width") != NULL);
+        EXPECT_EQ(1920, o->ensure_property_number("width")->to_number());
+        EXPECT_STREQ("rtmp://ossrs.net/live", o->ensure_property_string("tcUrl")->to_str().c_str());
+        EXPECT_TRUE(o->ensure_property_string("width") == NULL);
+        EXPECT_TRUE(o->get_property("none") == NULL);
+
+        SrsAmf0Object* child = o->get_property("video")->to_object();
+        EXPECT_STREQ("h264", child->ensure_property_string("codec")->to_str().c_str());
+
+        char dst[256];
+        SrsBuffer w(dst, sizeof(dst));
+        EXPECT_EQ(size, o->total_size());
+        HELPER_ASSERT_SUCCESS(o->write(&w));
+        EXPECT_EQ(0, memcmp(buf, dst, size));
+
+        // The got property is still valid after decoding all.
+        EXPECT_EQ(4, o->count());
+        EXPECT_EQ(child, o->get_property("video"));
+        EXPECT_STREQ("video", o->key_at(2).c_str());
+
+        o->set("width", SrsAmf0Any::number(1280));
+        EXPECT_EQ(1280, o->ensure_property_number("width")->to_number());
+        EXPECT_STREQ("width", o->key_at(3).c_str());
+    }
+
+    // Copy the lazy object.
+    if (true) {
+        SrsAmf0Any* p = NULL;
+        SrsBuffer b(buf, size);
+        HELPER_ASSERT_SUCCESS(srs_amf0_read_any(&b, &p));
+        SrsAutoFree(SrsAmf0Any, p);
+
+        SrsAmf0Any* cp = p->copy();
+        SrsAutoFree(SrsAmf0Any, cp);
+        EXPECT_EQ(4, cp->to_object()->count());
+        EXPECT_EQ(size, cp->total_size());
+    }
+
+    // Modify the got nested object and number, which should never use the stale raw bytes.
+    if (true) {
+        SrsAmf0Any* p = NULL;
+        SrsBuffer b(buf, size);
+        HELPER_ASSERT_SUCCESS(srs_amf0_read_any(&b, &p));
+        SrsAutoFree(SrsAmf0Any, p);
+
+        SrsAmf0Object* o = p->to_object();
+        o->get_property("video")->to_object()->set("codec", SrsAmf0Any::str("h265"));
+        o->ensure_property_number("width")->set_number(1280);
+
+        SrsAmf0Any* cp = p->copy();
+        SrsAutoFree(SrsAmf0Any, cp);
+
+        char dst[256];
+        SrsBuffer w(dst, sizeof(dst));
+        HELPER_ASSERT_SUCCESS(o->write(&w));
+        EXPECT_EQ(w.pos(), o->total_size());
+
+        SrsAmf0Any* q = NULL;
+        SrsBuffer r(dst, w.pos());
+        HELPER_ASSERT_SUCCESS(srs_amf0_read_any(&r, &q));
+        SrsAutoFree(SrsAmf0Any, q);
+
+        SrsAmf0Any* objs[] = {q, cp};
+        for (int i = 0; i < 2; i++) {
+            SrsAmf0Object* v = objs[i]->to_object();
+            EXPECT_EQ(1280, v->ensure_property_number("width")->to_number());
+            EXPECT_STREQ("h265", v->get_property("video")->to_object()->ensure_property_string("codec")->to_str().c_str());
+        }
+    }
+
+    // Write the raw bytes, when the got value is not modified.
+    if (true) {
+        SrsAmf0Any* p = NULL;
+        SrsBuffer b(buf, size);
+        HELPER_ASSERT_SUCCESS(srs_amf0_read_any(&b, &p));
+        SrsAutoFree(SrsAmf0Any, p);
+
+        SrsAmf0Object* o = p->to_object();
+        EXPECT_EQ(1920, o->ensure_property_number("width")->to_number());
+        EXPECT_TRUE(o->get_property("video") != NULL);
+        EXPECT_TRUE(o->properties->raw() != NULL);
+    }
+
+    // Fail for the invalid marker of property, when read.
+    if (true) {
+        buf[size - 5] = 0x0f;
+        SrsAmf0Any* p = NULL;
+        SrsBuffer b(buf, size);
+        HELPER_EXPECT_FAILED(srs_amf0_read_any(&b, &p));
+        srs_freep(p);
+    }
+}
+
+VOID TEST(ProtocolAMF0Test, Amf0EcmaArrayMoveTo)
+{
+    srs_error_t err;
+
+    char buf[128];
+    int size = 0;
+    if (true) {
+        SrsAmf0EcmaArray* arr = SrsAmf0Any::ecma_array();
+        SrsAutoFree(SrsAmf0EcmaArray, arr);
+        arr->set("width", SrsAmf0Any::number(1920));
+        arr->set("height", SrsAmf0Any::number(1080));
+
+        size = arr->total_size();
+        SrsBuffer b(buf, sizeof(buf));
+        HELPER_ASSERT_SUCCESS(arr->write(&b));
+    }
+
+    SrsAmf0Any* p = NULL;
+    SrsBuffer b(buf, size);
+    HELPER_ASSERT_SUCCESS(srs_amf0_read_any(&b, &p));
+    SrsAutoFree(SrsAmf0Any, p);
+
+    SrsAmf0Object* o = SrsAmf0Any::object();
+    SrsAutoFree(SrsAmf0Object, o);
+    o->set("duration", SrsAmf0Any::number(0));
+
+    SrsAmf0EcmaArray* arr = p->to_ecma_array();
+    arr->move_to(o);
+    EXPECT_EQ(0, arr->count());
+    EXPECT_EQ(2, o->count());
+    EXPECT_TRUE(o->get_property("duration") == NULL);
+    EXPECT_EQ(1080, o->ensure_property_number("height")->to_number());
+}
+
 VOID TEST(ProtocolJSONTest, Interfaces)
 {
     if (true) {
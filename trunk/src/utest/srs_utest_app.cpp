@@ -15,6 +15,26 @@ using namespace std;
 #include <srs_app_st.hpp>
 #include <srs_protocol_conn.hpp>
 #include <srs_app_conn.hpp>
+#include <srs_app_hls.hpp>
+#include <srs_kernel_flv.hpp>
+#include <srs_kernel_ts.hpp>
+#include <srs_kernel_utility.hpp>
+#include <srs_core_autofree.hpp>
+#include <srs_app_dash.hpp>
+#include <srs_app_recv_thread.hpp>
+#include <srs_app_rtmp_conn.hpp>
+#include <srs_app_delivery.hpp>
+#include <srs_app_source.hpp>
+#include <srs_app_edge.hpp>
+#include <srs_app_statistic.hpp>
+#include <srs_app_threads.hpp>
+#include <srs_kernel_codec.hpp>
+#include <srs_protocol_rtmp_stack.hpp>
+#include <srs_utest_config.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <sys/socket.h>
 
 class MockIDResource : public ISrsResource
 {
@@ -512,6 +532,361 @@ VOID TEST(AppFragmentTest, CheckDuration)
 	}
 }
 
+VOID TEST(AppHlsMemoryTest, WriterTakeBuffer)
+{
+    srs_error_t err;
+
+    SrsHlsMemoryWriter w(false);
+    EXPECT_FALSE(w.is_open());
+    HELPER_EXPECT_FAILED(w.write((void*)"Hello", 5, NULL));
+
+    HELPER_EXPECT_SUCCESS(w.open("/not/exists/dir/a.ts.tmp"));
+    EXPECT_TRUE(w.is_open());
+
+    // Write more than the initial buffer, which should grow.
+    char buf[SRS_TS_PACKET_SIZE];
+    memset(buf, 0x47, sizeof(buf));
+    for (int i = 0; i < 2000; i++) {
+        ssize_t nn = 0;
+        HELPER_EXPECT_SUCCESS(w.write(buf, sizeof(buf), &nn));
+        EXPECT_EQ(SRS_TS_PACKET_SIZE, nn);
+    }
+    EXPECT_EQ(2000 * SRS_TS_PACKET_SIZE, w.tellg());
+
+    off_t pos = 0;
+    HELPER_EXPECT_SUCCESS(w.lseek(0, SEEK_CUR, &pos));
+    EXPECT_EQ(2000 * SRS_TS_PACKET_SIZE, pos);
+    HELPER_EXPECT_FAILED(w.lseek(0, SEEK_SET, NULL));
+    w.close();
+
+    // The buffer is transferred to the message, and the writer is reset.
+    SrsSharedPtrMessage* msg = w.take();
+    SrsAutoFree(SrsSharedPtrMessage, msg);
+    EXPECT_EQ(2000 * SRS_TS_PACKET_SIZE, msg->size);
+    EXPECT_EQ(0x47, (uint8_t)msg->payload[msg->size - 1]);
+    EXPECT_EQ(0, w.tellg());
+
+    // Empty segment is also a valid message.
+    HELPER_EXPECT_SUCCESS(w.open("a.ts.tmp"));
+    w.close();
+    SrsSharedPtrMessage* empty = w.take();
+    SrsAutoFree(SrsSharedPtrMessage, empty);
+    EXPECT_EQ(0, empty->size);
+}
+
+VOID TEST(AppHlsMemoryTest, StorePutFetchRemove)
+{
+    SrsHlsMemoryStore store;
+
+    char* payload = new char[10];
+    memset(payload, 0x01, 10);
+    SrsSharedPtrMessage data;
+    data.wrap(payload, 10);
+
+    // The path is normalized, and the buffer is shared.
+    store.put("test.com", "./objs/nginx/html//live/livestream-0.ts", &data);
+    EXPECT_EQ(10, store.size("test.com"));
+    EXPECT_EQ(0, store.size("other.com"));
+    EXPECT_TRUE(store.exists("objs/nginx/html/live/livestream-0.ts"));
+
+    if (true) {
+        SrsSharedPtrMessage* msg = store.fetch("./objs/nginx/html/live/livestream-0.ts");
+        SrsAutoFree(SrsSharedPtrMessage, msg);
+        ASSERT_TRUE(msg != NULL);
+        EXPECT_EQ(payload, msg->payload);
+        EXPECT_EQ(10, msg->size);
+    }
+    EXPECT_TRUE(store.fetch("./objs/nginx/html/live/livestream-1.ts") == NULL);
+
+    // Replace the file of the same path.
+    char* payload2 = new char[20];
+    SrsSharedPtrMessage data2;
+    data2.wrap(payload2, 20);
+    store.put("test.com", "./objs/nginx/html/live/livestream-0.ts", &data2);
+    EXPECT_EQ(20, store.size("test.com"));
+
+    // Should not remove the new file by the stale buffer.
+    store.remove("./objs/nginx/html/live/livestream-0.ts", &data);
+    EXPECT_EQ(20, store.size("test.com"));
+
+    store.remove("./objs/nginx/html/live/livestream-0.ts", &data2);
+    EXPECT_EQ(0, store.size("test.com"));
+    EXPECT_FALSE(store.exists("./objs/nginx/html/live/livestream-0.ts"));
+}
+
+VOID TEST(AppHlsMemoryTest, SegmentInMemory)
+{
+    srs_error_t err;
+
+    SrsTsContext ctx;
+    SrsHlsMemoryWriter w(false);
+    SrsFragmentWindow window;
+
+    for (int i = 0; i < 3; i++) {
+        SrsHlsSegment* seg = new SrsHlsSegment(&ctx, SrsAudioCodecIdAAC, SrsVideoCodecIdAVC, &w);
+        seg->set_vhost("utest.memory");
+        seg->set_path("./objs/utest-memory/live/livestream-" + srs_int2str(i) + "-[duration].ts");
+        seg->uri = "livestream-" + srs_int2str(i) + "-[duration].ts";
+
+        // Memory only, never touch the disk.
+        HELPER_EXPECT_SUCCESS(seg->create_dir());
+        HELPER_EXPECT_SUCCESS(w.open(seg->tmppath()));
+        HELPER_EXPECT_SUCCESS(w.write((void*)"0123456789", 10, NULL));
+        w.close();
+
+        seg->append(0);
+        seg->append(1000);
+        HELPER_EXPECT_SUCCESS(seg->rename());
+        EXPECT_EQ(10, seg->memory_size());
+        EXPECT_STREQ(("livestream-" + srs_int2str(i) + "-1000.ts").c_str(), seg->uri.c_str());
+
+        window.append(seg);
+    }
+
+    EXPECT_FALSE(srs_path_exists("./objs/utest-memory"));
+    EXPECT_EQ(30, _srs_hls_memory->size("utest.memory"));
+    EXPECT_TRUE(_srs_hls_memory->exists("objs/utest-memory/live/livestream-0-1000.ts"));
+
+    // The expired segment is freed, and removed from memory.
+    window.expire_first();
+    EXPECT_EQ(2, window.size());
+    window.clear_expired(false);
+    EXPECT_EQ(20, _srs_hls_memory->size("utest.memory"));
+    EXPECT_FALSE(_srs_hls_memory->exists("objs/utest-memory/live/livestream-0-1000.ts"));
+
+    // Dispose all segments.
+    window.dispose();
+    EXPECT_EQ(0, _srs_hls_memory->size("utest.memory"));
+}
+
+// Create the in-memory segments of stream, each is 10 bytes.
+void mock_hls_memory_segments(SrsTsContext* ctx, SrsHlsMemoryWriter* w, SrsFragmentWindow* window, string stream, int nn)
+{
+    srs_error_t err;
+
+    for (int i = 0; i < nn; i++) {
+        SrsHlsSegment* seg = new SrsHlsSegment(ctx, SrsAudioCodecIdAAC, SrsVideoCodecIdAVC, w);
+        seg->set_vhost("utest.budget");
+        seg->set_path("./objs/utest-budget/live/" + stream + "-" + srs_int2str(i) + ".ts");
+        seg->uri = stream + "-" + srs_int2str(i) + ".ts";
+
+        HELPER_EXPECT_SUCCESS(w->open(seg->tmppath()));
+        HELPER_EXPECT_SUCCESS(w->write((void*)"0123456789", 10, NULL));
+        w->close();
+
+        seg->append(0);
+        seg->append(1000);
+        HELPER_EXPECT_SUCCESS(seg->rename());
+        window->append(seg);
+    }
+}
+
+VOID TEST(AppHlsMemoryTest, BudgetPerStream)
+{
+    SrsTsContext ctx;
+    SrsHlsMemoryWriter w(false);
+
+    // Another stream of the same vhost, which uses much memory.
+    SrsFragmentWindow other;
+    mock_hls_memory_segments(&ctx, &w, &other, "other", 10);
+    EXPECT_EQ(100, _srs_hls_memory->size("utest.budget"));
+
+    SrsHlsMuxer muxer;
+    muxer.hls_memory_ = true;
+    muxer.hls_memory_budget_ = 25;
+    mock_hls_memory_segments(&ctx, &w, muxer.segments, "livestream", 3);
+    EXPECT_EQ(130, _srs_hls_memory->size("utest.budget"));
+
+    // Only the stream itself is limited by the budget, the other stream is not affected.
+    muxer.shrink_memory();
+    muxer.segments->clear_expired(false);
+    EXPECT_EQ(2, muxer.segments->size());
+    EXPECT_EQ(10, other.size());
+    EXPECT_EQ(120, _srs_hls_memory->size("utest.budget"));
+
+    // Always keep the latest segment.
+    muxer.hls_memory_budget_ = 1;
+    muxer.shrink_memory();
+    muxer.segments->clear_expired(false);
+    EXPECT_EQ(1, muxer.segments->size());
+
+    muxer.segments->dispose();
+    other.dispose();
+    EXPECT_EQ(0, _srs_hls_memory->size("utest.budget"));
+}
+
+VOID TEST(AppHlsMemoryTest, SegmentParts)
+{
+    srs_error_t err;
+
+    SrsTsContext ctx;
+    SrsHlsMemoryWriter w(false);
+
+    SrsHlsSegment* seg = new SrsHlsSegment(&ctx, SrsAudioCodecIdAAC, SrsVideoCodecIdAVC, &w);
+    SrsAutoFree(SrsHlsSegment, seg);
+    seg->set_vhost("utest.parts");
+    seg->set_path("./objs/utest-parts/live/livestream-5.ts");
+    seg->uri = "livestream-5.ts";
+    HELPER_EXPECT_SUCCESS(w.open(seg->tmppath()));
+    EXPECT_FALSE(seg->part_opened());
+
+    // The first part starts with keyframe.
+    seg->append(0);
+    seg->open_part(true);
+    HELPER_EXPECT_SUCCESS(w.write((void*)"0123456789", 10, NULL));
+    seg->append(500);
+    EXPECT_EQ(500 * SRS_UTIME_MILLISECONDS, seg->part_duration());
+    HELPER_EXPECT_SUCCESS(seg->close_part());
+
+    // Ignore the empty part.
+    seg->open_part(false);
+    HELPER_EXPECT_SUCCESS(seg->close_part());
+    EXPECT_EQ(1, (int)seg->parts.size());
+
+    seg->open_part(false);
+    HELPER_EXPECT_SUCCESS(w.write((void*)"abcde", 5, NULL));
+    seg->append(800);
+    HELPER_EXPECT_SUCCESS(seg->close_part());
+    ASSERT_EQ(2, (int)seg->parts.size());
+
+    SrsHlsPart* p0 = seg->parts[0];
+    EXPECT_STREQ("livestream-5.0.ts", p0->uri_.c_str());
+    EXPECT_EQ(500 * SRS_UTIME_MILLISECONDS, p0->duration_);
+    EXPECT_TRUE(p0->independent_);
+    EXPECT_EQ(10, p0->data_->size);
+
+    SrsHlsPart* p1 = seg->parts[1];
+    EXPECT_STREQ("livestream-5.1.ts", p1->uri_.c_str());
+    EXPECT_EQ(300 * SRS_UTIME_MILLISECONDS, p1->duration_);
+    EXPECT_FALSE(p1->independent_);
+    EXPECT_EQ(0, memcmp("abcde", p1->data_->payload, 5));
+
+    // The parts are served from memory.
+    EXPECT_EQ(15, _srs_hls_memory->size("utest.parts"));
+    EXPECT_TRUE(_srs_hls_memory->exists("./objs/utest-parts/live/livestream-5.1.ts"));
+
+    seg->clear_parts();
+    EXPECT_EQ(0, _srs_hls_memory->size("utest.parts"));
+    w.close();
+}
+
+VOID TEST(AppHlsMemoryTest, CutPartAtKeyframe)
+{
+    srs_error_t err;
+
+    SrsTsContext ctx;
+    SrsRequest req;
+    req.vhost = "utest.keyframe";
+
+    SrsHlsMuxer muxer;
+    muxer.req = req.copy();
+    muxer.hls_disk_ = false;
+    muxer.hls_memory_ = true;
+    muxer.hls_ll_ = true;
+    muxer.hls_ll_part_ = 1 * SRS_UTIME_SECONDS;
+    muxer.m3u8 = "./objs/utest-keyframe/live/livestream.m3u8";
+
+    SrsHlsMemoryWriter* w = new SrsHlsMemoryWriter(false);
+    muxer.writer = w;
+
+    SrsHlsSegment* seg = new SrsHlsSegment(&ctx, SrsAudioCodecIdAAC, SrsVideoCodecIdAVC, w);
+    muxer.current = seg;
+    seg->set_vhost("utest.keyframe");
+    seg->set_path("./objs/utest-keyframe/live/livestream-0.ts");
+    seg->uri = "livestream-0.ts";
+    HELPER_EXPECT_SUCCESS(w->open(seg->tmppath()));
+
+    // The keyframe starts the first part.
+    seg->append(0);
+    HELPER_EXPECT_SUCCESS(muxer.cut_part(true));
+    HELPER_EXPECT_SUCCESS(w->write((void*)"0123456789", 10, NULL));
+
+    seg->append(100);
+    HELPER_EXPECT_SUCCESS(muxer.cut_part(false));
+    HELPER_EXPECT_SUCCESS(w->write((void*)"0123456789", 10, NULL));
+    EXPECT_EQ(0, (int)seg->parts.size());
+
+    // The keyframe cuts a new part, even if the part is shorter than the target duration.
+    seg->append(200);
+    HELPER_EXPECT_SUCCESS(muxer.cut_part(true));
+    HELPER_EXPECT_SUCCESS(w->write((void*)"0123456789", 10, NULL));
+    ASSERT_EQ(1, (int)seg->parts.size());
+    EXPECT_TRUE(seg->parts[0]->independent_);
+    EXPECT_EQ(200 * SRS_UTIME_MILLISECONDS, seg->parts[0]->duration_);
+    EXPECT_EQ(20, seg->parts[0]->data_->size);
+
+    // Cut by the target duration, and the next part is not independent.
+    seg->append(1200);
+    HELPER_EXPECT_SUCCESS(muxer.cut_part(false));
+    HELPER_EXPECT_SUCCESS(w->write((void*)"0123456789", 10, NULL));
+    ASSERT_EQ(2, (int)seg->parts.size());
+    EXPECT_TRUE(seg->parts[1]->independent_);
+    EXPECT_EQ(1000 * SRS_UTIME_MILLISECONDS, seg->parts[1]->duration_);
+
+    seg->append(1300);
+    HELPER_EXPECT_SUCCESS(muxer.cut_part(true));
+    ASSERT_EQ(3, (int)seg->parts.size());
+    EXPECT_FALSE(seg->parts[2]->independent_);
+
+    _srs_hls_memory->remove(muxer.m3u8);
+    w->close();
+}
+
+// Wait for the LL-HLS playlist or part to be written.
+class MockHlsMemoryWaiter : public ISrsCoroutineHandler
+{
+public:
+    string path_;
+    bool done_;
+public:
+    MockHlsMemoryWaiter(string path) {
+        path_ = path;
+        done_ = false;
+    }
+    virtual ~MockHlsMemoryWaiter() {
+    }
+public:
+    virtual srs_error_t cycle() {
+        _srs_hls_memory->wait(path_, 1 * SRS_UTIME_SECONDS);
+        done_ = true;
+        return srs_success;
+    }
+};
+
+VOID TEST(AppHlsMemoryTest, WaitForPlaylist)
+{
+    srs_error_t err;
+
+    SrsSharedPtrMessage data;
+    data.wrap(new char[1], 1);
+    _srs_hls_memory->put_playlist("utest.wait", "./objs/utest-wait/live/a.m3u8", &data, 0, 0, "./objs/utest-wait/live/a-0.0.ts");
+
+    MockHlsMemoryWaiter w0("./objs/utest-wait/live/a.m3u8");
+    MockHlsMemoryWaiter w1("./objs/utest-wait/live/a-0.0.ts");
+    SrsSTCoroutine t0("w0", &w0), t1("w1", &w1);
+    HELPER_ASSERT_SUCCESS(t0.start());
+    HELPER_ASSERT_SUCCESS(t1.start());
+    srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+
+    // Other playlist never wakeup the requests.
+    _srs_hls_memory->put_playlist("utest.wait", "./objs/utest-wait/live/b.m3u8", &data, 0, 0, "./objs/utest-wait/live/b-0.0.ts");
+    srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+    EXPECT_FALSE(w0.done_);
+    EXPECT_FALSE(w1.done_);
+
+    // The preload hint part wakes up the requests of its playlist.
+    _srs_hls_memory->put("utest.wait", "./objs/utest-wait/live/a-0.0.ts", &data);
+    srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+    EXPECT_TRUE(w0.done_);
+    EXPECT_TRUE(w1.done_);
+    EXPECT_TRUE(_srs_hls_memory->waiters_.empty());
+
+    _srs_hls_memory->remove("./objs/utest-wait/live/a.m3u8");
+    _srs_hls_memory->remove("./objs/utest-wait/live/a-0.0.ts");
+    _srs_hls_memory->remove("./objs/utest-wait/live/b.m3u8");
+    EXPECT_EQ(0, _srs_hls_memory->size("utest.wait"));
+}
+
 VOID TEST(AppSecurity, CheckSecurity)
 {
     srs_error_t err;
@@ -783,3 +1158,730 @@ VOID TEST(AppSecurity, CheckSecurity)
     //       4. deny if matches deny strategy.
 }
 
+
+VOID TEST(AppDashTest, Fmp4Codecs)
+{
+    SrsFormat format;
+    EXPECT_STREQ("", srs_fmp4_video_codecs(&format).c_str());
+    EXPECT_STREQ("", srs_fmp4_audio_codecs(&format).c_str());
+
+    format.vcodec = new SrsVideoCodecConfig();
+    format.vcodec->id = SrsVideoCodecIdAVC;
+    uint8_t avcc[] = {0x01, 0x64, 0x00, 0x1f, 0xff};
+    format.vcodec->avc_extra_data.assign((char*)avcc, (char*)avcc + sizeof(avcc));
+    EXPECT_STREQ("avc1.64001f", srs_fmp4_video_codecs(&format).c_str());
+
+    format.acodec = new SrsAudioCodecConfig();
+    format.acodec->id = SrsAudioCodecIdAAC;
+    format.acodec->aac_object = SrsAacObjectTypeAacHE;
+    EXPECT_STREQ("mp4a.40.5", srs_fmp4_audio_codecs(&format).c_str());
+
+#ifdef SRS_H265
+    // The HEVC Main profile, level 3.1, with progressive and frame-only constraint flags.
+    format.vcodec->id = SrsVideoCodecIdHEVC;
+    SrsHevcDecoderConfigurationRecord* r = &format.vcodec->hevc_dec_conf_record_;
+    r->general_profile_space = 0;
+    r->general_profile_idc = 1;
+    r->general_profile_compatibility_flags = 0x60000000;
+    r->general_tier_flag = 0;
+    r->general_level_idc = 93;
+    r->general_constraint_indicator_flags = 0xb00000000000ULL;
+    EXPECT_STREQ("hev1.1.6.L93.B0", srs_fmp4_video_codecs(&format).c_str());
+    EXPECT_STREQ("hvc1.1.6.L93.B0", srs_fmp4_video_codecs(&format, true).c_str());
+#endif
+}
+
+static std::string mock_read_file(std::string path)
+{
+    std::ifstream f(path.c_str());
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+VOID TEST(AppDashTest, CmafM3u8Writer)
+{
+    srs_error_t err;
+
+    SrsSetEnvConfig(dash_hls, "SRS_VHOST_DASH_DASH_HLS", "on");
+    SrsSetEnvConfig(dash_path, "SRS_VHOST_DASH_DASH_PATH", "./objs/utest-cmaf");
+
+    SrsRequest req;
+    req.vhost = "__defaultVhost__";
+    req.app = "live";
+    req.stream = "livestream";
+
+    SrsFormat format;
+    format.vcodec = new SrsVideoCodecConfig();
+    format.vcodec->id = SrsVideoCodecIdAVC;
+    format.vcodec->width = 1280;
+    format.vcodec->height = 720;
+    uint8_t avcc[] = {0x01, 0x4d, 0x00, 0x1f, 0xff};
+    format.vcodec->avc_extra_data.assign((char*)avcc, (char*)avcc + sizeof(avcc));
+    format.acodec = new SrsAudioCodecConfig();
+    format.acodec->id = SrsAudioCodecIdAAC;
+    format.acodec->aac_object = SrsAacObjectTypeAacLC;
+
+    SrsFragmentWindow afragments, vfragments;
+    for (int i = 0; i < 2; i++) {
+        SrsFragment* v = new SrsFragment();
+        v->set_number(10 + i);
+        v->append(i * 2000);
+        v->append(i * 2000 + 1960);
+        vfragments.append(v);
+
+        SrsFragment* a = new SrsFragment();
+        a->set_number(10 + i);
+        a->append(i * 2000);
+        a->append(i * 2000 + 2000);
+        afragments.append(a);
+    }
+
+    SrsCmafM3u8Writer writer;
+    HELPER_EXPECT_SUCCESS(writer.initialize(&req));
+    HELPER_EXPECT_SUCCESS(writer.on_publish());
+    HELPER_EXPECT_SUCCESS(writer.write(&format, &afragments, &vfragments));
+
+    // The master never conflicts with the TS HLS m3u8.
+    EXPECT_FALSE(srs_path_exists("./objs/utest-cmaf/live/livestream.m3u8"));
+    std::string master = mock_read_file("./objs/utest-cmaf/live/livestream.cmaf.m3u8");
+    std::string video = mock_read_file("./objs/utest-cmaf/live/livestream/video.m3u8");
+    std::string audio = mock_read_file("./objs/utest-cmaf/live/livestream/audio.m3u8");
+
+    EXPECT_TRUE(master.find("CODECS=\"avc1.4d001f,mp4a.40.2\",RESOLUTION=1280x720") != std::string::npos);
+    EXPECT_TRUE(master.find("URI=\"livestream/audio.m3u8\"") != std::string::npos);
+    EXPECT_TRUE(master.find("\nlivestream/video.m3u8\n") != std::string::npos);
+
+    // The media m3u8 refers to the same init mp4 and m4s segments of DASH.
+    EXPECT_TRUE(video.find("#EXT-X-TARGETDURATION:2\n") != std::string::npos);
+    EXPECT_TRUE(video.find("#EXT-X-MEDIA-SEQUENCE:10\n") != std::string::npos);
+    EXPECT_TRUE(video.find("#EXT-X-MAP:URI=\"video-init.mp4\"") != std::string::npos);
+    EXPECT_TRUE(video.find("#EXTINF:1.960,\nvideo-11.m4s\n") != std::string::npos);
+    EXPECT_TRUE(audio.find("#EXT-X-MAP:URI=\"audio-init.mp4\"") != std::string::npos);
+    EXPECT_TRUE(audio.find("#EXTINF:2.000,\naudio-10.m4s\n") != std::string::npos);
+
+    writer.dispose();
+    EXPECT_FALSE(srs_path_exists("./objs/utest-cmaf/live/livestream.cmaf.m3u8"));
+    EXPECT_FALSE(srs_path_exists("./objs/utest-cmaf/live/livestream/video.m3u8"));
+}
+
+VOID TEST(AppDashTest, CmafM3u8WriterPureStream)
+{
+    srs_error_t err;
+
+    SrsSetEnvConfig(dash_hls, "SRS_VHOST_DASH_DASH_HLS", "on");
+    SrsSetEnvConfig(dash_path, "SRS_VHOST_DASH_DASH_PATH", "./objs/utest-cmaf");
+
+    SrsRequest req;
+    req.vhost = "__defaultVhost__";
+    req.app = "live";
+    req.stream = "livestream";
+
+    // Pure audio, the audio m3u8 is the variant stream.
+    if (true) {
+        SrsFormat format;
+        format.acodec = new SrsAudioCodecConfig();
+        format.acodec->id = SrsAudioCodecIdAAC;
+        format.acodec->aac_object = SrsAacObjectTypeAacLC;
+
+        SrsFragmentWindow afragments, vfragments;
+        SrsFragment* f = new SrsFragment();
+        f->set_number(10);
+        f->append(0);
+        f->append(2000);
+        afragments.append(f);
+
+        SrsCmafM3u8Writer writer;
+        HELPER_EXPECT_SUCCESS(writer.initialize(&req));
+        HELPER_EXPECT_SUCCESS(writer.on_publish());
+        HELPER_EXPECT_SUCCESS(writer.write(&format, &afragments, &vfragments));
+
+        std::string master = mock_read_file("./objs/utest-cmaf/live/livestream.cmaf.m3u8");
+        EXPECT_TRUE(master.find("#EXT-X-STREAM-INF:BANDWIDTH=48000,CODECS=\"mp4a.40.2\"\nlivestream/audio.m3u8\n") != std::string::npos);
+        EXPECT_TRUE(master.find("#EXT-X-MEDIA") == std::string::npos);
+        EXPECT_TRUE(srs_path_exists("./objs/utest-cmaf/live/livestream/audio.m3u8"));
+        EXPECT_FALSE(srs_path_exists("./objs/utest-cmaf/live/livestream/video.m3u8"));
+
+        writer.dispose();
+    }
+
+    // Pure video, without the audio group.
+    if (true) {
+        SrsFormat format;
+        format.vcodec = new SrsVideoCodecConfig();
+        format.vcodec->id = SrsVideoCodecIdAVC;
+        format.vcodec->width = 1280;
+        format.vcodec->height = 720;
+        uint8_t avcc[] = {0x01, 0x4d, 0x00, 0x1f, 0xff};
+        format.vcodec->avc_extra_data.assign((char*)avcc, (char*)avcc + sizeof(avcc));
+
+        SrsFragmentWindow afragments, vfragments;
+        SrsFragment* f = new SrsFragment();
+        f->set_number(10);
+        f->append(0);
+        f->append(2000);
+        vfragments.append(f);
+
+        SrsCmafM3u8Writer writer;
+        HELPER_EXPECT_SUCCESS(writer.initialize(&req));
+        HELPER_EXPECT_SUCCESS(writer.on_publish());
+        HELPER_EXPECT_SUCCESS(writer.write(&format, &afragments, &vfragments));
+
+        std::string master = mock_read_file("./objs/utest-cmaf/live/livestream.cmaf.m3u8");
+        EXPECT_TRUE(master.find("CODECS=\"avc1.4d001f\",RESOLUTION=1280x720\nlivestream/video.m3u8\n") != std::string::npos);
+        EXPECT_TRUE(master.find("AUDIO=") == std::string::npos);
+        EXPECT_FALSE(srs_path_exists("./objs/utest-cmaf/live/livestream/audio.m3u8"));
+
+        writer.dispose();
+    }
+}
+
+VOID TEST(AppMergedReadTest, AdaptiveSleep)
+{
+    srs_utime_t latency = 350 * SRS_UTIME_MILLISECONDS;
+
+    // Unknown bitrate, use the latency budget.
+    EXPECT_EQ(latency, srs_mr_adaptive_sleep(0, latency));
+
+    // Merge 64KB for each read, 65536*8/5000=104ms.
+    EXPECT_EQ(104857, srs_mr_adaptive_sleep(5000, latency));
+
+    // High bitrate, limited by the min sleep.
+    EXPECT_EQ(10 * SRS_UTIME_MILLISECONDS, srs_mr_adaptive_sleep(100000, latency));
+
+    // Low bitrate, limited by the latency budget.
+    EXPECT_EQ(latency, srs_mr_adaptive_sleep(500, latency));
+    EXPECT_EQ(100 * SRS_UTIME_MILLISECONDS, srs_mr_adaptive_sleep(500, 100 * SRS_UTIME_MILLISECONDS));
+}
+
+VOID TEST(AppMergedReadTest, AdaptiveRecvBuffer)
+{
+    // Double of the bytes in sleep, 104*5000*2/8=130000B.
+    EXPECT_EQ(130000, srs_mr_adaptive_rbuf(5000, 0, 104857));
+    EXPECT_EQ(130000, srs_mr_adaptive_rbuf(5000, 65000, 104857));
+
+    // The sampled read size is larger, for the burst of key frames.
+    EXPECT_EQ(262144, srs_mr_adaptive_rbuf(5000, 131072, 104857));
+
+    // The sleep is clamped by latency, but the recv buffer follows the bitrate.
+    srs_utime_t latency = 350 * SRS_UTIME_MILLISECONDS;
+    EXPECT_EQ(43750, srs_mr_adaptive_rbuf(500, 0, latency));
+    EXPECT_EQ(87500, srs_mr_adaptive_rbuf(1000, 0, latency));
+}
+
+VOID TEST(AppMergedWriteTest, AdaptiveSleep)
+{
+    srs_utime_t latency = 350 * SRS_UTIME_MILLISECONDS;
+    srs_utime_t now = 1000 * SRS_UTIME_SECONDS;
+
+    // Use the latency budget, util sampled.
+    if (true) {
+        SrsMwAdaptive amw(latency);
+        EXPECT_EQ(latency, amw.sleep());
+        EXPECT_EQ(16384, amw.bytes());
+        EXPECT_FALSE(amw.sample(now, 0, 0));
+        EXPECT_FALSE(amw.sample(now + 1 * SRS_UTIME_SECONDS, 625000, 0));
+        EXPECT_EQ(latency, amw.sleep());
+    }
+
+    // For 5000kbps, wait for 16KB, that is 16384*8/5000=26ms.
+    if (true) {
+        SrsMwAdaptive amw(latency);
+        EXPECT_FALSE(amw.sample(now, 0, 0));
+        EXPECT_TRUE(amw.sample(now + 3 * SRS_UTIME_SECONDS, 625000 * 3, 0));
+        EXPECT_EQ(5000, amw.kbps());
+        EXPECT_EQ(5000, amw.drain_kbps());
+        EXPECT_EQ(26214, amw.sleep());
+    }
+
+    // For 64kbps audio, never got 16KB in budget, wait 350*350/2048=59ms.
+    if (true) {
+        SrsMwAdaptive amw(latency);
+        EXPECT_FALSE(amw.sample(now, 0, 0));
+        EXPECT_TRUE(amw.sample(now + 3 * SRS_UTIME_SECONDS, 8000 * 3, 0));
+        EXPECT_EQ(64, amw.kbps());
+        EXPECT_EQ(59814, amw.sleep());
+    }
+
+    // For 100Mbps, limited by the min wait.
+    if (true) {
+        SrsMwAdaptive amw(latency);
+        EXPECT_FALSE(amw.sample(now, 0, 0));
+        EXPECT_TRUE(amw.sample(now + 3 * SRS_UTIME_SECONDS, 12500000 * 3, 0));
+        EXPECT_EQ(10 * SRS_UTIME_MILLISECONDS, amw.sleep());
+    }
+
+    // The socket send buffer does not drain, use the latency budget.
+    if (true) {
+        SrsMwAdaptive amw(latency);
+        EXPECT_FALSE(amw.sample(now, 0, 0));
+        EXPECT_TRUE(amw.sample(now + 3 * SRS_UTIME_SECONDS, 625000 * 3, 0));
+        EXPECT_EQ(26214, amw.sleep());
+
+        EXPECT_TRUE(amw.sample(now + 6 * SRS_UTIME_SECONDS, 625000 * 6, 625000));
+        EXPECT_EQ(5000, amw.kbps());
+        EXPECT_LT(amw.drain_kbps(), 5000);
+        EXPECT_EQ(625000, amw.outq());
+        EXPECT_EQ(latency, amw.sleep());
+    }
+
+    // Reload the latency budget.
+    if (true) {
+        SrsMwAdaptive amw(latency);
+        amw.set_latency(100 * SRS_UTIME_MILLISECONDS);
+        EXPECT_EQ(100 * SRS_UTIME_MILLISECONDS, amw.sleep());
+    }
+}
+
+SrsSharedPtrMessage* mock_delivery_message(int8_t type, uint8_t b0, uint8_t b1)
+{
+    SrsMessageHeader h;
+    h.message_type = type;
+
+    char* payload = new char[2];
+    payload[0] = (char)b0;
+    payload[1] = (char)b1;
+
+    SrsSharedPtrMessage* msg = new SrsSharedPtrMessage();
+    srs_error_t err = msg->create(&h, payload, 2);
+    srs_freep(err);
+    return msg;
+}
+
+VOID TEST(AppDeliveryTest, ReplicaRing)
+{
+    // Keep about two GOPs, and start from the last keyframe.
+    if (true) {
+        SrsDeliveryReplica replica("/live/livestream");
+        replica.on_message(mock_delivery_message(RTMP_MSG_AMF0DataMessage, 0x02, 0x00));
+        replica.on_message(mock_delivery_message(RTMP_MSG_VideoMessage, 0x17, 0x00));
+        replica.on_message(mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x00));
+        EXPECT_EQ(0, replica.first());
+        EXPECT_EQ(3, replica.head());
+        EXPECT_EQ(3, replica.start());
+
+        // GOP #1 at 3, GOP #2 at 6.
+        replica.on_message(mock_delivery_message(RTMP_MSG_VideoMessage, 0x17, 0x01));
+        replica.on_message(mock_delivery_message(RTMP_MSG_VideoMessage, 0x27, 0x01));
+        replica.on_message(mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x01));
+        replica.on_message(mock_delivery_message(RTMP_MSG_VideoMessage, 0x17, 0x01));
+        EXPECT_EQ(3, replica.first());
+        EXPECT_EQ(7, replica.head());
+        EXPECT_EQ(6, replica.start());
+
+        // GOP #3 at 8, drop GOP #1.
+        replica.on_message(mock_delivery_message(RTMP_MSG_VideoMessage, 0x27, 0x01));
+        replica.on_message(mock_delivery_message(RTMP_MSG_VideoMessage, 0x17, 0x01));
+        EXPECT_EQ(6, replica.first());
+        EXPECT_EQ(9, replica.head());
+        EXPECT_EQ(8, replica.start());
+        EXPECT_TRUE(replica.at(8)->msg_->is_video());
+
+        // The metadata and sequence headers are cached for new players.
+        vector<SrsDeliveryMessage*> msgs;
+        replica.dump_headers(msgs);
+        ASSERT_EQ(3, (int)msgs.size());
+        EXPECT_FALSE(msgs.at(0)->msg_->is_av());
+        EXPECT_TRUE(msgs.at(1)->msg_->is_video());
+        EXPECT_TRUE(msgs.at(2)->msg_->is_audio());
+        for (int i = 0; i < (int)msgs.size(); i++) {
+            SrsDeliveryMessage::unref(msgs[i]);
+        }
+    }
+
+    // For stream without video, limited by the max messages.
+    if (true) {
+        SrsDeliveryReplica replica("/live/livestream", 4);
+        for (int i = 0; i < 6; i++) {
+            replica.on_message(mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x01));
+        }
+        EXPECT_EQ(2, replica.first());
+        EXPECT_EQ(6, replica.head());
+        EXPECT_EQ(6, replica.start());
+    }
+
+    // The message referred by player is still valid, after dropped by ring.
+    if (true) {
+        SrsDeliveryReplica replica("/live/livestream", 2);
+        replica.on_message(mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x01));
+        SrsDeliveryMessage* msg = replica.at(0)->ref();
+
+        for (int i = 0; i < 4; i++) {
+            replica.on_message(mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x02));
+        }
+        EXPECT_EQ(3, replica.first());
+        EXPECT_EQ(1, msg->refs_);
+        EXPECT_EQ(0x01, msg->msg_->payload[1]);
+        SrsDeliveryMessage::unref(msg);
+    }
+
+    // The sequence header is kept after dropped by ring, and replaced by the new one.
+    if (true) {
+        SrsDeliveryReplica replica("/live/livestream", 2);
+        replica.on_message(mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x00));
+        EXPECT_EQ(2, replica.at(0)->refs_);
+
+        for (int i = 0; i < 2; i++) {
+            replica.on_message(mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x01));
+        }
+        EXPECT_EQ(1, replica.first());
+        EXPECT_EQ(1, replica.audio_sh_->refs_);
+
+        replica.on_message(mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x00));
+        EXPECT_EQ(2, replica.audio_sh_->refs_);
+        EXPECT_EQ(replica.audio_sh_, replica.at(3));
+    }
+}
+
+VOID TEST(AppDeliveryTest, DeepCopyMessage)
+{
+    SrsSharedPtrMessage* msg = mock_delivery_message(RTMP_MSG_VideoMessage, 0x17, 0x01);
+    SrsAutoFree(SrsSharedPtrMessage, msg);
+    msg->timestamp = 100;
+
+    SrsSharedPtrMessage* copy = msg->deep_copy();
+    SrsAutoFree(SrsSharedPtrMessage, copy);
+
+    // Never share the payload, so it's safe to free in other thread.
+    EXPECT_EQ(0, msg->count());
+    EXPECT_EQ(0, copy->count());
+    EXPECT_NE(msg->payload, copy->payload);
+    EXPECT_EQ(msg->size, copy->size);
+    EXPECT_EQ(0, memcmp(msg->payload, copy->payload, msg->size));
+    EXPECT_EQ(100, copy->timestamp);
+    EXPECT_TRUE(copy->is_video());
+}
+
+VOID TEST(AppDeliveryTest, SendFlvTags)
+{
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+
+    // The player owns the write end of pipe, as a duplicated fd of HTTP-FLV player.
+    SrsDeliveryJob job(SrsDeliveryJobPlay, "/live/livestream");
+    job.fd_ = fds[1];
+    job.flv_ = true;
+    SrsDeliveryPlayer player(NULL, NULL, &job);
+    EXPECT_EQ(-1, job.fd_);
+
+    vector<SrsSharedPtrMessage*> msgs;
+    msgs.push_back(mock_delivery_message(RTMP_MSG_VideoMessage, 0x17, 0x01));
+    msgs.at(0)->timestamp = 100;
+    EXPECT_EQ(0, player.send_messages(msgs));
+    srs_freep(msgs[0]);
+
+    // A FLV tag in a HTTP chunk, the size is 11B tag header, 2B payload and 4B previous tag size.
+    uint8_t expect[] = {
+        '1', '1', '\r', '\n',
+        0x09, 0x00, 0x00, 0x02, 0x00, 0x00, 0x64, 0x00, 0x00, 0x00, 0x00,
+        0x17, 0x01,
+        0x00, 0x00, 0x00, 0x0d,
+        '\r', '\n',
+    };
+    char buf[64];
+    EXPECT_EQ((ssize_t)sizeof(expect), ::read(fds[0], buf, sizeof(buf)));
+    EXPECT_EQ(0, memcmp(expect, buf, sizeof(expect)));
+    ::close(fds[0]);
+}
+
+class MockLiveSourceHandler : public ISrsLiveSourceHandler
+{
+public:
+    virtual srs_error_t on_publish(SrsLiveSource* s, SrsRequest* r) {
+        return srs_success;
+    }
+    virtual void on_unpublish(SrsLiveSource* s, SrsRequest* r) {
+    }
+};
+
+class MockLiveSourceBridge : public ISrsLiveSourceBridge
+{
+public:
+    int nn_publish_;
+    int nn_audios_;
+    int nn_videos_;
+public:
+    MockLiveSourceBridge() {
+        nn_publish_ = nn_audios_ = nn_videos_ = 0;
+    }
+    virtual srs_error_t on_publish() {
+        nn_publish_++;
+        return srs_success;
+    }
+    virtual srs_error_t on_audio(SrsSharedPtrMessage* audio) {
+        nn_audios_++;
+        return srs_success;
+    }
+    virtual srs_error_t on_video(SrsSharedPtrMessage* video) {
+        nn_videos_++;
+        return srs_success;
+    }
+    virtual void on_unpublish() {
+    }
+};
+
+// Use the config for test, and restore the global one when done.
+class MockEdgeBridgeConfig
+{
+public:
+    SrsConfig* saved_;
+    MockSrsConfig conf_;
+public:
+    MockEdgeBridgeConfig() {
+        saved_ = _srs_config;
+        _srs_config = &conf_;
+    }
+    virtual ~MockEdgeBridgeConfig() {
+        _srs_config = saved_;
+    }
+};
+
+VOID TEST(AppEdgeBridgeTest, BridgePlayers)
+{
+    srs_error_t err;
+
+    MockEdgeBridgeConfig mock;
+    HELPER_ASSERT_SUCCESS(mock.conf_.parse(_MIN_OK_CONF));
+
+    SrsRequest req;
+    req.vhost = "__defaultVhost__";
+    req.app = "live";
+    req.stream = "livestream";
+
+    MockLiveSourceHandler handler;
+    SrsLiveSource source;
+    HELPER_ASSERT_SUCCESS(source.initialize(&req, &handler));
+
+    // The bridge players keep the stream alive, as the consumers do.
+    HELPER_EXPECT_SUCCESS(source.on_bridge_play());
+    HELPER_EXPECT_SUCCESS(source.on_bridge_play());
+    EXPECT_EQ(2, source.nb_bridge_players());
+    EXPECT_EQ(0, source.stream_die_at_);
+    EXPECT_EQ(0, source.publisher_idle_at_);
+
+    source.on_bridge_stop();
+    EXPECT_EQ(1, source.nb_bridge_players());
+    EXPECT_EQ(0, source.publisher_idle_at_);
+
+    // The publisher is idle when the last player quit.
+    source.on_bridge_stop();
+    EXPECT_EQ(0, source.nb_bridge_players());
+    EXPECT_NE(0, source.publisher_idle_at_);
+
+    // Not edge, the stream never dies.
+    EXPECT_EQ(0, source.stream_die_at_);
+    EXPECT_FALSE(source.stream_is_dead());
+}
+
+VOID TEST(AppEdgeBridgeTest, EdgeBridgePlayers)
+{
+    srs_error_t err;
+
+    MockEdgeBridgeConfig mock;
+    HELPER_ASSERT_SUCCESS(mock.conf_.parse(_MIN_OK_CONF "vhost __defaultVhost__{cluster{mode remote;origin 127.0.0.1:19351;}}"));
+
+    SrsRequest req;
+    req.vhost = "__defaultVhost__";
+    req.app = "live";
+    req.stream = "livestream";
+
+    MockLiveSourceHandler handler;
+    SrsLiveSource source;
+    HELPER_ASSERT_SUCCESS(source.initialize(&req, &handler));
+
+    // The first player starts the ingester, which publishes the source.
+    HELPER_EXPECT_SUCCESS(source.on_bridge_play());
+    EXPECT_EQ(SrsEdgeStatePlay, source.play_edge->state);
+    EXPECT_FALSE(source.can_publish(false));
+
+    // Other players share the same ingester.
+    HELPER_EXPECT_SUCCESS(source.on_bridge_play());
+    EXPECT_EQ(SrsEdgeStatePlay, source.play_edge->state);
+    EXPECT_EQ(2, source.nb_bridge_players());
+
+    source.on_bridge_stop();
+    EXPECT_EQ(SrsEdgeStatePlay, source.play_edge->state);
+    EXPECT_FALSE(source.stream_is_dead());
+
+    // Stop the ingester when the last player quit, and the edge stream dies.
+    source.on_bridge_stop();
+    EXPECT_EQ(SrsEdgeStateInit, source.play_edge->state);
+    EXPECT_TRUE(source.can_publish(false));
+    EXPECT_NE(0, source.stream_die_at_);
+}
+
+VOID TEST(AppEdgeBridgeTest, AttachBridge)
+{
+    srs_error_t err;
+
+    MockEdgeBridgeConfig mock;
+    HELPER_ASSERT_SUCCESS(mock.conf_.parse(_MIN_OK_CONF));
+
+    SrsRequest req;
+    req.vhost = "__defaultVhost__";
+    req.app = "live";
+    req.stream = "livestream";
+
+    MockLiveSourceHandler handler;
+    SrsLiveSource source;
+    HELPER_ASSERT_SUCCESS(source.initialize(&req, &handler));
+
+    // Not publishing, the bridge is notified when publish.
+    if (true) {
+        MockLiveSourceBridge* bridge = new MockLiveSourceBridge();
+        HELPER_EXPECT_SUCCESS(source.attach_bridge(bridge));
+        EXPECT_TRUE(source.has_bridge());
+        EXPECT_EQ(0, bridge->nn_publish_);
+
+        HELPER_EXPECT_SUCCESS(source.on_publish());
+        EXPECT_EQ(1, bridge->nn_publish_);
+
+        // The bridge is freed when unpublish.
+        source.on_unpublish();
+        EXPECT_FALSE(source.has_bridge());
+    }
+
+    // Attach when publishing, the bridge is notified and fed with the sequence headers.
+    if (true) {
+        HELPER_EXPECT_SUCCESS(source.on_publish());
+        source.meta->audio = mock_delivery_message(RTMP_MSG_AudioMessage, 0xaf, 0x00);
+        source.meta->video = mock_delivery_message(RTMP_MSG_VideoMessage, 0x17, 0x00);
+
+        MockLiveSourceBridge* bridge = new MockLiveSourceBridge();
+        HELPER_EXPECT_SUCCESS(source.attach_bridge(bridge));
+        EXPECT_EQ(1, bridge->nn_publish_);
+        EXPECT_EQ(1, bridge->nn_audios_);
+        EXPECT_EQ(1, bridge->nn_videos_);
+
+        source.on_unpublish();
+        EXPECT_FALSE(source.has_bridge());
+    }
+}
+
+VOID TEST(AppDeliveryTest, WorkersHotAndStop)
+{
+    srs_error_t err;
+
+    SrsRequest req;
+    req.vhost = "__defaultVhost__";
+    req.app = "live";
+    req.stream = "livestream";
+
+    MockLiveSourceHandler handler;
+    SrsLiveSource source;
+    HELPER_ASSERT_SUCCESS(source.initialize(&req, &handler));
+
+    SrsDeliveryWorkers* workers = new SrsDeliveryWorkers();
+    if (true) {
+        SrsSetEnvConfig(enabled, "SRS_DELIVERY_ENABLED", "on");
+        SrsSetEnvConfig(nn_workers, "SRS_DELIVERY_WORKERS", "2");
+        SrsSetEnvConfig(players, "SRS_DELIVERY_PLAYERS", "2");
+        HELPER_ASSERT_SUCCESS(workers->initialize());
+        EXPECT_TRUE(workers->enabled());
+
+        // The feeder is a consumer of source, but not a player.
+        SrsLiveConsumer* c0 = NULL;
+        SrsLiveConsumer* c1 = NULL;
+        HELPER_ASSERT_SUCCESS(source.create_consumer(c0));
+        HELPER_ASSERT_SUCCESS(source.create_consumer(c1));
+        EXPECT_TRUE(workers->hot(&source, &req));
+
+        string url = req.get_stream_url();
+        workers->feeders_[url].resize(2, NULL);
+        workers->feeders_[url][0] = new SrsDeliveryFeeder(workers, workers->workers_.at(0), url);
+        EXPECT_FALSE(workers->hot(&source, &req));
+
+        workers->players_[url] = 1;
+        EXPECT_TRUE(workers->hot(&source, &req));
+
+        srs_freep(c0);
+        srs_freep(c1);
+    }
+
+    // Hand off a player to worker, which is freed when stopping.
+    int fds[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    SrsDeliveryJob* job = new SrsDeliveryJob(SrsDeliveryJobPlay, req.get_stream_url());
+    job->fd_ = fds[1];
+    workers->submit(workers->workers_.at(1), job);
+    srs_usleep(30 * SRS_UTIME_MILLISECONDS);
+
+    // The workers quit before the workers and jobs are freed, and the player is closed.
+    workers->stop_workers();
+    EXPECT_EQ(0, workers->nn_running_);
+    EXPECT_TRUE(workers->workers_.at(1)->players_.empty());
+
+    char buf[16];
+    EXPECT_EQ(0, ::read(fds[0], buf, sizeof(buf)));
+    ::close(fds[0]);
+
+    srs_freep(workers);
+}
+
+VOID TEST(AppDeliveryTest, QuitIfJobsPipeClosed)
+{
+    srs_error_t err;
+
+    SrsDeliveryWorkers* workers = new SrsDeliveryWorkers();
+    SrsAutoFree(SrsDeliveryWorkers, workers);
+
+    SrsSetEnvConfig(enabled, "SRS_DELIVERY_ENABLED", "on");
+    SrsSetEnvConfig(nn_workers, "SRS_DELIVERY_WORKERS", "1");
+    HELPER_ASSERT_SUCCESS(workers->initialize());
+
+    // The worker quits for EOF of jobs pipe, rather than spinning on it.
+    SrsDeliveryWorker* worker = workers->workers_.at(0);
+    ::close(worker->jobs_pipe_[1]);
+    worker->jobs_pipe_[1] = -1;
+
+    int nn_running = 1;
+    for (int i = 0; i < 100 && nn_running > 0; i++) {
+        srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+
+        SrsThreadMutex* lock = workers->lock_;
+        SrsThreadLocker(lock);
+        nn_running = workers->nn_running_;
+    }
+    EXPECT_EQ(0, nn_running);
+}
+
+class MockDeliveryExpire : public ISrsExpire
+{
+public:
+    virtual void expire() {
+    }
+};
+
+VOID TEST(AppDeliveryTest, KeepClientUtilLeave)
+{
+    srs_error_t err;
+
+    SrsRequest req;
+    req.vhost = "__defaultVhost__";
+    req.app = "live";
+    req.stream = "livestream";
+
+    SrsStatistic* stat = SrsStatistic::instance();
+    MockDeliveryExpire conn;
+    HELPER_ASSERT_SUCCESS(stat->on_client("delivery-client", &req, &conn, SrsFlvPlay));
+
+    SrsDeliveryWorkers workers;
+    workers.workers_.push_back(new SrsDeliveryWorker(&workers, 0));
+
+    // The client is kept in stat after handoff, but the connection is freed.
+    stat->on_client_handoff("delivery-client");
+    workers.clients_["delivery-client"] = req.copy();
+    EXPECT_TRUE(workers.delivered("delivery-client"));
+    ASSERT_TRUE(stat->find_client("delivery-client") != NULL);
+    EXPECT_TRUE(stat->find_client("delivery-client")->conn == NULL);
+
+    // Remove the client when the worker reports the player is gone, and fire on_stop async.
+    SrsDeliveryJob job(SrsDeliveryJobLeave, req.get_stream_url());
+    job.worker_ = 0;
+    job.id_ = "delivery-client";
+    workers.on_leave(&job);
+    EXPECT_FALSE(workers.delivered("delivery-client"));
+    EXPECT_TRUE(stat->find_client("delivery-client") == NULL);
+    EXPECT_EQ(1, workers.async_->count());
+}
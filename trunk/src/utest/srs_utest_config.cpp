@@ -3022,6 +3022,20 @@ VOID TEST(ConfigMainTest, CheckVhostConfig2)
         EXPECT_TRUE(conf.get_mr_enabled("ossrs.net"));
     }
 
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost ossrs.net{publish{mr on; mr_adaptive on;}}"));
+        EXPECT_TRUE(conf.get_mr_adaptive("ossrs.net"));
+        EXPECT_FALSE(conf.get_mr_adaptive("__defaultVhost__"));
+    }
+
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost ossrs.net{play{mw_latency 350; mw_adaptive on;}}"));
+        EXPECT_TRUE(conf.get_mw_adaptive("ossrs.net"));
+        EXPECT_FALSE(conf.get_mw_adaptive("__defaultVhost__"));
+    }
+
     if (true) {
         MockSrsConfig conf;
         HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost ossrs.net{publish{parse_sps off;}}"));
@@ -3131,6 +3145,78 @@ VOID TEST(ConfigMainTest, CheckVhostConfig2)
     }
 }
 
+VOID TEST(ConfigMainTest, CheckVhostSnapshot)
+{
+    srs_error_t err;
+
+    MockSrsConfig conf;
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost ossrs.net{tcp_nodelay on;min_latency on;play{gop_cache off;queue_length 20;mw_msgs 16;atc on;}}"
+        "vhost edge.net{cluster{mode remote;origin 127.0.0.1;}} vhost __defaultVhost__{play{gop_cache_max_frames 100;}}"));
+
+    conf.compile_snapshot();
+
+    EXPECT_TRUE(conf.get_vhost("ossrs.net") != NULL);
+    EXPECT_STREQ("ossrs.net", conf.get_vhost("ossrs.net")->arg0().c_str());
+    EXPECT_TRUE(conf.get_tcp_nodelay("ossrs.net"));
+    EXPECT_TRUE(conf.get_realtime_enabled("ossrs.net"));
+    EXPECT_FALSE(conf.get_gop_cache("ossrs.net"));
+    EXPECT_EQ(20 * SRS_UTIME_SECONDS, conf.get_queue_length("ossrs.net"));
+    EXPECT_EQ(16, conf.get_mw_msgs("ossrs.net", false));
+    EXPECT_EQ(16, conf.get_mw_msgs("ossrs.net", true));
+    EXPECT_TRUE(conf.get_atc("ossrs.net"));
+    EXPECT_FALSE(conf.get_vhost_is_edge("ossrs.net"));
+    EXPECT_TRUE(conf.get_vhost_is_edge("edge.net"));
+    EXPECT_EQ(2500, conf.get_gop_cache_max_frames("edge.net"));
+
+    // The vhost not found, use the default vhost.
+    EXPECT_STREQ("__defaultVhost__", conf.get_vhost("unknown.net")->arg0().c_str());
+    EXPECT_TRUE(conf.get_vhost("unknown.net", false) == NULL);
+    EXPECT_TRUE(conf.get_vhost_enabled("unknown.net"));
+    EXPECT_EQ(100, conf.get_gop_cache_max_frames("unknown.net"));
+    EXPECT_EQ(SRS_PERF_MW_MIN_MSGS, conf.get_mw_msgs("unknown.net", false));
+    EXPECT_EQ(SRS_PERF_MW_MIN_MSGS_REALTIME, conf.get_mw_msgs("unknown.net", true));
+
+    // The RTC never use the snapshot.
+    EXPECT_EQ(SRS_PERF_MW_MIN_MSGS_FOR_RTC, conf.get_mw_msgs("unknown.net", false, true));
+    EXPECT_TRUE(conf.get_realtime_enabled("unknown.net", true));
+
+    // The env is applied when compiling, and ignored after compiled.
+    if (true) {
+        SrsSetEnvConfig(gop_cache, "SRS_VHOST_PLAY_GOP_CACHE", "on");
+        EXPECT_FALSE(conf.get_gop_cache("ossrs.net"));
+
+        conf.compile_snapshot();
+        EXPECT_TRUE(conf.get_gop_cache("ossrs.net"));
+    }
+
+    // Parse again, the snapshot is dropped.
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost ossrs.net;"));
+    EXPECT_TRUE(conf.get_vhost("unknown.net") == NULL);
+    EXPECT_FALSE(conf.get_vhost_enabled("unknown.net"));
+    EXPECT_TRUE(conf.get_gop_cache("ossrs.net"));
+}
+
+VOID TEST(ConfigMainTest, CheckDirectiveFingerprint)
+{
+    srs_error_t err = srs_success;
+
+    MockSrsConfig conf;
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost a{play{gop_cache on;}} vhost b{play{gop_cache on;}}"
+        " vhost c{play{gop_cache off;}} vhost d{play{gop_cache o n;}} vhost e{play{gop_cache on; queue_length 10;}}"));
+
+    // The equal directives get the same fingerprint.
+    SrsConfDirective* a = conf.get_root()->get("vhost", "a");
+    SrsConfDirective* b = conf.get_root()->get("vhost", "b");
+    EXPECT_EQ(srs_directive_fingerprint(a->get("play")), srs_directive_fingerprint(b->get("play")));
+    EXPECT_NE(srs_directive_fingerprint(a), srs_directive_fingerprint(b));
+
+    // Any changes of args or children changes the fingerprint.
+    EXPECT_NE(srs_directive_fingerprint(a->get("play")), srs_directive_fingerprint(conf.get_root()->get("vhost", "c")->get("play")));
+    EXPECT_NE(srs_directive_fingerprint(a->get("play")), srs_directive_fingerprint(conf.get_root()->get("vhost", "d")->get("play")));
+    EXPECT_NE(srs_directive_fingerprint(a->get("play")), srs_directive_fingerprint(conf.get_root()->get("vhost", "e")->get("play")));
+    EXPECT_EQ(srs_directive_fingerprint(NULL), srs_directive_fingerprint(NULL));
+}
+
 VOID TEST(ConfigMainTest, CheckVhostConfig3)
 {
     srs_error_t err;
@@ -3684,6 +3770,25 @@ VOID TEST(ConfigMainTest, CheckVhostConfig5)
         EXPECT_TRUE(conf.get_heartbeat_summaries());
     }
 
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "heartbeat{enabled on;url xxx yyy;}"));
+        EXPECT_STREQ("xxx", conf.get_heartbeat_url().c_str());
+
+        vector<string> urls = conf.get_heartbeat_urls();
+        ASSERT_EQ(2, (int)urls.size());
+        EXPECT_STREQ("xxx", urls.at(0).c_str());
+        EXPECT_STREQ("yyy", urls.at(1).c_str());
+    }
+
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "http_api{enabled on;auth{enabled on;username xxx;password yyy;}}"));
+        EXPECT_TRUE(conf.get_http_api_auth_enabled());
+        EXPECT_STREQ("xxx", conf.get_http_api_auth_username().c_str());
+        EXPECT_STREQ("yyy", conf.get_http_api_auth_password().c_str());
+    }
+
     if (true) {
         MockSrsConfig conf;
         HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "stats{network 0;disk xxx;}"));
@@ -3935,6 +4040,32 @@ VOID TEST(ConfigMainTest, SrtServerTlpktDrop)
     }
 }
 
+VOID TEST(ConfigMainTest, DeliveryWorkers)
+{
+    srs_error_t err;
+
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF));
+        EXPECT_FALSE(conf.get_delivery_enabled());
+        EXPECT_EQ(4, conf.get_delivery_workers());
+        EXPECT_EQ(20000, conf.get_delivery_players());
+    }
+
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "delivery{enabled on; workers 8; players 5000;}"));
+        EXPECT_TRUE(conf.get_delivery_enabled());
+        EXPECT_EQ(8, conf.get_delivery_workers());
+        EXPECT_EQ(5000, conf.get_delivery_players());
+    }
+
+    if (true) {
+        MockSrsConfig conf;
+        HELPER_ASSERT_FAILED(conf.parse(_MIN_OK_CONF "delivery{threads 8;}"));
+    }
+}
+
 VOID TEST(ConfigEnvTest, CheckEnvValuesGlobal)
 {
     if (true) {
@@ -4066,6 +4197,22 @@ VOID TEST(ConfigEnvTest, CheckEnvValuesthreads)
     }
 }
 
+VOID TEST(ConfigEnvTest, CheckEnvValuesDelivery)
+{
+    if (true) {
+        MockSrsConfig conf;
+
+        SrsSetEnvConfig(delivery_enabled, "SRS_DELIVERY_ENABLED", "on");
+        EXPECT_TRUE(conf.get_delivery_enabled());
+
+        SrsSetEnvConfig(delivery_workers, "SRS_DELIVERY_WORKERS", "2");
+        EXPECT_EQ(2, conf.get_delivery_workers());
+
+        SrsSetEnvConfig(delivery_players, "SRS_DELIVERY_PLAYERS", "100");
+        EXPECT_EQ(100, conf.get_delivery_players());
+    }
+}
+
 VOID TEST(ConfigEnvTest, CheckEnvValuesRtmp)
 {
     if (true) {
@@ -4114,6 +4261,19 @@ VOID TEST(ConfigEnvTest, CheckEnvValuesHttpApi)
         EXPECT_FALSE(conf.get_http_api_crossdomain());
     }
 
+    if (true) {
+        MockSrsConfig conf;
+
+        SrsSetEnvConfig(http_api_auth_enabled, "SRS_HTTP_API_AUTH_ENABLED", "on");
+        EXPECT_TRUE(conf.get_http_api_auth_enabled());
+
+        SrsSetEnvConfig(http_api_auth_username, "SRS_HTTP_API_AUTH_USERNAME", "xxx");
+        EXPECT_STREQ("xxx", conf.get_http_api_auth_username().c_str());
+
+        SrsSetEnvConfig(http_api_auth_password, "SRS_HTTP_API_AUTH_PASSWORD", "yyy");
+        EXPECT_STREQ("yyy", conf.get_http_api_auth_password().c_str());
+    }
+
     if (true) {
         MockSrsConfig conf;
 
@@ -4187,6 +4347,14 @@ VOID TEST(ConfigEnvTest, CheckEnvValuesSrtServer)
         SrsSetEnvConfig(srt_listen_port, "SRS_SRT_SERVER_LISTEN", "10000");
         EXPECT_EQ(10000, conf.get_srt_listen_port());
 
+        EXPECT_TRUE(conf.get_srt_poller_thread());
+        SrsSetEnvConfig(srt_poller_thread, "SRS_SRT_SERVER_POLLER_THREAD", "off");
+        EXPECT_FALSE(conf.get_srt_poller_thread());
+
+        EXPECT_EQ(0, conf.get_srt_workers());
+        SrsSetEnvConfig(srt_workers, "SRS_SRT_SERVER_WORKERS", "4");
+        EXPECT_EQ(4, conf.get_srt_workers());
+
         SrsSetEnvConfig(srto_maxbw, "SRS_SRT_SERVER_MAXBW", "1000000000");
         EXPECT_EQ(1000000000, conf.get_srto_maxbw());
 
@@ -4386,6 +4554,13 @@ VOID TEST(ConfigEnvTest, CheckEnvValuesVhostPlay)
         EXPECT_EQ(128, conf.get_mw_msgs("__defaultVhost__", true, true));
     }
 
+    if (true) {
+        MockSrsConfig conf;
+
+        SrsSetEnvConfig(mw_adaptive, "SRS_VHOST_PLAY_MW_ADAPTIVE", "on");
+        EXPECT_TRUE(conf.get_mw_adaptive("__defaultVhost__"));
+    }
+
     if (true) {
         MockSrsConfig conf;
 
@@ -4450,6 +4625,9 @@ VOID TEST(ConfigEnvTest, CheckEnvValuesVhostPublish)
         SrsSetEnvConfig(mr_sleep, "SRS_VHOST_PUBLISH_MR_LATENCY", "10");
         EXPECT_EQ(10 * SRS_UTIME_MILLISECONDS, conf.get_mr_sleep("__defaultVhost__"));
 
+        SrsSetEnvConfig(mr_adaptive, "SRS_VHOST_PUBLISH_MR_ADAPTIVE", "on");
+        EXPECT_TRUE(conf.get_mr_adaptive("__defaultVhost__"));
+
         SrsSetEnvConfig(publish_normal_timeout, "SRS_VHOST_PUBLISH_NORMAL_TIMEOUT", "10");
         EXPECT_EQ(10 * SRS_UTIME_MILLISECONDS, conf.get_publish_normal_timeout("__defaultVhost__"));
 
@@ -4606,6 +4784,16 @@ VOID TEST(ConfigEnvTest, CheckEnvValuesHeartbeat)
         SrsSetEnvConfig(heartbeat_summaries, "SRS_HEARTBEAT_SUMMARIES", "on");
         EXPECT_TRUE(conf.get_heartbeat_summaries());
     }
+
+    if (true) {
+        MockSrsConfig conf;
+
+        SrsSetEnvConfig(heartbeat_url, "SRS_HEARTBEAT_URL", "xxx  yyy");
+        vector<string> urls = conf.get_heartbeat_urls();
+        ASSERT_EQ(2, (int)urls.size());
+        EXPECT_STREQ("xxx", urls.at(0).c_str());
+        EXPECT_STREQ("yyy", urls.at(1).c_str());
+    }
 }
 
 VOID TEST(ConfigEnvTest, CheckEnvValuesScope)
@@ -16,8 +16,18 @@ using namespace std;
 #include <srs_kernel_file.hpp>
 #include <srs_utest_kernel.hpp>
 #include <srs_app_http_static.hpp>
+#include <srs_app_http_api.hpp>
 #include <srs_protocol_utility.hpp>
 #include <srs_core_autofree.hpp>
+#include <srs_utest_config.hpp>
+#include <srs_kernel_flv.hpp>
+#include <srs_app_st.hpp>
+#include <srs_app_hls.hpp>
+#include <srs_app_http_stream.hpp>
+#include <srs_protocol_rtmp_stack.hpp>
+#include <srs_utest_mp4.hpp>
+#include <srs_kernel_mp4.hpp>
+#include <srs_kernel_balance.hpp>
 
 MockMSegmentsReader::MockMSegmentsReader()
 {
@@ -2153,3 +2163,605 @@ VOID TEST(ProtocolHTTPTest, PathEscape)
     }
 }
 
+
+class MockHlsEdgeCache : public SrsHlsEdgeCache
+{
+public:
+    int nn_fetch_;
+    int body_size_;
+    string url_;
+public:
+    MockHlsEdgeCache(string vhost) : SrsHlsEdgeCache(vhost) {
+        nn_fetch_ = 0;
+        body_size_ = 100;
+    }
+    virtual ~MockHlsEdgeCache() {
+    }
+protected:
+    virtual srs_error_t do_fetch(string url, string& body) {
+        nn_fetch_++;
+        url_ = url;
+        srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+        body = string(body_size_, 'x');
+        return srs_success;
+    }
+};
+
+class MockHlsEdgeClient : public ISrsCoroutineHandler
+{
+public:
+    MockHlsEdgeCache* cache_;
+    string path_;
+    int size_;
+public:
+    MockHlsEdgeClient(MockHlsEdgeCache* cache, string path) {
+        cache_ = cache;
+        path_ = path;
+        size_ = 0;
+    }
+    virtual ~MockHlsEdgeClient() {
+    }
+public:
+    virtual srs_error_t cycle() {
+        srs_error_t err = srs_success;
+
+        SrsSharedPtrMessage* data = NULL;
+        if ((err = cache_->fetch(path_, &data)) != srs_success) {
+            return err;
+        }
+
+        size_ = data->size;
+        srs_freep(data);
+        return err;
+    }
+};
+
+// Use the config for test, and restore the global one when done.
+class MockHlsEdgeConfig
+{
+public:
+    SrsConfig* saved_;
+    MockSrsConfig conf_;
+public:
+    MockHlsEdgeConfig() {
+        saved_ = _srs_config;
+        _srs_config = &conf_;
+    }
+    virtual ~MockHlsEdgeConfig() {
+        _srs_config = saved_;
+    }
+};
+
+VOID TEST(HTTPServerTest, HlsEdgeCollapse)
+{
+    srs_error_t err;
+
+    MockHlsEdgeCache cache("__defaultVhost__");
+
+    // The concurrent requests of the same file are collapsed to one fetch.
+    MockHlsEdgeClient c0(&cache, "/live/livestream-0.ts");
+    MockHlsEdgeClient c1(&cache, "/live/livestream-0.ts");
+    MockHlsEdgeClient c2(&cache, "/live/livestream-0.ts");
+    SrsSTCoroutine t0("c0", &c0), t1("c1", &c1), t2("c2", &c2);
+    HELPER_ASSERT_SUCCESS(t0.start());
+    HELPER_ASSERT_SUCCESS(t1.start());
+    HELPER_ASSERT_SUCCESS(t2.start());
+    for (int i = 0; i < 10 && (!c0.size_ || !c1.size_ || !c2.size_); i++) {
+        srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+    }
+
+    EXPECT_EQ(1, cache.nn_fetch_);
+    EXPECT_EQ(100, c0.size_);
+    EXPECT_EQ(100, c1.size_);
+    EXPECT_EQ(100, c2.size_);
+
+    // Hit the cache.
+    SrsSharedPtrMessage* data = NULL;
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/livestream-0.ts", &data));
+    EXPECT_EQ(100, data->size);
+    srs_freep(data);
+    EXPECT_EQ(1, cache.nn_fetch_);
+    EXPECT_EQ(100, cache.size());
+}
+
+VOID TEST(HTTPServerTest, HlsEdgeLRU)
+{
+    srs_error_t err;
+
+    MockHlsEdgeConfig mock;
+    HELPER_ASSERT_SUCCESS(mock.conf_.parse(_MIN_OK_CONF "vhost __defaultVhost__ {cluster {hls_cache 1; hls_ttl 0.02;}}"));
+
+    MockHlsEdgeCache cache("__defaultVhost__");
+    cache.body_size_ = 400 * 1024;
+
+    SrsSharedPtrMessage* data = NULL;
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/a.ts", &data));
+    srs_freep(data);
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/b.ts", &data));
+    srs_freep(data);
+
+    // Use a.ts, then b.ts is the least recently used, evicted for c.ts.
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/a.ts", &data));
+    srs_freep(data);
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/c.ts", &data));
+    srs_freep(data);
+    EXPECT_EQ(3, cache.nn_fetch_);
+    EXPECT_EQ(800 * 1024, cache.size());
+
+    // The evicted buffer is still valid for the response.
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/d.ts", &data));
+    EXPECT_EQ(400 * 1024, data->size);
+    srs_freep(data);
+
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/d.ts", &data));
+    srs_freep(data);
+    EXPECT_EQ(4, cache.nn_fetch_);
+
+    // The m3u8 expires by TTL.
+    cache.body_size_ = 100;
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/livestream.m3u8", &data));
+    srs_freep(data);
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/livestream.m3u8", &data));
+    srs_freep(data);
+    EXPECT_EQ(5, cache.nn_fetch_);
+
+    srs_usleep(30 * SRS_UTIME_MILLISECONDS);
+    srs_update_system_time();
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/livestream.m3u8", &data));
+    srs_freep(data);
+    EXPECT_EQ(6, cache.nn_fetch_);
+
+    // The query is forwarded to origin, and cached as a different file.
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/livestream.m3u8?hls_ctx=xxx", &data));
+    srs_freep(data);
+    EXPECT_EQ(7, cache.nn_fetch_);
+    EXPECT_STREQ("/live/livestream.m3u8?hls_ctx=xxx", cache.url_.c_str());
+
+    HELPER_ASSERT_SUCCESS(cache.fetch("/live/livestream.m3u8?hls_ctx=xxx", &data));
+    srs_freep(data);
+    EXPECT_EQ(7, cache.nn_fetch_);
+}
+
+VOID TEST(HTTPServerTest, HlsRewriteCtx)
+{
+    // The uri of ts, with or without query.
+    EXPECT_STREQ("livestream-13.ts?hls_ctx=xxx", srs_hls_rewrite_ctx("livestream-13.ts", "xxx").c_str());
+    EXPECT_STREQ("livestream-13.ts?hls_ctx=xxx&k=v", srs_hls_rewrite_ctx("livestream-13.ts?k=v", "xxx").c_str());
+
+    // The parts and preload hint of LL-HLS.
+    string m3u8 = "#EXTM3U\n"
+        "#EXTINF:2.000,\n"
+        "livestream-0.ts\n"
+        "#EXT-X-PART:DURATION=0.200,URI=\"livestream-1.0.ts\",INDEPENDENT=YES\n"
+        "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"livestream-1.1.ts\"\n";
+    string expect = "#EXTM3U\n"
+        "#EXTINF:2.000,\n"
+        "livestream-0.ts?hls_ctx=xxx\n"
+        "#EXT-X-PART:DURATION=0.200,URI=\"livestream-1.0.ts?hls_ctx=xxx\",INDEPENDENT=YES\n"
+        "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"livestream-1.1.ts?hls_ctx=xxx\"\n";
+    EXPECT_STREQ(expect.c_str(), srs_hls_rewrite_ctx(m3u8, "xxx").c_str());
+}
+
+VOID TEST(HTTPServerTest, HlsEdgeStreamUrl)
+{
+    // The m3u8 and ts of a stream are the same stream url, to select the same origin.
+    EXPECT_STREQ("/live/livestream", srs_hls_edge_stream_url("__defaultVhost__", "/live/livestream.m3u8").c_str());
+    EXPECT_STREQ("/live/livestream", srs_hls_edge_stream_url("__defaultVhost__", "/live/livestream.m3u8?hls_ctx=xxx").c_str());
+    EXPECT_STREQ("/live/livestream", srs_hls_edge_stream_url("__defaultVhost__", "/live/livestream-10.ts").c_str());
+    EXPECT_STREQ("/live/livestream", srs_hls_edge_stream_url("__defaultVhost__", "/live/livestream-10.ts?hls_ctx=xxx").c_str());
+    EXPECT_STREQ("/live/live-stream", srs_hls_edge_stream_url("__defaultVhost__", "/live/live-stream.m3u8").c_str());
+    EXPECT_STREQ("/live/live-stream", srs_hls_edge_stream_url("__defaultVhost__", "/live/live-stream-10.ts").c_str());
+    EXPECT_STREQ("ossrs.net/live/livestream", srs_hls_edge_stream_url("ossrs.net", "/live/livestream-10.ts").c_str());
+}
+
+VOID TEST(HTTPServerTest, HlsEdgeDispose)
+{
+    srs_error_t err;
+
+    MockHlsEdgeCache* cache = new MockHlsEdgeCache("__defaultVhost__");
+
+    // A request is fetching from origin, and the other is waiting for it.
+    MockHlsEdgeClient c0(cache, "/live/livestream-0.ts");
+    MockHlsEdgeClient c1(cache, "/live/livestream-0.ts");
+    SrsSTCoroutine t0("c0", &c0), t1("c1", &c1);
+    HELPER_ASSERT_SUCCESS(t0.start());
+    HELPER_ASSERT_SUCCESS(t1.start());
+    srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+    EXPECT_EQ(2, cache->nn_users_);
+
+    // The waiting request is notified to quit, and the fetching one is done before the cache is freed.
+    srs_freep(cache);
+    EXPECT_EQ(100, c0.size_);
+    EXPECT_EQ(0, c1.size_);
+}
+
+// Write the LL-HLS playlist with the new part, after a while.
+class MockHlsPartWriter : public ISrsCoroutineHandler
+{
+public:
+    string path_;
+    int parts_;
+public:
+    MockHlsPartWriter(string path, int parts) {
+        path_ = path;
+        parts_ = parts;
+    }
+    virtual ~MockHlsPartWriter() {
+    }
+public:
+    virtual srs_error_t cycle() {
+        srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+
+        SrsSharedPtrMessage data;
+        data.wrap(new char[1], 1);
+        _srs_hls_memory->put_playlist("__defaultVhost__", path_, &data, 5, parts_, "");
+        return srs_success;
+    }
+};
+
+VOID TEST(HTTPServerTest, HlsBlockingReload)
+{
+    srs_error_t err;
+
+    string path = "./objs/utest-ll/live/livestream.m3u8";
+    SrsSharedPtrMessage data;
+    data.wrap(new char[1], 1);
+    _srs_hls_memory->put_playlist("__defaultVhost__", path, &data, 5, 1, "./objs/utest-ll/live/livestream-5.1.ts");
+    EXPECT_TRUE(_srs_hls_memory->is_hint("objs/utest-ll/live/livestream-5.1.ts"));
+
+    SrsHlsStream hls;
+
+    // The part is ready, or not a blocking request.
+    if (true) {
+        SrsHttpMessage r(NULL, NULL);
+        HELPER_ASSERT_SUCCESS(r.set_url("/live/livestream.m3u8?_HLS_msn=5&_HLS_part=0", false));
+        HELPER_EXPECT_SUCCESS(hls.block_reload(&r, path));
+
+        HELPER_ASSERT_SUCCESS(r.set_url("/live/livestream.m3u8?_HLS_msn=4", false));
+        HELPER_EXPECT_SUCCESS(hls.block_reload(&r, path));
+
+        HELPER_ASSERT_SUCCESS(r.set_url("/live/livestream.m3u8", false));
+        HELPER_EXPECT_SUCCESS(hls.block_reload(&r, path));
+    }
+
+    // Reject the request too far in the future.
+    if (true) {
+        SrsHttpMessage r(NULL, NULL);
+        HELPER_ASSERT_SUCCESS(r.set_url("/live/livestream.m3u8?_HLS_msn=7", false));
+        HELPER_EXPECT_FAILED(hls.block_reload(&r, path));
+    }
+
+    // Hold the request until the part is written.
+    if (true) {
+        MockHlsPartWriter writer(path, 2);
+        SrsSTCoroutine trd("writer", &writer);
+        HELPER_ASSERT_SUCCESS(trd.start());
+
+        SrsHttpMessage r(NULL, NULL);
+        HELPER_ASSERT_SUCCESS(r.set_url("/live/livestream.m3u8?_HLS_msn=5&_HLS_part=1", false));
+
+        srs_utime_t starttime = srs_update_system_time();
+        HELPER_EXPECT_SUCCESS(hls.block_reload(&r, path));
+        srs_utime_t elapsed = srs_update_system_time() - starttime;
+        EXPECT_GE(elapsed, 5 * SRS_UTIME_MILLISECONDS);
+        EXPECT_LT(elapsed, 3 * SRS_UTIME_SECONDS);
+
+        string vhost;
+        int64_t msn = 0;
+        int nn_parts = 0;
+        EXPECT_TRUE(_srs_hls_memory->progress(path, &vhost, &msn, &nn_parts));
+        EXPECT_EQ(5, msn);
+        EXPECT_EQ(2, nn_parts);
+    }
+
+    _srs_hls_memory->remove(path);
+    EXPECT_FALSE(_srs_hls_memory->is_hint("objs/utest-ll/live/livestream-5.1.ts"));
+}
+
+VOID TEST(HTTPServerTest, LiveChunkWriter)
+{
+    srs_error_t err;
+
+    SrsLiveChunkWriter w;
+    EXPECT_EQ(0, w.size());
+
+    HELPER_EXPECT_SUCCESS(w.write((void*)"Hello", 5, NULL));
+
+    iovec iovs[2];
+    iovs[0].iov_base = (void*)" ";
+    iovs[0].iov_len = 1;
+    iovs[1].iov_base = (void*)"SRS";
+    iovs[1].iov_len = 3;
+    ssize_t nn = 0;
+    HELPER_EXPECT_SUCCESS(w.writev(iovs, 2, &nn));
+    EXPECT_EQ(4, nn);
+    EXPECT_EQ(9, w.size());
+    EXPECT_EQ(9, w.tellg());
+
+    char* data = w.take();
+    EXPECT_EQ(0, w.size());
+    EXPECT_EQ("Hello SRS", string(data, 9));
+    srs_freepa(data);
+}
+
+VOID TEST(HTTPServerTest, LiveChunkRing)
+{
+    SrsRequest req;
+    req.vhost = "__defaultVhost__";
+
+    // The TS player joins at the latest joinable chunk.
+    if (true) {
+        SrsLiveChunkRing ring(NULL, &req, ".ts");
+        EXPECT_EQ(-1, ring.join());
+
+        ring.append(new char[1], 1, false);
+        EXPECT_EQ(-1, ring.join());
+
+        ring.append(new char[2], 2, true);
+        ring.append(new char[3], 3, false);
+        ring.append(new char[4], 4, true);
+        ring.append(new char[5], 5, false);
+        EXPECT_EQ(3, ring.join());
+
+        int64_t cursor = ring.join();
+        vector<SrsSharedPtrMessage*> chunks;
+        ring.fetch(cursor, chunks, 1);
+        ASSERT_EQ(1, (int)chunks.size());
+        EXPECT_EQ(4, chunks.at(0)->size);
+        EXPECT_EQ(4, cursor);
+        srs_freep(chunks.at(0));
+        chunks.clear();
+
+        ring.fetch(cursor, chunks, 10);
+        ASSERT_EQ(1, (int)chunks.size());
+        EXPECT_EQ(5, chunks.at(0)->size);
+        EXPECT_EQ(5, cursor);
+        srs_freep(chunks.at(0));
+        chunks.clear();
+
+        // No more chunks.
+        ring.fetch(cursor, chunks, 10);
+        EXPECT_TRUE(chunks.empty());
+
+        ring.clear();
+        EXPECT_EQ(0, ring.size());
+        EXPECT_EQ(-1, ring.join());
+    }
+
+    // The audio player joins at the oldest chunk.
+    if (true) {
+        SrsLiveChunkRing ring(NULL, &req, ".aac");
+        ring.append(new char[1], 1, true);
+        ring.append(new char[2], 2, true);
+        EXPECT_EQ(0, ring.join());
+    }
+
+    // Shrink the chunks before the previous joinable chunk, and the slow player skips to the latest joinable chunk.
+    if (true) {
+        SrsLiveChunkRing ring(NULL, &req, ".ts");
+        for (int i = 0; i < 100; i++) {
+            ring.append(new char[1], 1, i == 0);
+        }
+        EXPECT_EQ(100, ring.size());
+
+        ring.append(new char[1], 1, true);
+        EXPECT_EQ(101, ring.size());
+
+        // Drop the chunks before seq 100, but keep the min chunks.
+        ring.append(new char[1], 1, true);
+        EXPECT_EQ(64, ring.size());
+
+        int64_t cursor = 0;
+        vector<SrsSharedPtrMessage*> chunks;
+        ring.fetch(cursor, chunks, 10);
+        ASSERT_EQ(1, (int)chunks.size());
+        EXPECT_EQ(102, cursor);
+        srs_freep(chunks.at(0));
+    }
+
+    // Never exceed the max chunks, even no joinable chunk.
+    if (true) {
+        SrsLiveChunkRing ring(NULL, &req, ".ts");
+        for (int i = 0; i < 3000; i++) {
+            ring.append(new char[1], 1, false);
+        }
+        EXPECT_EQ(2048, ring.size());
+    }
+}
+
+VOID TEST(HTTPServerTest, VodMp4Seek)
+{
+    srs_error_t err;
+
+    string data;
+    HELPER_ASSERT_SUCCESS(mock_mp4_file(10000, data));
+
+    SrsHttpMuxEntry e;
+    e.pattern = "/";
+
+    SrsVodStream h("/tmp");
+    h.set_fs_factory(new MockFileReaderFactory(data));
+    h.set_path_check(_mock_srs_path_always_exists);
+    h.entry = &e;
+
+    // Seek twice, the second one uses the cached index.
+    for (int i = 0; i < 2; i++) {
+        MockResponseWriter w;
+        SrsHttpMessage r(NULL, NULL);
+        HELPER_ASSERT_SUCCESS(r.set_url("/index.mp4?start=3.5&end=6", false));
+        HELPER_ASSERT_SUCCESS(h.serve_http(&w, &r));
+
+        string res = HELPER_BUFFER2STR(&w.io.out_buffer);
+        size_t pos = res.find("\r\n\r\n");
+        ASSERT_TRUE(pos != string::npos);
+        EXPECT_EQ(0, (int)res.find("HTTP/1.1 200"));
+
+        string body = res.substr(pos + 4);
+        MockSrsFileReader fr(body.data(), (int)body.length());
+        HELPER_ASSERT_SUCCESS(fr.open("cut.mp4"));
+
+        SrsMp4SeekIndex index;
+        HELPER_ASSERT_SUCCESS(index.initialize(&fr));
+        EXPECT_EQ(150, index.nb_samples());
+        EXPECT_EQ(3000, index.duration());
+    }
+
+    // Invalid time, serve the whole file.
+    if (true) {
+        MockResponseWriter w;
+        SrsHttpMessage r(NULL, NULL);
+        HELPER_ASSERT_SUCCESS(r.set_url("/index.mp4?start=6&end=3", false));
+        HELPER_ASSERT_SUCCESS(h.serve_http(&w, &r));
+
+        string res = HELPER_BUFFER2STR(&w.io.out_buffer);
+        EXPECT_EQ(data, res.substr(res.length() - data.length()));
+    }
+}
+
+VOID TEST(HTTPServerTest, Mp4IndexCacheLRU)
+{
+    srs_error_t err;
+
+    string data;
+    HELPER_ASSERT_SUCCESS(mock_mp4_file(4000, data));
+
+    // The capacity is for two files of 200 samples.
+    SrsMp4IndexCache cache(400);
+
+    SrsMp4SeekIndex* a = NULL;
+    if (true) {
+        MockSrsFileReader fr(data.data(), (int)data.length());
+        HELPER_ASSERT_SUCCESS(fr.open("a.mp4"));
+        HELPER_ASSERT_SUCCESS(cache.fetch("/tmp/srs-utest-a.mp4", &fr, &a));
+        EXPECT_EQ(1, cache.size());
+        EXPECT_EQ(200, cache.nb_samples());
+    }
+
+    // Hit the cache.
+    if (true) {
+        MockSrsFileReader fr(data.data(), (int)data.length());
+        HELPER_ASSERT_SUCCESS(fr.open("a.mp4"));
+
+        SrsMp4SeekIndex* index = NULL;
+        HELPER_ASSERT_SUCCESS(cache.fetch("/tmp/srs-utest-a.mp4", &fr, &index));
+        EXPECT_TRUE(a == index);
+        EXPECT_EQ(1, cache.size());
+    }
+
+    // Evict the least recently used one.
+    if (true) {
+        SrsMp4SeekIndex* index = NULL;
+        for (int i = 0; i < 2; i++) {
+            MockSrsFileReader fr(data.data(), (int)data.length());
+            HELPER_ASSERT_SUCCESS(fr.open("b.mp4"));
+            HELPER_ASSERT_SUCCESS(cache.fetch("/tmp/srs-utest-" + srs_int2str(i) + ".mp4", &fr, &index));
+        }
+        EXPECT_EQ(2, cache.size());
+        EXPECT_EQ(400, cache.nb_samples());
+    }
+
+    // The changed file is parsed again.
+    if (true) {
+        string v2;
+        HELPER_ASSERT_SUCCESS(mock_mp4_file(2000, v2));
+
+        MockSrsFileReader fr(v2.data(), (int)v2.length());
+        HELPER_ASSERT_SUCCESS(fr.open("b.mp4"));
+
+        SrsMp4SeekIndex* index = NULL;
+        HELPER_ASSERT_SUCCESS(cache.fetch("/tmp/srs-utest-1.mp4", &fr, &index));
+        EXPECT_EQ(100, index->nb_samples());
+        EXPECT_EQ(2, cache.size());
+        EXPECT_EQ(300, cache.nb_samples());
+    }
+
+    // Fail for invalid file.
+    if (true) {
+        MockSrsFileReader fr("Hello, world!", 13);
+        HELPER_ASSERT_SUCCESS(fr.open("c.mp4"));
+
+        SrsMp4SeekIndex* index = NULL;
+        HELPER_EXPECT_FAILED(cache.fetch("/tmp/srs-utest-c.mp4", &fr, &index));
+        EXPECT_EQ(2, cache.size());
+    }
+}
+
+VOID TEST(HTTPServerTest, HeartbeatsAuth)
+{
+    srs_error_t err;
+
+    // Accept heartbeats without authorization if auth is disabled, like other HTTP APIs.
+    if (true) {
+        MockHlsEdgeConfig mock;
+        HELPER_ASSERT_SUCCESS(mock.conf_.parse(_MIN_OK_CONF "http_api{enabled on;}"));
+
+        MockBufferIO io;
+        io.append("POST /api/v1/heartbeats HTTP/1.1\r\nContent-Length: 43\r\n\r\n"
+            "{\"ip\":\"10.0.0.31\",\"load\":15,\"ports\":[1935]}");
+        SrsHttpParser hp; HELPER_ASSERT_SUCCESS(hp.initialize(HTTP_REQUEST));
+        ISrsHttpMessage* r = NULL; HELPER_ASSERT_SUCCESS(hp.parse_message(&io, &r));
+        SrsAutoFree(ISrsHttpMessage, r);
+
+        EXPECT_TRUE(srs_api_authorized(r));
+
+        MockResponseWriter w;
+        SrsGoApiHeartbeats h;
+        HELPER_ASSERT_SUCCESS(h.serve_http(&w, r));
+        __MOCK_HTTP_EXPECT_STRHAS(200, "\"code\":0", w);
+        EXPECT_EQ(15, _srs_lb_servers->load("10.0.0.31"));
+        EXPECT_EQ(15, _srs_lb_servers->load("10.0.0.31:1935"));
+    }
+
+    // Reject heartbeats without authorization if auth is enabled.
+    if (true) {
+        MockHlsEdgeConfig mock;
+        HELPER_ASSERT_SUCCESS(mock.conf_.parse(_MIN_OK_CONF "http_api{enabled on;auth{enabled on;username admin;password admin;}}"));
+
+        MockResponseWriter w;
+        SrsHttpMessage r(NULL, NULL);
+        r.set_basic(HTTP_REQUEST, HTTP_POST, (http_status)200, -1);
+        HELPER_ASSERT_SUCCESS(r.set_url("/api/v1/heartbeats", false));
+
+        SrsGoApiHeartbeats h;
+        HELPER_ASSERT_SUCCESS(h.serve_http(&w, &r));
+        __MOCK_HTTP_EXPECT_STRHAS(401, "401 Unauthorized", w);
+        __MOCK_HTTP_EXPECT_STRHAS(401, "WWW-Authenticate", w);
+    }
+
+    // Reject heartbeats with wrong password.
+    if (true) {
+        MockHlsEdgeConfig mock;
+        HELPER_ASSERT_SUCCESS(mock.conf_.parse(_MIN_OK_CONF "http_api{enabled on;auth{enabled on;username admin;password admin;}}"));
+
+        SrsHttpHeader header;
+        header.set("Authorization", "Basic YWRtaW46eHh4"); // admin:xxx
+
+        MockResponseWriter w;
+        SrsHttpMessage r(NULL, NULL);
+        r.set_basic(HTTP_REQUEST, HTTP_POST, (http_status)200, -1);
+        r.set_header(&header, false);
+        HELPER_ASSERT_SUCCESS(r.set_url("/api/v1/heartbeats", false));
+
+        EXPECT_FALSE(srs_api_authorized(&r));
+
+        SrsGoApiHeartbeats h;
+        HELPER_ASSERT_SUCCESS(h.serve_http(&w, &r));
+        __MOCK_HTTP_EXPECT_STRHAS(401, "401 Unauthorized", w);
+    }
+
+    // Accept the right username and password.
+    if (true) {
+        MockHlsEdgeConfig mock;
+        HELPER_ASSERT_SUCCESS(mock.conf_.parse(_MIN_OK_CONF "http_api{enabled on;auth{enabled on;username admin;password admin;}}"));
+
+        SrsHttpHeader header;
+        header.set("Authorization", "Basic YWRtaW46YWRtaW4="); // admin:admin
+
+        SrsHttpMessage r(NULL, NULL);
+        r.set_basic(HTTP_REQUEST, HTTP_POST, (http_status)200, -1);
+        r.set_header(&header, false);
+        HELPER_ASSERT_SUCCESS(r.set_url("/api/v1/heartbeats", false));
+
+        EXPECT_TRUE(srs_api_authorized(&r));
+    }
+}
@@ -105,6 +105,12 @@ srs_error_t MockSrsFile::lseek(off_t offset, int whence, off_t* seeked)
             _buf->skip(offset - _buf->pos());
         }
     } else if (whence == SEEK_CUR) {
+        if (_buf->data() && offset > _buf->left()) {
+            return srs_error_new(-1, "Overflow");
+        }
+        if (_buf->data()) {
+            _buf->skip(offset);
+        }
     } else if (whence == SEEK_END) {
         if (_buf->data()) {
             _buf->skip(_buf->left());
@@ -3288,6 +3294,178 @@ VOID TEST(KernelLBRRTest, CoverAll)
     }
 }
 
+// Use a dedicated servers state for test, and restore the global one when done.
+class MockLbServers
+{
+public:
+    SrsLbServers* servers_;
+    SrsLbServers* saved_;
+public:
+    MockLbServers() {
+        saved_ = _srs_lb_servers;
+        _srs_lb_servers = servers_ = new SrsLbServers();
+    }
+    virtual ~MockLbServers() {
+        _srs_lb_servers = saved_;
+        srs_freep(servers_);
+    }
+};
+
+VOID TEST(KernelLBRRTest, Failover)
+{
+    MockLbServers mock;
+
+    vector<string> servers;
+    servers.push_back("s0:1935");
+    servers.push_back("s1:1935");
+    servers.push_back("s2:1935");
+
+    // Skip the down server.
+    mock.servers_->on_failure("s1:1935");
+    EXPECT_FALSE(mock.servers_->healthy("s1:1935"));
+
+    // The state is keyed by host:port, other port of the same host is not affected.
+    EXPECT_TRUE(mock.servers_->healthy("s1:1936"));
+
+    SrsLbRoundRobin lb;
+    EXPECT_TRUE("s0:1935" == lb.select(servers));
+    EXPECT_TRUE("s2:1935" == lb.select(servers));
+    EXPECT_TRUE("s0:1935" == lb.select(servers));
+
+    // Recover when connect ok.
+    mock.servers_->on_success("s1:1935");
+    EXPECT_TRUE(mock.servers_->healthy("s1:1935"));
+    EXPECT_TRUE("s1:1935" == lb.select(servers));
+
+    // Still select one if all servers are down.
+    mock.servers_->on_failure("s0:1935");
+    mock.servers_->on_failure("s1:1935");
+    mock.servers_->on_failure("s2:1935");
+    EXPECT_FALSE(lb.select(servers).empty());
+}
+
+VOID TEST(KernelLBRRTest, ConsistentHash)
+{
+    MockLbServers mock;
+
+    vector<string> servers;
+    servers.push_back("s0:1935");
+    servers.push_back("s1:1935");
+    servers.push_back("s2:1935");
+
+    // The same stream always selects the same server, even for different edges.
+    if (true) {
+        SrsLbConsistentHash lb0("rtmp://live/livestream");
+        SrsLbConsistentHash lb1("rtmp://live/livestream");
+        string server = lb0.select(servers);
+        EXPECT_TRUE(server == lb0.select(servers));
+        EXPECT_TRUE(server == lb1.select(servers));
+    }
+
+    // The streams should be distributed to all servers.
+    map<string, int> counts;
+    map<string, string> selected;
+    for (int i = 0; i < 300; i++) {
+        SrsLbConsistentHash lb("rtmp://live/stream" + srs_int2str(i));
+        string server = lb.select(servers);
+        counts[server]++;
+        selected["stream" + srs_int2str(i)] = server;
+    }
+    EXPECT_EQ(3, (int)counts.size());
+    EXPECT_GT(counts["s0:1935"], 50);
+    EXPECT_GT(counts["s1:1935"], 50);
+    EXPECT_GT(counts["s2:1935"], 50);
+
+    // When s1 is down, only the streams of s1 are moved.
+    mock.servers_->on_failure("s1:1935");
+    for (int i = 0; i < 300; i++) {
+        SrsLbConsistentHash lb("rtmp://live/stream" + srs_int2str(i));
+        string server = lb.select(servers);
+        EXPECT_TRUE(server != "s1:1935");
+
+        string prev = selected["stream" + srs_int2str(i)];
+        if (prev != "s1:1935") {
+            EXPECT_TRUE(server == prev);
+        }
+    }
+}
+
+VOID TEST(KernelLBRRTest, ConsistentHashDistribution)
+{
+    MockLbServers mock;
+
+    vector<string> servers;
+    servers.push_back("192.168.1.10:1935");
+    servers.push_back("192.168.1.11:1935");
+    servers.push_back("192.168.1.12:1935");
+    servers.push_back("192.168.1.13:1935");
+
+    // Similar servers and streams should be spread evenly by the weight.
+    map<string, int> counts;
+    for (int i = 0; i < 4000; i++) {
+        SrsLbConsistentHash lb("rtmp://live/livestream" + srs_int2str(i));
+        counts[lb.select(servers)]++;
+    }
+    EXPECT_EQ(4, (int)counts.size());
+    for (int i = 0; i < (int)servers.size(); i++) {
+        EXPECT_GT(counts[servers[i]], 800);
+    }
+
+    // The weight depends on both server and key.
+    EXPECT_NE(srs_lb_weight("s0:1935", "key"), srs_lb_weight("s0:1936", "key"));
+    EXPECT_NE(srs_lb_weight("s0:1935", "key"), srs_lb_weight("s0:193", "5key"));
+}
+
+VOID TEST(KernelLBRRTest, LeastLoad)
+{
+    MockLbServers mock;
+
+    vector<string> servers;
+    servers.push_back("s0:1935");
+    servers.push_back("s1:1935");
+    servers.push_back("s2:1935");
+
+    // Round-robin if no load.
+    if (true) {
+        SrsLbLeastLoad lb;
+        EXPECT_TRUE("s0:1935" == lb.select(servers));
+        EXPECT_TRUE("s1:1935" == lb.select(servers));
+        EXPECT_TRUE("s2:1935" == lb.select(servers));
+    }
+
+    // Select the least load, fed by heartbeat with ip:port.
+    mock.servers_->on_load("s0:1935", 80);
+    mock.servers_->on_load("s1:1935", 10);
+    mock.servers_->on_load("s2:1935", 50);
+    EXPECT_EQ(10, mock.servers_->load("s1:1935"));
+    EXPECT_EQ(-1, mock.servers_->load("s1:1936"));
+    if (true) {
+        SrsLbLeastLoad lb;
+        EXPECT_TRUE("s1:1935" == lb.select(servers));
+        EXPECT_EQ(1, (int)lb.current());
+        EXPECT_TRUE("s1:1935" == lb.select(servers));
+
+        // Failover to the next least load.
+        mock.servers_->on_failure("s1:1935");
+        EXPECT_TRUE("s2:1935" == lb.select(servers));
+    }
+
+    // Create by algorithm.
+    if (true) {
+        ISrsLbBalancer* lb = srs_lb_create("least_load", "");
+        EXPECT_TRUE(dynamic_cast<SrsLbLeastLoad*>(lb) != NULL);
+        srs_freep(lb);
+
+        lb = srs_lb_create("hash", "rtmp://live/livestream");
+        EXPECT_TRUE(dynamic_cast<SrsLbConsistentHash*>(lb) != NULL);
+        srs_freep(lb);
+
+        lb = srs_lb_create("", "");
+        EXPECT_TRUE(dynamic_cast<SrsLbRoundRobin*>(lb) != NULL);
+        srs_freep(lb);
+    }
+}
+
 VOID TEST(KernelCodecTest, CoverAll)
 {
     if (true) {
@@ -6209,4 +6387,99 @@ VOID TEST(KernelUtilityTest, CoverCheckIPAddrValid)
      ASSERT_FALSE(srs_check_ip_addr_valid("2001:0db8:85a3:0:0:8A2E:0370:7334:"));
 #endif
     ASSERT_FALSE(srs_check_ip_addr_valid("1e1.4.5.6"));
-}
\ No newline at end of file
+}
+
+class MockTsVectorWriter : public ISrsWriter
+{
+public:
+    std::string data;
+    std::string es;
+    int nn_writev;
+    int nn_iovs;
+    // The payload iovecs, which should point to the message.
+    std::vector<char*> payloads;
+public:
+    MockTsVectorWriter() {
+        nn_writev = nn_iovs = 0;
+    }
+    virtual ~MockTsVectorWriter() {
+    }
+public:
+    virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite) {
+        data.append((char*)buf, size);
+        return srs_success;
+    }
+    virtual srs_error_t writev(const iovec* iov, int iov_size, ssize_t* nwrite) {
+        nn_writev++;
+        nn_iovs += iov_size;
+        for (int i = 0; i < iov_size; i++) {
+            data.append((char*)iov[i].iov_base, iov[i].iov_len);
+            if (i % 2) {
+                payloads.push_back((char*)iov[i].iov_base);
+                es.append((char*)iov[i].iov_base, iov[i].iov_len);
+            }
+        }
+        return srs_success;
+    }
+};
+
+class MockTsStreamWriter : public ISrsStreamWriter
+{
+public:
+    std::string data;
+public:
+    virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite) {
+        srs_assert(size == SRS_TS_PACKET_SIZE);
+        data.append((char*)buf, size);
+        return srs_success;
+    }
+};
+
+VOID TEST(KernelTSTest, EncodePesByIovecs)
+{
+    srs_error_t err;
+
+    std::string payload(5000, 0);
+    for (int i = 0; i < (int)payload.size(); i++) {
+        payload[i] = (char)(i * 7);
+    }
+
+    MockTsVectorWriter vw;
+    MockTsStreamWriter sw;
+    for (int i = 0; i < 2; i++) {
+        SrsTsContext ctx;
+        SrsTsMessage m;
+        m.sid = SrsTsPESStreamIdAudioCommon;
+        m.dts = m.pts = 90000;
+        m.payload->append(payload.data(), (int)payload.size());
+
+        ISrsStreamWriter* w = i ? (ISrsStreamWriter*)&sw : (ISrsStreamWriter*)&vw;
+        HELPER_EXPECT_SUCCESS(ctx.encode(w, &m, SrsVideoCodecIdDisabled, SrsAudioCodecIdAAC));
+
+        // The payload iovecs point to the message, without copy.
+        if (i == 0) {
+            char* start = m.payload->bytes();
+            char* end = start + m.payload->length();
+            EXPECT_EQ(28, (int)vw.payloads.size());
+            for (int j = 0; j < (int)vw.payloads.size(); j++) {
+                EXPECT_TRUE(vw.payloads[j] >= start && vw.payloads[j] < end);
+            }
+        }
+    }
+
+    // One writev for all packets of the message, after the PAT and PMT.
+    EXPECT_EQ(1, vw.nn_writev);
+    EXPECT_EQ(56, vw.nn_iovs);
+    EXPECT_EQ(30 * SRS_TS_PACKET_SIZE, (int)vw.data.size());
+
+    // The vector writer and stream writer got the same packets.
+    EXPECT_TRUE(vw.data == sw.data);
+
+    // The payload iovecs are the whole message, and the continuity counter of packets increase.
+    EXPECT_TRUE(vw.es == payload);
+    for (int i = 2; i < 30; i++) {
+        char* p = (char*)vw.data.data() + i * SRS_TS_PACKET_SIZE;
+        EXPECT_EQ(0x47, (uint8_t)p[0]);
+        EXPECT_EQ((i - 2) & 0x0f, p[3] & 0x0f);
+    }
+}
@@ -1869,3 +1869,131 @@ VOID TEST(KernelMp4Test, SrsMp4M2tsInitEncoder)
     }
 }
 
+
+srs_error_t mock_mp4_file(int duration, string& data)
+{
+    srs_error_t err = srs_success;
+
+    MockSrsFileWriter fw;
+    if ((err = fw.open("test.mp4")) != srs_success) {
+        return srs_error_wrap(err, "open");
+    }
+
+    SrsMp4Encoder enc;
+    if ((err = enc.initialize(&fw)) != srs_success) {
+        return srs_error_wrap(err, "init");
+    }
+
+    SrsFormat fmt;
+    if ((err = fmt.initialize()) != srs_success) {
+        return srs_error_wrap(err, "format");
+    }
+
+    uint8_t vsh[] = {
+        0x17,
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x64, 0x00, 0x20, 0xff, 0xe1, 0x00, 0x19, 0x67, 0x64, 0x00, 0x20,
+        0xac, 0xd9, 0x40, 0xc0, 0x29, 0xb0, 0x11, 0x00, 0x00, 0x03, 0x00, 0x01, 0x00, 0x00, 0x03, 0x00,
+        0x32, 0x0f, 0x18, 0x31, 0x96, 0x01, 0x00, 0x05, 0x68, 0xeb, 0xec, 0xb2, 0x2c
+    };
+    if ((err = fmt.on_video(0, (char*)vsh, sizeof(vsh))) != srs_success) {
+        return srs_error_wrap(err, "video sh");
+    }
+    if ((err = enc.write_sample(&fmt, SrsMp4HandlerTypeVIDE, SrsVideoAvcFrameTypeKeyFrame, SrsVideoAvcFrameTraitSequenceHeader,
+        0, 0, (uint8_t*)fmt.raw, fmt.nb_raw)) != srs_success) {
+        return srs_error_wrap(err, "write video sh");
+    }
+
+    uint8_t ash[] = {0xaf, 0x00, 0x12, 0x10};
+    if ((err = fmt.on_audio(0, (char*)ash, sizeof(ash))) != srs_success) {
+        return srs_error_wrap(err, "audio sh");
+    }
+    if ((err = enc.write_sample(&fmt, SrsMp4HandlerTypeSOUN, 0, SrsAudioAacFrameTraitSequenceHeader,
+        0, 0, (uint8_t*)fmt.raw, fmt.nb_raw)) != srs_success) {
+        return srs_error_wrap(err, "write audio sh");
+    }
+
+    uint8_t frame[100];
+    HELPER_ARRAY_INIT(frame, sizeof(frame), 0);
+    for (int i = 0; i * 40 < duration; i++) {
+        uint32_t dts = i * 40;
+        uint16_t ft = (i % 25 == 0)? SrsVideoAvcFrameTypeKeyFrame : SrsVideoAvcFrameTypeInterFrame;
+        if ((err = enc.write_sample(&fmt, SrsMp4HandlerTypeVIDE, ft, SrsVideoAvcFrameTraitNALU, dts, dts, frame, sizeof(frame))) != srs_success) {
+            return srs_error_wrap(err, "write video");
+        }
+        if ((err = enc.write_sample(&fmt, SrsMp4HandlerTypeSOUN, 0, SrsAudioAacFrameTraitRawData, dts, dts, frame, 10)) != srs_success) {
+            return srs_error_wrap(err, "write audio");
+        }
+    }
+
+    if ((err = enc.flush()) != srs_success) {
+        return srs_error_wrap(err, "flush");
+    }
+
+    data = fw.str();
+    return err;
+}
+
+VOID TEST(KernelMp4Test, SeekIndex)
+{
+    srs_error_t err;
+
+    string data;
+    HELPER_ASSERT_SUCCESS(mock_mp4_file(10000, data));
+
+    MockSrsFileReader fr(data.data(), (int)data.length());
+    HELPER_ASSERT_SUCCESS(fr.open("test.mp4"));
+
+    SrsMp4SeekIndex index;
+    HELPER_ASSERT_SUCCESS(index.initialize(&fr));
+    EXPECT_EQ(500, index.nb_samples());
+
+    // Seek to the keyframe at 3000ms, to the end.
+    if (true) {
+        SrsSimpleStream header;
+        off_t offset = 0;
+        uint64_t size = 0;
+        HELPER_ASSERT_SUCCESS(index.seek(3500, -1, &header, &offset, &size));
+        EXPECT_EQ(175 * 110, (int)size);
+        EXPECT_TRUE(offset + size < data.length());
+
+        // The cut file should be parsed again.
+        string cut = string(header.bytes(), header.length()) + data.substr(offset, size);
+        MockSrsFileReader cr(cut.data(), (int)cut.length());
+        HELPER_ASSERT_SUCCESS(cr.open("cut.mp4"));
+
+        SrsMp4SeekIndex ci;
+        HELPER_ASSERT_SUCCESS(ci.initialize(&cr));
+        EXPECT_EQ(350, ci.nb_samples());
+        EXPECT_EQ(6960, ci.duration());
+    }
+
+    // Seek in range, the keyframe at end is excluded.
+    if (true) {
+        SrsSimpleStream header;
+        off_t offset = 0;
+        uint64_t size = 0;
+        HELPER_ASSERT_SUCCESS(index.seek(3000, 6000, &header, &offset, &size));
+        EXPECT_EQ(75 * 110, (int)size);
+
+        string cut = string(header.bytes(), header.length()) + data.substr(offset, size);
+        MockSrsFileReader cr(cut.data(), (int)cut.length());
+        HELPER_ASSERT_SUCCESS(cr.open("cut.mp4"));
+
+        SrsMp4SeekIndex ci;
+        HELPER_ASSERT_SUCCESS(ci.initialize(&cr));
+        EXPECT_EQ(150, ci.nb_samples());
+        EXPECT_EQ(3000, ci.duration());
+    }
+
+    // Seek before the first keyframe, or after the last one.
+    if (true) {
+        SrsSimpleStream header;
+        off_t offset = 0;
+        uint64_t size = 0;
+        HELPER_ASSERT_SUCCESS(index.seek(0, -1, &header, &offset, &size));
+        EXPECT_EQ(250 * 110, (int)size);
+
+        HELPER_ASSERT_SUCCESS(index.seek(100000, -1, &header, &offset, &size));
+        EXPECT_EQ(25 * 110, (int)size);
+    }
+}
@@ -12,5 +12,10 @@
 */
 #include <srs_utest.hpp>
 
+#include <string>
+
+// Encode a mp4 file with AVC and AAC of duration in ms, 25fps video with a keyframe per second.
+extern srs_error_t mock_mp4_file(int duration, std::string& data);
+
 #endif
 
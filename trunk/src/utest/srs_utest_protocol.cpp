@@ -1385,6 +1385,80 @@ VOID TEST(ProtocolStackTest, ProtocolRecvVAFmt3)
     }
 }
 
+/**
+* recv large messages in many chunks, the continuous chunks are gathered in one pass,
+* while interlaced by other chunk streams.
+*/
+VOID TEST(ProtocolStackTest, ProtocolRecvGatherChunks)
+{
+    srs_error_t err = srs_success;
+
+    MockBufferIO bio;
+    SrsProtocol proto(&bio);
+
+    char video[400], data[200];
+    for (int i = 0; i < (int)sizeof(video); i++) {
+        video[i] = (char)(i % 251);
+    }
+    for (int i = 0; i < (int)sizeof(data); i++) {
+        data[i] = (char)(i % 241);
+    }
+
+    // video message, cid=3, 400 bytes, chunk#1 and chunk#2.
+    uint8_t vh[] = {0x03, 0x00, 0x00, 0x10, 0x00, 0x01, 0x90, 0x09, 0x01, 0x00, 0x00, 0x00};
+    bio.in_buffer.append((char*)vh, sizeof(vh));
+    bio.in_buffer.append(video, 128);
+    bio.in_buffer.append("\xC3", 1);
+    bio.in_buffer.append(video + 128, 128);
+
+    // audio message, cid=4, 10 bytes, interlaced.
+    uint8_t ah[] = {0x04, 0x00, 0x00, 0x10, 0x00, 0x00, 0x0a, 0x08, 0x01, 0x00, 0x00, 0x00};
+    bio.in_buffer.append((char*)ah, sizeof(ah));
+    bio.in_buffer.append(data, 10);
+
+    // video message, chunk#3 and chunk#4.
+    bio.in_buffer.append("\xC3", 1);
+    bio.in_buffer.append(video + 256, 128);
+    bio.in_buffer.append("\xC3", 1);
+    bio.in_buffer.append(video + 384, 16);
+
+    // data message, cid=80 in 2 bytes basic header, 200 bytes, chunk#1 and chunk#2.
+    uint8_t dh[] = {0x00, 0x10, 0x00, 0x00, 0x10, 0x00, 0x00, 0xc8, 0x12, 0x01, 0x00, 0x00, 0x00};
+    bio.in_buffer.append((char*)dh, sizeof(dh));
+    bio.in_buffer.append(data, 128);
+    bio.in_buffer.append("\xC0\x10", 2);
+    bio.in_buffer.append(data + 128, 72);
+
+    if (true) {
+        SrsCommonMessage* msg = NULL;
+        HELPER_ASSERT_SUCCESS(proto.recv_message(&msg));
+        SrsAutoFree(SrsCommonMessage, msg);
+        EXPECT_TRUE(msg->header.is_audio());
+        EXPECT_EQ(10, msg->size);
+        EXPECT_EQ(0, memcmp(data, msg->payload, 10));
+    }
+
+    if (true) {
+        SrsCommonMessage* msg = NULL;
+        HELPER_ASSERT_SUCCESS(proto.recv_message(&msg));
+        SrsAutoFree(SrsCommonMessage, msg);
+        EXPECT_TRUE(msg->header.is_video());
+        EXPECT_EQ(0x10, msg->header.timestamp);
+        EXPECT_EQ(400, msg->size);
+        EXPECT_EQ(0, memcmp(video, msg->payload, 400));
+    }
+
+    if (true) {
+        SrsCommonMessage* msg = NULL;
+        HELPER_ASSERT_SUCCESS(proto.recv_message(&msg));
+        SrsAutoFree(SrsCommonMessage, msg);
+        EXPECT_TRUE(msg->header.is_amf0_data());
+        EXPECT_EQ(80, msg->header.perfer_cid);
+        EXPECT_EQ(200, msg->size);
+        EXPECT_EQ(0, memcmp(data, msg->payload, 200));
+    }
+}
+
 /**
 * recv video, audio and video, interlaced in chunks.
 */
@@ -9,6 +9,7 @@
 using namespace std;
 
 #include <srs_kernel_error.hpp>
+#include <srs_kernel_utility.hpp>
 
 MockReloadHandler::MockReloadHandler()
 {
@@ -192,6 +193,99 @@ srs_error_t MockSrsReloadConfig::do_reload(string buf)
     return err;
 }
 
+VOID TEST(ConfigReloadTest, ReloadSnapshot)
+{
+    srs_error_t err = srs_success;
+
+    MockSrsReloadConfig conf;
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost ossrs.net{play{gop_cache off;}}"));
+    conf.compile_snapshot();
+    EXPECT_FALSE(conf.get_gop_cache("ossrs.net"));
+    EXPECT_FALSE(conf.get_tcp_nodelay("new.net"));
+
+    // The snapshot is compiled again when reload.
+    HELPER_ASSERT_SUCCESS(conf.do_reload(_MIN_OK_CONF "vhost ossrs.net{play{gop_cache on;}} vhost new.net{tcp_nodelay on;}"));
+    EXPECT_TRUE(conf.get_gop_cache("ossrs.net"));
+    EXPECT_TRUE(conf.get_tcp_nodelay("new.net"));
+    EXPECT_STREQ("new.net", conf.get_vhost("new.net")->arg0().c_str());
+}
+
+VOID TEST(ConfigReloadTest, ReloadVhostSubscribers)
+{
+    srs_error_t err = srs_success;
+
+    MockReloadHandler ha, hb;
+    MockSrsReloadConfig conf;
+
+    conf.subscribe_vhost("a.net", &ha);
+    conf.subscribe_vhost("b.net", &hb);
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost a.net{play{gop_cache off;}} vhost b.net{play{gop_cache off;}}"));
+
+    // Only notify the subscribers of changed vhost.
+    HELPER_ASSERT_SUCCESS(conf.do_reload(_MIN_OK_CONF "vhost a.net{play{gop_cache on;}} vhost b.net{play{gop_cache off;}}"));
+    EXPECT_TRUE(ha.vhost_play_reloaded);
+    EXPECT_EQ(1, ha.count_true());
+    EXPECT_TRUE(hb.all_false());
+    ha.reset();
+
+    // The unchanged vhosts are skipped by fingerprint.
+    HELPER_ASSERT_SUCCESS(conf.do_reload(_MIN_OK_CONF "vhost a.net{play{gop_cache on;}} vhost b.net{play{gop_cache off;}}"));
+    EXPECT_TRUE(ha.all_false());
+    EXPECT_TRUE(hb.all_false());
+
+    // Never notify the unsubscribed handler.
+    conf.unsubscribe(&hb);
+    HELPER_ASSERT_SUCCESS(conf.do_reload(_MIN_OK_CONF "vhost a.net{play{gop_cache on;}} vhost b.net{play{gop_cache on;}}"));
+    EXPECT_TRUE(ha.all_false());
+    EXPECT_TRUE(hb.all_false());
+}
+
+VOID TEST(ConfigReloadTest, ReloadFingerprintCollision)
+{
+    srs_error_t err = srs_success;
+
+    MockReloadHandler handler;
+    MockSrsReloadConfig conf;
+
+    conf.subscribe_vhost("a.net", &handler);
+    HELPER_ASSERT_SUCCESS(conf.parse(_MIN_OK_CONF "vhost a.net{play{gop_cache off;}}"));
+    conf.compile_snapshot();
+
+    // Mock the fingerprint collision, the old vhost has the same fingerprint of the new one.
+    string after = _MIN_OK_CONF "vhost a.net{play{gop_cache on;}}";
+    MockSrsReloadConfig target;
+    HELPER_ASSERT_SUCCESS(target.parse(after));
+    conf.snapshot_->vhosts_["a.net"]->fingerprint_ = srs_directive_fingerprint(target.get_vhost("a.net"));
+
+    // The changed vhost is confirmed by the directives, so never skip it.
+    HELPER_ASSERT_SUCCESS(conf.do_reload(after));
+    EXPECT_TRUE(handler.vhost_play_reloaded);
+    EXPECT_TRUE(conf.get_gop_cache("a.net"));
+}
+
+VOID TEST(ConfigReloadTest, ReloadLotsOfVhosts)
+{
+    srs_error_t err = srs_success;
+
+    MockReloadHandler handler;
+    MockSrsReloadConfig conf;
+
+    // Lots of vhosts changed, which yields for each chunk of vhosts.
+    string before = _MIN_OK_CONF, after = _MIN_OK_CONF;
+    for (int i = 0; i < 32; i++) {
+        before += "vhost v" + srs_int2str(i) + ".net{play{gop_cache off;}} ";
+        after += "vhost v" + srs_int2str(i) + ".net{play{gop_cache on;}} ";
+    }
+
+    conf.subscribe_vhost("v31.net", &handler);
+    HELPER_ASSERT_SUCCESS(conf.parse(before));
+    HELPER_ASSERT_SUCCESS(conf.do_reload(after));
+    EXPECT_TRUE(handler.vhost_play_reloaded);
+    EXPECT_EQ(1, handler.count_true());
+    EXPECT_TRUE(conf.get_gop_cache("v0.net"));
+    EXPECT_TRUE(conf.get_gop_cache("v31.net"));
+}
+
 VOID TEST(ConfigReloadTest, ReloadEmpty)
 {
     srs_error_t err = srs_success;
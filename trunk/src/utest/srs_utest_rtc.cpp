@@ -12,14 +12,21 @@
 #include <srs_kernel_rtc_rtp.hpp>
 #include <srs_app_rtc_source.hpp>
 #include <srs_app_rtc_conn.hpp>
+#include <srs_app_rtc_network.hpp>
 #include <srs_kernel_codec.hpp>
 #include <srs_app_conn.hpp>
 
 #include <srs_utest_service.hpp>
+#include <srs_utest_config.hpp>
+#include <srs_utest_protocol.hpp>
+#include <srs_app_rtc_dtls.hpp>
+#include <srs_kernel_kbps.hpp>
 
 #include <vector>
 using namespace std;
 
+extern SrsPps* _srs_pps_srtps;
+
 VOID TEST(KernelRTCTest, RtpSTAPPayloadException)
 {
     srs_error_t err = srs_success;
@@ -771,6 +778,104 @@ VOID TEST(KernelRTCTest, NACKEncode)
     }
 }
 
+VOID TEST(KernelRTCTest, NACKReceiverQueue)
+{
+    srs_error_t err = srs_success;
+
+    // Normal case, insert and remove the lost sequences.
+    if (true) {
+        MockWallClock clk;
+        clk.set_clock(1 * SRS_UTIME_SECONDS);
+        SrsRtpRingBuffer rtp(1000);
+        SrsRtpNackForReceiver nack(&rtp, 1000 * 2 / 3, &clk);
+
+        nack.insert(100, 110);
+        EXPECT_EQ(10, (int)nack.size());
+        EXPECT_TRUE(nack.find(105) != NULL);
+
+        nack.remove(105);
+        EXPECT_TRUE(nack.find(105) == NULL);
+        EXPECT_EQ(9, (int)nack.size());
+
+        // The alias of sequence in window, should not be found.
+        EXPECT_TRUE(nack.find(100 + 2048) == NULL);
+
+        clk.set_clock(1 * SRS_UTIME_SECONDS + 50 * SRS_UTIME_MILLISECONDS);
+
+        uint32_t timeout_nacks = 0;
+        SrsRtcpNack rtcp(123);
+        nack.get_nack_seqs(rtcp, timeout_nacks);
+
+        vector<uint16_t> sns = rtcp.get_lost_sns();
+        EXPECT_EQ(9, (int)sns.size());
+        EXPECT_EQ(0, (int)timeout_nacks);
+        if (sns.size() == 9) {
+            EXPECT_EQ(100, sns.at(0));
+            EXPECT_EQ(104, sns.at(4));
+            EXPECT_EQ(106, sns.at(5));
+            EXPECT_EQ(109, sns.at(8));
+        }
+
+        // The FCI generated by receiver, should be decoded to the same sequences.
+        char buf[kRtcpPacketSize];
+        SrsBuffer stream(buf, sizeof(buf));
+        HELPER_EXPECT_SUCCESS(rtcp.encode(&stream));
+
+        SrsBuffer stream2(buf, stream.pos());
+        SrsRtcpNack rtcp2;
+        HELPER_EXPECT_SUCCESS(rtcp2.decode(&stream2));
+        EXPECT_TRUE(sns == rtcp2.get_lost_sns());
+    }
+
+    // The sequence flip back.
+    if (true) {
+        MockWallClock clk;
+        clk.set_clock(1 * SRS_UTIME_SECONDS);
+        SrsRtpRingBuffer rtp(1000);
+        SrsRtpNackForReceiver nack(&rtp, 1000 * 2 / 3, &clk);
+
+        nack.insert(65530, 4);
+        EXPECT_EQ(10, (int)nack.size());
+        nack.remove(0);
+        EXPECT_EQ(9, (int)nack.size());
+
+        clk.set_clock(1 * SRS_UTIME_SECONDS + 50 * SRS_UTIME_MILLISECONDS);
+
+        uint32_t timeout_nacks = 0;
+        SrsRtcpNack rtcp(123);
+        nack.get_nack_seqs(rtcp, timeout_nacks);
+
+        vector<uint16_t> sns = rtcp.get_lost_sns();
+        EXPECT_EQ(9, (int)sns.size());
+        if (sns.size() == 9) {
+            EXPECT_EQ(65530, sns.at(0));
+            EXPECT_EQ(65535, sns.at(5));
+            EXPECT_EQ(1, sns.at(6));
+            EXPECT_EQ(3, sns.at(8));
+        }
+    }
+
+    // The old sequences out of window should be dropped.
+    if (true) {
+        SrsRtpRingBuffer rtp(1000);
+        SrsRtpNackForReceiver nack(&rtp, 1000 * 2 / 3);
+
+        nack.insert(0, 10);
+        nack.insert(5000, 5001);
+        EXPECT_EQ(1, (int)nack.size());
+        EXPECT_TRUE(nack.find(5) == NULL);
+        EXPECT_TRUE(nack.find(5000) != NULL);
+
+        // The dropped sequences are notified to the ring buffer, like the timeout ones.
+        EXPECT_EQ(10, rtp.begin);
+
+        // Too many lost sequences, reset the queue.
+        nack.insert(5001, 6000);
+        nack.check_queue_size();
+        EXPECT_EQ(0, (int)nack.size());
+    }
+}
+
 extern bool srs_is_stun(const uint8_t* data, size_t size);
 extern bool srs_is_dtls(const uint8_t* data, size_t len);
 extern bool srs_is_rtp_or_rtcp(const uint8_t* data, size_t len);
@@ -778,6 +883,324 @@ extern bool srs_is_rtcp(const uint8_t* data, size_t len);
 
 #define mock_arr_push(arr, elem) arr.push_back(vector<uint8_t>(elem, elem + sizeof(elem)))
 
+VOID TEST(KernelRTCTest, ULPFECEncodeAndRecover)
+{
+    srs_error_t err = srs_success;
+
+    // Generate 5 packets in different size, the last one is the end of frame.
+    char raws[5][128];
+    int nn_raws[5];
+    SrsRtpFecEncoder encoder(10);
+    vector<SrsRtpPacket*> fecs;
+    for (int i = 0; i < 5; i++) {
+        SrsRtpPacket pkt;
+        pkt.frame_type = SrsFrameTypeVideo;
+        pkt.header.set_ssrc(200);
+        pkt.header.set_payload_type(102);
+        pkt.header.set_sequence(65534 + i);
+        pkt.header.set_timestamp(9000 + (i / 2) * 3000);
+        pkt.header.set_marker(i == 4);
+
+        char payload[100];
+        memset(payload, 'a' + i, sizeof(payload));
+        SrsRtpRawPayload* raw = new SrsRtpRawPayload();
+        raw->payload = payload;
+        raw->nn_payload = 60 + i * 10;
+        pkt.set_payload(raw, SrsRtspPacketPayloadTypeRaw);
+
+        SrsBuffer b(raws[i], sizeof(raws[i]));
+        HELPER_EXPECT_SUCCESS(pkt.encode(&b));
+        nn_raws[i] = b.pos();
+
+        HELPER_EXPECT_SUCCESS(encoder.encode(&pkt, fecs));
+    }
+
+    // Only one FEC packet, which is done by the marker.
+    ASSERT_EQ(1, (int)fecs.size());
+    SrsRtpPacket* fec = fecs.at(0);
+    SrsAutoFree(SrsRtpPacket, fec);
+    EXPECT_EQ(SrsRtspPacketPayloadTypeFEC, fec->payload_type());
+
+    // Marshal the FEC in RED, and unmarshal it.
+    SrsRtpUlpfecPayload* ulpfec = dynamic_cast<SrsRtpUlpfecPayload*>(fec->payload());
+    ASSERT_TRUE(ulpfec != NULL);
+    ulpfec->fec_pt = 97;
+    fec->header.set_payload_type(96);
+    EXPECT_EQ(65534, ulpfec->sn_base);
+    EXPECT_EQ(0xf800, ulpfec->mask);
+    EXPECT_TRUE(ulpfec->is_protected(1));
+    EXPECT_FALSE(ulpfec->is_protected(3));
+
+    char fec_bytes[kRtpPacketSize];
+    SrsBuffer fb(fec_bytes, sizeof(fec_bytes));
+    HELPER_EXPECT_SUCCESS(fec->encode(&fb));
+
+    SrsRtpUlpfecPayload decoded;
+    SrsBuffer db(fec_bytes + kRtpHeaderFixedSize, fb.pos() - kRtpHeaderFixedSize);
+    HELPER_EXPECT_SUCCESS(decoded.decode(&db));
+    EXPECT_EQ(97, decoded.fec_pt);
+    EXPECT_EQ(ulpfec->mask, decoded.mask);
+    EXPECT_EQ(ulpfec->nn_payload, decoded.nn_payload);
+
+    // Recover each lost packet, by all other received packets.
+    for (int lost = 0; lost < 5; lost++) {
+        vector<SrsRtpPacket*> pkts;
+        for (int i = 0; i < 5; i++) {
+            if (i == lost) {
+                continue;
+            }
+
+            SrsRtpPacket* pkt = new SrsRtpPacket();
+            char* p = pkt->wrap(raws[i], nn_raws[i]);
+            SrsBuffer b(p, nn_raws[i]);
+            HELPER_EXPECT_SUCCESS(pkt->decode(&b));
+            pkts.push_back(pkt);
+        }
+
+        char buf[kRtpPacketSize];
+        SrsBuffer b(buf, sizeof(buf));
+        HELPER_EXPECT_SUCCESS(decoded.recover((uint16_t)(65534 + lost), 200, pkts, &b));
+        EXPECT_EQ(nn_raws[lost], b.pos());
+        EXPECT_TRUE(!memcmp(raws[lost], buf, nn_raws[lost]));
+
+        for (int i = 0; i < (int)pkts.size(); i++) {
+            srs_freep(pkts[i]);
+        }
+    }
+
+    // Flush the group when packet is out of the mask.
+    if (true) {
+        SrsRtpFecEncoder e(16);
+        vector<SrsRtpPacket*> v;
+        SrsRtpPacket pkt;
+        pkt.header.set_sequence(100);
+        HELPER_EXPECT_SUCCESS(e.encode(&pkt, v));
+        pkt.header.set_sequence(116);
+        HELPER_EXPECT_SUCCESS(e.encode(&pkt, v));
+        ASSERT_EQ(1, (int)v.size());
+        SrsRtpPacket* f = e.flush();
+        ASSERT_TRUE(f != NULL);
+        EXPECT_EQ(116, dynamic_cast<SrsRtpUlpfecPayload*>(f->payload())->sn_base);
+        srs_freep(f);
+        srs_freep(v[0]);
+        EXPECT_TRUE(e.flush() == NULL);
+    }
+}
+
+VOID TEST(KernelRTCTest, ULPFECRecoverWithExtensions)
+{
+    srs_error_t err = srs_success;
+
+    // The sender and receiver use different extension ids.
+    SrsRtpExtensionTypes sender, receiver;
+    sender.register_by_uri(3, kTWCCExt);
+    receiver.register_by_uri(5, kTWCCExt);
+
+    // Generate 3 packets with twcc, the last one is the end of frame.
+    char raws[3][128];
+    int nn_raws[3];
+    char received[3][128];
+    int nn_received[3];
+    SrsRtpFecEncoder encoder(10);
+    vector<SrsRtpPacket*> fecs;
+    for (int i = 0; i < 3; i++) {
+        SrsRtpPacket pkt;
+        pkt.header.set_ssrc(200);
+        pkt.header.set_payload_type(102);
+        pkt.header.set_sequence(100 + i);
+        pkt.header.set_timestamp(9000);
+        pkt.header.set_marker(i == 2);
+
+        char payload[100];
+        memset(payload, 'a' + i, sizeof(payload));
+        SrsRtpRawPayload* raw = new SrsRtpRawPayload();
+        raw->payload = payload;
+        raw->nn_payload = 50 + i * 10;
+        pkt.set_payload(raw, SrsRtspPacketPayloadTypeRaw);
+
+        // The recovered packet is without extensions.
+        SrsBuffer b(raws[i], sizeof(raws[i]));
+        HELPER_EXPECT_SUCCESS(pkt.encode(&b));
+        nn_raws[i] = b.pos();
+
+        pkt.header.set_extensions(&sender);
+        HELPER_EXPECT_SUCCESS(pkt.header.set_twcc_sequence_number(3, 1000 + i));
+        HELPER_EXPECT_SUCCESS(encoder.encode(&pkt, fecs));
+
+        // The extension is changed between encode and recover.
+        pkt.header.set_extensions(&receiver);
+        HELPER_EXPECT_SUCCESS(pkt.header.set_twcc_sequence_number(5, 2000 + i));
+        SrsBuffer rb(received[i], sizeof(received[i]));
+        HELPER_EXPECT_SUCCESS(pkt.encode(&rb));
+        nn_received[i] = rb.pos();
+        EXPECT_EQ(0x10, received[i][0] & 0x10);
+        EXPECT_GT(nn_received[i], nn_raws[i]);
+    }
+
+    ASSERT_EQ(1, (int)fecs.size());
+    SrsRtpPacket* fec = fecs.at(0);
+    SrsAutoFree(SrsRtpPacket, fec);
+    SrsRtpUlpfecPayload* ulpfec = dynamic_cast<SrsRtpUlpfecPayload*>(fec->payload());
+    ASSERT_TRUE(ulpfec != NULL);
+    EXPECT_TRUE(ulpfec->normalized);
+
+    // Recover each lost packet, by all other received packets.
+    for (int lost = 0; lost < 3; lost++) {
+        vector<SrsRtpPacket*> pkts;
+        for (int i = 0; i < 3; i++) {
+            if (i == lost) {
+                continue;
+            }
+
+            SrsRtpPacket* pkt = new SrsRtpPacket();
+            char* p = pkt->wrap(received[i], nn_received[i]);
+            SrsBuffer b(p, nn_received[i]);
+            HELPER_EXPECT_SUCCESS(pkt->decode(&b));
+            pkts.push_back(pkt);
+        }
+
+        char buf[kRtpPacketSize];
+        SrsBuffer b(buf, sizeof(buf));
+        HELPER_EXPECT_SUCCESS(ulpfec->recover((uint16_t)(100 + lost), 200, pkts, &b));
+        EXPECT_EQ(nn_raws[lost], b.pos());
+        EXPECT_TRUE(!memcmp(raws[lost], buf, nn_raws[lost]));
+
+        for (int i = 0; i < (int)pkts.size(); i++) {
+            srs_freep(pkts[i]);
+        }
+    }
+}
+
+VOID TEST(KernelRTCTest, REDDecapsulate)
+{
+    srs_error_t err = srs_success;
+
+    char payload[] = {0x65, 0x01, 0x02, 0x03};
+
+    // The media packet with extension.
+    char media[64];
+    int nn_media = 0;
+    if (true) {
+        SrsRtpExtensionTypes types;
+        types.register_by_uri(3, kTWCCExt);
+
+        SrsRtpPacket pkt;
+        pkt.header.set_payload_type(102);
+        pkt.header.set_sequence(10);
+        pkt.header.set_marker(true);
+        pkt.header.set_extensions(&types);
+        HELPER_EXPECT_SUCCESS(pkt.header.set_twcc_sequence_number(3, 1000));
+
+        SrsRtpRawPayload* raw = new SrsRtpRawPayload();
+        raw->payload = payload;
+        raw->nn_payload = sizeof(payload);
+        pkt.set_payload(raw, SrsRtspPacketPayloadTypeRaw);
+
+        SrsBuffer b(media, sizeof(media));
+        HELPER_EXPECT_SUCCESS(pkt.encode(&b));
+        nn_media = b.pos();
+
+        // Wrap the media in RED.
+        SrsRtpRedPayload* red = new SrsRtpRedPayload();
+        red->primary_pt = 102;
+        red->primary = pkt.payload();
+        pkt.set_payload(red, SrsRtspPacketPayloadTypeRED);
+        pkt.header.set_payload_type(96);
+
+        char buf[64];
+        SrsBuffer rb(buf, sizeof(buf));
+        HELPER_EXPECT_SUCCESS(pkt.encode(&rb));
+        EXPECT_EQ(nn_media + 1, rb.pos());
+        EXPECT_EQ(nn_media + 1, (int)pkt.nb_bytes());
+
+        // The FEC block is not changed.
+        EXPECT_EQ(nn_media + 1, srs_rtp_red_decapsulate(buf, rb.pos(), 96, 102));
+        // Not RED, ignore.
+        EXPECT_EQ(nn_media + 1, srs_rtp_red_decapsulate(buf, rb.pos(), 95, 97));
+
+        EXPECT_EQ(nn_media, srs_rtp_red_decapsulate(buf, rb.pos(), 96, 97));
+        EXPECT_TRUE(!memcmp(media, buf, nn_media));
+    }
+}
+
+VOID TEST(KernelRTCTest, REDEncodeWithRedundancy)
+{
+    srs_error_t err = srs_success;
+
+    char payloads[4][8];
+    for (int i = 0; i < 4; i++) {
+        memset(payloads[i], 0x10 + i, sizeof(payloads[i]));
+    }
+
+    SrsRtpRedEncoder encoder(2);
+    vector<SrsRtpPacket*> reds;
+    for (int i = 0; i < 4; i++) {
+        SrsRtpPacket pkt;
+        pkt.header.set_payload_type(111);
+        pkt.header.set_ssrc(100);
+        // Lost the packet seq=13, so the last packet only carries seq=12.
+        pkt.header.set_sequence(i < 3? 10 + i : 11 + i);
+        pkt.header.set_timestamp(960 * (i < 3? i : i + 1));
+
+        SrsRtpRawPayload* raw = new SrsRtpRawPayload();
+        raw->payload = payloads[i];
+        raw->nn_payload = 1 + i;
+        pkt.set_payload(raw, SrsRtspPacketPayloadTypeRaw);
+
+        SrsRtpPacket* red = NULL;
+        HELPER_EXPECT_SUCCESS(encoder.encode(&pkt, &red));
+        reds.push_back(red);
+    }
+
+    // Decode the RED payload, the redundant blocks are the previous packets in distance.
+    int expects[4] = {0, 1, 2, 1};
+    for (int i = 0; i < 4; i++) {
+        SrsRtpPacket* red = reds.at(i);
+        SrsAutoFree(SrsRtpPacket, red);
+        EXPECT_EQ(111, red->header.get_payload_type());
+        EXPECT_EQ(SrsRtspPacketPayloadTypeRED, red->payload_type());
+
+        char buf[kRtpPacketSize];
+        SrsBuffer b(buf, sizeof(buf));
+        HELPER_EXPECT_SUCCESS(red->payload()->encode(&b));
+        EXPECT_EQ((int)red->payload()->nb_bytes(), b.pos());
+
+        SrsRtpRedPayload payload;
+        SrsBuffer rb(buf, b.pos());
+        HELPER_EXPECT_SUCCESS(payload.decode(&rb));
+        EXPECT_EQ(111, payload.primary_pt);
+        EXPECT_EQ(1 + i, (int)payload.primary->nb_bytes());
+        EXPECT_EQ(0x10 + i, ((SrsRtpRawPayload*)payload.primary)->payload[0]);
+        ASSERT_EQ(expects[i], (int)payload.redundants.size());
+
+        for (int j = 0; j < (int)payload.redundants.size(); j++) {
+            const SrsRtpRedBlock& block = payload.redundants.at(j);
+            int index = i - (int)payload.redundants.size() + j;
+            EXPECT_EQ(1 + index, block.size);
+            EXPECT_EQ(0x10 + index, block.payload[0]);
+        }
+    }
+
+    // The history is reset when SSRC changed.
+    if (true) {
+        SrsRtpPacket pkt;
+        pkt.header.set_payload_type(111);
+        pkt.header.set_ssrc(200);
+        pkt.header.set_sequence(14);
+        pkt.header.set_timestamp(960 * 5);
+
+        SrsRtpRawPayload* raw = new SrsRtpRawPayload();
+        raw->payload = payloads[0];
+        raw->nn_payload = 1;
+        pkt.set_payload(raw, SrsRtspPacketPayloadTypeRaw);
+
+        SrsRtpPacket* red = NULL;
+        HELPER_EXPECT_SUCCESS(encoder.encode(&pkt, &red));
+        SrsAutoFree(SrsRtpPacket, red);
+        EXPECT_EQ(2, (int)red->payload()->nb_bytes());
+    }
+}
+
 VOID TEST(KernelRTCTest, TestPacketType)
 {
     // DTLS packet.
@@ -1369,3 +1792,417 @@ VOID TEST(KernelRTCTest, JitterSequence)
     EXPECT_EQ((uint32_t)11, jitter.correct(11));
 }
 
+
+class MockDtlsCallback : public ISrsDtlsCallback
+{
+public:
+    bool done;
+    std::vector<std::string> outs;
+public:
+    MockDtlsCallback() {
+        done = false;
+    }
+    virtual ~MockDtlsCallback() {
+    }
+public:
+    virtual srs_error_t on_dtls_handshake_done() {
+        done = true;
+        return srs_success;
+    }
+    virtual srs_error_t on_dtls_application_data(const char* data, const int len) {
+        return srs_success;
+    }
+    virtual srs_error_t write_dtls_data(void* data, int size) {
+        outs.push_back(std::string((char*)data, size));
+        return srs_success;
+    }
+    virtual srs_error_t on_dtls_alert(std::string type, std::string desc) {
+        return srs_success;
+    }
+};
+
+// Drive the DTLS handshake between client and server, wait for the async handshake in workers.
+srs_error_t mock_dtls_handshake(SrsDtls* client, MockDtlsCallback* cc, SrsDtls* server, MockDtlsCallback* sc)
+{
+    srs_error_t err = srs_success;
+
+    if ((err = client->start_active_handshake()) != srs_success) {
+        return srs_error_wrap(err, "start");
+    }
+
+    for (int i = 0; i < 1000 && (!cc->done || !sc->done); i++) {
+        std::vector<std::string> outs;
+        outs.swap(cc->outs);
+        for (int j = 0; j < (int)outs.size(); j++) {
+            std::string& pkt = outs.at(j);
+            if ((err = server->on_dtls((char*)pkt.data(), (int)pkt.size())) != srs_success) {
+                return srs_error_wrap(err, "server");
+            }
+        }
+
+        outs.clear();
+        outs.swap(sc->outs);
+        for (int j = 0; j < (int)outs.size(); j++) {
+            std::string& pkt = outs.at(j);
+            if ((err = client->on_dtls((char*)pkt.data(), (int)pkt.size())) != srs_success) {
+                return srs_error_wrap(err, "client");
+            }
+        }
+
+        srs_usleep(1 * SRS_UTIME_MILLISECONDS);
+    }
+
+    return err;
+}
+
+VOID TEST(KernelRTCTest, DTLSSharedContext)
+{
+    srs_error_t err = srs_success;
+
+    // The SSL_CTX is shared by version and role.
+    SSL_CTX* ctx = _srs_rtc_dtls_certificate->get_dtls_ctx(SrsDtlsVersion1_2, "passive");
+    EXPECT_TRUE(ctx != NULL);
+    EXPECT_EQ(ctx, _srs_rtc_dtls_certificate->get_dtls_ctx(SrsDtlsVersion1_2, "passive"));
+    EXPECT_NE(ctx, _srs_rtc_dtls_certificate->get_dtls_ctx(SrsDtlsVersion1_2, "active"));
+    EXPECT_EQ(_srs_rtc_dtls_certificate->get_dtls_ctx(SrsDtlsVersionAuto, "active"),
+        _srs_rtc_dtls_certificate->get_dtls_ctx(SrsDtlsVersionAuto, "passive"));
+
+    // Handshake in ST thread, by the shared SSL_CTX.
+    for (int i = 0; i < 2; i++) {
+        MockDtlsCallback cc, sc;
+        SrsDtls client(&cc), server(&sc);
+        HELPER_EXPECT_SUCCESS(client.initialize("active", "dtls1.2"));
+        HELPER_EXPECT_SUCCESS(server.initialize("passive", "dtls1.2"));
+
+        HELPER_EXPECT_SUCCESS(mock_dtls_handshake(&client, &cc, &server, &sc));
+        EXPECT_TRUE(cc.done);
+        EXPECT_TRUE(sc.done);
+
+        std::string crk, csk, srk, ssk;
+        HELPER_EXPECT_SUCCESS(client.get_srtp_key(crk, csk));
+        HELPER_EXPECT_SUCCESS(server.get_srtp_key(srk, ssk));
+        EXPECT_TRUE(crk == ssk);
+        EXPECT_TRUE(csk == srk);
+    }
+}
+
+VOID TEST(KernelRTCTest, DTLSHandshakeInWorkers)
+{
+    srs_error_t err = srs_success;
+
+    SrsDtlsWorkers* workers = new SrsDtlsWorkers();
+
+    SrsDtlsWorkers* global = _srs_dtls_workers;
+    _srs_dtls_workers = workers;
+
+    if (true) {
+        SrsSetEnvConfig(dtls_workers, "SRS_RTC_SERVER_DTLS_WORKERS", "2");
+        HELPER_EXPECT_SUCCESS(workers->initialize());
+    }
+    EXPECT_TRUE(workers->enabled());
+
+    for (int i = 0; i < 3; i++) {
+        MockDtlsCallback cc, sc;
+        SrsDtls client(&cc), server(&sc);
+        HELPER_EXPECT_SUCCESS(client.initialize("active", "dtls1.2"));
+        HELPER_EXPECT_SUCCESS(server.initialize("passive", "dtls1.2"));
+
+        HELPER_EXPECT_SUCCESS(mock_dtls_handshake(&client, &cc, &server, &sc));
+        EXPECT_TRUE(cc.done);
+        EXPECT_TRUE(sc.done);
+
+        std::string crk, csk, srk, ssk;
+        HELPER_EXPECT_SUCCESS(client.get_srtp_key(crk, csk));
+        HELPER_EXPECT_SUCCESS(server.get_srtp_key(srk, ssk));
+        EXPECT_TRUE(crk == ssk);
+        EXPECT_TRUE(csk == srk);
+    }
+
+    // Free the DTLS when handshake in worker, the job should free the SSL.
+    if (true) {
+        MockDtlsCallback cc, sc;
+        SrsDtls client(&cc);
+        HELPER_EXPECT_SUCCESS(client.initialize("active", "dtls1.2"));
+        HELPER_EXPECT_SUCCESS(client.start_active_handshake());
+        ASSERT_FALSE(cc.outs.empty());
+
+        SrsDtls* server = new SrsDtls(&sc);
+        HELPER_EXPECT_SUCCESS(server->initialize("passive", "dtls1.2"));
+        HELPER_EXPECT_SUCCESS(server->on_dtls((char*)cc.outs.at(0).data(), (int)cc.outs.at(0).size()));
+        srs_freep(server);
+
+        srs_usleep(30 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(sc.outs.empty());
+    }
+
+    // Free the DTLS when handshake in worker and workers quit, the DTLS should be detached.
+    if (true) {
+        MockDtlsCallback cc, sc;
+        SrsDtls client(&cc);
+        HELPER_EXPECT_SUCCESS(client.initialize("active", "dtls1.2"));
+        HELPER_EXPECT_SUCCESS(client.start_active_handshake());
+        ASSERT_FALSE(cc.outs.empty());
+
+        SrsDtls server(&sc);
+        HELPER_EXPECT_SUCCESS(server.initialize("passive", "dtls1.2"));
+        HELPER_EXPECT_SUCCESS(server.on_dtls((char*)cc.outs.at(0).data(), (int)cc.outs.at(0).size()));
+
+        // Stop the workers, which wait for the worker threads to quit.
+        _srs_dtls_workers = global;
+        srs_freep(workers);
+        EXPECT_TRUE(sc.outs.empty());
+    }
+
+    _srs_dtls_workers = global;
+}
+
+VOID TEST(KernelRTCTest, DTLSSharedContextBySRTPGCM)
+{
+    // The SSL_CTX is keyed by srtp_gcm, so the new setting is applied when reload.
+    SSL_CTX* ctx = NULL;
+    if (true) {
+        SrsSetEnvConfig(srtp_gcm, "SRS_RTC_SERVER_SRTP_GCM", "off");
+        ctx = _srs_rtc_dtls_certificate->get_dtls_ctx(SrsDtlsVersion1_2, "passive");
+        EXPECT_EQ(ctx, _srs_rtc_dtls_certificate->get_dtls_ctx(SrsDtlsVersion1_2, "passive"));
+    }
+    if (true) {
+        SrsSetEnvConfig(srtp_gcm, "SRS_RTC_SERVER_SRTP_GCM", "on");
+        EXPECT_NE(ctx, _srs_rtc_dtls_certificate->get_dtls_ctx(SrsDtlsVersion1_2, "passive"));
+    }
+}
+
+VOID TEST(KernelRTCTest, DTLSRateLimit)
+{
+    srs_error_t err = srs_success;
+
+    SrsDtlsWorkers workers;
+    if (true) {
+        SrsSetEnvConfig(dtls_rate, "SRS_RTC_SERVER_DTLS_RATE", "2");
+        HELPER_EXPECT_SUCCESS(workers.initialize());
+    }
+    EXPECT_FALSE(workers.enabled());
+
+    EXPECT_TRUE(workers.admit());
+    EXPECT_TRUE(workers.admit());
+    EXPECT_FALSE(workers.admit());
+}
+
+// Build RTP packets of 1200 bytes, in buffers large enough for the SRTP trailer.
+void mock_srtp_packets(char* bufs, int nn_buf, iovec* iovs, int nn_iovs)
+{
+    for (int i = 0; i < nn_iovs; i++) {
+        char* p = bufs + i * nn_buf;
+        memset(p, i, nn_buf);
+
+        SrsBuffer b(p, nn_buf);
+        b.write_1bytes(0x80);
+        b.write_1bytes(111);
+        b.write_2bytes(100 + i);
+        b.write_4bytes(960 * i);
+        b.write_4bytes(0x01020304);
+
+        iovs[i].iov_base = p;
+        iovs[i].iov_len = 1200;
+    }
+}
+
+VOID TEST(KernelRTCTest, SRTPProtectBatch)
+{
+    srs_error_t err = srs_success;
+
+    std::string k0(30, 'a'), k1(30, 'b');
+    SrsSRTP sender, receiver;
+    HELPER_EXPECT_SUCCESS(sender.initialize(k1, k0));
+    HELPER_EXPECT_SUCCESS(receiver.initialize(k0, k1));
+
+    const int nn_iovs = 16;
+    const int nn_buf = 1500;
+    char* bufs = new char[nn_iovs * nn_buf];
+    SrsAutoFreeA(char, bufs);
+    char* origins = new char[nn_iovs * nn_buf];
+    SrsAutoFreeA(char, origins);
+
+    iovec iovs[nn_iovs];
+    mock_srtp_packets(bufs, nn_buf, iovs, nn_iovs);
+    memcpy(origins, bufs, nn_iovs * nn_buf);
+
+    HELPER_EXPECT_SUCCESS(sender.protect_rtps(iovs, nn_iovs));
+    for (int i = 0; i < nn_iovs; i++) {
+        EXPECT_EQ(1200 + 10, (int)iovs[i].iov_len);
+        EXPECT_TRUE(memcmp(origins + i * nn_buf + 12, bufs + i * nn_buf + 12, 1200 - 12));
+    }
+
+    for (int i = 0; i < nn_iovs; i++) {
+        int nb_plaintext = (int)iovs[i].iov_len;
+        HELPER_EXPECT_SUCCESS(receiver.unprotect_rtp(iovs[i].iov_base, &nb_plaintext));
+        EXPECT_EQ(1200, nb_plaintext);
+        iovs[i].iov_len = nb_plaintext;
+        EXPECT_TRUE(!memcmp(origins + i * nn_buf, bufs + i * nn_buf, 1200));
+    }
+
+    // Replay is not allowed for receiver.
+    if (true) {
+        HELPER_EXPECT_SUCCESS(sender.protect_rtps(iovs, 1));
+        int nb_plaintext = (int)iovs[0].iov_len;
+        HELPER_EXPECT_FAILED(receiver.unprotect_rtp(iovs[0].iov_base, &nb_plaintext));
+    }
+
+    // Not ready.
+    SrsSRTP srtp;
+    HELPER_EXPECT_FAILED(srtp.protect_rtps(iovs, nn_iovs));
+}
+
+VOID TEST(KernelRTCTest, SRTPSendInBatch)
+{
+    srs_error_t err = srs_success;
+
+    SrsRtcConnection s(NULL, SrsContextId());
+
+    // Send out directly if not in batch.
+    int64_t nn_srtps = _srs_pps_srtps->sugar;
+    if (true) {
+        SrsRtpPacket pkt;
+        pkt.header.set_sequence(100);
+        HELPER_EXPECT_SUCCESS(s.do_send_packet(&pkt));
+        EXPECT_EQ(0, s.nn_cache_iovs_);
+        EXPECT_EQ(nn_srtps + 1, _srs_pps_srtps->sugar);
+    }
+
+    // Send out in batch, when batch is full or end.
+    nn_srtps = _srs_pps_srtps->sugar;
+    s.begin_batch();
+    s.begin_batch();
+    for (int i = 0; i < SRS_PERF_RTC_SEND_BATCH + 2; i++) {
+        SrsRtpPacket pkt;
+        pkt.header.set_sequence(100 + i);
+        HELPER_EXPECT_SUCCESS(s.do_send_packet(&pkt));
+    }
+    EXPECT_EQ(2, s.nn_cache_iovs_);
+    EXPECT_EQ(nn_srtps + SRS_PERF_RTC_SEND_BATCH, _srs_pps_srtps->sugar);
+
+    // Only send out by the outermost batch.
+    HELPER_EXPECT_SUCCESS(s.end_batch());
+    EXPECT_EQ(2, s.nn_cache_iovs_);
+    HELPER_EXPECT_SUCCESS(s.end_batch());
+    EXPECT_EQ(0, s.nn_cache_iovs_);
+    EXPECT_EQ(nn_srtps + SRS_PERF_RTC_SEND_BATCH + 2, _srs_pps_srtps->sugar);
+}
+
+class MockRtcFailedNetwork : public SrsRtcDummyNetwork
+{
+public:
+    int nn_writes_;
+public:
+    MockRtcFailedNetwork() {
+        nn_writes_ = 0;
+    }
+    virtual ~MockRtcFailedNetwork() {
+    }
+public:
+    virtual srs_error_t protect_rtps(iovec* iovs, int nn_iovs) {
+        // Fail to protect the first packet, which should be dropped.
+        iovs[0].iov_len = 0;
+        return srs_error_new(ERROR_RTC_SRTP_PROTECT, "mock");
+    }
+    virtual srs_error_t write(void* buf, size_t size, ssize_t* nwrite) {
+        nn_writes_++;
+        return srs_error_new(ERROR_SOCKET_WRITE, "mock");
+    }
+};
+
+VOID TEST(KernelRTCTest, SRTPSendInBatchWithError)
+{
+    srs_error_t err = srs_success;
+
+    SrsRtcConnection s(NULL, SrsContextId());
+
+    MockRtcFailedNetwork* network = new MockRtcFailedNetwork();
+    SrsRtcDummyNetwork* dummy = s.networks_->dummy_;
+    s.networks_->dummy_ = network;
+
+    // Drop the packet failed to protect, but send the rest of batch even if write failed.
+    char buf[3][32];
+    iovec iovs[3];
+    for (int i = 0; i < 3; i++) {
+        iovs[i].iov_base = buf[i];
+        iovs[i].iov_len = sizeof(buf[i]);
+    }
+    HELPER_EXPECT_FAILED(s.send_packets(iovs, 3));
+    EXPECT_EQ(2, network->nn_writes_);
+
+    s.networks_->dummy_ = dummy;
+    srs_freep(network);
+}
+
+#ifdef SRS_SRTP_OPENSSL
+VOID TEST(KernelRTCTest, SRTPProtectAESGCM)
+{
+    srs_error_t err = srs_success;
+
+    // The AEAD_AES_128_GCM key is 16 bytes key and 12 bytes salt.
+    std::string k0(28, 'a'), k1(28, 'b');
+    SrsSRTP sender, receiver;
+    HELPER_EXPECT_SUCCESS(sender.initialize(k1, k0));
+    HELPER_EXPECT_SUCCESS(receiver.initialize(k0, k1));
+
+    const int nn_buf = 1500;
+    char buf[nn_buf], origin[nn_buf];
+    iovec iov;
+    mock_srtp_packets(buf, nn_buf, &iov, 1);
+    memcpy(origin, buf, nn_buf);
+
+    HELPER_EXPECT_SUCCESS(sender.protect_rtps(&iov, 1));
+    EXPECT_EQ(1200 + 16, (int)iov.iov_len);
+
+    int nb_plaintext = (int)iov.iov_len;
+    HELPER_EXPECT_SUCCESS(receiver.unprotect_rtp(iov.iov_base, &nb_plaintext));
+    EXPECT_EQ(1200, nb_plaintext);
+    EXPECT_TRUE(!memcmp(origin, buf, 1200));
+}
+#endif
+
+VOID TEST(KernelRTCTest, FECOnlyForNegotiatedConsumers)
+{
+    srs_error_t err = srs_success;
+
+    SrsRtcSource* source = new SrsRtcSource();
+    SrsAutoFree(SrsRtcSource, source);
+    source->fec_group_ = 2;
+
+    // The player with FEC, and the player without FEC.
+    SrsRtcConsumer* with_fec = NULL;
+    HELPER_EXPECT_SUCCESS(source->create_consumer(with_fec));
+    SrsAutoFree(SrsRtcConsumer, with_fec);
+    with_fec->set_fec(true);
+
+    SrsRtcConsumer* without_fec = NULL;
+    HELPER_EXPECT_SUCCESS(source->create_consumer(without_fec));
+    SrsAutoFree(SrsRtcConsumer, without_fec);
+
+    char payload[100];
+    memset(payload, 'a', sizeof(payload));
+    for (int i = 0; i < 2; i++) {
+        SrsRtpPacket pkt;
+        pkt.frame_type = SrsFrameTypeVideo;
+        pkt.header.set_ssrc(200);
+        pkt.header.set_payload_type(102);
+        pkt.header.set_sequence(100 + i);
+        pkt.header.set_timestamp(9000);
+
+        SrsRtpRawPayload* raw = new SrsRtpRawPayload();
+        raw->payload = payload;
+        raw->nn_payload = sizeof(payload);
+        pkt.set_payload(raw, SrsRtspPacketPayloadTypeRaw);
+
+        HELPER_EXPECT_SUCCESS(source->on_rtp(&pkt));
+    }
+
+    // The FEC packet is only delivered to the player negotiated FEC.
+    ASSERT_EQ(3, (int)with_fec->queue.size());
+    EXPECT_EQ(SrsRtspPacketPayloadTypeFEC, with_fec->queue.at(2)->payload_type());
+    EXPECT_EQ(2, (int)without_fec->queue.size());
+
+    // No FEC is generated, if no player negotiated FEC.
+    with_fec->set_fec(false);
+    EXPECT_FALSE(source->has_fec_consumer());
+}
@@ -22,6 +22,8 @@ using namespace std;
 #include <srs_protocol_http_client.hpp>
 #include <srs_protocol_rtmp_conn.hpp>
 #include <srs_protocol_conn.hpp>
+#include <srs_app_http_static.hpp>
+#include <srs_kernel_file.hpp>
 #include <sys/socket.h>
 #include <netdb.h>
 #include <st.h>
@@ -473,6 +475,133 @@ VOID TEST(TCPServerTest, WritevIOVC)
 	}
 }
 
+VOID TEST(TCPServerTest, Sendfile)
+{
+    srs_error_t err;
+
+    string path = "./objs/utest-sendfile.txt";
+    if (true) {
+        SrsFileWriter fw;
+        HELPER_ASSERT_SUCCESS(fw.open(path));
+        HELPER_ASSERT_SUCCESS(fw.write((void*)"Hello, world!", 13, NULL));
+    }
+
+    if (true) {
+        MockTcpHandler h;
+        SrsTcpListener l(&h);
+        l.set_endpoint(_srs_tmp_host, _srs_tmp_port);
+        HELPER_EXPECT_SUCCESS(l.listen());
+
+        SrsTcpClient c(_srs_tmp_host, _srs_tmp_port, _srs_tmp_timeout);
+        HELPER_EXPECT_SUCCESS(c.connect());
+
+        srs_usleep(30 * SRS_UTIME_MILLISECONDS);
+#ifdef SRS_OSX
+        ASSERT_TRUE(h.fd != NULL);
+#endif
+        SrsStSocket skt(h.fd);
+        if (!skt.sendfile_enabled()) {
+            return;
+        }
+
+        SrsFileReader fr;
+        HELPER_ASSERT_SUCCESS(fr.open(path));
+
+        // Send part of file, the file offset is not changed.
+        ssize_t nn = 0;
+        HELPER_EXPECT_SUCCESS(skt.sendfile(fr.fileno(), 7, 5, &nn));
+        EXPECT_EQ(5, nn);
+        EXPECT_EQ(5, skt.get_send_bytes());
+        EXPECT_EQ(0, fr.tellg());
+
+        char buf[16] = {0};
+        HELPER_EXPECT_SUCCESS(c.read_fully(buf, 5, NULL));
+        EXPECT_STREQ(buf, "world");
+
+        // Fail if file is EOF.
+        HELPER_EXPECT_FAILED(skt.sendfile(fr.fileno(), 7, 10, &nn));
+        EXPECT_EQ(6, nn);
+    }
+
+    ::unlink(path.c_str());
+}
+
+VOID TEST(HTTPServerTest, VodSendfile)
+{
+    srs_error_t err;
+
+    string path = "./objs/utest-sendfile.mp4";
+    if (true) {
+        SrsFileWriter fw;
+        HELPER_ASSERT_SUCCESS(fw.open(path));
+        HELPER_ASSERT_SUCCESS(fw.write((void*)"Hello, world!", 13, NULL));
+    }
+
+    MockTcpHandler h;
+    SrsTcpListener l(&h);
+    l.set_endpoint(_srs_tmp_host, _srs_tmp_port);
+    HELPER_EXPECT_SUCCESS(l.listen());
+
+    SrsTcpClient c(_srs_tmp_host, _srs_tmp_port, _srs_tmp_timeout);
+    HELPER_EXPECT_SUCCESS(c.connect());
+
+    srs_usleep(30 * SRS_UTIME_MILLISECONDS);
+    ASSERT_TRUE(h.fd != NULL);
+    SrsStSocket skt(h.fd);
+
+    SrsHttpMuxEntry e;
+    e.pattern = "/";
+
+    SrsVodStream vod("./objs");
+    vod.entry = &e;
+
+    // Serve the range of file by sendfile, over plaintext TCP.
+    if (true) {
+        SrsHttpResponseWriter w(&skt);
+        EXPECT_FALSE(w.sendfile_enabled());
+
+        SrsHttpMessage r(NULL, NULL);
+        HELPER_ASSERT_SUCCESS(r.set_url("/utest-sendfile.mp4?range=2-5", false));
+        HELPER_ASSERT_SUCCESS(vod.serve_http(&w, &r));
+
+        SrsHttpParser hp;
+        HELPER_ASSERT_SUCCESS(hp.initialize(HTTP_RESPONSE));
+
+        ISrsHttpMessage* msg = NULL;
+        HELPER_ASSERT_SUCCESS(hp.parse_message(&c, &msg));
+        SrsAutoFree(ISrsHttpMessage, msg);
+        EXPECT_EQ(206, msg->status_code());
+        EXPECT_STREQ("bytes 2-5/13", msg->header()->get("Content-Range").c_str());
+
+        string body;
+        HELPER_ASSERT_SUCCESS(msg->body_read_all(body));
+        EXPECT_STREQ("llo,", body.c_str());
+    }
+
+    // Serve the whole file, the next response on the same connection.
+    if (true) {
+        SrsHttpResponseWriter w(&skt);
+
+        SrsHttpMessage r(NULL, NULL);
+        HELPER_ASSERT_SUCCESS(r.set_url("/utest-sendfile.mp4", false));
+        HELPER_ASSERT_SUCCESS(vod.serve_http(&w, &r));
+
+        SrsHttpParser hp;
+        HELPER_ASSERT_SUCCESS(hp.initialize(HTTP_RESPONSE));
+
+        ISrsHttpMessage* msg = NULL;
+        HELPER_ASSERT_SUCCESS(hp.parse_message(&c, &msg));
+        SrsAutoFree(ISrsHttpMessage, msg);
+        EXPECT_EQ(200, msg->status_code());
+
+        string body;
+        HELPER_ASSERT_SUCCESS(msg->body_read_all(body));
+        EXPECT_STREQ("Hello, world!", body.c_str());
+    }
+
+    ::unlink(path.c_str());
+}
+
 VOID TEST(HTTPServerTest, MessageConnection)
 {
     srs_error_t err;
@@ -11,7 +11,10 @@
 #include <srs_protocol_rtmp_stack.hpp>
 #include <srs_app_srt_utility.hpp>
 #include <srs_app_srt_server.hpp>
+#include <srs_app_srt_source.hpp>
 #include <srs_core_autofree.hpp>
+#include <srs_utest_config.hpp>
+#include <srs_utest_kernel.hpp>
 
 #include <sstream>
 #include <vector>
@@ -181,6 +184,68 @@ public:
     }
 };
 
+VOID TEST(ServiceStSRTTest, PollProbe)
+{
+    srs_error_t err = srs_success;
+
+    std::string server_ip = "127.0.0.1";
+    int server_port = 19000;
+
+    // Use another poller to probe the listener, without notify the socket. The listener is only owned by the
+    // socket of this poller, so the fd is closed once.
+    ISrsSrtPoller* srt_poller = srs_srt_poller_new();
+    SrsAutoFree(ISrsSrtPoller, srt_poller);
+    HELPER_EXPECT_SUCCESS(srt_poller->initialize());
+
+    srs_srt_t srt_server_fd = srs_srt_socket_invalid();
+    HELPER_EXPECT_SUCCESS(srs_srt_socket_with_default_option(&srt_server_fd));
+    HELPER_EXPECT_SUCCESS(srs_srt_listen(srt_server_fd, server_ip, server_port));
+
+    SrsSrtSocket* srt_listener = new SrsSrtSocket(srt_poller, srt_server_fd);
+    SrsAutoFree(SrsSrtSocket, srt_listener);
+    HELPER_EXPECT_SUCCESS(srt_listener->enable_read());
+
+    srs_srt_t srt_client_fd = srs_srt_socket_invalid();
+    HELPER_EXPECT_SUCCESS(srs_srt_socket(&srt_client_fd));
+
+    int n_fds = 0;
+    HELPER_EXPECT_SUCCESS(srt_poller->probe(0, &n_fds));
+    EXPECT_EQ(0, n_fds);
+
+    SrsSrtSocket* srt_client_socket = new SrsSrtSocket(_srt_eventloop->poller(), srt_client_fd);
+    SrsAutoFree(SrsSrtSocket, srt_client_socket);
+    HELPER_EXPECT_SUCCESS(srt_client_socket->connect(server_ip, server_port));
+
+    HELPER_EXPECT_SUCCESS(srt_poller->probe(100, &n_fds));
+    EXPECT_EQ(1, n_fds);
+
+    // The event is level triggered, so probe again is ok.
+    HELPER_EXPECT_SUCCESS(srt_poller->probe(0, &n_fds));
+    EXPECT_EQ(1, n_fds);
+
+    HELPER_EXPECT_SUCCESS(srt_listener->disable_read());
+    HELPER_EXPECT_SUCCESS(srt_poller->probe(0, &n_fds));
+    EXPECT_EQ(0, n_fds);
+}
+
+VOID TEST(ServiceStSRTTest, EventLoopStop)
+{
+    srs_error_t err = srs_success;
+
+    SrsSrtEventLoop* loop = new SrsSrtEventLoop();
+    HELPER_EXPECT_SUCCESS(loop->initialize());
+    HELPER_EXPECT_SUCCESS(loop->start());
+
+    // Let the coroutine notify the poller thread to wait for the SRT events.
+    srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+    EXPECT_EQ(loop->wake_fd_ != NULL, loop->running_);
+
+    // The poller thread quits, before the poller is freed.
+    loop->stop_poller();
+    EXPECT_FALSE(loop->running_);
+    srs_freep(loop);
+}
+
 VOID TEST(ServiceStSRTTest, ListenConnectAccept) 
 {
     srs_error_t err = srs_success;
@@ -550,6 +615,109 @@ VOID TEST(ServiceSRTTest, Encrypt)
     }
 }
 
+class MockSrtLiveSource : public SrsLiveSource
+{
+public:
+    std::vector<uint32_t> audios;
+public:
+    virtual srs_error_t on_audio(SrsCommonMessage* audio) {
+        audios.push_back(audio->header.timestamp);
+        return srs_success;
+    }
+};
+
+// Mux the AAC frames to TS, each frame is a PES of 100ms.
+string mock_srt_ts_audio(int nb_frames)
+{
+    srs_error_t err = srs_success;
+
+    // The ADTS of AAC LC, 44.1kHz, stereo, with 10 bytes payload.
+    uint8_t adts[] = {0xff, 0xf1, 0x50, 0x80, 0x02, 0x3f, 0xfc, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a};
+
+    SrsTsContext ctx;
+    MockSrsFileWriter f;
+    for (int i = 0; i < nb_frames; i++) {
+        SrsTsMessage m;
+        m.sid = SrsTsPESStreamIdAudioCommon;
+        m.dts = m.pts = i * 100 * 90;
+        m.payload->append((char*)adts, sizeof(adts));
+        HELPER_EXPECT_SUCCESS(ctx.encode(&f, &m, SrsVideoCodecIdDisabled, SrsAudioCodecIdAAC));
+    }
+    return f.str();
+}
+
+void mock_srt_publish(SrsRtmpFromSrtBridge* bridge, string ts)
+{
+    srs_error_t err = srs_success;
+
+    // Send 7 TS packets in a SRT packet.
+    for (int pos = 0; pos < (int)ts.length(); pos += 7 * SRS_TS_PACKET_SIZE) {
+        int size = srs_min(7 * SRS_TS_PACKET_SIZE, (int)ts.length() - pos);
+        SrsSrtPacket pkt;
+        memcpy(pkt.wrap(size), ts.data() + pos, size);
+        HELPER_EXPECT_SUCCESS(bridge->on_packet(&pkt));
+    }
+}
+
+VOID TEST(SrtBridgeTest, DemuxInWorkers)
+{
+    srs_error_t err = srs_success;
+
+    string ts = mock_srt_ts_audio(10);
+    ASSERT_FALSE(ts.empty());
+    ASSERT_EQ(0, (int)ts.length() % SRS_TS_PACKET_SIZE);
+
+    // Demux in ST thread.
+    MockSrtLiveSource s0;
+    if (true) {
+        SrsRtmpFromSrtBridge bridge(&s0);
+        mock_srt_publish(&bridge, ts);
+    }
+    // The audio sequence header and the frames, except the last one which is not reaped.
+    ASSERT_GE((int)s0.audios.size(), 9);
+
+    SrsSrtDemuxWorkers* workers = new SrsSrtDemuxWorkers();
+
+    SrsSrtDemuxWorkers* global = _srs_srt_demuxers;
+    _srs_srt_demuxers = workers;
+
+    if (true) {
+        SrsSetEnvConfig(srt_workers, "SRS_SRT_SERVER_WORKERS", "2");
+        HELPER_EXPECT_SUCCESS(workers->initialize());
+    }
+    EXPECT_TRUE(workers->enabled());
+
+    // Demux in workers, the frames should be same as ST thread.
+    for (int i = 0; i < 3; i++) {
+        MockSrtLiveSource s1;
+        SrsRtmpFromSrtBridge bridge(&s1);
+        mock_srt_publish(&bridge, ts);
+
+        for (int j = 0; j < 100 && s1.audios.size() < s0.audios.size(); j++) {
+            srs_usleep(10 * SRS_UTIME_MILLISECONDS);
+        }
+        EXPECT_TRUE(s0.audios == s1.audios);
+    }
+
+    // Free the bridge when demux in worker, the frames should be dropped.
+    if (true) {
+        MockSrtLiveSource s2;
+        SrsRtmpFromSrtBridge* bridge = new SrsRtmpFromSrtBridge(&s2);
+        mock_srt_publish(bridge, ts);
+        srs_freep(bridge);
+
+        srs_usleep(30 * SRS_UTIME_MILLISECONDS);
+        EXPECT_TRUE(s2.audios.empty());
+    }
+
+    // The workers quit before the demuxers and jobs are freed.
+    workers->stop_workers();
+    EXPECT_EQ(0, workers->nn_running_);
+
+    _srs_srt_demuxers = global;
+    srs_freep(workers);
+}
+
 // TODO: FIXME: add mpegts conn test
 // set srt option, recv srt client, get srt client opt and check.
 